@@ -0,0 +1,125 @@
+import Foundation
+import SWAML
+
+/// Realistic LLM outputs the benchmarks run against
+///
+/// Generated deterministically, so runs (and baselines) are comparable.
+enum Corpus {
+    static let statuses = ["active", "pending", "archived"]
+
+    /// One extraction record, as a model would write it
+    static func record(_ i: Int) -> String {
+        """
+        {"id": \(i), "name": "Customer \(i)", "email": "customer\(i)@example.com", \
+        "age": \(20 + i % 50), "score": \(Double(i % 100) / 10), "active": \(i % 2 == 0), \
+        "status": "\(statuses[i % statuses.count])", "tags": ["tier-\(i % 3)", "region-\(i % 5)"]}
+        """
+    }
+
+    static let recordSchema = JSONSchema.object(
+        properties: [
+            "id": .integer,
+            "name": .string,
+            "email": .string,
+            "age": .integer,
+            "score": .number,
+            "active": .boolean,
+            "status": .enum(values: statuses),
+            "tags": .array(items: .string),
+        ],
+        required: ["id", "name", "email", "age", "score", "active", "status", "tags"]
+    )
+
+    static let recordsSchema = JSONSchema.array(items: recordSchema)
+
+    // MARK: - Outputs
+
+    /// A single object in a markdown code block, as most chat models answer
+    static let fenced = """
+        Here is the extracted data:
+
+        ```json
+        \(record(1))
+        ```
+
+        Let me know if you need anything else!
+        """
+
+    /// JSON embedded in prose, with a trailing comma
+    static let chatty = """
+        Sure! Based on the conversation, the customer details are \
+        \(record(2).dropLast()), } and I hope this helps. The one thing I wasn't sure \
+        about is the score, which I estimated from context.
+        """
+
+    /// A streaming response cut off mid-string
+    static let truncated = String(hugeArray.prefix(hugeArray.count / 2))
+
+    /// Python-style output: single quotes, unquoted keys, comments
+    static let singleQuoted = """
+        {
+          // extracted by the model
+          name: 'Ada Lovelace',
+          'email': 'ada@example.com',
+          age: 36,
+          'tags': ['math', 'computing',],
+        }
+        """
+
+    /// A large extraction result: 2,000 records
+    static let hugeArray = "[" + (0..<2_000).map(record).joined(separator: ",\n") + "]"
+
+    /// The same records with numbers and booleans as strings, which
+    /// `OutputParser` has to coerce
+    static let stringlyArray = "[" + (0..<500).map { i in
+        """
+        {"id": "\(i)", "name": "Customer \(i)", "email": "c\(i)@example.com", "age": "\(20 + i % 50)", \
+        "score": "\(Double(i % 100) / 10)", "active": "\(i % 2 == 0)", "status": "active", "tags": []}
+        """
+    }.joined(separator: ",") + "]"
+
+    /// 200 levels of nested objects
+    static let deepNesting = String(repeating: "{\"child\": ", count: 200) + "null" + String(repeating: "}", count: 200)
+
+    /// Every output, by name, for the parser benchmarks
+    static let outputs: [(name: String, text: String)] = [
+        ("fenced", fenced),
+        ("chatty", chatty),
+        ("singleQuoted", singleQuoted),
+        ("hugeArray", hugeArray),
+        ("deepNesting", deepNesting),
+    ]
+
+    // MARK: - Values
+
+    /// `stringlyArray` as a value, for coercion
+    static let stringlyValue: SwamlValue = (try? JsonishParser.parseValue(stringlyArray)) ?? .null
+
+    static let stringlyFieldType = FieldType.list(.map(key: .string, value: .union([.int, .float, .bool, .string])))
+
+    // MARK: - Mock Responses
+
+    /// An OpenAI chat completion whose content is `hugeArray`
+    static let openAIResponse: Data = {
+        let body: [String: Any] = [
+            "id": "chatcmpl-bench",
+            "object": "chat.completion",
+            "model": "bench",
+            "choices": [[
+                "index": 0,
+                "message": ["role": "assistant", "content": hugeArray],
+                "finish_reason": "stop",
+            ]],
+            "usage": ["prompt_tokens": 1_200, "completion_tokens": 60_000, "total_tokens": 61_200],
+        ]
+        return (try? JSONSerialization.data(withJSONObject: body)) ?? Data()
+    }()
+
+    /// A conversation with a long system prompt and a few turns
+    static let messages: [ChatMessage] = [
+        .system(String(repeating: "You extract customer records from support transcripts. ", count: 80), cacheable: true),
+        .user(String(repeating: "Customer: my order hasn't arrived. Agent: let me check. ", count: 200)),
+        .assistant(record(3)),
+        .user("Now extract every customer mentioned in the thread."),
+    ]
+}
@@ -0,0 +1,132 @@
+import Foundation
+#if canImport(Darwin)
+import Darwin
+#else
+import Glibc
+#endif
+
+/// One measured operation
+struct Benchmark {
+    let name: String
+
+    /// Input bytes processed per run, for throughput (0 to report runs/s only)
+    let bytes: Int
+
+    let run: () async throws -> Void
+
+    init(_ name: String, bytes: Int = 0, run: @escaping () async throws -> Void) {
+        self.name = name
+        self.bytes = bytes
+        self.run = run
+    }
+
+    init(_ name: String, input: String, run: @escaping () throws -> Void) {
+        self.init(name, bytes: input.utf8.count) { try run() }
+    }
+}
+
+/// Timing of one benchmark, as saved to and compared against baselines
+struct BenchmarkResult: Codable {
+    let name: String
+    let iterations: Int
+
+    /// Seconds per run
+    let p50: Double
+    let p99: Double
+    let mean: Double
+
+    let runsPerSecond: Double
+
+    /// Input megabytes per second, if the benchmark has an input size
+    let megabytesPerSecond: Double?
+
+    /// Growth of the process's peak resident memory while the benchmark ran
+    let peakMemoryGrowth: Int
+}
+
+struct BenchmarkRunner {
+    /// Runs per benchmark (after warm-up), and the time budget that can cut
+    /// them short for slow benchmarks
+    var iterations = 200
+    var timeBudget: TimeInterval = 5
+
+    func measure(_ benchmark: Benchmark) async throws -> BenchmarkResult {
+        let warmUp = max(iterations / 10, 1)
+        for _ in 0..<warmUp {
+            try await benchmark.run()
+        }
+
+        let peakBefore = Self.peakResidentBytes()
+        let clock = ContinuousClock()
+        let deadline = clock.now + .milliseconds(Int(timeBudget * 1000))
+
+        var samples: [Double] = []
+        samples.reserveCapacity(iterations)
+        while samples.count < iterations, samples.count < 10 || clock.now < deadline {
+            let start = clock.now
+            try await benchmark.run()
+            samples.append(Self.seconds(start.duration(to: clock.now)))
+        }
+
+        samples.sort()
+        let mean = samples.reduce(0, +) / Double(samples.count)
+        return BenchmarkResult(
+            name: benchmark.name,
+            iterations: samples.count,
+            p50: Self.percentile(samples, 0.50),
+            p99: Self.percentile(samples, 0.99),
+            mean: mean,
+            runsPerSecond: 1 / mean,
+            megabytesPerSecond: benchmark.bytes > 0 ? Double(benchmark.bytes) / mean / 1_000_000 : nil,
+            peakMemoryGrowth: max(Self.peakResidentBytes() - peakBefore, 0)
+        )
+    }
+
+    private static func percentile(_ sorted: [Double], _ p: Double) -> Double {
+        sorted[min(Int((Double(sorted.count - 1) * p).rounded(.up)), sorted.count - 1)]
+    }
+
+    private static func seconds(_ duration: Duration) -> Double {
+        let parts = duration.components
+        return Double(parts.seconds) + Double(parts.attoseconds) / 1e18
+    }
+
+    /// Peak resident set size of the process, in bytes
+    static func peakResidentBytes() -> Int {
+        var usage = rusage()
+        getrusage(RUSAGE_SELF, &usage)
+        #if canImport(Darwin)
+        return Int(usage.ru_maxrss)
+        #else
+        // Linux reports kilobytes
+        return Int(usage.ru_maxrss) * 1024
+        #endif
+    }
+}
+
+/// Keeps the optimizer from discarding a benchmark's result
+@inline(never)
+func blackHole<T>(_ value: T) {
+    withExtendedLifetime(value) {}
+}
+
+// MARK: - Baselines
+
+enum Baseline {
+    static func load(_ path: String) throws -> [String: BenchmarkResult] {
+        let data = try Data(contentsOf: URL(fileURLWithPath: path))
+        let results = try JSONDecoder().decode([BenchmarkResult].self, from: data)
+        return Dictionary(results.map { ($0.name, $0) }, uniquingKeysWith: { _, new in new })
+    }
+
+    static func save(_ results: [BenchmarkResult], to path: String) throws {
+        let encoder = JSONEncoder()
+        encoder.outputFormatting = [.prettyPrinted, .sortedKeys]
+        try encoder.encode(results).write(to: URL(fileURLWithPath: path))
+    }
+
+    /// p50 of `result` relative to its baseline (1.0 = unchanged)
+    static func ratio(_ result: BenchmarkResult, _ baseline: BenchmarkResult) -> Double {
+        baseline.p50 > 0 ? result.p50 / baseline.p50 : 1
+    }
+}
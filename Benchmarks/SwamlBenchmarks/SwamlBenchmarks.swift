@@ -0,0 +1,153 @@
+import Foundation
+import SWAML
+
+/// Benchmarks for SWAML's parsing, rendering and coercion hot paths
+///
+/// ```
+/// swift run -c release SwamlBenchmarks [--filter <substring>] [--iterations <n>]
+///     [--save <results.json>] [--baseline <results.json>] [--threshold <fraction>]
+/// ```
+///
+/// With `--baseline`, each benchmark's p50 is compared with the saved run and
+/// the process exits with status 1 if any is slower by more than `--threshold`
+/// (default 0.10), so CI can gate on it.
+@main
+struct SwamlBenchmarks {
+    static func main() async throws {
+        let options = Options(CommandLine.arguments.dropFirst())
+        let runner = BenchmarkRunner(iterations: options.iterations)
+        let baseline = try options.baselinePath.map(Baseline.load) ?? [:]
+
+        var results: [BenchmarkResult] = []
+        var regressions: [String] = []
+
+        print(pad("benchmark", 40), pad("p50", 12), pad("p99", 12), pad("MB/s", 10), "vs baseline")
+        for benchmark in benchmarks() where options.filter.map({ benchmark.name.contains($0) }) ?? true {
+            let result = try await runner.measure(benchmark)
+            results.append(result)
+
+            var comparison = ""
+            if let previous = baseline[benchmark.name] {
+                let ratio = Baseline.ratio(result, previous)
+                comparison = String(format: "%+.1f%%", (ratio - 1) * 100)
+                if ratio > 1 + options.threshold {
+                    regressions.append(benchmark.name)
+                    comparison += "  REGRESSION"
+                }
+            }
+            print(
+                pad(benchmark.name, 40),
+                pad(format(result.p50), 12),
+                pad(format(result.p99), 12),
+                pad(result.megabytesPerSecond.map { String(format: "%.1f", $0) } ?? "-", 10),
+                comparison
+            )
+        }
+
+        if let path = options.savePath {
+            try Baseline.save(results, to: path)
+        }
+        if !regressions.isEmpty {
+            print("\n\(regressions.count) benchmark(s) regressed by more than \(Int(options.threshold * 100))%:")
+            regressions.forEach { print("  \($0)") }
+            exit(1)
+        }
+    }
+
+    // MARK: - Benchmarks
+
+    static func benchmarks() -> [Benchmark] {
+        var all: [Benchmark] = []
+
+        for (name, text) in Corpus.outputs {
+            all.append(Benchmark("JsonishParser.parse/\(name)", input: text) {
+                blackHole(try JsonishParser.parse(text))
+            })
+            all.append(Benchmark("JsonishParser.parseValue/\(name)", input: text) {
+                blackHole(try JsonishParser.parseValue(text))
+            })
+        }
+        all.append(Benchmark("JsonishParser.parseValue/truncated", input: Corpus.truncated) {
+            blackHole(try JsonishParser.parseValue(Corpus.truncated, isDone: false))
+        })
+
+        for (name, text) in [("fenced", Corpus.fenced), ("chatty", Corpus.chatty), ("hugeArray", Corpus.hugeArray)] {
+            all.append(Benchmark("JSONExtractor.extract/\(name)", input: text) {
+                blackHole(try JSONExtractor.extract(from: text))
+            })
+        }
+
+        all.append(Benchmark("OutputParser.parseToValue/hugeArray", input: Corpus.hugeArray) {
+            blackHole(try OutputParser.parseToValue(Corpus.hugeArray, schema: Corpus.recordsSchema))
+        })
+        all.append(Benchmark("OutputParser.parseToValue/stringly", input: Corpus.stringlyArray) {
+            blackHole(try OutputParser.parseToValue(Corpus.stringlyArray, schema: Corpus.recordsSchema))
+        })
+
+        all.append(Benchmark("TypeCoercion.coerce/stringly", input: Corpus.stringlyArray) {
+            blackHole(try TypeCoercion.coerce(Corpus.stringlyValue, to: Corpus.stringlyFieldType))
+        })
+
+        all.append(Benchmark("SchemaPromptRenderer.render/records") {
+            blackHole(SchemaPromptRenderer.render(schema: Corpus.recordsSchema))
+        })
+
+        let builder = PromptBuilder()
+            .system("You extract customer records.\n{{ ctx.output_format }}")
+            .user("Transcript:\n{{ transcript }}")
+            .variable("transcript", String(repeating: "Customer: where is my order? ", count: 100))
+        all.append(Benchmark("PromptBuilder.build/records") {
+            blackHole(builder.build(schema: Corpus.recordsSchema))
+        })
+
+        let client = LLMClient(provider: .openAI(apiKey: "benchmark"), session: MockURLProtocol.session())
+        all.append(Benchmark("LLMClient.complete/mocked", bytes: Corpus.openAIResponse.count) {
+            blackHole(try await client.complete(
+                model: "bench",
+                messages: Corpus.messages,
+                responseFormat: .jsonObject
+            ))
+        })
+
+        return all
+    }
+
+    // MARK: - Output
+
+    private static func format(_ seconds: Double) -> String {
+        switch seconds {
+        case ..<1e-3: return String(format: "%.1f µs", seconds * 1e6)
+        case ..<1: return String(format: "%.2f ms", seconds * 1e3)
+        default: return String(format: "%.2f s", seconds)
+        }
+    }
+
+    private static func pad(_ text: String, _ width: Int) -> String {
+        text.count >= width ? text + " " : text + String(repeating: " ", count: width - text.count)
+    }
+}
+
+/// Command-line options
+struct Options {
+    var filter: String?
+    var iterations = 200
+    var savePath: String?
+    var baselinePath: String?
+    var threshold = 0.10
+
+    init<S: Sequence>(_ arguments: S) where S.Element == String {
+        var iterator = arguments.makeIterator()
+        while let argument = iterator.next() {
+            switch argument {
+            case "--filter": filter = iterator.next()
+            case "--iterations": iterations = iterator.next().flatMap(Int.init) ?? iterations
+            case "--save": savePath = iterator.next()
+            case "--baseline": baselinePath = iterator.next()
+            case "--threshold": threshold = iterator.next().flatMap(Double.init) ?? threshold
+            default:
+                print("Unknown option: \(argument)")
+                exit(2)
+            }
+        }
+    }
+}
@@ -29,9 +29,14 @@ let package = Package(
         // Main SWAML target - pure Swift LLM client
         .target(
             name: "SWAML",
-            dependencies: [],
+            dependencies: ["CSwamlAtomics"],
             path: "Sources/SWAML"
         ),
+        // Atomic word operations for lock-free reads (header-only C)
+        .target(
+            name: "CSwamlAtomics",
+            path: "Sources/CSwamlAtomics"
+        ),
         // Macro declarations (public interface)
         .target(
             name: "SwamlMacros",
@@ -48,6 +53,13 @@ let package = Package(
             ],
             path: "Sources/SwamlMacrosPlugin"
         ),
+        // Benchmarks for the parsing, rendering and coercion hot paths
+        // (swift run -c release SwamlBenchmarks)
+        .executableTarget(
+            name: "SwamlBenchmarks",
+            dependencies: ["SWAML"],
+            path: "Benchmarks/SwamlBenchmarks"
+        ),
         .testTarget(
             name: "SWAMLTests",
             dependencies: ["SWAML"],
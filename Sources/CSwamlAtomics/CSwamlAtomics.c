@@ -0,0 +1,2 @@
+// The operations are inline in the header; SwiftPM needs a source file per C target.
+#include "CSwamlAtomics.h"
@@ -0,0 +1,27 @@
+#ifndef CSWAML_ATOMICS_H
+#define CSWAML_ATOMICS_H
+
+#include <stdint.h>
+
+// Sequentially consistent operations on a word, for lock-free reads
+// in SWAML. Swift 5.9's standard library has no atomics, and these keep the
+// package free of a swift-atomics dependency.
+
+static inline intptr_t swaml_atomic_load(intptr_t *_Nonnull word) {
+    return __atomic_load_n(word, __ATOMIC_SEQ_CST);
+}
+
+static inline void swaml_atomic_store(intptr_t *_Nonnull word, intptr_t value) {
+    __atomic_store_n(word, value, __ATOMIC_SEQ_CST);
+}
+
+static inline intptr_t swaml_atomic_exchange(intptr_t *_Nonnull word, intptr_t value) {
+    return __atomic_exchange_n(word, value, __ATOMIC_SEQ_CST);
+}
+
+/// Returns the value before the addition
+static inline intptr_t swaml_atomic_fetch_add(intptr_t *_Nonnull word, intptr_t delta) {
+    return __atomic_fetch_add(word, delta, __ATOMIC_SEQ_CST);
+}
+
+#endif
@@ -0,0 +1,150 @@
+import Foundation
+
+extension ChatMessage {
+    /// Binary content sent with a message: an image, or a PDF document
+    ///
+    /// Unlike `ContentPart.imageBase64`, the bytes are kept as they are and
+    /// base64-encoded straight into the request body when it's written, so no
+    /// base64 string or `data:` URL is built on the way. A file attachment is
+    /// memory-mapped rather than read, and large bodies are spooled to disk
+    /// and uploaded from there (see `LLMClient`).
+    public struct Attachment: Sendable, Equatable {
+        /// Where the bytes come from
+        public enum Source: Sendable, Equatable {
+            case data(Data)
+            case file(URL)
+        }
+
+        public let source: Source
+
+        /// MIME type, e.g. `image/png` or `application/pdf`
+        public let mediaType: String
+
+        /// Hash of the bytes of a `.data` attachment, computed once
+        private let digest: ResponseCacheKey?
+        /// Hash of a `.file` attachment's bytes, shared by its copies
+        private let fileDigest: FileDigest?
+
+        public init(data: Data, mediaType: String) {
+            self.source = .data(data)
+            self.mediaType = mediaType
+            self.digest = ResponseCacheKey(hashing: data)
+            self.fileDigest = nil
+        }
+
+        /// - Parameter mediaType: MIME type; by default inferred from the
+        ///   file extension
+        public init(fileURL: URL, mediaType: String? = nil) {
+            self.source = .file(fileURL)
+            self.mediaType = mediaType ?? Self.mediaType(forExtension: fileURL.pathExtension)
+            self.digest = nil
+            self.fileDigest = FileDigest()
+        }
+
+        public static func == (lhs: Attachment, rhs: Attachment) -> Bool {
+            lhs.source == rhs.source && lhs.mediaType == rhs.mediaType
+        }
+
+        /// Whether this is a PDF rather than an image
+        var isDocument: Bool {
+            mediaType == "application/pdf"
+        }
+
+        /// The bytes, memory-mapped for a file
+        func contents() throws -> Data {
+            switch source {
+            case .data(let data):
+                return data
+            case .file(let url):
+                do {
+                    return try Data(contentsOf: url, options: .alwaysMapped)
+                } catch {
+                    throw SwamlError.configurationError("Could not read attachment \(url.path): \(error.localizedDescription)")
+                }
+            }
+        }
+
+        /// Key of the bytes in the encoded attachment cache
+        func contentKey(of contents: Data) -> ResponseCacheKey {
+            if let digest = digest {
+                return digest
+            }
+            guard case .file(let url) = source, let fileDigest = fileDigest else {
+                return ResponseCacheKey(hashing: contents)
+            }
+            return fileDigest.key(of: url) { contents }
+        }
+
+        /// What stands in for the bytes in a response cache key
+        var cacheIdentity: String {
+            if let digest = digest {
+                return digest.description
+            }
+            guard case .file(let url) = source, let fileDigest = fileDigest,
+                  let key = try? fileDigest.key(of: url, contents: contents) else {
+                return String(describing: source)
+            }
+            return key.description
+        }
+
+        /// Length of the base64 encoding of `count` bytes
+        static func base64Length(of count: Int) -> Int {
+            (count + 2) / 3 * 4
+        }
+
+        static func mediaType(forExtension pathExtension: String) -> String {
+            switch pathExtension.lowercased() {
+            case "png": return "image/png"
+            case "jpg", "jpeg": return "image/jpeg"
+            case "gif": return "image/gif"
+            case "webp": return "image/webp"
+            case "pdf": return "application/pdf"
+            default: return "application/octet-stream"
+            }
+        }
+    }
+}
+
+// MARK: - File Digest
+
+/// Hash of a file attachment's bytes
+///
+/// A file attachment is hashed for the response cache key and again for the
+/// encoded attachment cache; this keeps the first hash for the second, and
+/// for later calls with the same attachment, for as long as the file's size
+/// and modification date stay the same.
+final class FileDigest: @unchecked Sendable {
+    private let lock = NSLock()
+    private var stamp: Stamp?
+    private var key: ResponseCacheKey?
+
+    private struct Stamp: Equatable {
+        let size: Int
+        let modified: Date
+    }
+
+    /// The hash of the file at `url`, from `contents` if the file has changed
+    func key(of url: URL, contents: () throws -> Data) rethrows -> ResponseCacheKey {
+        let current = Self.stamp(of: url)
+        lock.lock()
+        if let current = current, current == stamp, let key = key {
+            lock.unlock()
+            return key
+        }
+        lock.unlock()
+
+        let hashed = ResponseCacheKey(hashing: try contents())
+        lock.lock()
+        defer { lock.unlock() }
+        stamp = current
+        key = current == nil ? nil : hashed
+        return hashed
+    }
+
+    private static func stamp(of url: URL) -> Stamp? {
+        guard let attributes = try? FileManager.default.attributesOfItem(atPath: url.path),
+              let size = (attributes[.size] as? NSNumber)?.intValue,
+              let modified = attributes[.modificationDate] as? Date else { return nil }
+        return Stamp(size: size, modified: modified)
+    }
+}
@@ -5,19 +5,44 @@ public struct ChatMessage: Codable, Sendable, Equatable {
     public let role: Role
     public let content: Content
 
-    public init(role: Role, content: String) {
+    /// Whether this message ends a cacheable prefix
+    ///
+    /// Mark the last message of content that repeats verbatim across calls
+    /// (the rendered schema, fixed instructions, few-shot examples). The
+    /// provider can then reuse its processing of everything up to and
+    /// including this message: `LLMClient` sends an Anthropic `cache_control`
+    /// breakpoint here and a `prompt_cache_key` derived from the prefix to
+    /// OpenAI. Tokens served from the provider's cache are reported in
+    /// `LLMResponse.Usage.cachedPromptTokens`.
+    public let cacheable: Bool
+
+    /// Encoded forms kept across requests (see `withEncodings()`)
+    let encodings: MessageEncodings?
+
+    public init(role: Role, content: String, cacheable: Bool = false) {
         self.role = role
         self.content = .text(content)
+        self.cacheable = cacheable
+        self.encodings = nil
     }
 
-    public init(role: Role, content: Content) {
+    public init(role: Role, content: Content, cacheable: Bool = false) {
         self.role = role
         self.content = content
+        self.cacheable = cacheable
+        self.encodings = nil
+    }
+
+    private init(role: Role, content: Content, cacheable: Bool, encodings: MessageEncodings?) {
+        self.role = role
+        self.content = content
+        self.cacheable = cacheable
+        self.encodings = encodings
     }
 
     /// Creates a system message
-    public static func system(_ content: String) -> ChatMessage {
-        ChatMessage(role: .system, content: content)
+    public static func system(_ content: String, cacheable: Bool = false) -> ChatMessage {
+        ChatMessage(role: .system, content: content, cacheable: cacheable)
     }
 
     /// Creates a user message
@@ -25,10 +50,56 @@ public struct ChatMessage: Codable, Sendable, Equatable {
         ChatMessage(role: .user, content: content)
     }
 
+    /// Creates a user message with attachments after the text
+    public static func user(_ content: String, attachments: [Attachment]) -> ChatMessage {
+        ChatMessage(role: .user, content: .multipart([.text(content)] + attachments.map { .attachment($0) }))
+    }
+
     /// Creates an assistant message
     public static func assistant(_ content: String) -> ChatMessage {
         ChatMessage(role: .assistant, content: content)
     }
+
+    /// A copy of this message marked as the end of a cacheable prefix
+    public func markedCacheable(_ cacheable: Bool = true) -> ChatMessage {
+        ChatMessage(role: role, content: content, cacheable: cacheable)
+    }
+
+    /// A copy that keeps its request encodings, for messages sent many
+    /// times (a session's history); unchanged if it has attachments or
+    /// image URLs, which aren't encoded with the rest of the message
+    func withEncodings() -> ChatMessage {
+        if case .multipart(let parts) = content, parts.contains(where: \.isExternal) {
+            return self
+        }
+        return ChatMessage(role: role, content: content, cacheable: cacheable, encodings: MessageEncodings())
+    }
+
+    /// Messages are equal by role, content and `cacheable`
+    public static func == (lhs: ChatMessage, rhs: ChatMessage) -> Bool {
+        lhs.role == rhs.role && lhs.content == rhs.content && lhs.cacheable == rhs.cacheable
+    }
+
+    private enum CodingKeys: String, CodingKey {
+        case role, content, cacheable
+    }
+
+    public init(from decoder: Decoder) throws {
+        let container = try decoder.container(keyedBy: CodingKeys.self)
+        self.role = try container.decode(Role.self, forKey: .role)
+        self.content = try container.decode(Content.self, forKey: .content)
+        self.cacheable = try container.decodeIfPresent(Bool.self, forKey: .cacheable) ?? false
+        self.encodings = nil
+    }
+
+    public func encode(to encoder: Encoder) throws {
+        var container = encoder.container(keyedBy: CodingKeys.self)
+        try container.encode(role, forKey: .role)
+        try container.encode(content, forKey: .content)
+        if cacheable {
+            try container.encode(true, forKey: .cacheable)
+        }
+    }
 }
 
 extension ChatMessage {
@@ -84,6 +155,18 @@ extension ChatMessage {
         case text(String)
         case imageURL(URL)
         case imageBase64(data: String, mediaType: String)
+        case attachment(Attachment)
+
+        /// Whether the part's bytes come from elsewhere (an attachment or an
+        /// image URL) when the request is written
+        var isExternal: Bool {
+            switch self {
+            case .text, .imageBase64:
+                return false
+            case .imageURL, .attachment:
+                return true
+            }
+        }
 
         private enum CodingKeys: String, CodingKey {
             case type
@@ -122,6 +205,13 @@ extension ChatMessage {
                 let data = try sourceContainer.decode(String.self, forKey: .data)
                 let mediaType = try sourceContainer.decode(String.self, forKey: .mediaType)
                 self = .imageBase64(data: data, mediaType: mediaType)
+            case "document":
+                let sourceContainer = try container.nestedContainer(keyedBy: ImageBase64Keys.self, forKey: .source)
+                let mediaType = try sourceContainer.decode(String.self, forKey: .mediaType)
+                guard let data = Data(base64Encoded: try sourceContainer.decode(String.self, forKey: .data)) else {
+                    throw DecodingError.dataCorruptedError(forKey: .source, in: container, debugDescription: "Invalid base64 data")
+                }
+                self = .attachment(Attachment(data: data, mediaType: mediaType))
             default:
                 throw DecodingError.dataCorruptedError(forKey: .type, in: container, debugDescription: "Unknown content type: \(type)")
             }
@@ -144,6 +234,13 @@ extension ChatMessage {
                 try sourceContainer.encode("base64", forKey: .type)
                 try sourceContainer.encode(mediaType, forKey: .mediaType)
                 try sourceContainer.encode(data, forKey: .data)
+            case .attachment(let attachment):
+                // Images come back as `imageBase64`
+                try container.encode(attachment.isDocument ? "document" : "image", forKey: .type)
+                var sourceContainer = container.nestedContainer(keyedBy: ImageBase64Keys.self, forKey: .source)
+                try sourceContainer.encode("base64", forKey: .type)
+                try sourceContainer.encode(attachment.mediaType, forKey: .mediaType)
+                try sourceContainer.encode(try attachment.contents().base64EncodedString(), forKey: .data)
             }
         }
     }
@@ -0,0 +1,137 @@
+import Foundation
+#if canImport(FoundationNetworking)
+import FoundationNetworking
+#endif
+
+/// Settings for the sessions created by `HTTPTransport`
+public struct HTTPTransportConfiguration: Sendable {
+    /// Concurrent connections kept per host. HTTP/2 multiplexes requests over
+    /// these, so this mostly matters for HTTP/1.1 endpoints.
+    public var maxConnectionsPerHost: Int
+
+    /// Longest a request may sit idle waiting for data (in seconds)
+    public var requestTimeout: TimeInterval
+
+    /// Longest a whole request may take, including the response body (in seconds)
+    public var resourceTimeout: TimeInterval
+
+    public init(
+        maxConnectionsPerHost: Int = 64,
+        requestTimeout: TimeInterval = 120,
+        resourceTimeout: TimeInterval = 600
+    ) {
+        self.maxConnectionsPerHost = maxConnectionsPerHost
+        self.requestTimeout = requestTimeout
+        self.resourceTimeout = resourceTimeout
+    }
+
+    /// Default settings
+    public static let standard = HTTPTransportConfiguration()
+}
+
+/// Owns one long-lived `URLSession` per provider host.
+///
+/// `URLSession.shared` caps connections per host at a handful and is shared
+/// with the rest of the process, so at high concurrency requests queue behind
+/// its sockets. Each host here gets its own session with a larger pool, no
+/// caching or cookies, and connections that stay open between requests, so
+/// every `LLMClient` talking to the same host reuses warm TLS connections.
+public final class HTTPTransport: @unchecked Sendable {
+    /// Transport used by clients created without an explicit session
+    public static let shared = HTTPTransport()
+
+    public let configuration: HTTPTransportConfiguration
+
+    private let lock = NSLock()
+    private var sessions: [String: URLSession] = [:]
+
+    public init(configuration: HTTPTransportConfiguration = .standard) {
+        self.configuration = configuration
+    }
+
+    /// Session for a provider's host
+    public func session(for provider: LLMProvider) -> URLSession {
+        session(for: provider.baseURL)
+    }
+
+    /// Session for the host of a URL
+    public func session(for url: URL) -> URLSession {
+        let key = Self.hostKey(for: url)
+
+        lock.lock()
+        defer { lock.unlock() }
+
+        if let existing = sessions[key] {
+            return existing
+        }
+        let session = URLSession(configuration: makeSessionConfiguration())
+        sessions[key] = session
+        return session
+    }
+
+    /// Open a connection to the provider's host ahead of the first request
+    ///
+    /// Sends a `HEAD` to the API base URL so DNS, TCP and TLS are done before
+    /// real traffic arrives. The response (usually 404 or 401) is ignored, as
+    /// are failures; the connection stays in the session's pool.
+    public func warmUp(_ provider: LLMProvider) async {
+        var request = URLRequest(url: provider.baseURL)
+        request.httpMethod = "HEAD"
+        request.timeoutInterval = 10
+        _ = try? await session(for: provider).data(for: request)
+    }
+
+    /// `scheme://host:port`, so equivalent URLs share a session
+    static func hostKey(for url: URL) -> String {
+        let scheme = url.scheme?.lowercased() ?? "https"
+        let host = url.host?.lowercased() ?? ""
+        let port = url.port ?? (scheme == "http" ? 80 : 443)
+        return "\(scheme)://\(host):\(port)"
+    }
+
+    private func makeSessionConfiguration() -> URLSessionConfiguration {
+        let config = URLSessionConfiguration.ephemeral
+        config.httpMaximumConnectionsPerHost = configuration.maxConnectionsPerHost
+        config.timeoutIntervalForRequest = configuration.requestTimeout
+        config.timeoutIntervalForResource = configuration.resourceTimeout
+        config.requestCachePolicy = .reloadIgnoringLocalCacheData
+        config.urlCache = nil
+        config.httpShouldSetCookies = false
+        config.httpCookieAcceptPolicy = .never
+        #if !canImport(FoundationNetworking)
+        config.waitsForConnectivity = false
+        #endif
+        return config
+    }
+}
+
+// MARK: - Deadlines
+
+/// Run an operation, failing with `SwamlError.timeout` if it outlasts `timeout`
+///
+/// The operation is cancelled when the deadline passes, which cancels any
+/// request it has in flight. A nil timeout runs it without a deadline.
+func withDeadline<T: Sendable>(
+    _ timeout: TimeInterval?,
+    operation: @escaping @Sendable () async throws -> T
+) async throws -> T {
+    guard let timeout = timeout else {
+        return try await operation()
+    }
+
+    return try await withThrowingTaskGroup(of: T.self) { group in
+        group.addTask {
+            try await operation()
+        }
+        group.addTask {
+            try await Task.sleep(nanoseconds: UInt64(max(0, timeout) * 1_000_000_000))
+            throw SwamlError.timeout(seconds: timeout)
+        }
+        defer { group.cancelAll() }
+
+        guard let result = try await group.next() else {
+            throw CancellationError()
+        }
+        return result
+    }
+}
@@ -0,0 +1,269 @@
+import Foundation
+
+/// A JSON value that has already been encoded, for splicing into request bodies
+struct EncodedJSON: Sendable, Equatable {
+    let bytes: [UInt8]
+
+    /// Encode a string literal
+    init(string: String) {
+        var writer = JSONBodyWriter(capacity: string.utf8.count + 2)
+        writer.value(string)
+        self.bytes = writer.bytes
+    }
+
+    /// Encode a JSON-compatible value (`[String: Any]`, `[Any]`, strings, numbers, ...)
+    init(any value: Any) {
+        var writer = JSONBodyWriter()
+        writer.value(any: value)
+        self.bytes = writer.bytes
+    }
+
+    /// Wrap bytes that are already one complete JSON value
+    init(bytes: [UInt8]) {
+        self.bytes = bytes
+    }
+}
+
+/// Encoded forms of one message, reused by every request it's sent in
+///
+/// `SwamlSession` attaches one to each message of its history, so a turn
+/// only encodes the messages added since the previous one; the rest of the
+/// body is spliced in. Messages with attachments don't get one (their
+/// base64 is encoded when the body is assembled).
+final class MessageEncodings: @unchecked Sendable {
+    /// Request format a message was encoded in
+    enum Format: Hashable {
+        case openAI
+        /// Anthropic, with or without a `cache_control` breakpoint
+        case anthropic(cacheControl: Bool)
+    }
+
+    private let lock = NSLock()
+    private var encoded: [Format: EncodedJSON] = [:]
+
+    /// Number of stored encodings
+    var count: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return encoded.count
+    }
+
+    /// The message in `format`, written by `encode` the first time
+    func encoding(_ format: Format, encode: (inout JSONBodyWriter) -> Void) -> EncodedJSON {
+        lock.lock()
+        if let cached = encoded[format] {
+            lock.unlock()
+            return cached
+        }
+        lock.unlock()
+
+        var writer = JSONBodyWriter(capacity: 256)
+        encode(&writer)
+        let encoding = EncodedJSON(bytes: writer.bytes)
+
+        lock.lock()
+        encoded[format] = encoding
+        lock.unlock()
+        return encoding
+    }
+}
+
+/// Writes a JSON document straight into a byte buffer.
+///
+/// Request bodies are built with this instead of a `[String: Any]` tree and
+/// `JSONSerialization`: values are escaped as they're appended, nothing is
+/// boxed, and parts that are the same on every call (system prompts, schemas)
+/// can be spliced in from an `EncodedJSON`. Object keys of `value(any:)`
+/// dictionaries are sorted so identical input gives identical bytes.
+///
+/// Attachments are only marked in `bytes`: `RequestBody` encodes them in when
+/// the body is assembled, so `bytes` and `data` are the body without them.
+struct JSONBodyWriter: Sendable {
+    private(set) var bytes: [UInt8] = []
+
+    /// Attachments whose base64 goes at an offset of `bytes`, in order
+    private(set) var attachments: [(offset: Int, attachment: ChatMessage.Attachment)] = []
+
+    /// Whether the innermost open container has no elements yet
+    private var isFirst: [Bool] = []
+
+    /// Whether a key was just written, so the next value needs no separator
+    private var afterKey = false
+
+    init(capacity: Int = 1024) {
+        bytes.reserveCapacity(capacity)
+    }
+
+    var data: Data {
+        Data(bytes)
+    }
+
+    // MARK: Containers
+
+    mutating func beginObject() {
+        separate()
+        bytes.append(UInt8(ascii: "{"))
+        isFirst.append(true)
+    }
+
+    mutating func endObject() {
+        isFirst.removeLast()
+        bytes.append(UInt8(ascii: "}"))
+    }
+
+    mutating func beginArray() {
+        separate()
+        bytes.append(UInt8(ascii: "["))
+        isFirst.append(true)
+    }
+
+    mutating func endArray() {
+        isFirst.removeLast()
+        bytes.append(UInt8(ascii: "]"))
+    }
+
+    /// Write an object key; the next call writes its value
+    mutating func key(_ key: String) {
+        separate()
+        appendString(key)
+        bytes.append(UInt8(ascii: ":"))
+        afterKey = true
+    }
+
+    // MARK: Values
+
+    mutating func value(_ string: String) {
+        separate()
+        appendString(string)
+    }
+
+    mutating func value(_ int: Int) {
+        separate()
+        bytes.append(contentsOf: String(int).utf8)
+    }
+
+    mutating func value(_ double: Double) {
+        separate()
+        if double.isFinite {
+            bytes.append(contentsOf: double.description.utf8)
+        } else {
+            bytes.append(contentsOf: "null".utf8)
+        }
+    }
+
+    mutating func value(_ bool: Bool) {
+        separate()
+        bytes.append(contentsOf: (bool ? "true" : "false").utf8)
+    }
+
+    mutating func null() {
+        separate()
+        bytes.append(contentsOf: "null".utf8)
+    }
+
+    /// Splice in an already-encoded value
+    mutating func value(_ encoded: EncodedJSON) {
+        separate()
+        bytes.append(contentsOf: encoded.bytes)
+    }
+
+    /// Write a string of `prefix` followed by the base64 of an attachment
+    mutating func value(_ attachment: ChatMessage.Attachment, prefix: String = "") {
+        separate()
+        appendString(prefix)
+        // Base64 never needs escaping, so it goes between the quotes as is
+        bytes.removeLast()
+        attachments.append((offset: bytes.count, attachment: attachment))
+        bytes.append(UInt8(ascii: "\""))
+    }
+
+    /// Write a JSON-compatible value of unknown type
+    mutating func value(any: Any) {
+        switch any {
+        case let string as String:
+            value(string)
+        // Exact type checks: on Apple platforms an NSNumber (as produced by
+        // JSONSerialization) casts to Bool, Int and Double alike
+        case let bool as Bool where type(of: any) == Bool.self:
+            value(bool)
+        case let int as Int where type(of: any) == Int.self:
+            value(int)
+        case let double as Double where type(of: any) == Double.self:
+            value(double)
+        case let float as Float where type(of: any) == Float.self:
+            value(Double(float))
+        case let encoded as EncodedJSON:
+            value(encoded)
+        case let dict as [String: Any]:
+            beginObject()
+            for key in dict.keys.sorted() {
+                self.key(key)
+                value(any: dict[key]!)
+            }
+            endObject()
+        case let array as [Any]:
+            beginArray()
+            for element in array {
+                value(any: element)
+            }
+            endArray()
+        case let number as NSNumber:
+            if String(cString: number.objCType) == "c" {
+                value(number.boolValue)
+            } else {
+                separate()
+                bytes.append(contentsOf: number.stringValue.utf8)
+            }
+        default:
+            null()
+        }
+    }
+
+    // MARK: Encoding
+
+    /// Write the separator a new element needs
+    private mutating func separate() {
+        if afterKey {
+            afterKey = false
+            return
+        }
+        guard let first = isFirst.last else { return }
+        if first {
+            isFirst[isFirst.count - 1] = false
+        } else {
+            bytes.append(UInt8(ascii: ","))
+        }
+    }
+
+    private mutating func appendString(_ string: String) {
+        bytes.append(UInt8(ascii: "\""))
+        for byte in string.utf8 {
+            switch byte {
+            case UInt8(ascii: "\""):
+                bytes.append(UInt8(ascii: "\\"))
+                bytes.append(UInt8(ascii: "\""))
+            case UInt8(ascii: "\\"):
+                bytes.append(UInt8(ascii: "\\"))
+                bytes.append(UInt8(ascii: "\\"))
+            case 0x0A:
+                bytes.append(UInt8(ascii: "\\"))
+                bytes.append(UInt8(ascii: "n"))
+            case 0x0D:
+                bytes.append(UInt8(ascii: "\\"))
+                bytes.append(UInt8(ascii: "r"))
+            case 0x09:
+                bytes.append(UInt8(ascii: "\\"))
+                bytes.append(UInt8(ascii: "t"))
+            case 0x00..<0x20:
+                bytes.append(contentsOf: "\\u00".utf8)
+                bytes.append(Self.hexDigits[Int(byte >> 4)])
+                bytes.append(Self.hexDigits[Int(byte & 0x0F)])
+            default:
+                bytes.append(byte)
+            }
+        }
+        bytes.append(UInt8(ascii: "\""))
+    }
+
+    private static let hexDigits: [UInt8] = Array("0123456789abcdef".utf8)
+}
@@ -0,0 +1,538 @@
+import Foundation
+#if canImport(FoundationNetworking)
+import FoundationNetworking
+#endif
+
+// MARK: - Batch Types
+
+/// One request of a provider batch
+public struct LLMBatchRequest: Sendable {
+    /// Identifier echoed back with the result (unique within the batch)
+    public let customId: String
+    public let model: String
+    public let messages: [ChatMessage]
+    public let responseFormat: ResponseFormat?
+    public let temperature: Double?
+    public let maxTokens: Int?
+
+    public init(
+        customId: String,
+        model: String,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat? = nil,
+        temperature: Double? = nil,
+        maxTokens: Int? = nil
+    ) {
+        self.customId = customId
+        self.model = model
+        self.messages = messages
+        self.responseFormat = responseFormat
+        self.temperature = temperature
+        self.maxTokens = maxTokens
+    }
+}
+
+/// A batch submitted to a provider's asynchronous batch API
+public struct LLMBatchJob: Sendable, Equatable {
+    /// Processing state, unified across providers
+    public enum Status: String, Sendable {
+        case validating
+        case inProgress = "in_progress"
+        case finalizing
+        case completed
+        case failed
+        case expired
+        case cancelling
+        case cancelled
+
+        /// Whether the provider has stopped processing the batch
+        public var isFinished: Bool {
+            switch self {
+            case .completed, .failed, .expired, .cancelled:
+                return true
+            case .validating, .inProgress, .finalizing, .cancelling:
+                return false
+            }
+        }
+    }
+
+    public let id: String
+    public let status: Status
+
+    /// Requests that have finished successfully so far
+    public let succeededCount: Int
+
+    /// Requests that have failed (or expired) so far
+    public let failedCount: Int
+
+    /// OpenAI: file with the successful results
+    public let outputFileId: String?
+
+    /// OpenAI: file with the failed requests
+    public let errorFileId: String?
+
+    /// Anthropic: where the results can be downloaded
+    public let resultsURL: URL?
+
+    public init(
+        id: String,
+        status: Status,
+        succeededCount: Int = 0,
+        failedCount: Int = 0,
+        outputFileId: String? = nil,
+        errorFileId: String? = nil,
+        resultsURL: URL? = nil
+    ) {
+        self.id = id
+        self.status = status
+        self.succeededCount = succeededCount
+        self.failedCount = failedCount
+        self.outputFileId = outputFileId
+        self.errorFileId = errorFileId
+        self.resultsURL = resultsURL
+    }
+}
+
+/// Result of one request of a provider batch
+public struct LLMBatchResult: Sendable {
+    /// The request's `customId`
+    public let customId: String
+
+    /// The response, or the error the request failed with
+    public let result: Result<LLMResponse, Error>
+}
+
+// MARK: - Batch API
+
+extension LLMClient {
+    /// Submit requests to the provider's batch API
+    ///
+    /// The requests are serialized one at a time to a temporary file that is
+    /// then uploaded, so large batches aren't held in memory as one body.
+    /// OpenAI-compatible providers get a JSONL file for `/batches`; Anthropic
+    /// gets a Message Batches request.
+    ///
+    /// Creating a batch isn't idempotent: a request that times out may still
+    /// have created (and will bill) a batch. So only the OpenAI file upload
+    /// is retried per `retryPolicy`; the request creating the batch is only
+    /// retried when the provider rejects it as rate limited (429).
+    public func submitBatch(_ requests: [LLMBatchRequest], retryPolicy: RetryPolicy = .none) async throws -> LLMBatchJob {
+        guard provider.supportsBatchAPI else {
+            throw SwamlError.configurationError("Provider has no batch API")
+        }
+        guard !requests.isEmpty else {
+            throw SwamlError.configurationError("Batch has no requests")
+        }
+
+        if provider.isOpenAICompatible {
+            return try await submitOpenAIBatch(requests, retryPolicy: retryPolicy)
+        } else {
+            return try await submitAnthropicBatch(requests, retryPolicy: retryPolicy)
+        }
+    }
+
+    /// Fetch the current state of a batch
+    public func batchStatus(_ id: String) async throws -> LLMBatchJob {
+        if provider.isOpenAICompatible {
+            let request = batchRequest(provider.baseURL.appendingPathComponent("batches/\(id)"))
+            return try await send(request, decoding: OpenAIBatchObject.self).job
+        } else {
+            let request = batchRequest(provider.baseURL.appendingPathComponent("messages/batches/\(id)"))
+            return try await send(request, decoding: AnthropicBatchObject.self).job
+        }
+    }
+
+    /// Ask the provider to stop processing a batch
+    public func cancelBatch(_ id: String) async throws -> LLMBatchJob {
+        if provider.isOpenAICompatible {
+            let request = batchRequest(provider.baseURL.appendingPathComponent("batches/\(id)/cancel"), method: "POST")
+            return try await send(request, decoding: OpenAIBatchObject.self).job
+        } else {
+            let request = batchRequest(provider.baseURL.appendingPathComponent("messages/batches/\(id)/cancel"), method: "POST")
+            return try await send(request, decoding: AnthropicBatchObject.self).job
+        }
+    }
+
+    /// Stream the results of a finished batch
+    ///
+    /// Result files are parsed line by line as they download. Results arrive
+    /// in the provider's order, not submission order; match them up by
+    /// `customId`.
+    public nonisolated func batchResults(_ job: LLMBatchJob) -> AsyncThrowingStream<LLMBatchResult, Error> {
+        AsyncThrowingStream { continuation in
+            let task = Task {
+                do {
+                    try await self.readBatchResults(job, continuation: continuation)
+                    continuation.finish()
+                } catch {
+                    continuation.finish(throwing: error)
+                }
+            }
+            continuation.onTermination = { _ in
+                task.cancel()
+            }
+        }
+    }
+
+    // MARK: - OpenAI
+
+    private func submitOpenAIBatch(_ requests: [LLMBatchRequest], retryPolicy: RetryPolicy) async throws -> LLMBatchJob {
+        let boundary = "swaml-\(UUID().uuidString)"
+        let file = try UploadFile(prefix: "swaml-batch")
+
+        try file.write("--\(boundary)\r\n")
+        try file.write("Content-Disposition: form-data; name=\"purpose\"\r\n\r\nbatch\r\n")
+        try file.write("--\(boundary)\r\n")
+        try file.write("Content-Disposition: form-data; name=\"file\"; filename=\"batch.jsonl\"\r\n")
+        try file.write("Content-Type: application/jsonl\r\n\r\n")
+
+        for request in requests {
+            var writer = JSONBodyWriter(capacity: Self.estimatedBodySize(request.messages) + 128)
+            writer.beginObject()
+            writer.key("custom_id")
+            writer.value(request.customId)
+            writer.key("method")
+            writer.value("POST")
+            writer.key("url")
+            writer.value("/v1/chat/completions")
+            writer.key("body")
+            writeOpenAIRequestBody(
+                into: &writer,
+                model: request.model,
+                messages: request.messages,
+                responseFormat: request.responseFormat,
+                temperature: request.temperature,
+                maxTokens: request.maxTokens,
+                topP: nil,
+                stop: nil
+            )
+            writer.endObject()
+            try RequestBody.write(writer, to: file)
+            try file.write("\n")
+        }
+
+        try file.write("\r\n--\(boundary)--\r\n")
+        try file.close()
+
+        var upload = batchRequest(provider.baseURL.appendingPathComponent("files"), method: "POST")
+        upload.setValue("multipart/form-data; boundary=\(boundary)", forHTTPHeaderField: "Content-Type")
+        // Uploading again only leaves an unused file behind
+        let fileURL = file.url
+        let uploadedData = try await RetryExecutor(policy: retryPolicy).execute { [upload] in
+            try await self.send(upload, fromFile: fileURL)
+        }
+        let uploaded = try JSONDecoder().decode(OpenAIFileObject.self, from: uploadedData)
+
+        var create = batchRequest(provider.baseURL.appendingPathComponent("batches"), method: "POST")
+        create.setValue("application/json", forHTTPHeaderField: "Content-Type")
+        create.httpBody = try JSONSerialization.data(withJSONObject: [
+            "input_file_id": uploaded.id,
+            "endpoint": "/v1/chat/completions",
+            "completion_window": "24h"
+        ])
+        let created = try await createBatch(retryPolicy: retryPolicy) { [create] in
+            try await self.send(create, decoding: OpenAIBatchObject.self)
+        }
+        return created.job
+    }
+
+    // MARK: - Anthropic
+
+    private func submitAnthropicBatch(_ requests: [LLMBatchRequest], retryPolicy: RetryPolicy) async throws -> LLMBatchJob {
+        let file = try UploadFile(prefix: "swaml-batch")
+
+        try file.write("{\"requests\":[")
+        for (index, request) in requests.enumerated() {
+            let messages = try await fetchingImageURLs(request.messages)
+            var writer = JSONBodyWriter(capacity: Self.estimatedBodySize(messages) + 64)
+            writer.beginObject()
+            writer.key("custom_id")
+            writer.value(request.customId)
+            writer.key("params")
+            writeAnthropicRequestBody(
+                into: &writer,
+                model: request.model,
+                messages: messages,
+                temperature: request.temperature,
+                maxTokens: request.maxTokens ?? 4096,
+                topP: nil,
+                stop: nil
+            )
+            writer.endObject()
+
+            if index > 0 {
+                try file.write(",")
+            }
+            try RequestBody.write(writer, to: file)
+        }
+        try file.write("]}")
+        try file.close()
+
+        var create = batchRequest(provider.baseURL.appendingPathComponent("messages/batches"), method: "POST")
+        create.setValue("application/json", forHTTPHeaderField: "Content-Type")
+        let fileURL = file.url
+        let data = try await createBatch(retryPolicy: retryPolicy) { [create] in
+            try await self.send(create, fromFile: fileURL)
+        }
+        return try JSONDecoder().decode(AnthropicBatchObject.self, from: data).job
+    }
+
+    /// Send the request creating a batch, retrying it only while the provider
+    /// rate-limits it: a 429 proves no batch was created, a timeout or a 5xx
+    /// doesn't
+    private func createBatch<T>(
+        retryPolicy: RetryPolicy,
+        _ operation: @Sendable () async throws -> T
+    ) async throws -> T {
+        var attempt = 0
+        while true {
+            do {
+                return try await operation()
+            } catch SwamlError.apiError(statusCode: 429, _) where attempt < retryPolicy.maxRetries {
+                CallTrace.record { $0.retries += 1 }
+                try await Task.sleep(nanoseconds: UInt64(retryPolicy.delayForAttempt(attempt) * 1_000_000_000))
+                attempt += 1
+            }
+        }
+    }
+
+    // MARK: - Results
+
+    private func readBatchResults(
+        _ job: LLMBatchJob,
+        continuation: AsyncThrowingStream<LLMBatchResult, Error>.Continuation
+    ) async throws {
+        guard job.status.isFinished else {
+            throw SwamlError.configurationError("Batch \(job.id) is still \(job.status.rawValue)")
+        }
+
+        var downloads: [URLRequest] = []
+        if provider.isOpenAICompatible {
+            for fileId in [job.outputFileId, job.errorFileId].compactMap({ $0 }) {
+                downloads.append(batchRequest(provider.baseURL.appendingPathComponent("files/\(fileId)/content")))
+            }
+        } else if let resultsURL = job.resultsURL {
+            downloads.append(batchRequest(resultsURL))
+        }
+
+        let decoder = LLMBatchDecoder(provider: provider)
+        for request in downloads {
+            try await forEachLine(of: request) { line in
+                if let result = try decoder.decode(line: line) {
+                    continuation.yield(result)
+                }
+                return true
+            }
+        }
+    }
+
+    // MARK: - Requests
+
+    private func batchRequest(_ url: URL, method: String = "GET") -> URLRequest {
+        var request = URLRequest(url: url)
+        request.httpMethod = method
+
+        let auth = provider.authHeader
+        request.setValue(auth.value, forHTTPHeaderField: auth.name)
+
+        for (key, value) in provider.additionalHeaders {
+            request.setValue(value, forHTTPHeaderField: key)
+        }
+        return request
+    }
+
+    private func send<T: Decodable>(_ request: URLRequest, decoding type: T.Type) async throws -> T {
+        let (data, response) = try await session.data(for: request)
+        try Self.validate(response, body: data)
+        return try JSONDecoder().decode(T.self, from: data)
+    }
+
+    /// Upload a request body from disk
+    private func send(_ request: URLRequest, fromFile fileURL: URL) async throws -> Data {
+        #if canImport(FoundationNetworking)
+        // swift-corelibs-foundation has no async file upload
+        var request = request
+        request.httpBody = try Data(contentsOf: fileURL)
+        let (data, response) = try await session.data(for: request)
+        #else
+        let (data, response) = try await session.upload(for: request, fromFile: fileURL)
+        #endif
+        try Self.validate(response, body: data)
+        return data
+    }
+}
+
+// MARK: - Result Decoding
+
+/// Decodes the lines of a provider's batch result file
+struct LLMBatchDecoder {
+    let provider: LLMProvider
+
+    /// Decode one line of a result file
+    ///
+    /// - Returns: The result, or nil for blank lines
+    func decode(line: String) throws -> LLMBatchResult? {
+        let trimmed = line.trimmingCharacters(in: .whitespaces)
+        guard !trimmed.isEmpty else { return nil }
+
+        let data = Data(trimmed.utf8)
+        if provider.isOpenAICompatible {
+            let entry = try JSONDecoder().decode(OpenAIBatchResultLine.self, from: data)
+            return LLMBatchResult(customId: entry.customId, result: Result { try entry.response() })
+        } else {
+            let entry = try JSONDecoder().decode(AnthropicBatchResultLine.self, from: data)
+            return LLMBatchResult(customId: entry.customId, result: Result { try entry.response() })
+        }
+    }
+}
+
+// MARK: - OpenAI Batch Structures
+
+struct OpenAIFileObject: Codable {
+    let id: String
+}
+
+struct OpenAIBatchObject: Codable {
+    let id: String
+    let status: String
+    let outputFileId: String?
+    let errorFileId: String?
+    let requestCounts: RequestCounts?
+
+    private enum CodingKeys: String, CodingKey {
+        case id, status
+        case outputFileId = "output_file_id"
+        case errorFileId = "error_file_id"
+        case requestCounts = "request_counts"
+    }
+
+    struct RequestCounts: Codable {
+        let total: Int
+        let completed: Int
+        let failed: Int
+    }
+
+    var job: LLMBatchJob {
+        LLMBatchJob(
+            id: id,
+            status: LLMBatchJob.Status(rawValue: status) ?? .inProgress,
+            succeededCount: requestCounts?.completed ?? 0,
+            failedCount: requestCounts?.failed ?? 0,
+            outputFileId: outputFileId,
+            errorFileId: errorFileId
+        )
+    }
+}
+
+struct OpenAIBatchResultLine: Codable {
+    let customId: String
+    let response: Response?
+    let error: BatchError?
+
+    private enum CodingKeys: String, CodingKey {
+        case customId = "custom_id"
+        case response, error
+    }
+
+    struct Response: Codable {
+        let statusCode: Int
+        let body: SwamlValue?
+
+        private enum CodingKeys: String, CodingKey {
+            case statusCode = "status_code"
+            case body
+        }
+    }
+
+    struct BatchError: Codable {
+        let code: String?
+        let message: String?
+    }
+
+    func response() throws -> LLMResponse {
+        if let error = error {
+            throw SwamlError.apiError(statusCode: response?.statusCode ?? 0, message: error.message ?? error.code ?? "Unknown error")
+        }
+        guard let response = response, let body = response.body else {
+            throw SwamlError.parseError("No response for batch request \(customId)")
+        }
+        guard (200...299).contains(response.statusCode) else {
+            let message = body["error"]?["message"]?.stringValue ?? body.description
+            throw SwamlError.apiError(statusCode: response.statusCode, message: message)
+        }
+        return try SwamlValueDecoder().decode(OpenAICompletionResponse.self, from: body).toLLMResponse()
+    }
+}
+
+// MARK: - Anthropic Batch Structures
+
+struct AnthropicBatchObject: Codable {
+    let id: String
+    let processingStatus: String
+    let requestCounts: RequestCounts?
+    let resultsUrl: String?
+
+    private enum CodingKeys: String, CodingKey {
+        case id
+        case processingStatus = "processing_status"
+        case requestCounts = "request_counts"
+        case resultsUrl = "results_url"
+    }
+
+    struct RequestCounts: Codable {
+        let processing: Int
+        let succeeded: Int
+        let errored: Int
+        let canceled: Int
+        let expired: Int
+    }
+
+    var job: LLMBatchJob {
+        let status: LLMBatchJob.Status
+        switch processingStatus {
+        case "ended": status = .completed
+        case "canceling": status = .cancelling
+        default: status = .inProgress
+        }
+
+        return LLMBatchJob(
+            id: id,
+            status: status,
+            succeededCount: requestCounts?.succeeded ?? 0,
+            failedCount: requestCounts.map { $0.errored + $0.canceled + $0.expired } ?? 0,
+            resultsURL: resultsUrl.flatMap { URL(string: $0) }
+        )
+    }
+}
+
+struct AnthropicBatchResultLine: Codable {
+    let customId: String
+    let result: Outcome
+
+    private enum CodingKeys: String, CodingKey {
+        case customId = "custom_id"
+        case result
+    }
+
+    struct Outcome: Codable {
+        let type: String
+        let message: SwamlValue?
+        let error: SwamlValue?
+    }
+
+    func response() throws -> LLMResponse {
+        switch result.type {
+        case "succeeded":
+            guard let message = result.message else {
+                throw SwamlError.parseError("No message for batch request \(customId)")
+            }
+            return try SwamlValueDecoder().decode(AnthropicCompletionResponse.self, from: message).toLLMResponse
+        case "errored":
+            let message = result.error?["error"]?["message"]?.stringValue ?? "Unknown error"
+            throw SwamlError.apiError(statusCode: 0, message: message)
+        default:
+            // canceled or expired
+            throw SwamlError.networkError("Batch request \(customId) \(result.type)")
+        }
+    }
+}
@@ -6,11 +6,23 @@ import FoundationNetworking
 /// HTTP client for making requests to LLM APIs
 public actor LLMClient {
     public let provider: LLMProvider
-    private let session: URLSession
+    let session: URLSession
 
-    public init(provider: LLMProvider, session: URLSession? = nil) {
+    /// Admission control applied before each request, fed by response headers
+    public let rateLimiter: RateLimiter?
+
+    /// Encoded system prompts, by text
+    private var encodedSystemPrompts: [String: EncodedJSON] = [:]
+
+    /// Downloads of image URLs sent to Anthropic, by URL
+    private var fetchedImages: [URL: Task<ChatMessage.Attachment, Error>] = [:]
+
+    /// - Parameter session: Session to send requests on; by default the
+    ///   shared `HTTPTransport` session for the provider's host
+    public init(provider: LLMProvider, session: URLSession? = nil, rateLimiter: RateLimiter? = nil) {
         self.provider = provider
-        self.session = session ?? URLSession.shared
+        self.session = session ?? HTTPTransport.shared.session(for: provider)
+        self.rateLimiter = rateLimiter
     }
 
     /// Send a chat completion request to the LLM
@@ -23,26 +35,391 @@ public actor LLMClient {
         topP: Double? = nil,
         stop: [String]? = nil
     ) async throws -> LLMResponse {
+        try await complete(
+            model: model,
+            messages: messages,
+            responseFormat: responseFormat,
+            encodedSchema: nil,
+            temperature: temperature,
+            maxTokens: maxTokens,
+            topP: topP,
+            stop: stop
+        )
+    }
+
+    /// Send a chat completion request
+    ///
+    /// - Parameter encodedSchema: Pre-encoded `schema` of a `.jsonSchema` response
+    ///   format, spliced into the body instead of encoding the dictionary again
+    func complete(
+        model: String,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat?,
+        encodedSchema: EncodedJSON?,
+        temperature: Double? = nil,
+        maxTokens: Int? = nil,
+        topP: Double? = nil,
+        stop: [String]? = nil
+    ) async throws -> LLMResponse {
+        let maxTokens = completionBudget(maxTokens)
+        let estimatedTokens = Self.estimatedTokens(messages: messages, maxTokens: maxTokens)
+        if let rateLimiter = rateLimiter {
+            try await CallTrace.measure(.rateLimit) {
+                try await rateLimiter.acquire(estimatedTokens: estimatedTokens)
+            }
+        }
+
+        let response: LLMResponse
         if provider.isOpenAICompatible {
-            return try await completeOpenAI(
+            response = try await completeOpenAI(
                 model: model,
                 messages: messages,
                 responseFormat: responseFormat,
+                encodedSchema: encodedSchema,
                 temperature: temperature,
                 maxTokens: maxTokens,
                 topP: topP,
                 stop: stop
             )
         } else {
-            return try await completeAnthropic(
+            response = try await completeAnthropic(
                 model: model,
-                messages: messages,
+                messages: try await fetchingImageURLs(messages),
+                responseFormat: responseFormat,
+                encodedSchema: encodedSchema,
                 temperature: temperature,
-                maxTokens: maxTokens ?? 4096,
+                maxTokens: maxTokens ?? Self.defaultAnthropicMaxTokens,
                 topP: topP,
                 stop: stop
             )
         }
+
+        if let usage = response.usage {
+            await rateLimiter?.settle(estimatedTokens: estimatedTokens, actualTokens: usage.totalTokens)
+            CallTrace.record {
+                $0.promptTokens += usage.promptTokens
+                $0.completionTokens += usage.completionTokens
+                $0.cachedPromptTokens += usage.cachedPromptTokens ?? 0
+            }
+        }
+        return response
+    }
+
+    // MARK: - Continuation
+
+    /// Send a completion, continuing JSON output cut off by the token limit
+    ///
+    /// While the response stops at the token limit with its JSON still open,
+    /// the output so far is sent back as the assistant's turn and the model is
+    /// asked to carry on from where it stopped, up to `maxContinuations`
+    /// times. The pieces are stitched with `JSONContinuation`, so the tokens
+    /// already generated are kept rather than paid for again. Anthropic
+    /// continues a trailing assistant message directly (prefill); other
+    /// providers are asked to continue in a follow-up user message. Either way
+    /// the response format is dropped: a continuation isn't a JSON document
+    /// itself, and Anthropic can't be prefilled into a forced tool call.
+    ///
+    /// The returned response has the stitched content, the summed usage and
+    /// the finish reason of the last request.
+    func complete(
+        model: String,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat?,
+        encodedSchema: EncodedJSON?,
+        temperature: Double?,
+        maxTokens: Int?,
+        maxContinuations: Int
+    ) async throws -> LLMResponse {
+        var response = try await complete(
+            model: model,
+            messages: messages,
+            responseFormat: responseFormat,
+            encodedSchema: encodedSchema,
+            temperature: temperature,
+            maxTokens: maxTokens
+        )
+        guard maxContinuations > 0, response.finishReason?.isTruncation == true else {
+            return response
+        }
+
+        let first = response
+        var output = JSONContinuation(response.content)
+        var usage = response.usage
+        var continuations = 0
+        while continuations < maxContinuations,
+              response.finishReason?.isTruncation == true,
+              output.hasStarted, !output.isComplete {
+            continuations += 1
+            CallTrace.record { $0.continuations += 1 }
+
+            response = try await complete(
+                model: model,
+                messages: continuationMessages(messages, output: output),
+                responseFormat: nil,
+                encodedSchema: nil,
+                temperature: temperature,
+                maxTokens: maxTokens
+            )
+            output.append(response.content)
+            usage = Self.adding(usage, response.usage)
+        }
+
+        return LLMResponse(
+            content: output.text,
+            model: first.model,
+            usage: usage,
+            finishReason: response.finishReason,
+            id: first.id
+        )
+    }
+
+    /// The conversation asking the model to continue `output`
+    private func continuationMessages(_ messages: [ChatMessage], output: JSONContinuation) -> [ChatMessage] {
+        guard provider.isOpenAICompatible else {
+            // Anthropic rejects a final assistant turn ending in whitespace
+            let prefill = output.text.replacingOccurrences(of: "\\s+$", with: "", options: .regularExpression)
+            return messages + [.assistant(prefill)]
+        }
+        return messages + [
+            .assistant(output.text),
+            .user("""
+                Your response was cut off. Continue it from exactly where it stopped, \
+                inside \(output.openContext). Output only the remaining text: don't repeat \
+                anything already written, and don't add commentary or code fences.
+                """)
+        ]
+    }
+
+    private static func adding(_ a: LLMResponse.Usage?, _ b: LLMResponse.Usage?) -> LLMResponse.Usage? {
+        guard let a = a else { return b }
+        guard let b = b else { return a }
+        func sum(_ x: Int?, _ y: Int?) -> Int? {
+            x == nil && y == nil ? nil : (x ?? 0) + (y ?? 0)
+        }
+        return LLMResponse.Usage(
+            promptTokens: a.promptTokens + b.promptTokens,
+            completionTokens: a.completionTokens + b.completionTokens,
+            totalTokens: a.totalTokens + b.totalTokens,
+            cachedPromptTokens: sum(a.cachedPromptTokens, b.cachedPromptTokens),
+            cacheCreationTokens: sum(a.cacheCreationTokens, b.cacheCreationTokens)
+        )
+    }
+
+    /// Stream a chat completion from the LLM as server-sent events
+    ///
+    /// Each chunk carries the text generated since the previous one; the finish
+    /// reason and usage arrive on the final chunks. Cancelling the consuming task
+    /// cancels the underlying request.
+    public nonisolated func stream(
+        model: String,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat? = nil,
+        temperature: Double? = nil,
+        maxTokens: Int? = nil,
+        topP: Double? = nil,
+        stop: [String]? = nil
+    ) -> AsyncThrowingStream<LLMStreamChunk, Error> {
+        AsyncThrowingStream { continuation in
+            let task = Task {
+                do {
+                    try await self.performStream(
+                        model: model,
+                        messages: messages,
+                        responseFormat: responseFormat,
+                        temperature: temperature,
+                        maxTokens: maxTokens,
+                        topP: topP,
+                        stop: stop,
+                        continuation: continuation
+                    )
+                    continuation.finish()
+                } catch {
+                    continuation.finish(throwing: error)
+                }
+            }
+            continuation.onTermination = { _ in
+                task.cancel()
+            }
+        }
+    }
+
+    // MARK: - Streaming
+
+    private func performStream(
+        model: String,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat?,
+        temperature: Double?,
+        maxTokens: Int?,
+        topP: Double?,
+        stop: [String]?,
+        continuation: AsyncThrowingStream<LLMStreamChunk, Error>.Continuation
+    ) async throws {
+        let maxTokens = completionBudget(maxTokens)
+        try await rateLimiter?.acquire(estimatedTokens: Self.estimatedTokens(messages: messages, maxTokens: maxTokens))
+
+        let request: URLRequest
+        let body: RequestBody
+        if provider.isOpenAICompatible {
+            (request, body) = try makeOpenAIRequest(
+                model: model,
+                messages: messages,
+                responseFormat: responseFormat,
+                encodedSchema: nil,
+                temperature: temperature,
+                maxTokens: maxTokens,
+                topP: topP,
+                stop: stop,
+                stream: true
+            )
+        } else {
+            // Tool input streams as `input_json_delta` events, which the
+            // decoder doesn't read, so streams keep the schema in the prompt
+            (request, body) = try makeAnthropicRequest(
+                model: model,
+                messages: try await fetchingImageURLs(messages),
+                responseFormat: nil,
+                encodedSchema: nil,
+                temperature: temperature,
+                maxTokens: maxTokens ?? Self.defaultAnthropicMaxTokens,
+                topP: topP,
+                stop: stop,
+                stream: true
+            )
+        }
+
+        defer { withExtendedLifetime(body) {} }
+
+        var decoder = LLMStreamDecoder(provider: provider)
+
+        try await forEachLine(of: request) { line in
+            if let chunk = try decoder.decode(line: line) {
+                continuation.yield(chunk)
+            }
+            return !decoder.isFinished
+        }
+    }
+
+    /// Read a response body line by line as it arrives
+    ///
+    /// - Parameter body: Called for each line; return false to stop reading
+    func forEachLine(of request: URLRequest, _ body: (String) throws -> Bool) async throws {
+        #if canImport(FoundationNetworking)
+        // swift-corelibs-foundation has no URLSession.bytes(for:), so the body
+        // is read in one piece and split into lines
+        let (data, response) = try await session.data(for: request)
+        await recordRateLimits(response)
+        try Self.validate(response, body: data)
+
+        for line in String(decoding: data, as: UTF8.self).split(whereSeparator: \.isNewline) {
+            try Task.checkCancellation()
+            guard try body(String(line)) else { break }
+        }
+        #else
+        let (bytes, response) = try await session.bytes(for: request)
+        await recordRateLimits(response)
+
+        var errorBody = Data()
+        if let httpResponse = response as? HTTPURLResponse, !(200...299).contains(httpResponse.statusCode) {
+            for try await byte in bytes {
+                errorBody.append(byte)
+            }
+        }
+        try Self.validate(response, body: errorBody)
+
+        for try await line in bytes.lines {
+            guard try body(line) else { break }
+        }
+        #endif
+    }
+
+    /// Send a non-streaming request
+    ///
+    /// A spooled body is uploaded from its file. In a traced call, records
+    /// the request and response sizes and the `network` time, split into
+    /// time to first byte and download where URLSession reports task metrics.
+    func send(_ request: URLRequest, body: RequestBody? = nil) async throws -> (Data, URLResponse) {
+        guard let trace = CallTrace.current else {
+            #if !canImport(FoundationNetworking)
+            if let uploadFile = body?.uploadFile {
+                return try await session.upload(for: request, fromFile: uploadFile)
+            }
+            #endif
+            return try await session.data(for: request)
+        }
+
+        trace.record {
+            $0.requests += 1
+            $0.requestBytes += body?.count
+                ?? request.httpBody?.count
+                ?? request.value(forHTTPHeaderField: "Content-Length").flatMap { Int($0) }
+                ?? 0
+        }
+        let session = session
+        let (data, response): (Data, URLResponse) = try await trace.measure(.network) {
+            #if canImport(FoundationNetworking)
+            try await session.data(for: request)
+            #else
+            if let uploadFile = body?.uploadFile {
+                return try await session.upload(
+                    for: request,
+                    fromFile: uploadFile,
+                    delegate: TaskMetricsCollector(trace: trace)
+                )
+            }
+            return try await session.data(for: request, delegate: TaskMetricsCollector(trace: trace))
+            #endif
+        }
+        trace.record { $0.responseBytes += data.count }
+        return (data, response)
+    }
+
+    /// Feed a response's rate-limit headers to the limiter
+    func recordRateLimits(_ response: URLResponse) async {
+        guard let rateLimiter = rateLimiter, let httpResponse = response as? HTTPURLResponse else { return }
+        await rateLimiter.update(from: httpResponse)
+    }
+
+    /// Completion budget Anthropic requests get when none is set, since its
+    /// API requires one
+    static let defaultAnthropicMaxTokens = 4096
+
+    /// The `maxTokens` actually sent to the provider
+    func completionBudget(_ maxTokens: Int?) -> Int? {
+        provider.isOpenAICompatible ? maxTokens : maxTokens ?? Self.defaultAnthropicMaxTokens
+    }
+
+    /// Rough size of a request for the token bucket: about four characters per
+    /// prompt token, plus the completion budget, which providers count up front
+    static func estimatedTokens(messages: [ChatMessage], maxTokens: Int?) -> Int {
+        var characters = 0
+        for message in messages {
+            switch message.content {
+            case .text(let text):
+                characters += text.utf8.count
+            case .multipart(let parts):
+                for part in parts {
+                    if case .text(let text) = part {
+                        characters += text.utf8.count
+                    } else {
+                        // Images are billed at roughly a thousand tokens
+                        characters += 4000
+                    }
+                }
+            }
+        }
+        return characters / 4 + (maxTokens ?? 0)
+    }
+
+    static func validate(_ response: URLResponse, body: Data) throws {
+        guard let httpResponse = response as? HTTPURLResponse else {
+            throw SwamlError.networkError("Invalid response type")
+        }
+
+        guard (200...299).contains(httpResponse.statusCode) else {
+            let errorBody = String(data: body, encoding: .utf8) ?? "Unknown error"
+            throw SwamlError.apiError(statusCode: httpResponse.statusCode, message: errorBody)
+        }
     }
 
     // MARK: - OpenAI-Compatible API
@@ -51,11 +428,52 @@ public actor LLMClient {
         model: String,
         messages: [ChatMessage],
         responseFormat: ResponseFormat?,
+        encodedSchema: EncodedJSON?,
         temperature: Double?,
         maxTokens: Int?,
         topP: Double?,
         stop: [String]?
     ) async throws -> LLMResponse {
+        let (request, body) = try makeOpenAIRequest(
+            model: model,
+            messages: messages,
+            responseFormat: responseFormat,
+            encodedSchema: encodedSchema,
+            temperature: temperature,
+            maxTokens: maxTokens,
+            topP: topP,
+            stop: stop,
+            stream: false
+        )
+
+        defer { withExtendedLifetime(body) {} }
+
+        let (data, response) = try await send(request, body: body)
+        await recordRateLimits(response)
+        try Self.validate(response, body: data)
+
+        let decoder = JSONDecoder()
+        let apiResponse = try decoder.decode(OpenAICompletionResponse.self, from: data)
+        return try apiResponse.toLLMResponse(schemaConstrained: enforcesSchema(responseFormat))
+    }
+
+    /// Whether the provider constrains output to `responseFormat`'s schema
+    private func enforcesSchema(_ responseFormat: ResponseFormat?) -> Bool {
+        guard case .jsonSchema(_, _, true)? = responseFormat else { return false }
+        return provider.structuredOutput == .jsonSchema
+    }
+
+    private func makeOpenAIRequest(
+        model: String,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat?,
+        encodedSchema: EncodedJSON?,
+        temperature: Double?,
+        maxTokens: Int?,
+        topP: Double?,
+        stop: [String]?,
+        stream: Bool
+    ) throws -> (URLRequest, RequestBody) {
         let url = provider.baseURL.appendingPathComponent("chat/completions")
         var request = URLRequest(url: url)
         request.httpMethod = "POST"
@@ -67,92 +485,390 @@ public actor LLMClient {
         for (key, value) in provider.additionalHeaders {
             request.setValue(value, forHTTPHeaderField: key)
         }
+        if stream {
+            request.setValue("text/event-stream", forHTTPHeaderField: "Accept")
+        }
 
-        var body: [String: Any] = [
-            "model": model,
-            "messages": messages.map { encodeOpenAIMessage($0) }
-        ]
+        let body = try CallTrace.measure(.encode) {
+            var writer = JSONBodyWriter(capacity: Self.estimatedBodySize(messages))
+            writeOpenAIRequestBody(
+                into: &writer,
+                model: model,
+                messages: messages,
+                responseFormat: responseFormat,
+                encodedSchema: encodedSchema,
+                temperature: temperature,
+                maxTokens: maxTokens,
+                topP: topP,
+                stop: stop,
+                stream: stream
+            )
+            return try RequestBody(writer)
+        }
+        try body.attach(to: &request)
+        return (request, body)
+    }
 
+    /// Write a chat completion request body, shared by direct and batch requests
+    func writeOpenAIRequestBody(
+        into writer: inout JSONBodyWriter,
+        model: String,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat?,
+        encodedSchema: EncodedJSON? = nil,
+        temperature: Double?,
+        maxTokens: Int?,
+        topP: Double?,
+        stop: [String]?,
+        stream: Bool = false
+    ) {
+        writer.beginObject()
+        writer.key("model")
+        writer.value(model)
+
+        writer.key("messages")
+        writer.beginArray()
+        let prefixEnd = messages.lastIndex { $0.cacheable }
+        let prefixStart = writer.bytes.count
+        var prefixKey: ResponseCacheKey?
+        for (index, message) in messages.enumerated() {
+            writeOpenAIMessage(message, into: &writer)
+            if index == prefixEnd {
+                prefixKey = ResponseCacheKey(hashing: writer.bytes[prefixStart...])
+            }
+        }
+        writer.endArray()
+
+        // OpenAI caches prefixes automatically; the key routes requests that
+        // share one to the same cache
+        if let prefixKey = prefixKey, provider.supportsPromptCacheKey {
+            writer.key("prompt_cache_key")
+            writer.value(prefixKey.description)
+        }
         if let responseFormat = responseFormat {
-            body["response_format"] = responseFormat.toRequestFormat()
+            writer.key("response_format")
+            responseFormat.write(into: &writer, encodedSchema: encodedSchema)
         }
         if let temperature = temperature {
-            body["temperature"] = temperature
+            writer.key("temperature")
+            writer.value(temperature)
         }
         if let maxTokens = maxTokens {
-            body["max_tokens"] = maxTokens
+            writer.key("max_tokens")
+            writer.value(maxTokens)
         }
         if let topP = topP {
-            body["top_p"] = topP
+            writer.key("top_p")
+            writer.value(topP)
         }
         if let stop = stop, !stop.isEmpty {
-            body["stop"] = stop
+            writer.key("stop")
+            writer.value(any: stop)
         }
+        if stream {
+            writer.key("stream")
+            writer.value(true)
+            // Ask for a final chunk carrying token usage
+            writer.key("stream_options")
+            writer.beginObject()
+            writer.key("include_usage")
+            writer.value(true)
+            writer.endObject()
+        }
+        writer.endObject()
+    }
 
-        request.httpBody = try JSONSerialization.data(withJSONObject: body)
+    private func writeOpenAIMessage(_ message: ChatMessage, into writer: inout JSONBodyWriter) {
+        guard let encodings = message.encodings else {
+            writeOpenAIMessageObject(message, into: &writer)
+            return
+        }
+        writer.value(encodings.encoding(.openAI) { writeOpenAIMessageObject(message, into: &$0) })
+    }
 
-        let (data, response) = try await session.data(for: request)
+    private func writeOpenAIMessageObject(_ message: ChatMessage, into writer: inout JSONBodyWriter) {
+        writer.beginObject()
+        writer.key("role")
+        writer.value(message.role.rawValue)
 
-        guard let httpResponse = response as? HTTPURLResponse else {
-            throw SwamlError.networkError("Invalid response type")
+        writer.key("content")
+        switch message.content {
+        case .text(let text):
+            writeText(text, role: message.role, into: &writer)
+        case .multipart(let parts):
+            writer.beginArray()
+            for part in parts {
+                writeContentPart(part, into: &writer)
+            }
+            writer.endArray()
         }
+        writer.endObject()
+    }
 
-        guard (200...299).contains(httpResponse.statusCode) else {
-            let errorBody = String(data: data, encoding: .utf8) ?? "Unknown error"
-            throw SwamlError.apiError(statusCode: httpResponse.statusCode, message: errorBody)
+    private func writeContentPart(_ part: ChatMessage.ContentPart, into writer: inout JSONBodyWriter) {
+        writer.beginObject()
+        switch part {
+        case .text(let text):
+            writer.key("type")
+            writer.value("text")
+            writer.key("text")
+            writer.value(text)
+        case .imageURL(let url):
+            writer.key("type")
+            writer.value("image_url")
+            writer.key("image_url")
+            writer.beginObject()
+            writer.key("url")
+            writer.value(url.absoluteString)
+            writer.endObject()
+        case .imageBase64(let data, let mediaType):
+            writer.key("type")
+            writer.value("image_url")
+            writer.key("image_url")
+            writer.beginObject()
+            writer.key("url")
+            writer.value("data:\(mediaType);base64,\(data)")
+            writer.endObject()
+        case .attachment(let attachment) where attachment.isDocument:
+            writer.key("type")
+            writer.value("file")
+            writer.key("file")
+            writer.beginObject()
+            if case .file(let url) = attachment.source {
+                writer.key("filename")
+                writer.value(url.lastPathComponent)
+            }
+            writer.key("file_data")
+            writer.value(attachment, prefix: "data:\(attachment.mediaType);base64,")
+            writer.endObject()
+        case .attachment(let attachment):
+            writer.key("type")
+            writer.value("image_url")
+            writer.key("image_url")
+            writer.beginObject()
+            writer.key("url")
+            writer.value(attachment, prefix: "data:\(attachment.mediaType);base64,")
+            writer.endObject()
         }
+        writer.endObject()
+    }
 
-        let decoder = JSONDecoder()
-        let apiResponse = try decoder.decode(OpenAICompletionResponse.self, from: data)
+    // MARK: - Body Encoding
 
-        guard let choice = apiResponse.choices.first,
-              let content = choice.message.content else {
-            throw SwamlError.parseError("No content in response")
+    /// Key identifying a request in the response cache
+    ///
+    /// Hashes the provider's endpoint and the request as an OpenAI-format body,
+    /// which is already normalized: fixed field order, sorted schema keys.
+    func cacheKey(
+        model: String,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat?,
+        encodedSchema: EncodedJSON? = nil,
+        temperature: Double?,
+        maxTokens: Int?
+    ) -> ResponseCacheKey {
+        var writer = JSONBodyWriter(capacity: Self.estimatedBodySize(messages))
+        writer.beginArray()
+        writer.value(provider.baseURL.absoluteString)
+        writeOpenAIRequestBody(
+            into: &writer,
+            model: model,
+            messages: messages,
+            responseFormat: responseFormat,
+            encodedSchema: encodedSchema,
+            temperature: temperature,
+            maxTokens: maxTokens,
+            topP: nil,
+            stop: nil
+        )
+        // Attachments aren't in the bytes; their content hashes stand in
+        for (_, attachment) in writer.attachments {
+            writer.value(attachment.cacheIdentity)
         }
+        writer.endArray()
+        return ResponseCacheKey(hashing: writer.bytes)
+    }
 
-        return LLMResponse(
-            content: content,
-            model: apiResponse.model,
-            usage: apiResponse.usage,
-            finishReason: choice.finishReason,
-            id: apiResponse.id
-        )
+    /// Write message text, reusing the encoded bytes of system prompts
+    ///
+    /// System prompts (usually the rendered schema plus fixed instructions)
+    /// repeat across calls, so their escaped form is cached; user text is
+    /// escaped on every call.
+    private func writeText(_ text: String, role: ChatMessage.Role, into writer: inout JSONBodyWriter) {
+        guard role == .system else {
+            writer.value(text)
+            return
+        }
+        writer.value(encodedSystemText(text))
     }
 
-    private func encodeOpenAIMessage(_ message: ChatMessage) -> [String: Any] {
-        var dict: [String: Any] = ["role": message.role.rawValue]
+    private func encodedSystemText(_ text: String) -> EncodedJSON {
+        if let cached = encodedSystemPrompts[text] {
+            return cached
+        }
+        if encodedSystemPrompts.count >= Self.maxEncodedSystemPrompts {
+            encodedSystemPrompts.removeAll(keepingCapacity: true)
+        }
+        let encoded = EncodedJSON(string: text)
+        encodedSystemPrompts[text] = encoded
+        return encoded
+    }
 
-        switch message.content {
-        case .text(let text):
-            dict["content"] = text
-        case .multipart(let parts):
-            dict["content"] = parts.map { encodeContentPart($0) }
+    /// Upper bound on cached system prompts before the cache is reset
+    private static let maxEncodedSystemPrompts = 64
+
+    /// Initial buffer size for a request body: the message text plus room
+    /// for escaping and the surrounding fields
+    static func estimatedBodySize(_ messages: [ChatMessage]) -> Int {
+        var size = 512
+        for message in messages {
+            switch message.content {
+            case .text(let text):
+                size += text.utf8.count + 32
+            case .multipart(let parts):
+                for part in parts {
+                    switch part {
+                    case .text(let text):
+                        size += text.utf8.count + 48
+                    case .imageURL(let url):
+                        size += url.absoluteString.utf8.count + 64
+                    case .imageBase64(let data, _):
+                        size += data.utf8.count + 96
+                    case .attachment:
+                        // Encoded in when the body is assembled
+                        size += 96
+                    }
+                }
+            }
+        }
+        return size + size / 16
+    }
+
+    // MARK: - Image URLs
+
+    /// Messages with their image URL parts replaced by the downloaded images
+    ///
+    /// Anthropic only takes images inline. The URLs are fetched concurrently
+    /// and each download is kept (up to `maxFetchedImages`), so an image
+    /// that's sent again isn't downloaded again; as attachments, the images
+    /// share the content-addressed `EncodedAttachmentCache`.
+    func fetchingImageURLs(_ messages: [ChatMessage]) async throws -> [ChatMessage] {
+        var urls = Set<URL>()
+        for message in messages {
+            guard case .multipart(let parts) = message.content else { continue }
+            for case .imageURL(let url) in parts {
+                urls.insert(url)
+            }
+        }
+        guard !urls.isEmpty else { return messages }
+
+        let tasks = urls.map { ($0, fetchTask(for: $0)) }
+        var images: [URL: ChatMessage.Attachment] = [:]
+        try await withThrowingTaskGroup(of: (URL, ChatMessage.Attachment).self) { group in
+            for (url, task) in tasks {
+                group.addTask {
+                    do {
+                        return (url, try await task.value)
+                    } catch {
+                        await self.forgetFetch(of: url)
+                        throw error
+                    }
+                }
+            }
+            for try await (url, image) in group {
+                images[url] = image
+            }
         }
 
-        return dict
+        return messages.map { message in
+            guard case .multipart(let parts) = message.content else { return message }
+            let resolved = parts.map { part -> ChatMessage.ContentPart in
+                guard case .imageURL(let url) = part, let image = images[url] else { return part }
+                return .attachment(image)
+            }
+            return ChatMessage(role: message.role, content: .multipart(resolved), cacheable: message.cacheable)
+        }
     }
 
-    private func encodeContentPart(_ part: ChatMessage.ContentPart) -> [String: Any] {
-        switch part {
-        case .text(let text):
-            return ["type": "text", "text": text]
-        case .imageURL(let url):
-            return ["type": "image_url", "image_url": ["url": url.absoluteString]]
-        case .imageBase64(let data, let mediaType):
-            return ["type": "image_url", "image_url": ["url": "data:\(mediaType);base64,\(data)"]]
+    private func fetchTask(for url: URL) -> Task<ChatMessage.Attachment, Error> {
+        if let task = fetchedImages[url] {
+            return task
+        }
+        if fetchedImages.count >= Self.maxFetchedImages {
+            fetchedImages.removeAll(keepingCapacity: true)
+        }
+        let session = session
+        let task = Task {
+            try await Self.fetchImage(url, session: session)
         }
+        fetchedImages[url] = task
+        return task
     }
 
+    /// Drop a failed download, so the next request tries again
+    private func forgetFetch(of url: URL) {
+        fetchedImages[url] = nil
+    }
+
+    private static func fetchImage(_ url: URL, session: URLSession) async throws -> ChatMessage.Attachment {
+        let (data, response) = try await session.data(for: URLRequest(url: url))
+        // `data:` URLs have no status to check
+        if response is HTTPURLResponse {
+            try validate(response, body: Data())
+        }
+        let mediaType = response.mimeType ?? ChatMessage.Attachment.mediaType(forExtension: url.pathExtension)
+        return ChatMessage.Attachment(data: data, mediaType: mediaType)
+    }
+
+    /// Upper bound on kept image downloads before they're reset
+    private static let maxFetchedImages = 32
+
     // MARK: - Anthropic API
 
     private func completeAnthropic(
         model: String,
         messages: [ChatMessage],
+        responseFormat: ResponseFormat?,
+        encodedSchema: EncodedJSON?,
         temperature: Double?,
         maxTokens: Int,
         topP: Double?,
         stop: [String]?
     ) async throws -> LLMResponse {
+        let (request, body) = try makeAnthropicRequest(
+            model: model,
+            messages: messages,
+            responseFormat: responseFormat,
+            encodedSchema: encodedSchema,
+            temperature: temperature,
+            maxTokens: maxTokens,
+            topP: topP,
+            stop: stop,
+            stream: false
+        )
+
+        defer { withExtendedLifetime(body) {} }
+
+        let (data, response) = try await send(request, body: body)
+        await recordRateLimits(response)
+        try Self.validate(response, body: data)
+
+        let decoder = JSONDecoder()
+        let apiResponse = try decoder.decode(AnthropicCompletionResponse.self, from: data)
+        return apiResponse.toLLMResponse
+    }
+
+    private func makeAnthropicRequest(
+        model: String,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat?,
+        encodedSchema: EncodedJSON?,
+        temperature: Double?,
+        maxTokens: Int,
+        topP: Double?,
+        stop: [String]?,
+        stream: Bool
+    ) throws -> (URLRequest, RequestBody) {
         let url = provider.baseURL.appendingPathComponent("messages")
         var request = URLRequest(url: url)
         request.httpMethod = "POST"
@@ -163,101 +879,277 @@ public actor LLMClient {
         for (key, value) in provider.additionalHeaders {
             request.setValue(value, forHTTPHeaderField: key)
         }
+        if stream {
+            request.setValue("text/event-stream", forHTTPHeaderField: "Accept")
+        }
+
+        let body = try CallTrace.measure(.encode) {
+            var writer = JSONBodyWriter(capacity: Self.estimatedBodySize(messages))
+            writeAnthropicRequestBody(
+                into: &writer,
+                model: model,
+                messages: messages,
+                responseFormat: responseFormat,
+                encodedSchema: encodedSchema,
+                temperature: temperature,
+                maxTokens: maxTokens,
+                topP: topP,
+                stop: stop,
+                stream: stream
+            )
+            return try RequestBody(writer)
+        }
+        try body.attach(to: &request)
+        return (request, body)
+    }
 
+    /// Write a messages request body, shared by direct and batch requests
+    ///
+    /// A `.jsonSchema` response format with an object schema becomes a tool
+    /// taking the schema as its `input_schema`, and `tool_choice` forces the
+    /// model to call it; other formats are left to the prompt.
+    func writeAnthropicRequestBody(
+        into writer: inout JSONBodyWriter,
+        model: String,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat? = nil,
+        encodedSchema: EncodedJSON? = nil,
+        temperature: Double?,
+        maxTokens: Int,
+        topP: Double?,
+        stop: [String]?,
+        stream: Bool = false
+    ) {
         // Anthropic requires system message to be separate
-        var systemMessage: String? = nil
-        var anthropicMessages: [[String: Any]] = []
+        let systemMessages = messages.filter { $0.role == .system }
+        let breakpoints = Self.anthropicCacheBreakpoints(messages)
 
-        for message in messages {
-            if message.role == .system {
-                systemMessage = message.content.textValue
-            } else {
-                anthropicMessages.append(encodeAnthropicMessage(message))
-            }
+        writer.beginObject()
+        writer.key("model")
+        writer.value(model)
+
+        writer.key("messages")
+        writer.beginArray()
+        for (index, message) in messages.enumerated() where message.role != .system {
+            writeAnthropicMessage(message, cacheControl: breakpoints.contains(index), into: &writer)
         }
+        writer.endArray()
 
-        var body: [String: Any] = [
-            "model": model,
-            "messages": anthropicMessages,
-            "max_tokens": maxTokens
-        ]
+        writer.key("max_tokens")
+        writer.value(maxTokens)
 
-        if let systemMessage = systemMessage {
-            body["system"] = systemMessage
+        if systemMessages.count > 1 || systemMessages.contains(where: { $0.cacheable }) {
+            // Block form, so each system message keeps its own breakpoint
+            writer.key("system")
+            writer.beginArray()
+            for (index, message) in messages.enumerated() where message.role == .system {
+                writer.beginObject()
+                writer.key("type")
+                writer.value("text")
+                writer.key("text")
+                writeText(message.content.textValue ?? "", role: .system, into: &writer)
+                if breakpoints.contains(index) {
+                    Self.writeCacheControl(into: &writer)
+                }
+                writer.endObject()
+            }
+            writer.endArray()
+        } else if let systemMessage = systemMessages.first?.content.textValue {
+            writer.key("system")
+            writeText(systemMessage, role: .system, into: &writer)
         }
         if let temperature = temperature {
-            body["temperature"] = temperature
+            writer.key("temperature")
+            writer.value(temperature)
         }
         if let topP = topP {
-            body["top_p"] = topP
+            writer.key("top_p")
+            writer.value(topP)
         }
         if let stop = stop, !stop.isEmpty {
-            body["stop_sequences"] = stop
+            writer.key("stop_sequences")
+            writer.value(any: stop)
+        }
+        if case .jsonSchema(let name, let schema, _)? = responseFormat,
+           provider.structuredOutput == .toolUse,
+           schema["type"] as? String == "object" {
+            Self.writeOutputTool(named: Self.formatName(name), schema: encodedSchema ?? EncodedJSON(any: schema), into: &writer)
+        }
+        if stream {
+            writer.key("stream")
+            writer.value(true)
         }
+        writer.endObject()
+    }
 
-        request.httpBody = try JSONSerialization.data(withJSONObject: body)
+    /// Write a tool taking the output as its input, and force its use
+    private static func writeOutputTool(named name: String, schema: EncodedJSON, into writer: inout JSONBodyWriter) {
+        writer.key("tools")
+        writer.beginArray()
+        writer.beginObject()
+        writer.key("name")
+        writer.value(name)
+        writer.key("description")
+        writer.value("Respond by calling this tool with the output as its input.")
+        writer.key("input_schema")
+        writer.value(schema)
+        writer.endObject()
+        writer.endArray()
 
-        let (data, response) = try await session.data(for: request)
-
-        guard let httpResponse = response as? HTTPURLResponse else {
-            throw SwamlError.networkError("Invalid response type")
-        }
+        writer.key("tool_choice")
+        writer.beginObject()
+        writer.key("type")
+        writer.value("tool")
+        writer.key("name")
+        writer.value(name)
+        writer.endObject()
+    }
 
-        guard (200...299).contains(httpResponse.statusCode) else {
-            let errorBody = String(data: data, encoding: .utf8) ?? "Unknown error"
-            throw SwamlError.apiError(statusCode: httpResponse.statusCode, message: errorBody)
-        }
+    /// `name` as a valid tool or response format name: up to 64 ASCII
+    /// letters, digits, `_` and `-`
+    static func formatName(_ name: String) -> String {
+        let sanitized = String(name.prefix(64).map { character in
+            character.isASCII && (character.isLetter || character.isNumber || character == "-") ? character : "_"
+        })
+        return sanitized.isEmpty ? "output" : sanitized
+    }
 
-        let decoder = JSONDecoder()
-        let apiResponse = try decoder.decode(AnthropicCompletionResponse.self, from: data)
+    /// Indices of the messages that get a `cache_control` breakpoint
+    ///
+    /// Anthropic caches in the order tools, system, messages and accepts at
+    /// most four breakpoints, so the last four cacheable messages in that
+    /// order are kept; each covers everything before it.
+    static func anthropicCacheBreakpoints(_ messages: [ChatMessage]) -> Set<Int> {
+        let system = messages.indices.filter { messages[$0].role == .system && messages[$0].cacheable }
+        let rest = messages.indices.filter { messages[$0].role != .system && messages[$0].cacheable }
+        return Set((system + rest).suffix(maxAnthropicCacheBreakpoints))
+    }
 
-        let content = apiResponse.content
-            .compactMap { $0.text }
-            .joined()
+    private static let maxAnthropicCacheBreakpoints = 4
 
-        let finishReason: LLMResponse.FinishReason? = {
-            guard let reason = apiResponse.stopReason else { return nil }
-            return LLMResponse.FinishReason(rawValue: reason)
-        }()
+    private static func writeCacheControl(into writer: inout JSONBodyWriter) {
+        writer.key("cache_control")
+        writer.beginObject()
+        writer.key("type")
+        writer.value("ephemeral")
+        writer.endObject()
+    }
 
-        return LLMResponse(
-            content: content,
-            model: apiResponse.model,
-            usage: apiResponse.usage.toLLMUsage,
-            finishReason: finishReason,
-            id: apiResponse.id
-        )
+    private func writeAnthropicMessage(
+        _ message: ChatMessage,
+        cacheControl: Bool,
+        into writer: inout JSONBodyWriter
+    ) {
+        guard let encodings = message.encodings else {
+            writeAnthropicMessageObject(message, cacheControl: cacheControl, into: &writer)
+            return
+        }
+        writer.value(encodings.encoding(.anthropic(cacheControl: cacheControl)) {
+            writeAnthropicMessageObject(message, cacheControl: cacheControl, into: &$0)
+        })
     }
 
-    private func encodeAnthropicMessage(_ message: ChatMessage) -> [String: Any] {
-        var dict: [String: Any] = ["role": message.role.rawValue]
+    private func writeAnthropicMessageObject(
+        _ message: ChatMessage,
+        cacheControl: Bool,
+        into writer: inout JSONBodyWriter
+    ) {
+        writer.beginObject()
+        writer.key("role")
+        writer.value(message.role.rawValue)
 
+        writer.key("content")
         switch message.content {
+        case .text(let text) where cacheControl:
+            // The breakpoint has to sit on a content block
+            writer.beginArray()
+            writeAnthropicContentPart(.text(text), cacheControl: true, into: &writer)
+            writer.endArray()
         case .text(let text):
-            dict["content"] = text
+            writer.value(text)
         case .multipart(let parts):
-            dict["content"] = parts.map { encodeAnthropicContentPart($0) }
+            writer.beginArray()
+            for (index, part) in parts.enumerated() {
+                writeAnthropicContentPart(
+                    part,
+                    cacheControl: cacheControl && index == parts.count - 1,
+                    into: &writer
+                )
+            }
+            writer.endArray()
         }
-
-        return dict
+        writer.endObject()
     }
 
-    private func encodeAnthropicContentPart(_ part: ChatMessage.ContentPart) -> [String: Any] {
+    private func writeAnthropicContentPart(
+        _ part: ChatMessage.ContentPart,
+        cacheControl: Bool = false,
+        into writer: inout JSONBodyWriter
+    ) {
+        writer.beginObject()
         switch part {
         case .text(let text):
-            return ["type": "text", "text": text]
+            writer.key("type")
+            writer.value("text")
+            writer.key("text")
+            writer.value(text)
         case .imageURL(let url):
-            // Anthropic doesn't support URL directly, would need to fetch and convert
-            return ["type": "text", "text": "[Image URL: \(url.absoluteString)]"]
+            // Only reached for messages that didn't go through
+            // `fetchingImageURLs`; Anthropic takes images inline
+            writer.key("type")
+            writer.value("text")
+            writer.key("text")
+            writer.value("[Image URL: \(url.absoluteString)]")
         case .imageBase64(let data, let mediaType):
-            return [
-                "type": "image",
-                "source": [
-                    "type": "base64",
-                    "media_type": mediaType,
-                    "data": data
-                ]
-            ]
+            writer.key("type")
+            writer.value("image")
+            writer.key("source")
+            writer.beginObject()
+            writer.key("type")
+            writer.value("base64")
+            writer.key("media_type")
+            writer.value(mediaType)
+            writer.key("data")
+            writer.value(data)
+            writer.endObject()
+        case .attachment(let attachment):
+            writer.key("type")
+            writer.value(attachment.isDocument ? "document" : "image")
+            writer.key("source")
+            writer.beginObject()
+            writer.key("type")
+            writer.value("base64")
+            writer.key("media_type")
+            writer.value(attachment.mediaType)
+            writer.key("data")
+            writer.value(attachment)
+            writer.endObject()
         }
+        if cacheControl {
+            Self.writeCacheControl(into: &writer)
+        }
+        writer.endObject()
     }
 }
+
+#if !canImport(FoundationNetworking)
+/// Adds a request's time to first byte and download time to its call trace
+private final class TaskMetricsCollector: NSObject, URLSessionTaskDelegate, @unchecked Sendable {
+    private let trace: CallTrace
+
+    init(trace: CallTrace) {
+        self.trace = trace
+    }
+
+    func urlSession(_ session: URLSession, task: URLSessionTask, didFinishCollecting metrics: URLSessionTaskMetrics) {
+        guard let transaction = metrics.transactionMetrics.last,
+              let requestStart = transaction.requestStartDate,
+              let responseStart = transaction.responseStartDate,
+              let responseEnd = transaction.responseEndDate else {
+            return
+        }
+        trace.add(.timeToFirstByte, responseStart.timeIntervalSince(requestStart))
+        trace.add(.download, responseEnd.timeIntervalSince(responseStart))
+    }
+}
+#endif
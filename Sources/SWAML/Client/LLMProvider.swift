@@ -67,6 +67,24 @@ public enum LLMProvider: Sendable {
         }
     }
 
+    /// Whether the provider has an asynchronous batch API
+    /// (OpenAI `/batches` or Anthropic Message Batches)
+    public var supportsBatchAPI: Bool {
+        capabilities.batchAPI
+    }
+
+    /// Whether to send OpenAI's `prompt_cache_key` routing hint for requests
+    /// with a cacheable prefix (other OpenAI-compatible servers may reject
+    /// unknown fields)
+    public var supportsPromptCacheKey: Bool {
+        capabilities.promptCacheKey
+    }
+
+    /// How the provider can hold output to a JSON Schema
+    public var structuredOutput: StructuredOutput {
+        capabilities.structuredOutput
+    }
+
     /// The chat completions endpoint path
     public var chatCompletionsPath: String {
         switch self {
@@ -77,3 +95,67 @@ public enum LLMProvider: Sendable {
         }
     }
 }
+
+// MARK: - Capabilities
+
+extension LLMProvider {
+    /// How a provider can be made to produce output matching a JSON Schema
+    public enum StructuredOutput: Sendable, Equatable {
+        /// Only by describing the schema in the prompt
+        case prompt
+
+        /// A `json_schema` response format with `strict` set: generation is
+        /// constrained to the schema
+        case jsonSchema
+
+        /// A forced call of a tool whose `input_schema` is the schema; the
+        /// tool input is the output (Anthropic)
+        case toolUse
+
+        /// Whether `schema` can be sent natively in this mode
+        ///
+        /// Strict mode needs every object closed, with all its properties
+        /// required; tool inputs only need an object at the root. Neither
+        /// accepts references left unresolved.
+        public func accepts(_ schema: JSONSchema) -> Bool {
+            guard case .object = schema, schema.isSelfContained else { return false }
+            switch self {
+            case .prompt:
+                return false
+            case .jsonSchema:
+                return schema.isStrictCompatible
+            case .toolUse:
+                return true
+            }
+        }
+    }
+
+    /// What a provider supports beyond plain chat completions
+    public struct Capabilities: Sendable, Equatable {
+        /// How output can be held to a schema
+        public let structuredOutput: StructuredOutput
+
+        /// An asynchronous batch API (OpenAI `/batches` or Anthropic Message Batches)
+        public let batchAPI: Bool
+
+        /// OpenAI's `prompt_cache_key` routing hint
+        public let promptCacheKey: Bool
+    }
+
+    /// The provider's capabilities
+    public var capabilities: Capabilities {
+        switch self {
+        case .openAI:
+            return Capabilities(structuredOutput: .jsonSchema, batchAPI: true, promptCacheKey: true)
+        case .anthropic:
+            return Capabilities(structuredOutput: .toolUse, batchAPI: true, promptCacheKey: false)
+        case .openRouter:
+            // Strict schemas are only honoured by some of the routed models
+            return Capabilities(structuredOutput: .prompt, batchAPI: false, promptCacheKey: false)
+        case .custom:
+            // Assume OpenAI-compatible, without knowing what the server enforces
+            // or whether it has `/files` and `/batches` at all
+            return Capabilities(structuredOutput: .prompt, batchAPI: false, promptCacheKey: false)
+        }
+    }
+}
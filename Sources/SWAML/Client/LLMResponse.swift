@@ -17,38 +17,99 @@ public struct LLMResponse: Sendable {
     /// The unique ID of this response
     public let id: String?
 
+    /// Whether the provider held `content` to the requested JSON Schema (a
+    /// strict `json_schema` response format), so it can be decoded as-is
+    /// rather than through the tolerant parser
+    ///
+    /// Not set for a forced tool call's input: Anthropic doesn't constrain it
+    /// to the tool's `input_schema`, so it still goes through the parser.
+    public let isSchemaConstrained: Bool
+
     public init(
         content: String,
         model: String,
         usage: Usage? = nil,
         finishReason: FinishReason? = nil,
-        id: String? = nil
+        id: String? = nil,
+        isSchemaConstrained: Bool = false
     ) {
         self.content = content
         self.model = model
         self.usage = usage
         self.finishReason = finishReason
         self.id = id
+        self.isSchemaConstrained = isSchemaConstrained
     }
 }
 
 extension LLMResponse {
     /// Token usage statistics
     public struct Usage: Codable, Sendable {
+        /// All input tokens, including any served from the provider's prompt cache
         public let promptTokens: Int
         public let completionTokens: Int
         public let totalTokens: Int
 
-        public init(promptTokens: Int, completionTokens: Int, totalTokens: Int) {
+        /// Input tokens read from the provider's prompt cache
+        /// (billed at a discount); nil when the provider doesn't report it
+        public let cachedPromptTokens: Int?
+
+        /// Input tokens written to the provider's prompt cache on this call
+        /// (Anthropic only)
+        public let cacheCreationTokens: Int?
+
+        public init(
+            promptTokens: Int,
+            completionTokens: Int,
+            totalTokens: Int,
+            cachedPromptTokens: Int? = nil,
+            cacheCreationTokens: Int? = nil
+        ) {
             self.promptTokens = promptTokens
             self.completionTokens = completionTokens
             self.totalTokens = totalTokens
+            self.cachedPromptTokens = cachedPromptTokens
+            self.cacheCreationTokens = cacheCreationTokens
         }
 
         private enum CodingKeys: String, CodingKey {
             case promptTokens = "prompt_tokens"
             case completionTokens = "completion_tokens"
             case totalTokens = "total_tokens"
+            case promptTokensDetails = "prompt_tokens_details"
+            case cacheCreationTokens = "cache_creation_tokens"
+        }
+
+        /// OpenAI reports cache reads under `prompt_tokens_details`
+        private enum DetailsKeys: String, CodingKey {
+            case cachedTokens = "cached_tokens"
+        }
+
+        public init(from decoder: Decoder) throws {
+            let container = try decoder.container(keyedBy: CodingKeys.self)
+            self.promptTokens = try container.decode(Int.self, forKey: .promptTokens)
+            self.completionTokens = try container.decode(Int.self, forKey: .completionTokens)
+            self.totalTokens = try container.decode(Int.self, forKey: .totalTokens)
+            if container.contains(.promptTokensDetails),
+               !(try container.decodeNil(forKey: .promptTokensDetails)) {
+                let details = try container.nestedContainer(keyedBy: DetailsKeys.self, forKey: .promptTokensDetails)
+                self.cachedPromptTokens = try details.decodeIfPresent(Int.self, forKey: .cachedTokens)
+            } else {
+                self.cachedPromptTokens = nil
+            }
+            self.cacheCreationTokens = try container.decodeIfPresent(Int.self, forKey: .cacheCreationTokens)
+        }
+
+        public func encode(to encoder: Encoder) throws {
+            var container = encoder.container(keyedBy: CodingKeys.self)
+            try container.encode(promptTokens, forKey: .promptTokens)
+            try container.encode(completionTokens, forKey: .completionTokens)
+            try container.encode(totalTokens, forKey: .totalTokens)
+            if let cachedPromptTokens = cachedPromptTokens {
+                var details = container.nestedContainer(keyedBy: DetailsKeys.self, forKey: .promptTokensDetails)
+                try details.encode(cachedPromptTokens, forKey: .cachedTokens)
+            }
+            try container.encodeIfPresent(cacheCreationTokens, forKey: .cacheCreationTokens)
         }
     }
 
@@ -66,6 +127,11 @@ extension LLMResponse {
             let rawValue = try container.decode(String.self)
             self = FinishReason(rawValue: rawValue) ?? .stop
         }
+
+        /// Whether generation stopped at the token limit, leaving the output cut off
+        public var isTruncation: Bool {
+            self == .length || self == .maxTokens
+        }
     }
 }
 
@@ -77,22 +143,30 @@ public enum ResponseFormat: @unchecked Sendable {
     case jsonObject
     case jsonSchema(name: String, schema: [String: Any], strict: Bool)
 
-    func toRequestFormat() -> [String: Any] {
+    /// Write the `response_format` request field
+    ///
+    /// - Parameter encodedSchema: Pre-encoded `schema` of a `.jsonSchema` format
+    func write(into writer: inout JSONBodyWriter, encodedSchema: EncodedJSON? = nil) {
+        writer.beginObject()
+        writer.key("type")
         switch self {
         case .text:
-            return ["type": "text"]
+            writer.value("text")
         case .jsonObject:
-            return ["type": "json_object"]
+            writer.value("json_object")
         case .jsonSchema(let name, let schema, let strict):
-            return [
-                "type": "json_schema",
-                "json_schema": [
-                    "name": name,
-                    "schema": schema,
-                    "strict": strict
-                ]
-            ]
+            writer.value("json_schema")
+            writer.key("json_schema")
+            writer.beginObject()
+            writer.key("name")
+            writer.value(name)
+            writer.key("schema")
+            writer.value(encodedSchema ?? EncodedJSON(any: schema))
+            writer.key("strict")
+            writer.value(strict)
+            writer.endObject()
         }
+        writer.endObject()
     }
 }
 
@@ -122,6 +196,24 @@ struct OpenAICompletionResponse: Codable {
         let role: String
         let content: String?
     }
+
+    /// - Parameter schemaConstrained: Whether the request had a strict
+    ///   `json_schema` response format the provider enforces
+    func toLLMResponse(schemaConstrained: Bool = false) throws -> LLMResponse {
+        guard let choice = choices.first,
+              let content = choice.message.content else {
+            throw SwamlError.parseError("No content in response")
+        }
+
+        return LLMResponse(
+            content: content,
+            model: model,
+            usage: usage,
+            finishReason: choice.finishReason,
+            id: id,
+            isSchemaConstrained: schemaConstrained && choice.finishReason?.isTruncation != true
+        )
+    }
 }
 
 // MARK: - Anthropic API Response Structures
@@ -144,23 +236,158 @@ struct AnthropicCompletionResponse: Codable {
     struct ContentBlock: Codable {
         let type: String
         let text: String?
+
+        /// Arguments of a `tool_use` block
+        let input: SwamlValue?
     }
 
     struct AnthropicUsage: Codable {
+        /// Input tokens after the last cache breakpoint (not cached)
         let inputTokens: Int
         let outputTokens: Int
+        let cacheReadInputTokens: Int?
+        let cacheCreationInputTokens: Int?
 
         private enum CodingKeys: String, CodingKey {
             case inputTokens = "input_tokens"
             case outputTokens = "output_tokens"
+            case cacheReadInputTokens = "cache_read_input_tokens"
+            case cacheCreationInputTokens = "cache_creation_input_tokens"
+        }
+
+        /// Anthropic's `input_tokens` excludes cache reads and writes; fold them
+        /// back in so `promptTokens` means the same as for OpenAI
+        var totalInputTokens: Int {
+            inputTokens + (cacheReadInputTokens ?? 0) + (cacheCreationInputTokens ?? 0)
         }
 
         var toLLMUsage: LLMResponse.Usage {
             LLMResponse.Usage(
-                promptTokens: inputTokens,
+                promptTokens: totalInputTokens,
                 completionTokens: outputTokens,
-                totalTokens: inputTokens + outputTokens
+                totalTokens: totalInputTokens + outputTokens,
+                cachedPromptTokens: cacheReadInputTokens,
+                cacheCreationTokens: cacheCreationInputTokens
             )
         }
     }
+
+    /// The response; a forced tool call's input becomes the content, as JSON
+    /// (not marked schema-constrained, see `LLMResponse.isSchemaConstrained`)
+    var toLLMResponse: LLMResponse {
+        let finishReason = stopReason.flatMap { reason in
+            reason == "tool_use" ? LLMResponse.FinishReason.toolCalls : LLMResponse.FinishReason(rawValue: reason)
+        }
+        if let input = content.first(where: { $0.type == "tool_use" })?.input,
+           let json = try? input.toJSONString() {
+            return LLMResponse(
+                content: json,
+                model: model,
+                usage: usage.toLLMUsage,
+                finishReason: finishReason,
+                id: id
+            )
+        }
+        return LLMResponse(
+            content: content.compactMap { $0.text }.joined(),
+            model: model,
+            usage: usage.toLLMUsage,
+            finishReason: finishReason,
+            id: id
+        )
+    }
+}
+
+// MARK: - Streaming
+
+/// An incremental piece of a streamed LLM response
+public struct LLMStreamChunk: Sendable {
+    /// Text generated since the previous chunk (may be empty)
+    public let delta: String
+
+    /// The reason the model stopped generating, on the last content chunk
+    public let finishReason: LLMResponse.FinishReason?
+
+    /// Token usage, when the provider reports it (usually at the end of the stream)
+    public let usage: LLMResponse.Usage?
+
+    public init(
+        delta: String,
+        finishReason: LLMResponse.FinishReason? = nil,
+        usage: LLMResponse.Usage? = nil
+    ) {
+        self.delta = delta
+        self.finishReason = finishReason
+        self.usage = usage
+    }
+}
+
+/// A `chat.completion.chunk` event from an OpenAI-compatible stream
+struct OpenAIStreamChunk: Codable {
+    let id: String?
+    let model: String?
+    let choices: [Choice]?
+    let usage: LLMResponse.Usage?
+    let error: StreamError?
+
+    struct Choice: Codable {
+        let delta: Delta?
+        let finishReason: LLMResponse.FinishReason?
+
+        private enum CodingKeys: String, CodingKey {
+            case delta
+            case finishReason = "finish_reason"
+        }
+    }
+
+    struct Delta: Codable {
+        let content: String?
+    }
+
+    /// Error reported mid-stream (e.g. by OpenRouter after the response has started)
+    struct StreamError: Codable {
+        let message: String
+    }
+}
+
+/// An event from an Anthropic Messages stream
+struct AnthropicStreamEvent: Codable {
+    let type: String
+    let message: Message?
+    let delta: Delta?
+    let usage: DeltaUsage?
+    let error: StreamError?
+
+    /// Payload of `message_start`
+    struct Message: Codable {
+        let id: String
+        let model: String
+        let usage: AnthropicCompletionResponse.AnthropicUsage?
+    }
+
+    /// Payload of `content_block_delta` and `message_delta`
+    struct Delta: Codable {
+        let type: String?
+        let text: String?
+        let stopReason: String?
+
+        private enum CodingKeys: String, CodingKey {
+            case type, text
+            case stopReason = "stop_reason"
+        }
+    }
+
+    /// Cumulative usage sent with `message_delta`
+    struct DeltaUsage: Codable {
+        let outputTokens: Int?
+
+        private enum CodingKeys: String, CodingKey {
+            case outputTokens = "output_tokens"
+        }
+    }
+
+    struct StreamError: Codable {
+        let type: String?
+        let message: String
+    }
 }
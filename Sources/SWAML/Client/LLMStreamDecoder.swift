@@ -0,0 +1,107 @@
+import Foundation
+
+/// Decodes the server-sent event lines of a streaming completion into chunks
+///
+/// OpenAI-compatible providers send one `chat.completion.chunk` per `data:` line
+/// and finish with `data: [DONE]`. Anthropic sends typed events (`message_start`,
+/// `content_block_delta`, `message_delta`, ...) and finishes with `message_stop`.
+/// Lines that aren't `data:` fields (`event:`, `id:`, `:` comments, keep-alives)
+/// are ignored.
+struct LLMStreamDecoder {
+    private let isOpenAICompatible: Bool
+    private let decoder = JSONDecoder()
+
+    /// Whether the provider has signalled the end of the stream
+    private(set) var isFinished = false
+
+    // Anthropic reports input tokens on message_start and output tokens on message_delta
+    private var promptTokens = 0
+    private var completionTokens = 0
+    private var cachedPromptTokens: Int?
+    private var cacheCreationTokens: Int?
+
+    init(provider: LLMProvider) {
+        self.isOpenAICompatible = provider.isOpenAICompatible
+    }
+
+    /// Decode one line of the event stream
+    ///
+    /// - Returns: A chunk if the line carried text, a finish reason or usage
+    mutating func decode(line: String) throws -> LLMStreamChunk? {
+        guard !isFinished, line.hasPrefix("data:") else { return nil }
+
+        var payload = line.dropFirst(5)
+        if payload.first == " " {
+            payload = payload.dropFirst()
+        }
+        guard !payload.isEmpty else { return nil }
+
+        if payload == "[DONE]" {
+            isFinished = true
+            return nil
+        }
+
+        let data = Data(payload.utf8)
+        return isOpenAICompatible ? try decodeOpenAI(data) : try decodeAnthropic(data)
+    }
+
+    private func decodeOpenAI(_ data: Data) throws -> LLMStreamChunk? {
+        let chunk = try decoder.decode(OpenAIStreamChunk.self, from: data)
+
+        if let error = chunk.error {
+            throw SwamlError.networkError("Stream error: \(error.message)")
+        }
+
+        let choice = chunk.choices?.first
+        let delta = choice?.delta?.content ?? ""
+        guard !delta.isEmpty || choice?.finishReason != nil || chunk.usage != nil else {
+            return nil
+        }
+
+        return LLMStreamChunk(delta: delta, finishReason: choice?.finishReason, usage: chunk.usage)
+    }
+
+    private mutating func decodeAnthropic(_ data: Data) throws -> LLMStreamChunk? {
+        let event = try decoder.decode(AnthropicStreamEvent.self, from: data)
+
+        switch event.type {
+        case "message_start":
+            if let usage = event.message?.usage {
+                promptTokens = usage.totalInputTokens
+                completionTokens = usage.outputTokens
+                cachedPromptTokens = usage.cacheReadInputTokens
+                cacheCreationTokens = usage.cacheCreationInputTokens
+            }
+            return nil
+
+        case "content_block_delta":
+            guard event.delta?.type == "text_delta", let text = event.delta?.text, !text.isEmpty else {
+                return nil
+            }
+            return LLMStreamChunk(delta: text)
+
+        case "message_delta":
+            completionTokens = event.usage?.outputTokens ?? completionTokens
+            let finishReason = event.delta?.stopReason.flatMap(LLMResponse.FinishReason.init(rawValue:))
+            let usage = LLMResponse.Usage(
+                promptTokens: promptTokens,
+                completionTokens: completionTokens,
+                totalTokens: promptTokens + completionTokens,
+                cachedPromptTokens: cachedPromptTokens,
+                cacheCreationTokens: cacheCreationTokens
+            )
+            return LLMStreamChunk(delta: "", finishReason: finishReason, usage: usage)
+
+        case "message_stop":
+            isFinished = true
+            return nil
+
+        case "error":
+            throw SwamlError.networkError("Stream error: \(event.error?.message ?? "Unknown error")")
+
+        default:
+            // ping, content_block_start, content_block_stop
+            return nil
+        }
+    }
+}
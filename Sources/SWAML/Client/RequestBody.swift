@@ -0,0 +1,212 @@
+import Foundation
+#if canImport(FoundationNetworking)
+import FoundationNetworking
+#endif
+
+/// A request body with the attachments of its `JSONBodyWriter` encoded in
+///
+/// Without attachments this is just the writer's bytes. Otherwise the JSON
+/// around each attachment is copied out and the attachment's base64 is
+/// encoded directly after it, taken from the `EncodedAttachmentCache` when
+/// the same bytes were sent before. Bodies over `spoolThreshold` go to a
+/// temporary file rather than memory, and URLSession uploads them from disk.
+///
+/// The body has to outlive the request it's attached to: a spooled body's
+/// file is deleted on release.
+enum RequestBody {
+    case data(Data)
+    case file(UploadFile, length: Int)
+
+    /// Size above which a body with attachments is spooled to disk
+    static let spoolThreshold = 4 << 20
+
+    init(_ writer: JSONBodyWriter, cache: EncodedAttachmentCache = .shared) throws {
+        guard !writer.attachments.isEmpty else {
+            self = .data(writer.data)
+            return
+        }
+
+        let contents = try writer.attachments.map { try $0.attachment.contents() }
+        let length = contents.reduce(writer.bytes.count) {
+            $0 + ChatMessage.Attachment.base64Length(of: $1.count)
+        }
+        if length > Self.spoolThreshold {
+            let file = try UploadFile(prefix: "swaml-body")
+            try Self.assemble(writer, contents: contents, cache: cache) { try file.write($0) }
+            try file.close()
+            self = .file(file, length: length)
+        } else {
+            var data = Data(capacity: length)
+            try Self.assemble(writer, contents: contents, cache: cache) { data.append($0) }
+            self = .data(data)
+        }
+    }
+
+    /// Append a body to a file, as one line of a batch upload
+    static func write(_ writer: JSONBodyWriter, to file: UploadFile, cache: EncodedAttachmentCache = .shared) throws {
+        let contents = try writer.attachments.map { try $0.attachment.contents() }
+        try assemble(writer, contents: contents, cache: cache) { try file.write($0) }
+    }
+
+    var count: Int {
+        switch self {
+        case .data(let data):
+            return data.count
+        case .file(_, let length):
+            return length
+        }
+    }
+
+    /// Set the body of a request
+    ///
+    /// A spooled body is attached mapped, so it stays off the heap; where
+    /// URLSession can upload from a file, `uploadFile` is sent instead.
+    func attach(to request: inout URLRequest) throws {
+        switch self {
+        case .data(let data):
+            request.httpBody = data
+        case .file(let file, _):
+            request.httpBody = try Data(contentsOf: file.url, options: .alwaysMapped)
+        }
+    }
+
+    /// The file to upload a spooled body from
+    var uploadFile: URL? {
+        #if canImport(FoundationNetworking)
+        // swift-corelibs-foundation has no async file upload
+        return nil
+        #else
+        guard case .file(let file, _) = self else { return nil }
+        return file.url
+        #endif
+    }
+
+    private static func assemble(
+        _ writer: JSONBodyWriter,
+        contents: [Data],
+        cache: EncodedAttachmentCache,
+        _ emit: (Data) throws -> Void
+    ) throws {
+        var start = 0
+        for ((offset, attachment), data) in zip(writer.attachments, contents) {
+            try emit(Data(writer.bytes[start..<offset]))
+            try cache.encode(data, key: attachment.contentKey(of: data), emit)
+            start = offset
+        }
+        try emit(Data(writer.bytes[start...]))
+    }
+}
+
+// MARK: - Encoded Attachment Cache
+
+/// Base64 encodings of attachments, by a hash of their bytes
+///
+/// An image sent with every call of a conversation, or fetched from two
+/// URLs, is encoded once. Bounded by the total size of the encodings, oldest
+/// first out; encodings over `maxEntryBytes` aren't kept and are written a
+/// chunk at a time instead.
+final class EncodedAttachmentCache: @unchecked Sendable {
+    static let shared = EncodedAttachmentCache()
+
+    let capacity: Int
+    let maxEntryBytes: Int
+
+    private let lock = NSLock()
+    private var entries: [ResponseCacheKey: Data] = [:]
+    /// Keys, oldest first
+    private var order: [ResponseCacheKey] = []
+    private var totalBytes = 0
+
+    /// Raw bytes per chunk of an uncached encoding (a multiple of 3, so the
+    /// chunks concatenate without padding)
+    private static let chunkSize = 48 * 1024
+
+    init(capacity: Int = 32 << 20, maxEntryBytes: Int = 8 << 20) {
+        self.capacity = capacity
+        self.maxEntryBytes = maxEntryBytes
+    }
+
+    var count: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return entries.count
+    }
+
+    /// Emit the base64 encoding of `contents`
+    func encode(_ contents: Data, key: ResponseCacheKey, _ emit: (Data) throws -> Void) throws {
+        if let cached = cached(key) {
+            try emit(cached)
+            return
+        }
+
+        guard ChatMessage.Attachment.base64Length(of: contents.count) <= maxEntryBytes else {
+            var index = contents.startIndex
+            while index < contents.endIndex {
+                let end = contents.index(index, offsetBy: Self.chunkSize, limitedBy: contents.endIndex) ?? contents.endIndex
+                try emit(contents[index..<end].base64EncodedData())
+                index = end
+            }
+            return
+        }
+
+        let encoded = contents.base64EncodedData()
+        store(encoded, for: key)
+        try emit(encoded)
+    }
+
+    private func cached(_ key: ResponseCacheKey) -> Data? {
+        lock.lock()
+        defer { lock.unlock() }
+        return entries[key]
+    }
+
+    private func store(_ encoded: Data, for key: ResponseCacheKey) {
+        lock.lock()
+        defer { lock.unlock() }
+        guard entries[key] == nil else { return }
+        entries[key] = encoded
+        order.append(key)
+        totalBytes += encoded.count
+        while totalBytes > capacity, !order.isEmpty {
+            let oldest = order.removeFirst()
+            totalBytes -= entries.removeValue(forKey: oldest)?.count ?? 0
+        }
+    }
+}
+
+// MARK: - Upload File
+
+/// Temporary file a request body is serialized into before upload; deleted on release
+final class UploadFile {
+    let url: URL
+    private let handle: FileHandle
+    private var isClosed = false
+
+    init(prefix: String) throws {
+        url = FileManager.default.temporaryDirectory
+            .appendingPathComponent("\(prefix)-\(UUID().uuidString)")
+        guard FileManager.default.createFile(atPath: url.path, contents: nil) else {
+            throw SwamlError.internalError("Could not create upload file at \(url.path)")
+        }
+        handle = try FileHandle(forWritingTo: url)
+    }
+
+    deinit {
+        try? close()
+        try? FileManager.default.removeItem(at: url)
+    }
+
+    func write(_ data: Data) throws {
+        try handle.write(contentsOf: data)
+    }
+
+    func write(_ string: String) throws {
+        try write(Data(string.utf8))
+    }
+
+    func close() throws {
+        guard !isClosed else { return }
+        isClosed = true
+        try handle.close()
+    }
+}
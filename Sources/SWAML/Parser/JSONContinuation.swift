@@ -0,0 +1,154 @@
+import Foundation
+
+/// JSON output stitched together from a response cut off by the token limit
+/// and the continuations the model wrote after it
+///
+/// The open objects, arrays and strings are tracked as text is appended, so
+/// each piece is scanned once and `isComplete` says when the top-level value
+/// has been closed. Continuations are cleaned up before they're appended:
+/// - a code fence the model opened the continuation with is dropped
+/// - a continuation that opens by repeating the whole element the output
+///   stopped in (e.g. the string it was writing, 8 bytes or more) has the
+///   repeat dropped
+/// - a continuation that starts the whole output over replaces it
+public struct JSONContinuation: Sendable {
+    /// The stitched output
+    public private(set) var text = ""
+
+    /// Whether the top-level object or array has been closed
+    public private(set) var isComplete = false
+
+    /// Open containers, innermost last (`{` or `[`)
+    private var stack: [UInt8] = []
+    private var inString = false
+    private var escaped = false
+
+    /// UTF-8 offset in `text` where the element being written starts: just
+    /// past the last bracket, comma or colon outside a string
+    private var elementStart = 0
+
+    /// Shortest repeated element that's treated as a repeat rather than new text
+    static let minimumOverlap = 8
+
+    public init(_ text: String = "") {
+        append(text)
+    }
+
+    /// Whether the top-level value has been opened
+    public var hasStarted: Bool {
+        isComplete || !stack.isEmpty
+    }
+
+    /// Append the next piece of output
+    public mutating func append(_ fragment: String) {
+        guard hasStarted, !isComplete else {
+            let offset = text.utf8.count
+            text += fragment
+            scan(fragment.utf8, from: offset)
+            return
+        }
+
+        if startsOver(fragment) {
+            self = JSONContinuation(fragment)
+            return
+        }
+
+        let next = newPart(of: fragment)
+        let offset = text.utf8.count
+        text += next
+        scan(next.utf8, from: offset)
+    }
+
+    /// Text that would close everything still open, innermost first
+    public var closingSuffix: String {
+        var suffix = inString ? "\"" : ""
+        for open in stack.reversed() {
+            suffix += open == UInt8(ascii: "{") ? "}" : "]"
+        }
+        return suffix
+    }
+
+    /// Where the output stops, for the prompt asking the model to continue
+    /// (e.g. "a string in an array in an object")
+    public var openContext: String {
+        var parts = stack.reversed().map { $0 == UInt8(ascii: "{") ? "an object" : "an array" }
+        if inString {
+            parts.insert("a string", at: 0)
+        }
+        return parts.isEmpty ? "the top level" : parts.joined(separator: " in ")
+    }
+
+    // MARK: - Scanning
+
+    /// - Parameter offset: UTF-8 offset of `bytes` in `text`
+    private mutating func scan<S: Sequence>(_ bytes: S, from offset: Int) where S.Element == UInt8 {
+        for (position, byte) in zip(offset..., bytes) {
+            if isComplete {
+                return
+            }
+            if inString {
+                if escaped {
+                    escaped = false
+                } else if byte == UInt8(ascii: "\\") {
+                    escaped = true
+                } else if byte == UInt8(ascii: "\"") {
+                    inString = false
+                }
+                continue
+            }
+
+            switch byte {
+            case UInt8(ascii: "\""):
+                // Quotes in prose before the value don't open strings
+                inString = !stack.isEmpty
+            case UInt8(ascii: "{"), UInt8(ascii: "["):
+                stack.append(byte)
+                elementStart = position + 1
+            case UInt8(ascii: "}"), UInt8(ascii: "]"):
+                guard !stack.isEmpty else { continue }
+                stack.removeLast()
+                isComplete = stack.isEmpty
+                elementStart = position + 1
+            case UInt8(ascii: ","), UInt8(ascii: ":"):
+                elementStart = position + 1
+            default:
+                break
+            }
+        }
+    }
+
+    // MARK: - Cleanup
+
+    /// Whether a continuation repeats the start of the output
+    private func startsOver(_ fragment: String) -> Bool {
+        guard let start = text.firstIndex(where: { $0 == "{" || $0 == "[" }) else { return false }
+        let head = text[start...].prefix(32)
+        guard head.count >= 16 else { return false }
+
+        var candidate = Substring(fragment).drop(while: \.isWhitespace)
+        if candidate.hasPrefix("```") {
+            candidate = candidate.drop(while: { $0 != "\n" }).drop(while: \.isWhitespace)
+        }
+        return candidate.hasPrefix(head)
+    }
+
+    /// The part of a continuation that isn't already in the output
+    ///
+    /// Only an exact repeat of the element the output stopped in is dropped;
+    /// any other overlap with the output may be text that belongs there
+    /// (`[1, 2` continued with `2, 3]`).
+    private func newPart(of fragment: String) -> Substring {
+        var fragment = Substring(fragment)
+        if !inString, fragment.drop(while: \.isWhitespace).hasPrefix("```") {
+            fragment = fragment.drop(while: { $0 != "\n" }).dropFirst()
+        }
+
+        let isSpace = { (byte: UInt8) in byte == 0x20 || byte == 0x0A || byte == 0x0D || byte == 0x09 }
+        let element = text.utf8.dropFirst(elementStart).drop(while: isSpace)
+        guard element.count >= Self.minimumOverlap else { return fragment }
+
+        let body = fragment.utf8.drop(while: isSpace)
+        guard body.starts(with: element) else { return fragment }
+        return Substring(body.dropFirst(element.count))
+    }
+}
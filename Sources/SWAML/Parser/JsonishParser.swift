@@ -98,32 +98,14 @@ public struct JsonishParser {
     // MARK: - JSON Structure Extraction
 
     private static func extractAndFixJSON(from text: String, isDone: Bool) -> String? {
-        // Find all potential JSON objects and arrays
-        var candidates: [(String, Int)] = []  // (json, startIndex)
-
-        // Find JSON objects
-        var searchStart = text.startIndex
-        while let objectRange = findBalancedBraces(in: text, from: searchStart, open: "{", close: "}") {
-            let candidate = String(text[objectRange])
-            let startPos = text.distance(from: text.startIndex, to: objectRange.lowerBound)
-            candidates.append((candidate, startPos))
-            searchStart = text.index(after: objectRange.lowerBound)
-        }
-
-        // Find JSON arrays
-        searchStart = text.startIndex
-        while let arrayRange = findBalancedBraces(in: text, from: searchStart, open: "[", close: "]") {
-            let candidate = String(text[arrayRange])
-            let startPos = text.distance(from: text.startIndex, to: arrayRange.lowerBound)
-            candidates.append((candidate, startPos))
-            searchStart = text.index(after: arrayRange.lowerBound)
-        }
-
-        // Sort by position (earlier is usually better for LLM output)
-        candidates.sort { $0.1 < $1.1 }
-
-        // Try each candidate, fix it, and validate
-        for (candidate, _) in candidates {
+        // Index every balanced object/array span in one pass
+        let bytes = Array(text.utf8)
+        let index = JsonishStructuralIndex(bytes: bytes)
+
+        // Spans are ranked outermost first, so inner sub-objects are only
+        // rewritten and validated if every enclosing candidate failed
+        for span in index.spans {
+            let candidate = String(decoding: bytes[span.range], as: UTF8.self)
             if let json = fixAndValidate(candidate) {
                 return json
             }
@@ -468,54 +450,6 @@ public struct JsonishParser {
 
     // MARK: - Helpers
 
-    /// Find balanced braces/brackets starting from a given position
-    private static func findBalancedBraces(
-        in text: String,
-        from start: String.Index,
-        open: Character,
-        close: Character
-    ) -> Range<String.Index>? {
-        guard let openIndex = text[start...].firstIndex(of: open) else { return nil }
-
-        var depth = 0
-        var inString = false
-        var escapeNext = false
-        var index = openIndex
-
-        while index < text.endIndex {
-            let c = text[index]
-
-            if escapeNext {
-                escapeNext = false
-                index = text.index(after: index)
-                continue
-            }
-
-            if c == "\\" && inString {
-                escapeNext = true
-                index = text.index(after: index)
-                continue
-            }
-
-            if c == "\"" {
-                inString.toggle()
-            } else if !inString {
-                if c == open {
-                    depth += 1
-                } else if c == close {
-                    depth -= 1
-                    if depth == 0 {
-                        return openIndex..<text.index(after: index)
-                    }
-                }
-            }
-
-            index = text.index(after: index)
-        }
-
-        return nil
-    }
-
     /// Check if string is valid JSON
     private static func isValidJSON(_ string: String) -> Bool {
         guard let data = string.data(using: .utf8) else { return false }
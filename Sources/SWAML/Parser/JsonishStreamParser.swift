@@ -0,0 +1,574 @@
+import Foundation
+
+/// Incremental jsonish parser for streamed LLM output.
+///
+/// `JsonishParser.parseStreaming` re-parses the whole accumulated buffer on
+/// every delta. This parser instead keeps its tokenizer state and the partially
+/// built value between chunks, so every byte of the stream is scanned once.
+/// `current` returns the value received so far with open strings, arrays and
+/// objects closed.
+///
+/// The same repairs as `JsonishParser` are applied while scanning:
+/// - Comments (// and /* */)
+/// - Single-quoted and triple-quoted strings
+/// - Unquoted object keys
+/// - Trailing commas
+/// - Raw newlines and tabs inside strings
+///
+/// Text before the first `{` or `[` is skipped. If the output turns out not to
+/// be valid jsonish (e.g. a brace in prose), the parser discards what it has
+/// and waits for the next structure.
+///
+/// Example usage:
+/// ```swift
+/// var parser = JsonishStreamParser()
+/// for try await chunk in llmClient.stream(model: model, messages: messages) {
+///     parser.append(chunk.delta)
+///     if let partial = parser.current {
+///         render(partial)
+///     }
+/// }
+/// ```
+public struct JsonishStreamParser: Sendable {
+    private struct Container: Sendable {
+        let isObject: Bool
+        var members: [String: SwamlValue] = [:]
+        var elements: [SwamlValue] = []
+        var key: String?
+        var sawColon = false
+
+        var value: SwamlValue {
+            isObject ? .map(members) : .array(elements)
+        }
+
+        mutating func insert(_ value: SwamlValue) {
+            if isObject {
+                if let key = key {
+                    members[key] = value
+                }
+                key = nil
+                sawColon = false
+            } else {
+                elements.append(value)
+            }
+        }
+    }
+
+    private enum Token: Sendable {
+        case none
+        case string(quote: UInt8, isKey: Bool)
+        /// Saw `""` - either an empty string or the start of `"""`
+        case emptyOrTriple(isKey: Bool)
+        case tripleString(isKey: Bool)
+        case bareKey
+        case number
+        case literal
+    }
+
+    private enum Phase: Sendable {
+        case seeking
+        case parsing
+        case complete
+    }
+
+    private enum Comment: Sendable {
+        case none
+        case slash
+        case line
+        case block
+        case blockStar
+    }
+
+    private enum Escape: Sendable {
+        case none
+        case pending
+        case unicode
+    }
+
+    private var phase: Phase = .seeking
+    private var stack: [Container] = []
+    private var root: SwamlValue?
+
+    private var token: Token = .none
+    private var tokenBytes: [UInt8] = []
+    private var stringHasContent = false
+    private var escape: Escape = .none
+    private var unicodeDigits: [UInt8] = []
+    private var highSurrogate: UInt32?
+    private var comment: Comment = .none
+
+    /// Incremented whenever `current` may have changed
+    public private(set) var revision = 0
+
+    /// Number of values (scalars and containers) completed so far
+    public private(set) var completedValueCount = 0
+
+    public init() {}
+
+    // MARK: - Public API
+
+    /// Whether the top-level value has been closed
+    public var isComplete: Bool {
+        phase == .complete
+    }
+
+    /// Feed the next chunk of output
+    public mutating func append(_ chunk: String) {
+        var changed = false
+
+        for byte in chunk.utf8 {
+            guard phase != .complete else { break }
+            let wasParsing = phase == .parsing
+            consume(byte)
+            if wasParsing || phase != .seeking {
+                changed = true
+            }
+        }
+
+        if changed {
+            revision += 1
+        }
+    }
+
+    /// The value received so far, with anything still open closed
+    ///
+    /// Returns nil until the first `{` or `[` has been seen. Keys whose value
+    /// hasn't started yet and truncated `true`/`false`/`null` literals are left out.
+    public var current: SwamlValue? {
+        if let root = root {
+            return root
+        }
+        guard !stack.isEmpty else { return nil }
+
+        var value = pendingTokenValue
+        for var container in stack.reversed() {
+            if let child = value {
+                container.insert(child)
+            }
+            value = container.value
+        }
+        return value
+    }
+
+    // MARK: - Byte Dispatch
+
+    private mutating func consume(_ byte: UInt8) {
+        switch token {
+        case .none:
+            break
+
+        case .string(let quote, let isKey):
+            consumeString(byte, quote: quote, isKey: isKey)
+            return
+
+        case .emptyOrTriple(let isKey):
+            if byte == .doubleQuote {
+                token = .tripleString(isKey: isKey)
+                return
+            }
+            finishString(isKey: isKey)
+
+        case .tripleString(let isKey):
+            consumeTripleString(byte, isKey: isKey)
+            return
+
+        case .bareKey:
+            if byte.isIdentifierContinue {
+                tokenBytes.append(byte)
+                return
+            }
+            finishBareKey()
+
+        case .number:
+            if byte.isNumberContinue {
+                tokenBytes.append(byte)
+                return
+            }
+            finishNumber()
+
+        case .literal:
+            if byte.isLetter {
+                tokenBytes.append(byte)
+                return
+            }
+            finishLiteral()
+        }
+
+        consumeStructural(byte)
+    }
+
+    private mutating func consumeStructural(_ byte: UInt8) {
+        switch phase {
+        case .seeking:
+            if byte == .openBrace || byte == .openBracket {
+                stack.append(Container(isObject: byte == .openBrace))
+                phase = .parsing
+            }
+            return
+        case .complete:
+            return
+        case .parsing:
+            break
+        }
+
+        switch comment {
+        case .none:
+            break
+        case .slash:
+            if byte == .slash {
+                comment = .line
+                return
+            }
+            if byte == .star {
+                comment = .block
+                return
+            }
+            // A stray slash is ignored
+            comment = .none
+        case .line:
+            if byte == .newline {
+                comment = .none
+            }
+            return
+        case .block:
+            if byte == .star {
+                comment = .blockStar
+            }
+            return
+        case .blockStar:
+            if byte == .slash {
+                comment = .none
+            } else if byte != .star {
+                comment = .block
+            }
+            return
+        }
+
+        switch byte {
+        case .space, .newline, .carriageReturn, .tab, .comma:
+            return
+
+        case .colon:
+            guard let top = stack.last, top.isObject, top.key != nil, !top.sawColon else { return fail() }
+            stack[stack.count - 1].sawColon = true
+
+        case .slash:
+            comment = .slash
+
+        case .openBrace, .openBracket:
+            guard expectsValue else { return fail() }
+            stack.append(Container(isObject: byte == .openBrace))
+
+        case .closeBrace:
+            // A key without a value means this wasn't an object after all
+            guard let top = stack.last, top.isObject, top.key == nil else { return fail() }
+            complete(stack.removeLast().value)
+
+        case .closeBracket:
+            guard let top = stack.last, !top.isObject else { return fail() }
+            complete(stack.removeLast().value)
+
+        case .doubleQuote, .singleQuote:
+            guard expectsKey || expectsValue else { return fail() }
+            startToken(.string(quote: byte, isKey: expectsKey))
+            stringHasContent = false
+
+        case .minus, UInt8.digitZero...UInt8.digitNine:
+            guard expectsValue else { return fail() }
+            startToken(.number, with: byte)
+
+        default:
+            if expectsKey, byte.isIdentifierStart {
+                startToken(.bareKey, with: byte)
+            } else if expectsValue, byte == UInt8(ascii: "t") || byte == UInt8(ascii: "f") || byte == UInt8(ascii: "n") {
+                startToken(.literal, with: byte)
+            } else {
+                fail()
+            }
+        }
+    }
+
+    // MARK: - Strings
+
+    private mutating func consumeString(_ byte: UInt8, quote: UInt8, isKey: Bool) {
+        switch escape {
+        case .pending:
+            escape = .none
+            decodeEscape(byte)
+            return
+
+        case .unicode:
+            guard byte.hexDigitValue != nil else {
+                // Not a \uXXXX escape - keep it verbatim
+                escape = .none
+                tokenBytes.append(contentsOf: [.backslash, UInt8(ascii: "u")] + unicodeDigits)
+                consumeString(byte, quote: quote, isKey: isKey)
+                return
+            }
+            unicodeDigits.append(byte)
+            if unicodeDigits.count == 4 {
+                escape = .none
+                let value = unicodeDigits.reduce(UInt32(0)) { $0 << 4 | ($1.hexDigitValue ?? 0) }
+                appendCodeUnit(value)
+            }
+            return
+
+        case .none:
+            break
+        }
+
+        if byte == quote {
+            if quote == .doubleQuote, !stringHasContent {
+                token = .emptyOrTriple(isKey: isKey)
+                return
+            }
+            finishString(isKey: isKey)
+            return
+        }
+
+        stringHasContent = true
+
+        switch byte {
+        case .backslash:
+            escape = .pending
+        case .carriageReturn:
+            // Carriage returns inside strings are dropped
+            break
+        default:
+            flushHighSurrogate()
+            tokenBytes.append(byte)
+        }
+    }
+
+    private mutating func consumeTripleString(_ byte: UInt8, isKey: Bool) {
+        if byte == .doubleQuote,
+           tokenBytes.count >= 2,
+           tokenBytes[tokenBytes.count - 1] == .doubleQuote,
+           tokenBytes[tokenBytes.count - 2] == .doubleQuote {
+            tokenBytes.removeLast(2)
+            finishString(isKey: isKey)
+            return
+        }
+        tokenBytes.append(byte)
+    }
+
+    private mutating func decodeEscape(_ byte: UInt8) {
+        if byte != UInt8(ascii: "u") {
+            flushHighSurrogate()
+        }
+
+        switch byte {
+        case .doubleQuote, .singleQuote, .backslash, .slash:
+            tokenBytes.append(byte)
+        case UInt8(ascii: "b"):
+            tokenBytes.append(0x08)
+        case UInt8(ascii: "f"):
+            tokenBytes.append(0x0C)
+        case UInt8(ascii: "n"):
+            tokenBytes.append(.newline)
+        case UInt8(ascii: "r"):
+            tokenBytes.append(.carriageReturn)
+        case UInt8(ascii: "t"):
+            tokenBytes.append(.tab)
+        case UInt8(ascii: "u"):
+            escape = .unicode
+            unicodeDigits.removeAll(keepingCapacity: true)
+        default:
+            // Not a JSON escape - keep it verbatim (e.g. Windows paths)
+            tokenBytes.append(.backslash)
+            tokenBytes.append(byte)
+        }
+    }
+
+    private mutating func appendCodeUnit(_ codeUnit: UInt32) {
+        if let high = highSurrogate {
+            highSurrogate = nil
+            if (0xDC00...0xDFFF).contains(codeUnit) {
+                appendScalar(0x10000 + ((high - 0xD800) << 10) + (codeUnit - 0xDC00))
+                return
+            }
+            appendScalar(0xFFFD)
+        }
+
+        if (0xD800...0xDBFF).contains(codeUnit) {
+            highSurrogate = codeUnit
+            return
+        }
+        appendScalar(codeUnit)
+    }
+
+    private mutating func flushHighSurrogate() {
+        if highSurrogate != nil {
+            highSurrogate = nil
+            appendScalar(0xFFFD)
+        }
+    }
+
+    private mutating func appendScalar(_ value: UInt32) {
+        let scalar = Unicode.Scalar(value) ?? "\u{FFFD}"
+        var encoded: [UInt8] = []
+        UTF8.encode(scalar) { encoded.append($0) }
+        tokenBytes.append(contentsOf: encoded)
+    }
+
+    // MARK: - Token Completion
+
+    private mutating func startToken(_ newToken: Token, with byte: UInt8? = nil) {
+        token = newToken
+        tokenBytes.removeAll(keepingCapacity: true)
+        if let byte = byte {
+            tokenBytes.append(byte)
+        }
+    }
+
+    private mutating func finishString(isKey: Bool) {
+        flushHighSurrogate()
+        let text = String(decoding: tokenBytes, as: UTF8.self)
+        token = .none
+        if isKey {
+            stack[stack.count - 1].key = text
+        } else {
+            complete(.string(text))
+        }
+    }
+
+    private mutating func finishBareKey() {
+        token = .none
+        stack[stack.count - 1].key = String(decoding: tokenBytes, as: UTF8.self)
+    }
+
+    private mutating func finishNumber() {
+        token = .none
+        guard let value = Self.number(from: tokenBytes) else { return fail() }
+        complete(value)
+    }
+
+    private mutating func finishLiteral() {
+        token = .none
+        switch String(decoding: tokenBytes, as: UTF8.self) {
+        case "true":
+            complete(.bool(true))
+        case "false":
+            complete(.bool(false))
+        case "null":
+            complete(.null)
+        default:
+            fail()
+        }
+    }
+
+    /// Attach a finished value to its parent (or make it the root)
+    private mutating func complete(_ value: SwamlValue) {
+        completedValueCount += 1
+
+        guard !stack.isEmpty else {
+            root = value
+            phase = .complete
+            return
+        }
+        stack[stack.count - 1].insert(value)
+    }
+
+    /// Drop the current structure and wait for the next one
+    private mutating func fail() {
+        stack.removeAll()
+        token = .none
+        tokenBytes.removeAll(keepingCapacity: true)
+        escape = .none
+        highSurrogate = nil
+        comment = .none
+        phase = .seeking
+    }
+
+    // MARK: - Helpers
+
+    private var expectsKey: Bool {
+        guard let top = stack.last else { return false }
+        return top.isObject && top.key == nil
+    }
+
+    private var expectsValue: Bool {
+        guard let top = stack.last else { return false }
+        return !top.isObject || top.sawColon
+    }
+
+    /// Value of the token currently being scanned, if it can be shown partially
+    private var pendingTokenValue: SwamlValue? {
+        switch token {
+        case .string(_, isKey: false), .tripleString(isKey: false):
+            return .string(String(decoding: tokenBytes, as: UTF8.self))
+        case .emptyOrTriple(isKey: false):
+            return .string("")
+        case .number:
+            var digits = tokenBytes
+            while let last = digits.last, !last.isDigit {
+                digits.removeLast()
+            }
+            return Self.number(from: digits)
+        default:
+            return nil
+        }
+    }
+
+    private static func number(from bytes: [UInt8]) -> SwamlValue? {
+        let text = String(decoding: bytes, as: UTF8.self)
+        if let int = Int(text) {
+            return .int(int)
+        }
+        return Double(text).map(SwamlValue.float)
+    }
+}
+
+// MARK: - Byte Classification
+
+extension UInt8 {
+    fileprivate static let tab = UInt8(ascii: "\t")
+    fileprivate static let newline = UInt8(ascii: "\n")
+    fileprivate static let carriageReturn = UInt8(ascii: "\r")
+    fileprivate static let space = UInt8(ascii: " ")
+    fileprivate static let doubleQuote = UInt8(ascii: "\"")
+    fileprivate static let singleQuote = UInt8(ascii: "'")
+    fileprivate static let comma = UInt8(ascii: ",")
+    fileprivate static let minus = UInt8(ascii: "-")
+    fileprivate static let slash = UInt8(ascii: "/")
+    fileprivate static let star = UInt8(ascii: "*")
+    fileprivate static let digitZero = UInt8(ascii: "0")
+    fileprivate static let digitNine = UInt8(ascii: "9")
+    fileprivate static let colon = UInt8(ascii: ":")
+    fileprivate static let openBracket = UInt8(ascii: "[")
+    fileprivate static let backslash = UInt8(ascii: "\\")
+    fileprivate static let closeBracket = UInt8(ascii: "]")
+    fileprivate static let openBrace = UInt8(ascii: "{")
+    fileprivate static let closeBrace = UInt8(ascii: "}")
+
+    fileprivate var isDigit: Bool {
+        self >= .digitZero && self <= .digitNine
+    }
+
+    fileprivate var isLetter: Bool {
+        (self >= UInt8(ascii: "a") && self <= UInt8(ascii: "z")) ||
+        (self >= UInt8(ascii: "A") && self <= UInt8(ascii: "Z"))
+    }
+
+    fileprivate var isIdentifierStart: Bool {
+        isLetter || self == UInt8(ascii: "_") || self == UInt8(ascii: "$")
+    }
+
+    fileprivate var isIdentifierContinue: Bool {
+        isIdentifierStart || isDigit
+    }
+
+    fileprivate var isNumberContinue: Bool {
+        isDigit || self == UInt8(ascii: ".") || self == UInt8(ascii: "e") || self == UInt8(ascii: "E") ||
+        self == UInt8(ascii: "+") || self == .minus
+    }
+
+    fileprivate var hexDigitValue: UInt32? {
+        switch self {
+        case UInt8(ascii: "0")...UInt8(ascii: "9"): return UInt32(self - UInt8(ascii: "0"))
+        case UInt8(ascii: "a")...UInt8(ascii: "f"): return UInt32(self - UInt8(ascii: "a") + 10)
+        case UInt8(ascii: "A")...UInt8(ascii: "F"): return UInt32(self - UInt8(ascii: "A") + 10)
+        default: return nil
+        }
+    }
+}
@@ -0,0 +1,76 @@
+import Foundation
+
+/// One-pass structural index of the balanced `{...}` and `[...]` spans in LLM output.
+///
+/// The index is built with a single scan over the UTF-8 bytes and records every
+/// balanced span together with its nesting depth, so candidates can be ranked
+/// without re-scanning the text from each opening brace.
+///
+/// Balancing follows the same rules as candidate extraction always has:
+/// - Braces and brackets are balanced independently of each other
+/// - Double-quoted strings are skipped, but only inside an open structure
+///   (quotes in surrounding prose don't affect the scan)
+/// - An unclosed opening brace doesn't hide later candidates
+struct JsonishStructuralIndex {
+    /// A balanced span in the input
+    struct Span: Equatable {
+        /// Offset of the opening `{` or `[`
+        let start: Int
+
+        /// Offset just past the closing `}` or `]`
+        let end: Int
+
+        /// Number of structures enclosing this span (0 = top level)
+        let depth: Int
+
+        var range: Range<Int> { start..<end }
+    }
+
+    /// Balanced spans ranked for extraction: outermost first, then by position
+    let spans: [Span]
+
+    init(bytes: [UInt8]) {
+        var found: [Span] = []
+        var braces: [(start: Int, depth: Int)] = []
+        var brackets: [(start: Int, depth: Int)] = []
+        var inString = false
+        var escapeNext = false
+
+        for (offset, byte) in bytes.enumerated() {
+            if inString {
+                if escapeNext {
+                    escapeNext = false
+                } else if byte == UInt8(ascii: "\\") {
+                    escapeNext = true
+                } else if byte == UInt8(ascii: "\"") {
+                    inString = false
+                }
+                continue
+            }
+
+            switch byte {
+            case UInt8(ascii: "\""):
+                if !braces.isEmpty || !brackets.isEmpty {
+                    inString = true
+                }
+            case UInt8(ascii: "{"):
+                braces.append((offset, braces.count + brackets.count))
+            case UInt8(ascii: "["):
+                brackets.append((offset, braces.count + brackets.count))
+            case UInt8(ascii: "}"):
+                if let open = braces.popLast() {
+                    found.append(Span(start: open.start, end: offset + 1, depth: open.depth))
+                }
+            case UInt8(ascii: "]"):
+                if let open = brackets.popLast() {
+                    found.append(Span(start: open.start, end: offset + 1, depth: open.depth))
+                }
+            default:
+                break
+            }
+        }
+
+        found.sort { ($0.depth, $0.start) < ($1.depth, $1.start) }
+        self.spans = found
+    }
+}
@@ -0,0 +1,606 @@
+import Foundation
+
+/// Single-pass, byte-level implementation of SWAML's jsonish parser.
+///
+/// Works directly on the UTF-8 bytes of the LLM output and builds a `SwamlValue`
+/// while tokenizing. The repairs applied by `JsonishParser`'s string rewrite
+/// chain are handled inline instead of as separate passes:
+/// - Comments (// and /* */) are skipped like whitespace
+/// - Single-quoted and triple-quoted strings are read as regular strings
+/// - Unquoted object keys are accepted
+/// - Trailing commas before } or ] are ignored
+/// - Raw newlines and tabs inside strings are kept as content
+///
+/// There is no intermediate JSON string and no re-validation step.
+struct JsonishValueParser {
+    private let bytes: [UInt8]
+    private let end: Int
+    private let allowPartial: Bool
+    private(set) var position: Int
+
+    /// Maximum nesting depth before the input is rejected
+    static let maxDepth = 512
+
+    /// - Parameters:
+    ///   - bytes: UTF-8 input
+    ///   - start: Offset to start parsing from
+    ///   - end: Offset to stop parsing at (defaults to the end of `bytes`)
+    ///   - allowPartial: Close open strings, arrays and objects at end of input
+    ///     instead of failing (for streaming)
+    init(bytes: [UInt8], start: Int = 0, end: Int? = nil, allowPartial: Bool = false) {
+        self.bytes = bytes
+        self.end = end ?? bytes.count
+        self.allowPartial = allowPartial
+        self.position = start
+    }
+
+    // MARK: - Entry Points
+
+    /// Parse an object or array at the current position
+    ///
+    /// - Parameter requireEnd: Only succeed if nothing but whitespace and
+    ///   comments follows the value
+    mutating func parseRoot(requireEnd: Bool = false) -> SwamlValue? {
+        skipWhitespaceAndComments()
+        guard position < end, bytes[position] == .openBrace || bytes[position] == .openBracket else {
+            return nil
+        }
+        guard let value = parseValue(depth: 0) else { return nil }
+        if requireEnd {
+            skipWhitespaceAndComments()
+            guard position >= end else { return nil }
+        }
+        return value
+    }
+
+    /// Extract the best JSON value from raw LLM output
+    ///
+    /// Mirrors the stages of `JsonishParser.parse`: direct parse, markdown code
+    /// blocks and embedded candidates. For incomplete streams the first
+    /// structure is parsed partially before falling back to candidates.
+    static func extract(from bytes: [UInt8], isDone: Bool) -> (value: SwamlValue, path: JsonishParser.ExtractionPath)? {
+        // Direct parse (most common case)
+        var direct = JsonishValueParser(bytes: bytes)
+        if let value = direct.parseRoot(requireEnd: true) {
+            return (value, .direct)
+        }
+
+        // Markdown code blocks
+        if let value = extractFromCodeBlocks(bytes) {
+            return (value, .codeBlock)
+        }
+
+        // For incomplete streams, close whatever is open before looking at
+        // nested candidates (which would only be fragments of the output)
+        if !isDone, let candidate = firstStructureStart(in: bytes, from: 0) {
+            var parser = JsonishValueParser(bytes: bytes, start: candidate, allowPartial: true)
+            if let value = parser.parseRoot() {
+                return (value, .partial)
+            }
+        }
+
+        // Embedded JSON structures, outermost first
+        for span in JsonishStructuralIndex(bytes: bytes).spans {
+            var parser = JsonishValueParser(bytes: bytes, start: span.start)
+            if let value = parser.parseRoot() {
+                return (value, .embedded)
+            }
+        }
+
+        return nil
+    }
+
+    // MARK: - Values
+
+    private mutating func parseValue(depth: Int) -> SwamlValue? {
+        skipWhitespaceAndComments()
+        guard position < end else { return nil }
+
+        switch bytes[position] {
+        case .openBrace:
+            return parseObject(depth: depth + 1)
+        case .openBracket:
+            return parseArray(depth: depth + 1)
+        case .doubleQuote, .singleQuote:
+            return parseString().map(SwamlValue.string)
+        case .minus, UInt8.digitZero...UInt8.digitNine:
+            return parseNumber()
+        default:
+            return parseLiteral()
+        }
+    }
+
+    private mutating func parseObject(depth: Int) -> SwamlValue? {
+        guard depth <= Self.maxDepth else { return nil }
+        position += 1  // {
+
+        var dict: [String: SwamlValue] = [:]
+
+        while true {
+            skipWhitespaceAndComments()
+            guard position < end else { return closedAtEnd(.map(dict)) }
+
+            if bytes[position] == .closeBrace {
+                position += 1
+                return .map(dict)
+            }
+
+            guard let key = parseKey() else {
+                return closedAtEnd(.map(dict))
+            }
+
+            skipWhitespaceAndComments()
+            guard position < end else { return closedAtEnd(.map(dict)) }
+            guard bytes[position] == .colon else { return nil }
+            position += 1
+
+            guard let value = parseValue(depth: depth) else {
+                // A value cut off by the end of the stream is dropped
+                return closedAtEnd(.map(dict))
+            }
+            dict[key] = value
+
+            skipWhitespaceAndComments()
+            guard position < end else { return closedAtEnd(.map(dict)) }
+
+            switch bytes[position] {
+            case .comma:
+                position += 1
+            case .closeBrace:
+                break
+            default:
+                return nil
+            }
+        }
+    }
+
+    private mutating func parseArray(depth: Int) -> SwamlValue? {
+        guard depth <= Self.maxDepth else { return nil }
+        position += 1  // [
+
+        var elements: [SwamlValue] = []
+
+        while true {
+            skipWhitespaceAndComments()
+            guard position < end else { return closedAtEnd(.array(elements)) }
+
+            if bytes[position] == .closeBracket {
+                position += 1
+                return .array(elements)
+            }
+
+            guard let element = parseValue(depth: depth) else {
+                return closedAtEnd(.array(elements))
+            }
+            elements.append(element)
+
+            skipWhitespaceAndComments()
+            guard position < end else { return closedAtEnd(.array(elements)) }
+
+            switch bytes[position] {
+            case .comma:
+                position += 1
+            case .closeBracket:
+                break
+            default:
+                return nil
+            }
+        }
+    }
+
+    /// Result for a structure that was cut off by the end of the input
+    private func closedAtEnd(_ value: SwamlValue) -> SwamlValue? {
+        allowPartial && position >= end ? value : nil
+    }
+
+    // MARK: - Keys
+
+    /// Parse a quoted or bare-identifier object key
+    private mutating func parseKey() -> String? {
+        let byte = bytes[position]
+        if byte == .doubleQuote || byte == .singleQuote {
+            return parseString()
+        }
+
+        guard byte.isIdentifierStart else { return nil }
+        let start = position
+        position += 1
+        while position < end, bytes[position].isIdentifierContinue {
+            position += 1
+        }
+        return String(decoding: bytes[start..<position], as: UTF8.self)
+    }
+
+    // MARK: - Strings
+
+    private mutating func parseString() -> String? {
+        let quote = bytes[position]
+
+        if quote == .doubleQuote,
+           position + 2 < end,
+           bytes[position + 1] == .doubleQuote,
+           bytes[position + 2] == .doubleQuote {
+            return parseTripleQuotedString()
+        }
+
+        position += 1
+        let contentStart = position
+
+        // Only materialized once the content differs from the raw bytes
+        var scratch: [UInt8] = []
+        var usesScratch = false
+
+        while position < end {
+            let byte = bytes[position]
+
+            if byte == quote {
+                let text = usesScratch
+                    ? String(decoding: scratch, as: UTF8.self)
+                    : String(decoding: bytes[contentStart..<position], as: UTF8.self)
+                position += 1
+                return text
+            }
+
+            if byte == .backslash || byte == .carriageReturn {
+                if !usesScratch {
+                    scratch.reserveCapacity(position - contentStart + 16)
+                    scratch.append(contentsOf: bytes[contentStart..<position])
+                    usesScratch = true
+                }
+                if byte == .carriageReturn {
+                    // Carriage returns inside strings are dropped
+                    position += 1
+                    continue
+                }
+                position += 1
+                guard position < end else { break }
+                decodeEscape(into: &scratch)
+                continue
+            }
+
+            if usesScratch {
+                scratch.append(byte)
+            }
+            position += 1
+        }
+
+        // Unterminated string
+        guard allowPartial else { return nil }
+        position = end
+        return usesScratch
+            ? String(decoding: scratch, as: UTF8.self)
+            : String(decoding: bytes[contentStart..<end], as: UTF8.self)
+    }
+
+    /// Parse a Python-style `"""..."""` string (content is taken verbatim)
+    private mutating func parseTripleQuotedString() -> String? {
+        position += 3
+        let contentStart = position
+
+        while position + 2 < end {
+            if bytes[position] == .doubleQuote,
+               bytes[position + 1] == .doubleQuote,
+               bytes[position + 2] == .doubleQuote {
+                let text = String(decoding: bytes[contentStart..<position], as: UTF8.self)
+                position += 3
+                return text
+            }
+            position += 1
+        }
+
+        guard allowPartial else { return nil }
+        position = end
+        return String(decoding: bytes[contentStart..<end], as: UTF8.self)
+    }
+
+    /// Decode the escape sequence whose introducing backslash was just consumed
+    private mutating func decodeEscape(into buffer: inout [UInt8]) {
+        let byte = bytes[position]
+        position += 1
+
+        switch byte {
+        case .doubleQuote, .singleQuote, .backslash, .slash:
+            buffer.append(byte)
+        case UInt8(ascii: "b"):
+            buffer.append(0x08)
+        case UInt8(ascii: "f"):
+            buffer.append(0x0C)
+        case UInt8(ascii: "n"):
+            buffer.append(.newline)
+        case UInt8(ascii: "r"):
+            buffer.append(.carriageReturn)
+        case UInt8(ascii: "t"):
+            buffer.append(.tab)
+        case UInt8(ascii: "u"):
+            guard var codeUnit = readHexQuad() else {
+                buffer.append(contentsOf: [.backslash, byte])
+                return
+            }
+            // Combine UTF-16 surrogate pairs
+            if (0xD800...0xDBFF).contains(codeUnit),
+               position + 1 < end,
+               bytes[position] == .backslash,
+               bytes[position + 1] == UInt8(ascii: "u") {
+                let saved = position
+                position += 2
+                if let low = readHexQuad(), (0xDC00...0xDFFF).contains(low) {
+                    codeUnit = 0x10000 + ((codeUnit - 0xD800) << 10) + (low - 0xDC00)
+                } else {
+                    position = saved
+                }
+            }
+            let scalar = Unicode.Scalar(codeUnit) ?? "\u{FFFD}"
+            UTF8.encode(scalar) { buffer.append($0) }
+        default:
+            // Not a JSON escape - keep it verbatim (e.g. Windows paths)
+            buffer.append(.backslash)
+            buffer.append(byte)
+        }
+    }
+
+    private mutating func readHexQuad() -> UInt32? {
+        guard position + 4 <= end else { return nil }
+        var value: UInt32 = 0
+        for offset in 0..<4 {
+            guard let digit = bytes[position + offset].hexDigitValue else { return nil }
+            value = value << 4 | digit
+        }
+        position += 4
+        return value
+    }
+
+    // MARK: - Numbers
+
+    private mutating func parseNumber() -> SwamlValue? {
+        let start = position
+        var isFloat = false
+
+        if bytes[position] == .minus {
+            position += 1
+        }
+        let integerStart = position
+        skipDigits()
+        guard position > integerStart else { return nil }
+
+        if position + 1 < end, bytes[position] == .dot, bytes[position + 1].isDigit {
+            isFloat = true
+            position += 1
+            skipDigits()
+        }
+
+        if position < end, bytes[position] == .lowerE || bytes[position] == .upperE {
+            var lookahead = position + 1
+            if lookahead < end, bytes[lookahead] == .plus || bytes[lookahead] == .minus {
+                lookahead += 1
+            }
+            if lookahead < end, bytes[lookahead].isDigit {
+                isFloat = true
+                position = lookahead
+                skipDigits()
+            }
+        }
+
+        let text = String(decoding: bytes[start..<position], as: UTF8.self)
+        if !isFloat, let int = Int(text) {
+            return .int(int)
+        }
+        return Double(text).map(SwamlValue.float)
+    }
+
+    private mutating func skipDigits() {
+        while position < end, bytes[position].isDigit {
+            position += 1
+        }
+    }
+
+    // MARK: - Literals
+
+    private static let literals: [(word: [UInt8], value: SwamlValue)] = [
+        (Array("true".utf8), .bool(true)),
+        (Array("false".utf8), .bool(false)),
+        (Array("null".utf8), .null),
+    ]
+
+    private mutating func parseLiteral() -> SwamlValue? {
+        let available = end - position
+
+        for literal in Self.literals {
+            let length = min(literal.word.count, available)
+            guard bytes[position..<(position + length)].elementsEqual(literal.word[0..<length]) else {
+                continue
+            }
+            if length == literal.word.count {
+                position += length
+                return literal.value
+            }
+            // Literal cut off by the end of the stream
+            if allowPartial {
+                position = end
+            }
+            return nil
+        }
+
+        return nil
+    }
+
+    // MARK: - Whitespace and Comments
+
+    private mutating func skipWhitespaceAndComments() {
+        while position < end {
+            let byte = bytes[position]
+
+            if byte.isWhitespace {
+                position += 1
+                continue
+            }
+
+            guard byte == .slash, position + 1 < end else { return }
+
+            switch bytes[position + 1] {
+            case .slash:
+                position += 2
+                while position < end, bytes[position] != .newline {
+                    position += 1
+                }
+            case .star:
+                position += 2
+                while position + 1 < end, !(bytes[position] == .star && bytes[position + 1] == .slash) {
+                    position += 1
+                }
+                position = min(position + 2, end)
+            default:
+                return
+            }
+        }
+    }
+
+    // MARK: - Scanning Helpers
+
+    /// Offset of the next `{` or `[` at or after `start`
+    static func firstStructureStart(in bytes: [UInt8], from start: Int) -> Int? {
+        var index = start
+        while index < bytes.count {
+            if bytes[index] == .openBrace || bytes[index] == .openBracket {
+                return index
+            }
+            index += 1
+        }
+        return nil
+    }
+
+    /// Try each fenced markdown code block in order
+    private static func extractFromCodeBlocks(_ bytes: [UInt8]) -> SwamlValue? {
+        var searchStart = 0
+
+        while let open = fenceStart(in: bytes, from: searchStart) {
+            // Skip the language tag (```json, ```JSON, ...)
+            var contentStart = open + 3
+            while contentStart < bytes.count, bytes[contentStart].isIdentifierContinue {
+                contentStart += 1
+            }
+
+            guard let close = fenceStart(in: bytes, from: contentStart) else {
+                return nil
+            }
+
+            var parser = JsonishValueParser(bytes: bytes, start: contentStart, end: close)
+            if let value = parser.parseRoot(requireEnd: true) {
+                return value
+            }
+
+            searchStart = close + 3
+        }
+
+        return nil
+    }
+
+    private static func fenceStart(in bytes: [UInt8], from start: Int) -> Int? {
+        var index = start
+        while index + 2 < bytes.count {
+            if bytes[index] == .backtick, bytes[index + 1] == .backtick, bytes[index + 2] == .backtick {
+                return index
+            }
+            index += 1
+        }
+        return nil
+    }
+}
+
+// MARK: - Public API
+
+extension JsonishParser {
+    /// Which stage of extraction produced a parsed value
+    public enum ExtractionPath: String, Sendable {
+        /// The whole output was one (possibly repaired) JSON value
+        case direct
+
+        /// The value was inside a markdown code block
+        case codeBlock
+
+        /// An incomplete stream was closed off at the end of the input
+        case partial
+
+        /// The value was embedded in surrounding text
+        case embedded
+    }
+
+    /// Parse LLM output directly into a `SwamlValue`
+    ///
+    /// Single-pass alternative to `parse(_:isDone:)` that applies the same
+    /// repairs while tokenizing the UTF-8 bytes, without building an
+    /// intermediate JSON string or re-validating it with `JSONSerialization`.
+    ///
+    /// - Parameter input: Raw LLM output
+    /// - Parameter isDone: Whether the stream is complete (for streaming support)
+    /// - Returns: The parsed value
+    /// - Throws: SwamlError if no valid JSON can be extracted
+    public static func parseValue(_ input: String, isDone: Bool = true) throws -> SwamlValue {
+        if let extracted = JsonishValueParser.extract(from: Array(input.utf8), isDone: isDone) {
+            CallTrace.record { $0.parsePaths.append(extracted.path) }
+            return extracted.value
+        }
+
+        // For streaming, be more lenient with partial content
+        if !isDone {
+            return .map([:])
+        }
+
+        let trimmed = input.trimmingCharacters(in: .whitespacesAndNewlines)
+        throw SwamlError.parseError("Could not extract valid JSON from output: \(trimmed.prefix(200))")
+    }
+}
+
+// MARK: - Byte Classification
+
+extension UInt8 {
+    fileprivate static let tab = UInt8(ascii: "\t")
+    fileprivate static let newline = UInt8(ascii: "\n")
+    fileprivate static let carriageReturn = UInt8(ascii: "\r")
+    fileprivate static let space = UInt8(ascii: " ")
+    fileprivate static let doubleQuote = UInt8(ascii: "\"")
+    fileprivate static let singleQuote = UInt8(ascii: "'")
+    fileprivate static let plus = UInt8(ascii: "+")
+    fileprivate static let comma = UInt8(ascii: ",")
+    fileprivate static let minus = UInt8(ascii: "-")
+    fileprivate static let dot = UInt8(ascii: ".")
+    fileprivate static let slash = UInt8(ascii: "/")
+    fileprivate static let star = UInt8(ascii: "*")
+    fileprivate static let digitZero = UInt8(ascii: "0")
+    fileprivate static let digitNine = UInt8(ascii: "9")
+    fileprivate static let colon = UInt8(ascii: ":")
+    fileprivate static let upperE = UInt8(ascii: "E")
+    fileprivate static let lowerE = UInt8(ascii: "e")
+    fileprivate static let openBracket = UInt8(ascii: "[")
+    fileprivate static let backslash = UInt8(ascii: "\\")
+    fileprivate static let closeBracket = UInt8(ascii: "]")
+    fileprivate static let backtick = UInt8(ascii: "`")
+    fileprivate static let openBrace = UInt8(ascii: "{")
+    fileprivate static let closeBrace = UInt8(ascii: "}")
+
+    fileprivate var isWhitespace: Bool {
+        self == .space || self == .newline || self == .carriageReturn || self == .tab
+    }
+
+    fileprivate var isDigit: Bool {
+        self >= .digitZero && self <= .digitNine
+    }
+
+    fileprivate var isIdentifierStart: Bool {
+        (self >= UInt8(ascii: "a") && self <= UInt8(ascii: "z")) ||
+        (self >= UInt8(ascii: "A") && self <= UInt8(ascii: "Z")) ||
+        self == UInt8(ascii: "_") || self == UInt8(ascii: "$")
+    }
+
+    fileprivate var isIdentifierContinue: Bool {
+        isIdentifierStart || isDigit
+    }
+
+    fileprivate var hexDigitValue: UInt32? {
+        switch self {
+        case UInt8(ascii: "0")...UInt8(ascii: "9"): return UInt32(self - UInt8(ascii: "0"))
+        case UInt8(ascii: "a")...UInt8(ascii: "f"): return UInt32(self - UInt8(ascii: "a") + 10)
+        case UInt8(ascii: "A")...UInt8(ascii: "F"): return UInt32(self - UInt8(ascii: "A") + 10)
+        default: return nil
+        }
+    }
+}
@@ -9,55 +9,56 @@ public struct OutputParser {
         schema: JSONSchema? = nil,
         type: T.Type
     ) throws -> T {
-        // Extract JSON from potentially wrapped output
-        let jsonString = try JSONExtractor.extract(from: output)
-
-        // Get JSON data for decoding
-        let data: Data
-        if let schema = schema {
-            // Parse to SwamlValue for coercion
-            var swamlValue = try SwamlValue.fromJSONString(jsonString)
-            swamlValue = try applySchemaCoercion(swamlValue, schema: schema)
-            let coercedJSON = try swamlValue.toJSONString()
-            guard let d = coercedJSON.data(using: .utf8) else {
-                throw SwamlError.parseError("Failed to convert to UTF-8")
-            }
-            data = d
-        } else {
-            // Decode directly without going through SwamlValue
-            guard let d = jsonString.data(using: .utf8) else {
-                throw SwamlError.parseError("Failed to convert to UTF-8")
-            }
-            data = d
+        try parse(output, plan: schema.map(SchemaPlan.cached(for:)), type: type)
+    }
+
+    /// Parse raw LLM output into a typed value, coercing with a compiled plan
+    public static func parse<T: Codable>(
+        _ output: String,
+        plan: SchemaPlan?,
+        type: T.Type
+    ) throws -> T {
+        let swamlValue = try CallTrace.measure(.parse) {
+            // Extract the value from potentially wrapped output in one pass
+            let value = try JsonishParser.parseValue(output)
+            return try plan?.coerce(value) ?? value
         }
 
-        // Try decoding with snake_case conversion first, then without
+        // Decode straight from the value tree; snake_case keys are matched
+        // in the same lookup as camelCase ones
         do {
-            let decoder = JSONDecoder()
-            decoder.keyDecodingStrategy = .convertFromSnakeCase
-            return try decoder.decode(T.self, from: data)
-        } catch {
-            // Retry without key conversion for already-camelCase JSON
-            do {
-                let decoder = JSONDecoder()
-                return try decoder.decode(T.self, from: data)
-            } catch let error2 {
-                throw SwamlError.parseError("Failed to decode \(T.self): \(error2.localizedDescription)")
+            return try CallTrace.measure(.decode) {
+                try SwamlValueDecoder().decode(T.self, from: swamlValue)
             }
+        } catch {
+            throw SwamlError.parseError("Failed to decode \(T.self): \(error.localizedDescription)")
         }
     }
 
     /// Parse raw output to SwamlValue with schema validation
     public static func parseToValue(_ output: String, schema: JSONSchema? = nil) throws -> SwamlValue {
-        let jsonString = try JSONExtractor.extract(from: output)
-        var swamlValue = try SwamlValue.fromJSONString(jsonString)
+        try parseToValue(output, plan: schema.map(SchemaPlan.cached(for:)))
+    }
+
+    /// Parse raw output to SwamlValue, coercing and validating with a compiled plan
+    public static func parseToValue(_ output: String, plan: SchemaPlan?) throws -> SwamlValue {
+        try CallTrace.measure(.parse) {
+            var swamlValue = try JsonishParser.parseValue(output)
 
-        if let schema = schema {
-            swamlValue = try applySchemaCoercion(swamlValue, schema: schema)
-            try validateAgainstSchema(swamlValue, schema: schema)
+            if let plan = plan {
+                swamlValue = try plan.coerce(swamlValue)
+                try plan.validate(swamlValue)
+            }
+
+            return swamlValue
         }
+    }
 
-        return swamlValue
+    /// Parse raw output into the compact representation used for large results
+    ///
+    /// Same parsing and validation as `parseToValue`; see `CompactSwamlValue`.
+    public static func parseToCompactValue(_ output: String, schema: JSONSchema? = nil) throws -> CompactSwamlValue {
+        try parseToValue(output, schema: schema).compacted(schema: schema)
     }
 
     /// Parse with repair attempts for malformed JSON
@@ -77,126 +78,64 @@ public struct OutputParser {
             throw error
         }
     }
+}
 
-    // MARK: - Schema Coercion
-
-    private static func applySchemaCoercion(_ value: SwamlValue, schema: JSONSchema) throws -> SwamlValue {
-        switch schema {
-        case .string:
-            return try TypeCoercion.coerce(value, to: FieldType.string)
-        case .integer:
-            return try TypeCoercion.coerce(value, to: FieldType.int)
-        case .number:
-            return try TypeCoercion.coerce(value, to: FieldType.float)
-        case .boolean:
-            return try TypeCoercion.coerce(value, to: FieldType.bool)
-        case .null:
-            if value.isNull {
-                return value
-            }
-            throw SwamlError.typeCoercionError(expected: "null", actual: value.typeName)
-        case .array(let items):
-            guard case .array(let elements) = value else {
-                throw SwamlError.typeCoercionError(expected: "array", actual: value.typeName)
-            }
-            let coercedElements = try elements.map { try applySchemaCoercion($0, schema: items) }
-            return .array(coercedElements)
-        case .object(let properties, _, _):
-            guard case .map(var dict) = value else {
-                throw SwamlError.typeCoercionError(expected: "object", actual: value.typeName)
-            }
-            for (key, propSchema) in properties {
-                if let propValue = dict[key] {
-                    dict[key] = try applySchemaCoercion(propValue, schema: propSchema)
-                }
-            }
-            return .map(dict)
-        case .enum:
-            // Enum values should be strings
-            return try TypeCoercion.coerce(value, to: FieldType.string)
-        case .ref:
-            // References are resolved at a higher level
+// MARK: - Structured Output
+
+extension OutputParser {
+    /// Parse a response into a typed value
+    ///
+    /// Content the provider held to the schema (see
+    /// `LLMResponse.isSchemaConstrained`) is decoded as-is with `JSONDecoder`;
+    /// extraction, repair and coercion only run if that fails.
+    public static func parse<T: Codable>(
+        _ response: LLMResponse,
+        plan: SchemaPlan?,
+        type: T.Type
+    ) throws -> T {
+        if response.isSchemaConstrained, let value = decodeStrict(response.content, as: T.self) {
             return value
-        case .anyOf(let schemas):
-            // Try each schema until one works
-            for subSchema in schemas {
-                if let coerced = try? applySchemaCoercion(value, schema: subSchema) {
-                    return coerced
-                }
-            }
-            throw SwamlError.schemaValidationError("Value doesn't match any schema in anyOf")
         }
+        return try parse(response.content, plan: plan, type: type)
     }
 
-    // MARK: - Schema Validation
+    /// Parse a response to SwamlValue, validating with a compiled plan
+    ///
+    /// Schema-constrained content is read as plain JSON and only validated;
+    /// `parseToValue(_:plan:)` is the fallback.
+    public static func parseToValue(_ response: LLMResponse, plan: SchemaPlan?) throws -> SwamlValue {
+        if response.isSchemaConstrained, let value = strictValue(response.content, plan: plan) {
+            return value
+        }
+        return try parseToValue(response.content, plan: plan)
+    }
 
-    private static func validateAgainstSchema(_ value: SwamlValue, schema: JSONSchema) throws {
-        switch schema {
-        case .string:
-            guard value.isString else {
-                throw SwamlError.schemaValidationError("Expected string, got \(value.typeName)")
-            }
-        case .integer:
-            guard value.isInt else {
-                throw SwamlError.schemaValidationError("Expected integer, got \(value.typeName)")
-            }
-        case .number:
-            guard value.isNumber else {
-                throw SwamlError.schemaValidationError("Expected number, got \(value.typeName)")
-            }
-        case .boolean:
-            guard value.isBool else {
-                throw SwamlError.schemaValidationError("Expected boolean, got \(value.typeName)")
-            }
-        case .null:
-            guard value.isNull else {
-                throw SwamlError.schemaValidationError("Expected null, got \(value.typeName)")
-            }
-        case .array(let items):
-            guard let elements = value.arrayValue else {
-                throw SwamlError.schemaValidationError("Expected array, got \(value.typeName)")
-            }
-            for element in elements {
-                try validateAgainstSchema(element, schema: items)
-            }
-        case .object(let properties, let required, _):
-            guard let dict = value.mapValue else {
-                throw SwamlError.schemaValidationError("Expected object, got \(value.typeName)")
-            }
-            // Check required properties
-            for reqKey in required {
-                guard dict[reqKey] != nil else {
-                    throw SwamlError.schemaValidationError("Missing required property: \(reqKey)")
-                }
-            }
-            // Validate property types
-            for (key, propSchema) in properties {
-                if let propValue = dict[key] {
-                    try validateAgainstSchema(propValue, schema: propSchema)
-                }
-            }
-        case .enum(let values):
-            guard let stringValue = value.stringValue else {
-                throw SwamlError.schemaValidationError("Enum value must be a string")
-            }
-            guard values.contains(stringValue) else {
-                throw SwamlError.schemaValidationError("Invalid enum value: \(stringValue). Expected one of: \(values.joined(separator: ", "))")
-            }
-        case .ref:
-            // Reference validation happens at schema resolution time
-            break
-        case .anyOf(let schemas):
-            var valid = false
-            for subSchema in schemas {
-                if (try? validateAgainstSchema(value, schema: subSchema)) != nil {
-                    valid = true
-                    break
-                }
-            }
-            if !valid {
-                throw SwamlError.schemaValidationError("Value doesn't match any schema in anyOf")
+    /// `content` decoded by `JSONDecoder`, or nil if it doesn't decode
+    static func decodeStrict<T: Decodable>(_ content: String, as type: T.Type) -> T? {
+        let decoded = CallTrace.measure(.decode) {
+            try? JSONDecoder().decode(T.self, from: Data(content.utf8))
+        }
+        if decoded != nil {
+            CallTrace.record { $0.strictDecodes += 1 }
+        }
+        return decoded
+    }
+
+    /// `content` read as JSON, or nil if it isn't JSON or fails validation
+    private static func strictValue(_ content: String, plan: SchemaPlan?) -> SwamlValue? {
+        let value: SwamlValue? = CallTrace.measure(.parse) {
+            guard let value = try? SwamlValue.fromJSONString(content) else { return nil }
+            do {
+                try plan?.validate(value)
+            } catch {
+                return nil
             }
+            return value
+        }
+        if value != nil {
+            CallTrace.record { $0.strictDecodes += 1 }
         }
+        return value
     }
 }
 
@@ -0,0 +1,599 @@
+import Foundation
+
+/// A `JSONSchema` lowered into a flat program for coercing and validating values.
+///
+/// Compiling resolves everything that doesn't depend on the value once:
+/// - nodes live in one array and refer to each other by index
+/// - enum values are a hashed set
+/// - `.ref`s to dynamic enums are replaced with their values; other refs
+///   accept anything, as before
+/// - object properties are sorted, so errors are reported deterministically
+/// - each `anyOf` knows which branches can accept each kind of value, and
+///   dispatches objects on a discriminator (a required property whose enum
+///   values tell the branches apart) when the branches have one
+///
+/// Branch misses inside `anyOf` are recorded without building errors; a
+/// `SwamlError` is only created for the failure that's reported.
+///
+/// Plans are immutable and safe to share. `OutputParser` compiles and caches
+/// them per schema (`SchemaPlan.cached(for:)`); the runtime keeps one per
+/// function alongside its resolved schema.
+public final class SchemaPlan: Sendable {
+    /// Kinds of `SwamlValue`, for `anyOf` dispatch
+    private enum Kind: Int, CaseIterable {
+        case null, bool, int, float, string, array, map
+
+        init(_ value: SwamlValue) {
+            switch value {
+            case .null: self = .null
+            case .bool: self = .bool
+            case .int: self = .int
+            case .float: self = .float
+            case .string: self = .string
+            case .array: self = .array
+            case .map: self = .map
+            }
+        }
+    }
+
+    private struct Field: Sendable {
+        let key: String
+        let node: Int
+    }
+
+    private struct Discriminator: Sendable {
+        let key: String
+        let branches: [String: Int]
+    }
+
+    private struct Branches: Sendable {
+        /// All branches, in schema order
+        let all: [Int]
+
+        /// Branches that could accept a value, by `Kind.rawValue`
+        let byKind: [[Int]]
+
+        let discriminator: Discriminator?
+    }
+
+    private enum Node: Sendable {
+        case string
+        case integer
+        case number
+        case boolean
+        case null
+        case any
+        case array(item: Int)
+        case object(fields: [Field], required: [String])
+        case enumeration(Set<String>, ordered: [String])
+        case anyOf(Branches)
+    }
+
+    /// Why a value was rejected; turned into a `SwamlError` only when reported
+    private enum Failure {
+        case coercion(expected: String, actual: SwamlValue)
+        case unexpected(expected: String, actual: SwamlValue)
+        case missingRequired(String)
+        case enumNotString
+        case invalidEnum(String, allowed: [String])
+        case noMatchingBranch
+
+        var error: SwamlError {
+            switch self {
+            case .coercion(let expected, let actual):
+                switch (expected, actual) {
+                case ("int", .float(let v)):
+                    let reason = v.truncatingRemainder(dividingBy: 1) == 0 ? "float out of range" : "float with decimal"
+                    return .typeCoercionError(expected: expected, actual: reason)
+                case ("int", .string(let s)), ("float", .string(let s)), ("bool", .string(let s)):
+                    return .typeCoercionError(expected: expected, actual: "string '\(s)'")
+                default:
+                    return .typeCoercionError(expected: expected, actual: actual.typeName)
+                }
+            case .unexpected(let expected, let actual):
+                return .schemaValidationError("Expected \(expected), got \(actual.typeName)")
+            case .missingRequired(let key):
+                return .schemaValidationError("Missing required property: \(key)")
+            case .enumNotString:
+                return .schemaValidationError("Enum value must be a string")
+            case .invalidEnum(let value, let allowed):
+                return .schemaValidationError(
+                    "Invalid enum value: \(value). Expected one of: \(allowed.joined(separator: ", "))"
+                )
+            case .noMatchingBranch:
+                return .schemaValidationError("Value doesn't match any schema in anyOf")
+            }
+        }
+    }
+
+    private let nodes: [Node]
+    private let root: Int
+
+    /// Compile a schema
+    ///
+    /// - Parameter dynamicEnums: Values of dynamic enums, substituted for
+    ///   `.ref`s with the same name
+    public init(schema: JSONSchema, dynamicEnums: [String: [String]] = [:]) {
+        var compiler = Compiler(dynamicEnums: dynamicEnums.mapValues { (Set($0), $0) })
+        self.root = compiler.compile(schema)
+        self.nodes = compiler.nodes
+    }
+
+    /// Compile a schema, reusing the value sets of dynamic enum indexes
+    init(schema: JSONSchema, enumIndexes: [String: DynamicEnumIndex]) {
+        var compiler = Compiler(dynamicEnums: enumIndexes.mapValues { ($0.valueSet, $0.values) })
+        self.root = compiler.compile(schema)
+        self.nodes = compiler.nodes
+    }
+
+    /// Compile a schema, resolving refs against a TypeBuilder's dynamic enums
+    public convenience init(schema: JSONSchema, typeBuilder: TypeBuilder?) {
+        self.init(schema: schema, enumIndexes: typeBuilder?.snapshot().enumIndexes ?? [:])
+    }
+
+    // MARK: - Running
+
+    /// Coerce a value to the schema (e.g. `"42"` to an integer field)
+    public func coerce(_ value: SwamlValue) throws -> SwamlValue {
+        var failure: Failure?
+        guard let coerced = coerce(value, root, &failure) else {
+            throw (failure ?? .noMatchingBranch).error
+        }
+        return coerced
+    }
+
+    /// Check that a (coerced) value matches the schema
+    public func validate(_ value: SwamlValue) throws {
+        var failure: Failure?
+        guard validate(value, root, &failure) else {
+            throw (failure ?? .noMatchingBranch).error
+        }
+    }
+
+    /// Check that a value that's still streaming in can become a match
+    ///
+    /// `value` is a prefix of the final output, as `JsonishStreamParser.current`
+    /// returns it: strings and numbers may be cut short and properties still
+    /// missing, so required properties aren't checked and strings only need to
+    /// start some value they could coerce to. What's rejected can't be fixed
+    /// by more output, such as an object where an array belongs, or a string
+    /// that no enum value starts with (ignoring case).
+    public func validatePrefix(_ value: SwamlValue) throws {
+        var failure: Failure?
+        guard validatePrefix(value, root, &failure) else {
+            throw (failure ?? .noMatchingBranch).error
+        }
+    }
+
+    private func validatePrefix(_ value: SwamlValue, _ index: Int, _ failure: inout Failure?) -> Bool {
+        switch nodes[index] {
+        case .string:
+            return check(!value.isNull && !value.isArray && !value.isMap, "string", value, &failure)
+        case .integer, .number:
+            switch value {
+            case .int, .float, .bool:
+                return true
+            case .string(let s):
+                return check(s.allSatisfy { "0123456789+-.eE ".contains($0) }, "number", value, &failure)
+            default:
+                return check(false, "number", value, &failure)
+            }
+        case .boolean:
+            switch value {
+            case .bool, .int:
+                return true
+            case .string(let s):
+                let prefix = s.lowercased()
+                let accepted = ["true", "false", "yes", "no", "1", "0"].contains { $0.hasPrefix(prefix) }
+                return check(accepted, "boolean", value, &failure)
+            default:
+                return check(false, "boolean", value, &failure)
+            }
+        case .null:
+            return check(value.isNull, "null", value, &failure)
+        case .any:
+            return true
+
+        case .array(let item):
+            guard case .array(let elements) = value else {
+                failure = .unexpected(expected: "array", actual: value)
+                return false
+            }
+            for element in elements where !validatePrefix(element, item, &failure) {
+                return false
+            }
+            return true
+
+        case .object(let fields, _):
+            guard case .map(let dict) = value else {
+                failure = .unexpected(expected: "object", actual: value)
+                return false
+            }
+            for field in fields {
+                if let propValue = dict[field.key], !validatePrefix(propValue, field.node, &failure) {
+                    return false
+                }
+            }
+            return true
+
+        case .enumeration(_, let ordered):
+            let text: String
+            switch value {
+            case .string(let string):
+                text = string
+            case .int, .float, .bool:
+                guard let coerced = coerce(value, index, &failure)?.stringValue else { return false }
+                text = coerced
+            default:
+                failure = .enumNotString
+                return false
+            }
+            let prefix = text.lowercased()
+            guard ordered.contains(where: { $0.lowercased().hasPrefix(prefix) }) else {
+                failure = .invalidEnum(text, allowed: ordered)
+                return false
+            }
+            return true
+
+        case .anyOf(let branches):
+            var ignored: Failure?
+            for branch in branches.all where validatePrefix(value, branch, &ignored) {
+                return true
+            }
+            failure = .noMatchingBranch
+            return false
+        }
+    }
+
+    private func coerce(_ value: SwamlValue, _ index: Int, _ failure: inout Failure?) -> SwamlValue? {
+        switch nodes[index] {
+        case .string, .enumeration:
+            switch value {
+            case .string:
+                return value
+            case .int(let v):
+                return .string(String(v))
+            case .float(let v):
+                return .string(String(v))
+            case .bool(let v):
+                return .string(v ? "true" : "false")
+            case .null, .array, .map:
+                failure = .coercion(expected: "string", actual: value)
+                return nil
+            }
+
+        case .integer:
+            switch value {
+            case .int:
+                return value
+            case .float(let v):
+                // Whole and in range; anything else fails validation below
+                if let intValue = Int(exactly: v) {
+                    return .int(intValue)
+                }
+            case .string(let s):
+                if let intValue = Int(s) ?? Double(s).flatMap({ Int(exactly: $0) }) {
+                    return .int(intValue)
+                }
+            case .bool(let v):
+                return .int(v ? 1 : 0)
+            default:
+                break
+            }
+            failure = .coercion(expected: "int", actual: value)
+            return nil
+
+        case .number:
+            switch value {
+            case .float:
+                return value
+            case .int(let v):
+                return .float(Double(v))
+            case .string(let s):
+                if let floatValue = Double(s) {
+                    return .float(floatValue)
+                }
+            default:
+                break
+            }
+            failure = .coercion(expected: "float", actual: value)
+            return nil
+
+        case .boolean:
+            switch value {
+            case .bool:
+                return value
+            case .int(let v):
+                return .bool(v != 0)
+            case .string(let s):
+                switch s.lowercased() {
+                case "true", "1", "yes":
+                    return .bool(true)
+                case "false", "0", "no":
+                    return .bool(false)
+                default:
+                    break
+                }
+            default:
+                break
+            }
+            failure = .coercion(expected: "bool", actual: value)
+            return nil
+
+        case .null:
+            if value.isNull {
+                return value
+            }
+            failure = .coercion(expected: "null", actual: value)
+            return nil
+
+        case .any:
+            return value
+
+        case .array(let item):
+            guard case .array(let elements) = value else {
+                failure = .coercion(expected: "array", actual: value)
+                return nil
+            }
+            var coerced: [SwamlValue] = []
+            coerced.reserveCapacity(elements.count)
+            for element in elements {
+                guard let result = coerce(element, item, &failure) else { return nil }
+                coerced.append(result)
+            }
+            return .array(coerced)
+
+        case .object(let fields, _):
+            guard case .map(var dict) = value else {
+                failure = .coercion(expected: "object", actual: value)
+                return nil
+            }
+            for field in fields {
+                guard let propValue = dict[field.key] else { continue }
+                guard let result = coerce(propValue, field.node, &failure) else { return nil }
+                dict[field.key] = result
+            }
+            return .map(dict)
+
+        case .anyOf(let branches):
+            var ignored: Failure?
+            for branch in candidates(for: value, in: branches) {
+                if let coerced = coerce(value, branch, &ignored) {
+                    return coerced
+                }
+            }
+            failure = .noMatchingBranch
+            return nil
+        }
+    }
+
+    private func validate(_ value: SwamlValue, _ index: Int, _ failure: inout Failure?) -> Bool {
+        switch nodes[index] {
+        case .string:
+            return check(value.isString, "string", value, &failure)
+        case .integer:
+            return check(value.isInt, "integer", value, &failure)
+        case .number:
+            return check(value.isNumber, "number", value, &failure)
+        case .boolean:
+            return check(value.isBool, "boolean", value, &failure)
+        case .null:
+            return check(value.isNull, "null", value, &failure)
+        case .any:
+            return true
+
+        case .array(let item):
+            guard case .array(let elements) = value else {
+                failure = .unexpected(expected: "array", actual: value)
+                return false
+            }
+            for element in elements where !validate(element, item, &failure) {
+                return false
+            }
+            return true
+
+        case .object(let fields, let required):
+            guard case .map(let dict) = value else {
+                failure = .unexpected(expected: "object", actual: value)
+                return false
+            }
+            for key in required where dict[key] == nil {
+                failure = .missingRequired(key)
+                return false
+            }
+            for field in fields {
+                if let propValue = dict[field.key], !validate(propValue, field.node, &failure) {
+                    return false
+                }
+            }
+            return true
+
+        case .enumeration(let values, let ordered):
+            guard case .string(let string) = value else {
+                failure = .enumNotString
+                return false
+            }
+            guard values.contains(string) else {
+                failure = .invalidEnum(string, allowed: ordered)
+                return false
+            }
+            return true
+
+        case .anyOf(let branches):
+            var ignored: Failure?
+            for branch in candidates(for: value, in: branches) where validate(value, branch, &ignored) {
+                return true
+            }
+            failure = .noMatchingBranch
+            return false
+        }
+    }
+
+    private func check(_ condition: Bool, _ expected: String, _ value: SwamlValue, _ failure: inout Failure?) -> Bool {
+        if !condition {
+            failure = .unexpected(expected: expected, actual: value)
+        }
+        return condition
+    }
+
+    /// Branches worth trying for a value, most likely first
+    ///
+    /// An object whose discriminator names a branch tries that branch first,
+    /// then the other candidates in schema order.
+    private func candidates(for value: SwamlValue, in branches: Branches) -> [Int] {
+        let byKind = branches.byKind[Kind(value).rawValue]
+        guard let discriminator = branches.discriminator,
+              case .map(let dict) = value,
+              case .string(let tag)? = dict[discriminator.key],
+              let preferred = discriminator.branches[tag] else {
+            return byKind
+        }
+        return [preferred] + byKind.filter { $0 != preferred }
+    }
+
+    // MARK: - Compiling
+
+    private struct Compiler {
+        /// Value set and ordered values of each dynamic enum
+        let dynamicEnums: [String: (Set<String>, [String])]
+        var nodes: [Node] = []
+
+        init(dynamicEnums: [String: (Set<String>, [String])]) {
+            self.dynamicEnums = dynamicEnums
+        }
+
+        mutating func compile(_ schema: JSONSchema) -> Int {
+            let node: Node
+            switch schema {
+            case .string:
+                node = .string
+            case .integer:
+                node = .integer
+            case .number:
+                node = .number
+            case .boolean:
+                node = .boolean
+            case .null:
+                node = .null
+            case .enum(let values):
+                node = .enumeration(Set(values), ordered: values)
+            case .ref(let name):
+                if case let (values, ordered)? = dynamicEnums[name] {
+                    node = .enumeration(values, ordered: ordered)
+                } else {
+                    // References are resolved at a higher level
+                    node = .any
+                }
+            case .array(let items):
+                node = .array(item: compile(items))
+            case .object(let properties, let required, _):
+                let fields = properties.keys.sorted().map { key in
+                    Field(key: key, node: compile(properties[key]!))
+                }
+                node = .object(fields: fields, required: required)
+            case .anyOf(let schemas):
+                let branches = schemas.map { compile($0) }
+                node = .anyOf(Branches(
+                    all: branches,
+                    byKind: Kind.allCases.map { kind in
+                        branches.filter { accepts($0, kind) }
+                    },
+                    discriminator: discriminator(of: branches)
+                ))
+            }
+            nodes.append(node)
+            return nodes.count - 1
+        }
+
+        /// Whether a node could coerce a value of this kind (conservative)
+        private func accepts(_ index: Int, _ kind: Kind) -> Bool {
+            switch nodes[index] {
+            case .string, .enumeration:
+                return [.string, .int, .float, .bool].contains(kind)
+            case .integer:
+                return [.int, .float, .string, .bool].contains(kind)
+            case .number:
+                return [.float, .int, .string].contains(kind)
+            case .boolean:
+                return [.bool, .int, .string].contains(kind)
+            case .null:
+                return kind == .null
+            case .any:
+                return true
+            case .array:
+                return kind == .array
+            case .object:
+                return kind == .map
+            case .anyOf(let branches):
+                return !branches.byKind[kind.rawValue].isEmpty
+            }
+        }
+
+        /// A required property present in every branch whose enum values
+        /// don't overlap between branches
+        private func discriminator(of branches: [Int]) -> Discriminator? {
+            var objects: [(fields: [Field], required: [String])] = []
+            for branch in branches {
+                guard case .object(let fields, let required) = nodes[branch] else { return nil }
+                objects.append((fields, required))
+            }
+            guard objects.count > 1, let first = objects.first else { return nil }
+
+            candidate: for key in first.required.sorted() {
+                var mapping: [String: Int] = [:]
+                for (branch, object) in zip(branches, objects) {
+                    guard object.required.contains(key),
+                          let field = object.fields.first(where: { $0.key == key }),
+                          case .enumeration(_, let values) = nodes[field.node] else {
+                        continue candidate
+                    }
+                    for value in values {
+                        guard mapping.updateValue(branch, forKey: value) == nil else {
+                            continue candidate
+                        }
+                    }
+                }
+                return Discriminator(key: key, branches: mapping)
+            }
+            return nil
+        }
+    }
+}
+
+// MARK: - Plan Cache
+
+extension SchemaPlan {
+    private static let cache = PlanCache()
+
+    /// Shared plan for a schema, compiled on first use
+    public static func cached(for schema: JSONSchema) -> SchemaPlan {
+        cache.plan(for: schema)
+    }
+
+    private final class PlanCache: @unchecked Sendable {
+        private let lock = NSLock()
+        private var plans: [JSONSchema: SchemaPlan] = [:]
+
+        /// Upper bound on cached plans before the cache is reset
+        private static let maxPlans = 256
+
+        func plan(for schema: JSONSchema) -> SchemaPlan {
+            lock.lock()
+            if let plan = plans[schema] {
+                lock.unlock()
+                return plan
+            }
+            lock.unlock()
+
+            let plan = SchemaPlan(schema: schema)
+
+            lock.lock()
+            if plans.count >= Self.maxPlans {
+                plans.removeAll(keepingCapacity: true)
+            }
+            plans[schema] = plan
+            lock.unlock()
+            return plan
+        }
+    }
+}
@@ -0,0 +1,429 @@
+import Foundation
+
+/// Deterministic repair of parsed LLM output that doesn't match its schema.
+///
+/// Most outputs that fail to decode are mechanically fixable, and asking the
+/// model to fix them costs a whole extra round trip. `SchemaRepair` walks the
+/// value alongside the schema and fixes what it can:
+/// - scalars of the wrong type are coerced with `TypeCoercion` (`"42"` to an
+///   integer, `1` to `"1"`)
+/// - enum values are matched ignoring case, punctuation and spacing, then as
+///   whole words in an un-negated phrase and by small edit distance
+///   (`"Positive."`, `"The sentiment is positive"`, `"POSTIVE"`)
+/// - object keys are matched to properties through `aliases`, snake_case,
+///   camelCase and case-insensitive spellings
+/// - missing required properties that accept null are set to null
+/// - a single value where an array is expected is wrapped, and an object
+///   whose only value is the expected array (`{"items": [...]}`) is unwrapped
+/// - a one-element array where an object is expected is unwrapped
+///
+/// The result is only returned if it then validates against the schema;
+/// otherwise the repair gives up and returns nil.
+public struct SchemaRepair: Sendable {
+    /// A kind of fix that was applied
+    public enum Fix: String, Sendable {
+        case coercedScalar
+        case matchedEnum
+        case renamedKey
+        case filledNull
+        case wrappedInArray
+        case unwrappedArray
+        case unwrappedObject
+    }
+
+    /// A repaired value and the fixes it took
+    public struct Repaired: Sendable {
+        public let value: SwamlValue
+        public let fixes: [Fix]
+    }
+
+    public let schema: JSONSchema
+
+    /// Key aliases (property name -> alias), as in `SwamlTyped.fieldAliases`
+    public let aliases: [String: String]
+
+    /// Values of dynamic enums, for `.ref`s with the same name
+    public var dynamicEnums: [String: [String]] {
+        enumIndexes.mapValues(\.values)
+    }
+
+    /// Lookups over the dynamic enums, which also resolve their aliases
+    let enumIndexes: [String: DynamicEnumIndex]
+
+    private let plan: SchemaPlan
+
+    /// Plans of every `anyOf` branch in the schema, compiled once
+    private let branchPlans: [JSONSchema: SchemaPlan]
+
+    public init(schema: JSONSchema, aliases: [String: String] = [:], dynamicEnums: [String: [String]] = [:]) {
+        self.init(
+            schema: schema,
+            aliases: aliases,
+            enumIndexes: dynamicEnums.mapValues { values in
+                DynamicEnumIndex(values: values.map { TypeBuilderSnapshot.Value(name: $0, description: nil, alias: nil) })
+            }
+        )
+    }
+
+    init(schema: JSONSchema, aliases: [String: String], enumIndexes: [String: DynamicEnumIndex]) {
+        self.schema = schema
+        self.aliases = aliases
+        self.enumIndexes = enumIndexes
+        self.plan = Self.plan(for: schema, enumIndexes: enumIndexes)
+
+        var branchPlans: [JSONSchema: SchemaPlan] = [:]
+        Self.collectBranchPlans(schema, enumIndexes: enumIndexes, into: &branchPlans)
+        self.branchPlans = branchPlans
+    }
+
+    /// Repair guided by a `SwamlTyped` type's schema and aliases
+    public init<T: SwamlTyped>(for type: T.Type, typeBuilder: TypeBuilder? = nil) {
+        self.init(
+            schema: T.swamlSchema,
+            aliases: T.fieldAliases,
+            enumIndexes: typeBuilder?.snapshot().enumIndexes ?? [:]
+        )
+    }
+
+    /// Repair a value to match the schema
+    ///
+    /// - Returns: The repaired value (with no fixes if it already matched),
+    ///   or nil if it can't be made to match
+    public func repair(_ value: SwamlValue) -> Repaired? {
+        if validates(value, plan) {
+            return Repaired(value: value, fixes: [])
+        }
+
+        var fixes: [Fix] = []
+        let repaired = fix(value, schema, &fixes)
+        guard validates(repaired, plan) else { return nil }
+        return Repaired(value: repaired, fixes: fixes)
+    }
+
+    // MARK: - Fixing
+
+    private func fix(_ value: SwamlValue, _ schema: JSONSchema, _ fixes: inout [Fix]) -> SwamlValue {
+        switch schema {
+        case .string:
+            return coerce(value, to: .string, &fixes)
+        case .integer:
+            return coerce(unwrapSingle(value), to: .int, &fixes)
+        case .number:
+            if case .int = value {
+                return value
+            }
+            return coerce(unwrapSingle(value), to: .float, &fixes)
+        case .boolean:
+            return coerce(unwrapSingle(value), to: .bool, &fixes)
+        case .null:
+            return value
+
+        case .enum(let values):
+            return fixEnum(value, values, &fixes)
+        case .ref(let name):
+            if let index = enumIndexes[name] {
+                return fixDynamicEnum(value, index, &fixes)
+            }
+            return value
+
+        case .array(let items):
+            let elements: [SwamlValue]
+            switch value {
+            case .array(let array):
+                elements = array
+            case .map(let dict) where dict.count == 1 && dict.values.first?.arrayValue != nil:
+                fixes.append(.unwrappedArray)
+                elements = dict.values.first!.arrayValue!
+            case .null:
+                return value
+            default:
+                fixes.append(.wrappedInArray)
+                elements = [value]
+            }
+            return .array(elements.map { fix($0, items, &fixes) })
+
+        case .object(let properties, let required, let additional):
+            var value = value
+            if case .array(let elements) = value, elements.count == 1, elements[0].mapValue != nil {
+                fixes.append(.unwrappedObject)
+                value = elements[0]
+            }
+            guard case .map(let dict) = value else { return value }
+            return .map(fixObject(dict, properties, required, additional, &fixes))
+
+        case .anyOf(let branches):
+            // Keep a value one branch already accepts, else take the first
+            // branch that can be repaired to accept it
+            for branch in branches where validates(value, planFor(branch)) {
+                return value
+            }
+            for branch in branches {
+                var branchFixes: [Fix] = []
+                let repaired = fix(value, branch, &branchFixes)
+                if validates(repaired, planFor(branch)) {
+                    fixes += branchFixes
+                    return repaired
+                }
+            }
+            return value
+        }
+    }
+
+    private func fixObject(
+        _ dict: [String: SwamlValue],
+        _ properties: [String: JSONSchema],
+        _ required: [String],
+        _ additional: JSONSchema?,
+        _ fixes: inout [Fix]
+    ) -> [String: SwamlValue] {
+        // Match stray keys to properties the output didn't use
+        var result: [String: SwamlValue] = [:]
+        result.reserveCapacity(dict.count)
+        var renamed: [(key: String, value: SwamlValue)] = []
+        for (key, value) in dict {
+            if properties[key] != nil {
+                result[key] = value
+            } else {
+                renamed.append((key, value))
+            }
+        }
+        if !renamed.isEmpty {
+            var byAlias: [String: String] = [:]
+            var bySpelling: [String: String] = [:]
+            for name in properties.keys where dict[name] == nil {
+                if let alias = aliases[name] {
+                    byAlias[alias] = name
+                }
+                bySpelling[Self.normalizedKey(name)] = name
+            }
+            for (key, value) in renamed.sorted(by: { $0.key < $1.key }) {
+                if let name = byAlias[key] ?? bySpelling[Self.normalizedKey(key)], result[name] == nil {
+                    fixes.append(.renamedKey)
+                    result[name] = value
+                } else {
+                    result[key] = value
+                }
+            }
+        }
+
+        for (key, value) in result {
+            if let propertySchema = properties[key] ?? additional {
+                result[key] = fix(value, propertySchema, &fixes)
+            }
+        }
+
+        for key in required where result[key] == nil {
+            if let propertySchema = properties[key], Self.acceptsNull(propertySchema) {
+                fixes.append(.filledNull)
+                result[key] = .null
+            }
+        }
+        return result
+    }
+
+    private func coerce(_ value: SwamlValue, to type: FieldType, _ fixes: inout [Fix]) -> SwamlValue {
+        var value = value
+        if case .string(let string) = value, type != .string {
+            value = .string(string.trimmingCharacters(in: .whitespacesAndNewlines))
+        }
+        guard let coerced = try? TypeCoercion.coerce(value, to: type) else { return value }
+        if coerced != value {
+            fixes.append(.coercedScalar)
+        }
+        return coerced
+    }
+
+    /// `[x]` where a scalar is expected
+    private func unwrapSingle(_ value: SwamlValue) -> SwamlValue {
+        if case .array(let elements) = value, elements.count == 1 {
+            return elements[0]
+        }
+        return value
+    }
+
+    /// A dynamic enum value: its alias or folded spelling through the index,
+    /// then the fuzzy matching of a static enum
+    private func fixDynamicEnum(_ value: SwamlValue, _ index: DynamicEnumIndex, _ fixes: inout [Fix]) -> SwamlValue {
+        guard case .string(let text) = value else {
+            return fixEnum(value, index.values, &fixes)
+        }
+        if index.contains(text) {
+            return value
+        }
+        if let resolved = index.resolve(text) {
+            fixes.append(.matchedEnum)
+            return .string(resolved)
+        }
+        return fixEnum(value, index.values, &fixes)
+    }
+
+    private func fixEnum(_ value: SwamlValue, _ values: [String], _ fixes: inout [Fix]) -> SwamlValue {
+        let text: String
+        switch value {
+        case .string(let string):
+            text = string
+        case .int, .float, .bool:
+            text = (try? TypeCoercion.coerce(value, to: .string))?.stringValue ?? ""
+        default:
+            return value
+        }
+        if case .string = value, values.contains(text) {
+            return value
+        }
+        guard let match = Self.matchEnum(text, values) else { return value }
+        fixes.append(.matchedEnum)
+        return .string(match)
+    }
+
+    // MARK: - Matching
+
+    /// Closest enum value to `text`, if there's exactly one good candidate
+    static func matchEnum(_ text: String, _ values: [String]) -> String? {
+        if values.contains(text) {
+            return text
+        }
+        let normalized = normalizedKey(text)
+        guard !normalized.isEmpty else { return nil }
+        let candidates = values.map { (value: $0, key: normalizedKey($0)) }
+
+        // Same value ignoring case, spacing and punctuation
+        let exact = candidates.filter { $0.key == normalized }
+        if exact.count == 1 {
+            return exact[0].value
+        }
+
+        // The output names exactly one value among other words, and doesn't
+        // negate it ("not positive")
+        let words = Self.words(text)
+        if !words.contains(where: { negations.contains($0) }) {
+            let named = values.filter { value in
+                let valueWords = Self.words(value)
+                return valueWords.joined().count >= 3 && words.containsRun(valueWords)
+            }
+            if named.count == 1 {
+                return named[0]
+            }
+        }
+
+        // A typo: the single closest value within a quarter of its length
+        var best: (value: String, distance: Int)?
+        var tied = false
+        for candidate in candidates {
+            let distance = editDistance(normalized, candidate.key)
+            guard distance <= max(1, candidate.key.count / 4) else { continue }
+            if best == nil || distance < best!.distance {
+                best = (candidate.value, distance)
+                tied = false
+            } else if distance == best!.distance {
+                tied = true
+            }
+        }
+        return tied ? nil : best?.value
+    }
+
+    /// Words that turn naming a value into ruling it out
+    private static let negations: Set<String> = [
+        "not", "no", "never", "none", "neither", "nor", "non", "without",
+        "isnt", "arent", "wasnt", "werent", "dont", "doesnt", "didnt", "cant", "cannot", "wont",
+    ]
+
+    /// Lowercased runs of letters and digits, with apostrophes dropped
+    /// (`"Isn't positive."` is `["isnt", "positive"]`)
+    static func words(_ text: String) -> [String] {
+        text.lowercased()
+            .replacingOccurrences(of: "'", with: "")
+            .replacingOccurrences(of: "\u{2019}", with: "")
+            .components(separatedBy: CharacterSet.alphanumerics.inverted)
+            .filter { !$0.isEmpty }
+    }
+
+    /// Lowercased letters and digits only (`order_id`, `orderId` and
+    /// `Order ID` are all `orderid`)
+    static func normalizedKey(_ key: String) -> String {
+        String(String.UnicodeScalarView(key.lowercased().unicodeScalars.filter {
+            CharacterSet.alphanumerics.contains($0)
+        }))
+    }
+
+    /// Levenshtein distance over unicode scalars
+    static func editDistance(_ a: String, _ b: String) -> Int {
+        let a = Array(a.unicodeScalars)
+        let b = Array(b.unicodeScalars)
+        if a.isEmpty { return b.count }
+        if b.isEmpty { return a.count }
+
+        var previous = Array(0...b.count)
+        var current = [Int](repeating: 0, count: b.count + 1)
+        for i in 1...a.count {
+            current[0] = i
+            for j in 1...b.count {
+                let substitution = previous[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1)
+                current[j] = min(previous[j] + 1, current[j - 1] + 1, substitution)
+            }
+            swap(&previous, &current)
+        }
+        return previous[b.count]
+    }
+
+    private static func acceptsNull(_ schema: JSONSchema) -> Bool {
+        switch schema {
+        case .null:
+            return true
+        case .anyOf(let branches):
+            return branches.contains(where: acceptsNull)
+        default:
+            return false
+        }
+    }
+
+    // MARK: - Validation
+
+    private func planFor(_ branch: JSONSchema) -> SchemaPlan {
+        branchPlans[branch] ?? Self.plan(for: branch, enumIndexes: enumIndexes)
+    }
+
+    private static func plan(for schema: JSONSchema, enumIndexes: [String: DynamicEnumIndex]) -> SchemaPlan {
+        enumIndexes.isEmpty ? SchemaPlan.cached(for: schema) : SchemaPlan(schema: schema, enumIndexes: enumIndexes)
+    }
+
+    private static func collectBranchPlans(
+        _ schema: JSONSchema,
+        enumIndexes: [String: DynamicEnumIndex],
+        into plans: inout [JSONSchema: SchemaPlan]
+    ) {
+        switch schema {
+        case .array(let items):
+            collectBranchPlans(items, enumIndexes: enumIndexes, into: &plans)
+        case .object(let properties, _, let additional):
+            for property in properties.values {
+                collectBranchPlans(property, enumIndexes: enumIndexes, into: &plans)
+            }
+            if let additional = additional {
+                collectBranchPlans(additional, enumIndexes: enumIndexes, into: &plans)
+            }
+        case .anyOf(let branches):
+            for branch in branches {
+                if plans[branch] == nil {
+                    plans[branch] = plan(for: branch, enumIndexes: enumIndexes)
+                }
+                collectBranchPlans(branch, enumIndexes: enumIndexes, into: &plans)
+            }
+        case .string, .integer, .number, .boolean, .null, .enum, .ref:
+            break
+        }
+    }
+
+    private func validates(_ value: SwamlValue, _ plan: SchemaPlan) -> Bool {
+        (try? plan.validate(value)) != nil
+    }
+}
+
+private extension Array where Element == String {
+    /// Whether `run` appears in order and without gaps
+    func containsRun(_ run: [String]) -> Bool {
+        guard !run.isEmpty, run.count <= count else { return false }
+        return (0...(count - run.count)).contains { start in
+            self[start..<(start + run.count)].elementsEqual(run)
+        }
+    }
+}
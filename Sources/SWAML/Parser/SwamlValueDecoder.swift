@@ -0,0 +1,430 @@
+import Foundation
+
+/// Decodes `Decodable` types directly from a parsed `SwamlValue`.
+///
+/// Replaces the serialize-to-JSON-and-decode-again round trip through
+/// `JSONDecoder`. Keys are resolved in a single lookup that accepts:
+/// - The exact key
+/// - Its snake_case spelling (`order_id` for `orderId`)
+/// - The alias from `fieldAliases`, for `SwamlTyped` types at any depth
+///
+/// Scalars are coerced inline with `TypeCoercion`, so `"42"` decodes as an
+/// `Int` and `"yes"` as a `Bool`.
+public struct SwamlValueDecoder {
+    /// Extra key aliases for the top-level type (property name -> alias),
+    /// merged with its `fieldAliases`
+    public var fieldAliases: [String: String]
+
+    public init(fieldAliases: [String: String] = [:]) {
+        self.fieldAliases = fieldAliases
+    }
+
+    /// Decode a value of the given type
+    public func decode<T: Decodable>(_ type: T.Type, from value: SwamlValue) throws -> T {
+        var aliases = Self.aliases(for: T.self)
+        aliases.merge(fieldAliases) { _, custom in custom }
+
+        let decoder = _SwamlValueDecoder(value: value, codingPath: [], aliases: aliases)
+        return try decoder.decodeValue(T.self)
+    }
+
+    /// Aliases declared by a type, if it's `SwamlTyped`
+    fileprivate static func aliases(for type: Any.Type) -> [String: String] {
+        (type as? any SwamlTyped.Type)?.fieldAliases ?? [:]
+    }
+
+    /// `JSONDecoder.KeyDecodingStrategy.convertFromSnakeCase` applied to a single key
+    fileprivate static func camelCased(_ key: String) -> String {
+        guard key.contains("_") else { return key }
+
+        guard let first = key.firstIndex(where: { $0 != "_" }) else { return key }
+        var last = key.index(before: key.endIndex)
+        while last > first, key[last] == "_" {
+            last = key.index(before: last)
+        }
+
+        let components = key[first...last].split(separator: "_")
+        guard let head = components.first else { return key }
+        let joined = String(head) + components.dropFirst().map { $0.capitalized }.joined()
+
+        return String(key[..<first]) + joined + String(key[key.index(after: last)...])
+    }
+}
+
+// MARK: - Decoder
+
+private struct _SwamlValueDecoder: Decoder {
+    let value: SwamlValue
+    let codingPath: [CodingKey]
+    let aliases: [String: String]
+
+    var userInfo: [CodingUserInfoKey: Any] { [:] }
+
+    func container<Key: CodingKey>(keyedBy type: Key.Type) throws -> KeyedDecodingContainer<Key> {
+        guard case .map(let dict) = value else {
+            throw typeMismatch([String: SwamlValue].self, value)
+        }
+        return KeyedDecodingContainer(KeyedContainer<Key>(dict: dict, codingPath: codingPath, aliases: aliases))
+    }
+
+    func unkeyedContainer() throws -> UnkeyedDecodingContainer {
+        guard case .array(let elements) = value else {
+            throw typeMismatch([SwamlValue].self, value)
+        }
+        return UnkeyedContainer(elements: elements, codingPath: codingPath)
+    }
+
+    func singleValueContainer() throws -> SingleValueDecodingContainer {
+        SingleValueContainer(value: value, codingPath: codingPath)
+    }
+
+    /// Decode a nested value, special-casing types whose Codable form differs from JSON
+    func decodeValue<T: Decodable>(_ type: T.Type) throws -> T {
+        switch type {
+        case is SwamlValue.Type:
+            return try cast(value, to: T.self)
+        case is URL.Type:
+            let string = try SingleValueContainer(value: value, codingPath: codingPath).decode(String.self)
+            guard let url = URL(string: string) else {
+                throw DecodingError.dataCorrupted(.init(codingPath: codingPath, debugDescription: "Invalid URL string: \(string)"))
+            }
+            return try cast(url, to: T.self)
+        case is Decimal.Type:
+            return try cast(decimal(), to: T.self)
+        default:
+            return try T(from: self)
+        }
+    }
+
+    /// A decimal from the number's text, so `0.1` stays exactly `0.1`
+    /// (`Decimal(Double)` would carry the binary rounding error along)
+    private func decimal() throws -> Decimal {
+        let text: String
+        switch value {
+        case .int(let number):
+            return Decimal(number)
+        case .float(let number):
+            // The shortest text that round-trips, as JSONDecoder reads it
+            text = "\(number)"
+        case .string(let string):
+            text = string.trimmingCharacters(in: .whitespaces)
+        default:
+            throw typeMismatch(Decimal.self, value)
+        }
+        guard let decimal = Decimal(string: text, locale: Locale(identifier: "en_US_POSIX")) else {
+            throw typeMismatch(Decimal.self, value)
+        }
+        return decimal
+    }
+
+    private func cast<T>(_ decoded: Any, to type: T.Type) throws -> T {
+        guard let result = decoded as? T else {
+            throw typeMismatch(T.self, value)
+        }
+        return result
+    }
+
+    private func typeMismatch(_ expected: Any.Type, _ value: SwamlValue) -> DecodingError {
+        DecodingError.typeMismatch(expected, .init(
+            codingPath: codingPath,
+            debugDescription: "Expected \(expected) but found \(value.typeName)"
+        ))
+    }
+}
+
+// MARK: - Keyed Container
+
+private struct KeyedContainer<Key: CodingKey>: KeyedDecodingContainerProtocol {
+    let codingPath: [CodingKey]
+    private let dict: [String: SwamlValue]
+
+    /// Values by every spelling a key may be looked up under
+    private let lookup: [String: SwamlValue]
+
+    init(dict: [String: SwamlValue], codingPath: [CodingKey], aliases: [String: String]) {
+        self.dict = dict
+        self.codingPath = codingPath
+
+        // Exact keys win over converted ones, which win over aliases
+        var lookup = dict
+        for (key, value) in dict {
+            let converted = SwamlValueDecoder.camelCased(key)
+            if converted != key, lookup[converted] == nil {
+                lookup[converted] = value
+            }
+        }
+        let spellings = lookup
+        for (property, alias) in aliases where lookup[property] == nil {
+            if let value = spellings[alias] {
+                lookup[property] = value
+            }
+        }
+        self.lookup = lookup
+    }
+
+    var allKeys: [Key] {
+        dict.keys.compactMap { Key(stringValue: $0) }
+    }
+
+    func contains(_ key: Key) -> Bool {
+        lookup[key.stringValue] != nil
+    }
+
+    func decodeNil(forKey key: Key) throws -> Bool {
+        try value(forKey: key).isNull
+    }
+
+    func decode<T: Decodable>(_ type: T.Type, forKey key: Key) throws -> T {
+        try decoder(forKey: key, type: T.self).decodeValue(T.self)
+    }
+
+    func decode(_ type: Bool.Type, forKey key: Key) throws -> Bool {
+        try scalar(forKey: key).decode(Bool.self)
+    }
+
+    func decode(_ type: String.Type, forKey key: Key) throws -> String {
+        try scalar(forKey: key).decode(String.self)
+    }
+
+    func decode(_ type: Double.Type, forKey key: Key) throws -> Double {
+        try scalar(forKey: key).decode(Double.self)
+    }
+
+    func decode(_ type: Int.Type, forKey key: Key) throws -> Int {
+        try scalar(forKey: key).decode(Int.self)
+    }
+
+    func nestedContainer<NestedKey: CodingKey>(
+        keyedBy type: NestedKey.Type,
+        forKey key: Key
+    ) throws -> KeyedDecodingContainer<NestedKey> {
+        try decoder(forKey: key, type: nil).container(keyedBy: NestedKey.self)
+    }
+
+    func nestedUnkeyedContainer(forKey key: Key) throws -> UnkeyedDecodingContainer {
+        try decoder(forKey: key, type: nil).unkeyedContainer()
+    }
+
+    func superDecoder() throws -> Decoder {
+        _SwamlValueDecoder(value: .map(dict), codingPath: codingPath, aliases: [:])
+    }
+
+    func superDecoder(forKey key: Key) throws -> Decoder {
+        try decoder(forKey: key, type: nil)
+    }
+
+    // MARK: Helpers
+
+    private func value(forKey key: Key) throws -> SwamlValue {
+        guard let value = lookup[key.stringValue] else {
+            throw DecodingError.keyNotFound(key, .init(
+                codingPath: codingPath,
+                debugDescription: "No value associated with key \(key.stringValue)"
+            ))
+        }
+        return value
+    }
+
+    private func scalar(forKey key: Key) throws -> SingleValueContainer {
+        SingleValueContainer(value: try value(forKey: key), codingPath: codingPath + [key])
+    }
+
+    private func decoder(forKey key: Key, type: Any.Type?) throws -> _SwamlValueDecoder {
+        _SwamlValueDecoder(
+            value: try value(forKey: key),
+            codingPath: codingPath + [key],
+            aliases: type.map(SwamlValueDecoder.aliases(for:)) ?? [:]
+        )
+    }
+}
+
+// MARK: - Unkeyed Container
+
+private struct UnkeyedContainer: UnkeyedDecodingContainer {
+    let codingPath: [CodingKey]
+    private let elements: [SwamlValue]
+    private(set) var currentIndex = 0
+
+    init(elements: [SwamlValue], codingPath: [CodingKey]) {
+        self.elements = elements
+        self.codingPath = codingPath
+    }
+
+    var count: Int? { elements.count }
+    var isAtEnd: Bool { currentIndex >= elements.count }
+
+    mutating func decodeNil() throws -> Bool {
+        guard try peek().isNull else { return false }
+        currentIndex += 1
+        return true
+    }
+
+    mutating func decode<T: Decodable>(_ type: T.Type) throws -> T {
+        let decoder = _SwamlValueDecoder(
+            value: try peek(),
+            codingPath: codingPath + [IndexKey(currentIndex)],
+            aliases: SwamlValueDecoder.aliases(for: T.self)
+        )
+        let result = try decoder.decodeValue(T.self)
+        currentIndex += 1
+        return result
+    }
+
+    mutating func nestedContainer<NestedKey: CodingKey>(keyedBy type: NestedKey.Type) throws -> KeyedDecodingContainer<NestedKey> {
+        let container = try nextDecoder().container(keyedBy: NestedKey.self)
+        currentIndex += 1
+        return container
+    }
+
+    mutating func nestedUnkeyedContainer() throws -> UnkeyedDecodingContainer {
+        let container = try nextDecoder().unkeyedContainer()
+        currentIndex += 1
+        return container
+    }
+
+    mutating func superDecoder() throws -> Decoder {
+        let decoder = try nextDecoder()
+        currentIndex += 1
+        return decoder
+    }
+
+    private func peek() throws -> SwamlValue {
+        guard !isAtEnd else {
+            throw DecodingError.valueNotFound(SwamlValue.self, .init(
+                codingPath: codingPath + [IndexKey(currentIndex)],
+                debugDescription: "Unkeyed container is at end"
+            ))
+        }
+        return elements[currentIndex]
+    }
+
+    private func nextDecoder() throws -> _SwamlValueDecoder {
+        _SwamlValueDecoder(value: try peek(), codingPath: codingPath + [IndexKey(currentIndex)], aliases: [:])
+    }
+}
+
+// MARK: - Single Value Container
+
+private struct SingleValueContainer: SingleValueDecodingContainer {
+    let value: SwamlValue
+    let codingPath: [CodingKey]
+
+    func decodeNil() -> Bool {
+        value.isNull
+    }
+
+    func decode(_ type: Bool.Type) throws -> Bool {
+        guard case .bool(let result) = try coerce(to: .bool, Bool.self) else {
+            throw typeMismatch(Bool.self)
+        }
+        return result
+    }
+
+    func decode(_ type: String.Type) throws -> String {
+        guard case .string(let result) = try coerce(to: .string, String.self) else {
+            throw typeMismatch(String.self)
+        }
+        return result
+    }
+
+    func decode(_ type: Double.Type) throws -> Double {
+        guard case .float(let result) = try coerce(to: .float, Double.self) else {
+            throw typeMismatch(Double.self)
+        }
+        return result
+    }
+
+    func decode(_ type: Float.Type) throws -> Float {
+        Float(try decode(Double.self))
+    }
+
+    func decode(_ type: Int.Type) throws -> Int { try integer(Int.self) }
+
+    func decode(_ type: Int8.Type) throws -> Int8 { try integer(Int8.self) }
+    func decode(_ type: Int16.Type) throws -> Int16 { try integer(Int16.self) }
+    func decode(_ type: Int32.Type) throws -> Int32 { try integer(Int32.self) }
+    func decode(_ type: Int64.Type) throws -> Int64 { try integer(Int64.self) }
+    func decode(_ type: UInt.Type) throws -> UInt { try integer(UInt.self) }
+    func decode(_ type: UInt8.Type) throws -> UInt8 { try integer(UInt8.self) }
+    func decode(_ type: UInt16.Type) throws -> UInt16 { try integer(UInt16.self) }
+    func decode(_ type: UInt32.Type) throws -> UInt32 { try integer(UInt32.self) }
+    func decode(_ type: UInt64.Type) throws -> UInt64 { try integer(UInt64.self) }
+
+    func decode<T: Decodable>(_ type: T.Type) throws -> T {
+        let decoder = _SwamlValueDecoder(value: value, codingPath: codingPath, aliases: SwamlValueDecoder.aliases(for: T.self))
+        return try decoder.decodeValue(T.self)
+    }
+
+    /// Whole numbers that fit `T` exactly; anything else (`1e20` for an
+    /// `Int`, `-1` for a `UInt`, `2.5`) is a type mismatch
+    private func integer<T: FixedWidthInteger>(_ type: T.Type) throws -> T {
+        let result: T?
+        switch value {
+        case .int(let number):
+            result = T(exactly: number)
+        case .float(let number):
+            result = T(exactly: number)
+        case .string(let string):
+            result = T(string) ?? Double(string).flatMap { T(exactly: $0) }
+        default:
+            guard case .int(let number) = try coerce(to: .int, T.self) else {
+                throw typeMismatch(T.self)
+            }
+            result = T(exactly: number)
+        }
+        guard let result = result else {
+            throw DecodingError.typeMismatch(T.self, .init(
+                codingPath: codingPath,
+                debugDescription: "Number \(value) is not a whole number that fits in \(T.self)"
+            ))
+        }
+        return result
+    }
+
+    private func typeMismatch(_ type: Any.Type) -> DecodingError {
+        DecodingError.typeMismatch(type, .init(
+            codingPath: codingPath,
+            debugDescription: "Expected \(type) but found \(value.typeName)"
+        ))
+    }
+
+    /// Coerce with `TypeCoercion`, reporting failures as `DecodingError`
+    private func coerce(to fieldType: FieldType, _ type: Any.Type) throws -> SwamlValue {
+        if value.isNull {
+            throw DecodingError.valueNotFound(type, .init(
+                codingPath: codingPath,
+                debugDescription: "Expected \(type) value but found null instead"
+            ))
+        }
+
+        do {
+            return try TypeCoercion.coerce(value, to: fieldType)
+        } catch {
+            throw DecodingError.typeMismatch(type, .init(
+                codingPath: codingPath,
+                debugDescription: error.localizedDescription,
+                underlyingError: error
+            ))
+        }
+    }
+}
+
+// MARK: - Coding Keys
+
+private struct IndexKey: CodingKey {
+    let intValue: Int?
+    let stringValue: String
+
+    init(_ index: Int) {
+        self.intValue = index
+        self.stringValue = "Index \(index)"
+    }
+
+    init?(stringValue: String) {
+        return nil
+    }
+
+    init?(intValue: Int) {
+        self.init(intValue)
+    }
+}
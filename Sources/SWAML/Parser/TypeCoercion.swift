@@ -68,9 +68,12 @@ public struct TypeCoercion {
         case .int:
             return value
         case .float(let v):
-            // Only coerce if it's a whole number
+            // Only coerce if it's a whole number that fits
+            if let intValue = Int(exactly: v) {
+                return .int(intValue)
+            }
             if v.truncatingRemainder(dividingBy: 1) == 0 {
-                return .int(Int(v))
+                throw SwamlError.typeCoercionError(expected: "int", actual: "float out of range")
             }
             throw SwamlError.typeCoercionError(expected: "int", actual: "float with decimal")
         case .string(let s):
@@ -78,8 +81,8 @@ public struct TypeCoercion {
                 return .int(intValue)
             }
             // Try parsing as float then converting
-            if let floatValue = Double(s), floatValue.truncatingRemainder(dividingBy: 1) == 0 {
-                return .int(Int(floatValue))
+            if let intValue = Double(s).flatMap({ Int(exactly: $0) }) {
+                return .int(intValue)
             }
             throw SwamlError.typeCoercionError(expected: "int", actual: "string '\(s)'")
         case .bool(let v):
@@ -0,0 +1,247 @@
+import Foundation
+
+/// A template parsed into literal text and `{{ variable }}` placeholders.
+///
+/// Parsing happens once; rendering appends the segments into a single buffer
+/// sized up front, instead of searching and splicing the template each time.
+struct PromptTemplate: Sendable, Equatable {
+    enum Segment: Sendable, Equatable {
+        case literal(String)
+
+        /// A placeholder, with its original text for lenient rendering
+        case variable(name: String, source: String)
+    }
+
+    let segments: [Segment]
+
+    /// Parse a template
+    ///
+    /// Placeholders are `{{ name }}` with optional whitespace, where `name`
+    /// starts with a letter or underscore and continues with letters, digits,
+    /// underscores and dots. Any other `{{` is literal text.
+    init(_ template: String) {
+        let bytes = Array(template.utf8)
+        var segments: [Segment] = []
+        var literalStart = 0
+        var index = 0
+
+        func text(_ range: Range<Int>) -> String {
+            String(decoding: bytes[range], as: UTF8.self)
+        }
+
+        while index + 1 < bytes.count {
+            guard bytes[index] == UInt8(ascii: "{"), bytes[index + 1] == UInt8(ascii: "{"),
+                  let match = Self.placeholder(in: bytes, at: index) else {
+                index += 1
+                continue
+            }
+            if literalStart < index {
+                segments.append(.literal(text(literalStart..<index)))
+            }
+            segments.append(.variable(name: match.name, source: text(index..<match.end)))
+            index = match.end
+            literalStart = match.end
+        }
+        if literalStart < bytes.count {
+            segments.append(.literal(text(literalStart..<bytes.count)))
+        }
+        self.segments = segments
+    }
+
+    init(segments: [Segment]) {
+        // Merge adjacent literals so a fully bound template is a single string
+        var merged: [Segment] = []
+        for segment in segments {
+            if case .literal(let text) = segment, case .literal(let previous)? = merged.last {
+                merged[merged.count - 1] = .literal(previous + text)
+            } else {
+                merged.append(segment)
+            }
+        }
+        self.segments = merged
+    }
+
+    /// Names of the placeholders, in order of appearance
+    var variableNames: [String] {
+        segments.compactMap { segment in
+            if case .variable(let name, _) = segment { return name }
+            return nil
+        }
+    }
+
+    /// Whether the template has no placeholders left
+    var isConstant: Bool {
+        variableNames.isEmpty
+    }
+
+    /// UTF-8 length of the literal text
+    private var literalLength: Int {
+        segments.reduce(0) { total, segment in
+            if case .literal(let text) = segment { return total + text.utf8.count }
+            return total
+        }
+    }
+
+    /// Substitute the given values now, leaving the other placeholders open
+    func binding(_ values: [String: String], except open: Set<String> = []) -> PromptTemplate {
+        PromptTemplate(segments: segments.map { segment in
+            if case .variable(let name, _) = segment, !open.contains(name), let value = values[name] {
+                return .literal(value)
+            }
+            return segment
+        })
+    }
+
+    /// Render, leaving placeholders without a value as written
+    func render(_ values: [String: String]) -> String {
+        render { name, source in values[name] ?? source }
+    }
+
+    /// Render, throwing if a placeholder has no value
+    func renderStrict(_ values: [String: String]) throws -> String {
+        var missing: String?
+        let result = render { name, _ in
+            if let value = values[name] { return value }
+            missing = missing ?? name
+            return ""
+        }
+        if let missing = missing {
+            throw SwamlError.configurationError("Missing value for prompt variable '\(missing)'")
+        }
+        return result
+    }
+
+    private func render(_ value: (String, String) -> String) -> String {
+        if segments.count == 1, case .literal(let text) = segments[0] {
+            return text
+        }
+
+        var resolved: [String] = []
+        resolved.reserveCapacity(segments.count)
+        var length = literalLength
+        for segment in segments {
+            if case .variable(let name, let source) = segment {
+                let text = value(name, source)
+                length += text.utf8.count
+                resolved.append(text)
+            }
+        }
+
+        var result = ""
+        result.reserveCapacity(length)
+        var next = 0
+        for segment in segments {
+            switch segment {
+            case .literal(let text):
+                result.append(text)
+            case .variable:
+                result.append(resolved[next])
+                next += 1
+            }
+        }
+        return result
+    }
+
+    /// Match `{{ name }}` starting at `start`; returns the name and the end offset
+    private static func placeholder(in bytes: [UInt8], at start: Int) -> (name: String, end: Int)? {
+        var index = start + 2
+        skipWhitespace(bytes, &index)
+
+        let nameStart = index
+        guard index < bytes.count, isIdentifierHead(bytes[index]) else { return nil }
+        index += 1
+        while index < bytes.count, isIdentifierHead(bytes[index]) || isDigitOrDot(bytes[index]) {
+            index += 1
+        }
+        let nameEnd = index
+
+        skipWhitespace(bytes, &index)
+        guard index + 1 < bytes.count,
+              bytes[index] == UInt8(ascii: "}"), bytes[index + 1] == UInt8(ascii: "}") else {
+            return nil
+        }
+        return (String(decoding: bytes[nameStart..<nameEnd], as: UTF8.self), index + 2)
+    }
+
+    private static func skipWhitespace(_ bytes: [UInt8], _ index: inout Int) {
+        while index < bytes.count {
+            switch bytes[index] {
+            case UInt8(ascii: " "), UInt8(ascii: "\t"), UInt8(ascii: "\n"), UInt8(ascii: "\r"):
+                index += 1
+            default:
+                return
+            }
+        }
+    }
+
+    private static func isIdentifierHead(_ byte: UInt8) -> Bool {
+        (byte >= UInt8(ascii: "a") && byte <= UInt8(ascii: "z"))
+            || (byte >= UInt8(ascii: "A") && byte <= UInt8(ascii: "Z"))
+            || byte == UInt8(ascii: "_")
+    }
+
+    private static func isDigitOrDot(_ byte: UInt8) -> Bool {
+        (byte >= UInt8(ascii: "0") && byte <= UInt8(ascii: "9")) || byte == UInt8(ascii: ".")
+    }
+}
+
+/// A `PromptBuilder` prepared for rendering many times.
+///
+/// Created by `PromptBuilder.compile`, which parses the templates, renders the
+/// output format, examples and the builder's own variables into them once,
+/// and checks that every remaining placeholder is a declared per-call
+/// variable. Each `render` then only fills in those variables.
+///
+/// ```swift
+/// let prompt = try PromptBuilder()
+///     .system("You are a sentiment analyzer.\n{{ ctx.output_format }}")
+///     .user("Analyze this text: {{ text }}")
+///     .compile(returnType: SentimentResult.self, variables: ["text"])
+///
+/// let messages = try prompt.render(["text": "I love this product!"])
+/// ```
+public struct CompiledPrompt: Sendable {
+    /// Per-call variables, as declared when compiling
+    public let variableNames: Set<String>
+
+    private let prefix: PromptTemplate?
+    private let system: PromptTemplate?
+    private let user: PromptTemplate?
+
+    init(
+        variableNames: Set<String>,
+        prefix: PromptTemplate?,
+        system: PromptTemplate?,
+        user: PromptTemplate?
+    ) throws {
+        for template in [prefix, system, user].compactMap({ $0 }) {
+            if let unknown = template.variableNames.first(where: { !variableNames.contains($0) }) {
+                throw SwamlError.configurationError(
+                    "Prompt references undeclared variable '\(unknown)'"
+                )
+            }
+        }
+        self.variableNames = variableNames
+        self.prefix = prefix
+        self.system = system
+        self.user = user
+    }
+
+    /// Render the chat messages for one call
+    ///
+    /// - Parameter variables: Values for the declared variables; extra keys are ignored
+    /// - Throws: `SwamlError.configurationError` if a referenced variable has no value
+    public func render(_ variables: [String: String] = [:]) throws -> [ChatMessage] {
+        var messages: [ChatMessage] = []
+        if let prefix = prefix {
+            messages.append(.system(try prefix.renderStrict(variables), cacheable: true))
+        }
+        if let system = system {
+            messages.append(.system(try system.renderStrict(variables), cacheable: system.isConstant))
+        }
+        if let user = user {
+            messages.append(.user(try user.renderStrict(variables)))
+        }
+        return messages
+    }
+}
@@ -8,6 +8,7 @@ import Foundation
 /// - Variable substitution ({{ variable_name }} syntax)
 /// - Automatic output format injection ({{ ctx.output_format }})
 /// - Few-shot examples
+/// - A cacheable prefix of static instructions, reused by provider prompt caches
 ///
 /// Example usage:
 /// ```swift
@@ -20,7 +21,23 @@ import Foundation
 ///     .variable("text", "I love this product!")
 ///     .build(returnType: SentimentResult.self)
 /// ```
+///
+/// Providers cache prompts by exact prefix, so content that's identical on
+/// every call should come first. A system template that only references
+/// `{{ ctx.output_format }}` and the examples is marked cacheable as is; when
+/// the system prompt also needs per-call variables, move the static part
+/// (schema included) into `cacheablePrefix`, which is sent ahead of it:
+/// ```swift
+/// let prompt = PromptBuilder()
+///     .cacheablePrefix("""
+///         You are a sentiment analyzer.
+///         {{ ctx.output_format }}
+///         """)
+///     .system("The user's locale is {{ locale }}.")
+///     .user("Analyze this text: {{ text }}")
+/// ```
 public struct PromptBuilder: Sendable {
+    private var prefixTemplate: String = ""
     private var systemTemplate: String = ""
     private var userTemplate: String = ""
     private var variables: [String: String] = [:]
@@ -44,6 +61,23 @@ public struct PromptBuilder: Sendable {
         return copy
     }
 
+    /// Set the static instructions sent before the system prompt
+    ///
+    /// The prefix becomes its own system message, marked as the end of a
+    /// cacheable prefix (see `ChatMessage.cacheable`). It supports the same
+    /// placeholders as the system template, but anything substituted into it
+    /// should be the same on every call, or the provider cache never hits;
+    /// a prefix with an output format shortlisted for the request (`build`'s
+    /// `relevantTo:`) isn't marked.
+    ///
+    /// - Parameter template: The prefix template
+    /// - Returns: Updated builder for chaining
+    public func cacheablePrefix(_ template: String) -> PromptBuilder {
+        var copy = self
+        copy.prefixTemplate = template
+        return copy
+    }
+
     /// Set the user prompt template
     ///
     /// - Parameter template: The user prompt template
@@ -136,19 +170,29 @@ public struct PromptBuilder: Sendable {
     ///   - returnType: The expected return type (for schema generation)
     ///   - typeBuilder: Optional TypeBuilder for dynamic types
     ///   - includeDescriptions: Whether to include field descriptions in schema
+    ///   - query: The request, to shortlist dynamic enum values by (see
+    ///     `SchemaPromptRenderer`); a template with a shortlisted output
+    ///     format isn't marked cacheable
     /// - Returns: Array of ChatMessage ready for LLM call
     public func build<T: SwamlTyped>(
         returnType: T.Type,
         typeBuilder: TypeBuilder? = nil,
-        includeDescriptions: Bool = true
+        includeDescriptions: Bool = true,
+        relevantTo query: String? = nil
     ) -> [ChatMessage] {
         let outputFormat = SchemaPromptRenderer.render(
+            for: T.self,
+            typeBuilder: typeBuilder,
+            includeDescriptions: includeDescriptions,
+            relevantTo: query
+        )
+        let shortlisted = query != nil && SchemaPromptRenderer.rendersShortlist(
             for: T.self,
             typeBuilder: typeBuilder,
             includeDescriptions: includeDescriptions
         )
 
-        return buildWithOutputFormat(outputFormat)
+        return buildWithOutputFormat(outputFormat, isStatic: !shortlisted)
     }
 
     /// Build chat messages with a custom JSON schema
@@ -156,17 +200,21 @@ public struct PromptBuilder: Sendable {
     /// - Parameters:
     ///   - schema: The JSON schema for output format
     ///   - typeBuilder: Optional TypeBuilder for dynamic types
+    ///   - query: The request, to shortlist dynamic enum values by
     /// - Returns: Array of ChatMessage ready for LLM call
     public func build(
         schema: JSONSchema,
-        typeBuilder: TypeBuilder? = nil
+        typeBuilder: TypeBuilder? = nil,
+        relevantTo query: String? = nil
     ) -> [ChatMessage] {
         let outputFormat = SchemaPromptRenderer.render(
             schema: schema,
-            typeBuilder: typeBuilder
+            typeBuilder: typeBuilder,
+            relevantTo: query
         )
+        let shortlisted = query != nil && SchemaPromptRenderer.rendersShortlist(typeBuilder: typeBuilder)
 
-        return buildWithOutputFormat(outputFormat)
+        return buildWithOutputFormat(outputFormat, isStatic: !shortlisted)
     }
 
     /// Build chat messages without type information (raw prompts)
@@ -177,12 +225,58 @@ public struct PromptBuilder: Sendable {
         buildWithOutputFormat("")
     }
 
-    // MARK: - Private Helpers
+    // MARK: - Compiling
 
-    private func buildWithOutputFormat(_ outputFormat: String) -> [ChatMessage] {
-        var messages: [ChatMessage] = []
+    /// Compile for repeated rendering with an output format for the return type
+    ///
+    /// The templates are parsed and the output format, examples and variables
+    /// set on this builder are rendered in once; only `variables` are left to
+    /// fill on each `CompiledPrompt.render` call.
+    ///
+    /// - Parameters:
+    ///   - returnType: The expected return type (for schema generation)
+    ///   - typeBuilder: Optional TypeBuilder for dynamic types
+    ///   - includeDescriptions: Whether to include field descriptions in schema
+    ///   - variables: Names supplied per call; they take precedence over
+    ///     values set on the builder
+    /// - Throws: `SwamlError.configurationError` if a template references a
+    ///   variable that is neither set nor declared
+    public func compile<T: SwamlTyped>(
+        returnType: T.Type,
+        typeBuilder: TypeBuilder? = nil,
+        includeDescriptions: Bool = true,
+        variables: Set<String> = []
+    ) throws -> CompiledPrompt {
+        let outputFormat = SchemaPromptRenderer.render(
+            for: T.self,
+            typeBuilder: typeBuilder,
+            includeDescriptions: includeDescriptions
+        )
+        return try compileWithOutputFormat(outputFormat, variables: variables)
+    }
+
+    /// Compile for repeated rendering with a custom JSON schema
+    public func compile(
+        schema: JSONSchema,
+        typeBuilder: TypeBuilder? = nil,
+        variables: Set<String> = []
+    ) throws -> CompiledPrompt {
+        let outputFormat = SchemaPromptRenderer.render(
+            schema: schema,
+            typeBuilder: typeBuilder
+        )
+        return try compileWithOutputFormat(outputFormat, variables: variables)
+    }
+
+    /// Compile for repeated rendering without an output format
+    public func compileRaw(variables: Set<String> = []) throws -> CompiledPrompt {
+        try compileWithOutputFormat("", variables: variables)
+    }
+
+    // MARK: - Private Helpers
 
-        // Build all variables including special ones
+    /// Variables set on the builder plus the output format and examples
+    private func boundVariables(outputFormat: String) -> [String: String] {
         var allVariables = variables
         allVariables["ctx.output_format"] = outputFormat
 
@@ -193,50 +287,60 @@ public struct PromptBuilder: Sendable {
             }
             allVariables["examples"] = examples.joined(separator: "\n\n")
         }
+        return allVariables
+    }
+
+    /// - Parameter isStatic: Whether `outputFormat` is the same on every call
+    private func buildWithOutputFormat(_ outputFormat: String, isStatic outputFormatIsStatic: Bool = true) -> [ChatMessage] {
+        var messages: [ChatMessage] = []
+        let allVariables = boundVariables(outputFormat: outputFormat)
+        let staticPlaceholders = outputFormatIsStatic
+            ? Self.staticPlaceholders
+            : Self.staticPlaceholders.subtracting(["ctx.output_format"])
+
+        // Static prefix first, so it's identical across calls
+        if !prefixTemplate.isEmpty {
+            let template = PromptTemplate(prefixTemplate)
+            let cacheable = outputFormatIsStatic || !template.variableNames.contains("ctx.output_format")
+            messages.append(.system(template.render(allVariables), cacheable: cacheable))
+        }
 
         // Process system prompt
         if !systemTemplate.isEmpty {
-            let systemContent = substituteVariables(systemTemplate, variables: allVariables)
-            messages.append(.system(systemContent))
+            let template = PromptTemplate(systemTemplate)
+            let cacheable = isStatic(template, placeholders: staticPlaceholders)
+            messages.append(.system(template.render(allVariables), cacheable: cacheable))
         }
 
         // Process user prompt
         if !userTemplate.isEmpty {
-            let userContent = substituteVariables(userTemplate, variables: allVariables)
-            messages.append(.user(userContent))
+            messages.append(.user(PromptTemplate(userTemplate).render(allVariables)))
         }
 
         return messages
     }
 
-    /// Substitute {{ variable }} placeholders in a template
-    private func substituteVariables(_ template: String, variables: [String: String]) -> String {
-        var result = template
+    private func compileWithOutputFormat(_ outputFormat: String, variables open: Set<String>) throws -> CompiledPrompt {
+        let allVariables = boundVariables(outputFormat: outputFormat)
 
-        // Match {{ variable_name }} with optional whitespace
-        let pattern = #"\{\{\s*([a-zA-Z_][a-zA-Z0-9_.]*)\s*\}\}"#
-        guard let regex = try? NSRegularExpression(pattern: pattern) else {
-            return template
+        func compiled(_ template: String) -> PromptTemplate? {
+            template.isEmpty ? nil : PromptTemplate(template).binding(allVariables, except: open)
         }
 
-        let range = NSRange(template.startIndex..., in: template)
-        let matches = regex.matches(in: template, range: range)
-
-        // Process matches in reverse order to preserve indices
-        for match in matches.reversed() {
-            guard let fullRange = Range(match.range, in: result),
-                  let varRange = Range(match.range(at: 1), in: result) else {
-                continue
-            }
+        return try CompiledPrompt(
+            variableNames: open,
+            prefix: compiled(prefixTemplate),
+            system: compiled(systemTemplate),
+            user: compiled(userTemplate)
+        )
+    }
 
-            let varName = String(result[varRange])
-            if let value = variables[varName] {
-                result.replaceSubrange(fullRange, with: value)
-            }
-            // Leave unmatched variables as-is (or could throw)
-        }
+    /// Placeholders whose values don't change between calls
+    private static let staticPlaceholders: Set<String> = ["ctx.output_format", "example", "examples"]
 
-        return result
+    /// Whether a template renders the same on every call with this builder
+    private func isStatic(_ template: PromptTemplate, placeholders: Set<String>) -> Bool {
+        template.variableNames.allSatisfy { placeholders.contains($0) }
     }
 
     private func jsonEncode<T: Encodable>(_ value: T, prettyPrinted: Bool = false) throws -> String {
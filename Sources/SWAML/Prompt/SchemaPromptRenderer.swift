@@ -26,53 +26,104 @@ public struct SchemaPromptRenderer {
     /// - Enums: "Answer with any of the categories:\n..."
     /// - Primitives: "Answer as an int", "Answer as a float", etc.
     /// - Arrays: "Answer with a JSON Array using this schema:\n..."
+    ///
+    /// Types with a compile-time `swamlSchemaPrompt` return it directly. Otherwise
+    /// the rendered prompt is cached per type and TypeBuilder, and re-rendered
+    /// only after the TypeBuilder changes.
+    ///
+    /// - Parameter query: The request the prompt is for. Dynamic enums with a
+    ///   shortlist (`DynamicEnumBuilder.shortlist(_:)`) then list only their
+    ///   values most relevant to it; such prompts aren't cached.
     public static func render<T: SwamlTyped>(
         for type: T.Type,
         typeBuilder: TypeBuilder? = nil,
-        includeDescriptions: Bool = true
+        includeDescriptions: Bool = true,
+        relevantTo query: String? = nil
     ) -> String {
-        renderFullPrompt(
-            schema: T.swamlSchema,
-            descriptions: includeDescriptions ? T.fieldDescriptions : [:],
-            typeBuilder: typeBuilder
-        )
+        if includeDescriptions, let prompt = T.swamlSchemaPrompt {
+            return prompt
+        }
+
+        if let query = query, let snapshot = typeBuilder?.snapshot(), snapshot.hasShortlistedEnums {
+            return renderFullPrompt(
+                schema: T.swamlSchema,
+                descriptions: includeDescriptions ? T.fieldDescriptions : [:],
+                snapshot: snapshot.shortlisted(for: query)
+            )
+        }
+
+        let cache = typeBuilder?.schemaCache ?? .standalone
+        let key = SchemaCache.Key.type(ObjectIdentifier(T.self), includeDescriptions: includeDescriptions)
+
+        return cache.prompt(for: key, generation: typeBuilder?.generation ?? 0) {
+            renderFullPrompt(
+                schema: T.swamlSchema,
+                descriptions: includeDescriptions ? T.fieldDescriptions : [:],
+                snapshot: typeBuilder?.snapshot()
+            )
+        }
+    }
+
+    /// Whether `render(for:typeBuilder:includeDescriptions:relevantTo:)`
+    /// lists shortlisted enum values, so its prompt changes with the request
+    /// and shouldn't end a cacheable prefix
+    public static func rendersShortlist<T: SwamlTyped>(
+        for type: T.Type,
+        typeBuilder: TypeBuilder?,
+        includeDescriptions: Bool = true
+    ) -> Bool {
+        if includeDescriptions, T.swamlSchemaPrompt != nil {
+            return false
+        }
+        return rendersShortlist(typeBuilder: typeBuilder)
+    }
+
+    /// Whether `render(schema:descriptions:typeBuilder:relevantTo:)` may list
+    /// shortlisted enum values (see `rendersShortlist(for:typeBuilder:includeDescriptions:)`)
+    public static func rendersShortlist(typeBuilder: TypeBuilder?) -> Bool {
+        typeBuilder?.snapshot().hasShortlistedEnums ?? false
     }
 
     /// Render a schema prompt from JSONSchema directly
+    ///
+    /// - Parameter query: The request the prompt is for, to shortlist dynamic
+    ///   enum values by (see `render(for:typeBuilder:includeDescriptions:relevantTo:)`)
     public static func render(
         schema: JSONSchema,
         descriptions: [String: String] = [:],
-        typeBuilder: TypeBuilder? = nil
+        typeBuilder: TypeBuilder? = nil,
+        relevantTo query: String? = nil
+    ) -> String {
+        let snapshot = typeBuilder?.snapshot()
+        return render(
+            schema: schema,
+            descriptions: descriptions,
+            snapshot: query.flatMap { snapshot?.shortlisted(for: $0) } ?? snapshot
+        )
+    }
+
+    private static func render(
+        schema: JSONSchema,
+        descriptions: [String: String],
+        snapshot: TypeBuilderSnapshot?
     ) -> String {
         // If no descriptions provided but we have a TypeBuilder, try to extract them
         var finalDescriptions = descriptions
-        if descriptions.isEmpty, let tb = typeBuilder {
-            finalDescriptions = extractDescriptions(from: schema, typeBuilder: tb)
+        if descriptions.isEmpty, let snapshot = snapshot {
+            finalDescriptions = extractDescriptions(from: schema, snapshot: snapshot)
         }
-        return renderFullPrompt(schema: schema, descriptions: finalDescriptions, typeBuilder: typeBuilder)
+        return renderFullPrompt(schema: schema, descriptions: finalDescriptions, snapshot: snapshot)
     }
 
     /// Extract field descriptions from TypeBuilder for a given schema
-    private static func extractDescriptions(from schema: JSONSchema, typeBuilder: TypeBuilder) -> [String: String] {
+    private static func extractDescriptions(from schema: JSONSchema, snapshot: TypeBuilderSnapshot) -> [String: String] {
         // For object schemas, look up the class in TypeBuilder
         if case .object(let properties, _, _) = schema {
             // Try to find a matching class in TypeBuilder
-            for (_, classBuilder) in typeBuilder.allClassBuilders {
-                var matches = true
-                for propName in properties.keys {
-                    if classBuilder.allPropertyBuilders.first(where: { $0.name == propName }) == nil {
-                        matches = false
-                        break
-                    }
-                }
-                if matches {
-                    var descriptions: [String: String] = [:]
-                    for prop in classBuilder.allPropertyBuilders {
-                        if let desc = prop.descriptionValue {
-                            descriptions[prop.name] = desc
-                        }
-                    }
-                    return descriptions
+            for dynamicClass in snapshot.classes.values {
+                let names = Set(dynamicClass.properties.map(\.name))
+                if properties.keys.allSatisfy(names.contains) {
+                    return dynamicClass.descriptions
                 }
             }
         }
@@ -93,21 +144,19 @@ public struct SchemaPromptRenderer {
         className: String,
         from typeBuilder: TypeBuilder
     ) -> String {
-        guard let schema = typeBuilder.buildClassSchema(className) else {
-            return "Answer in JSON."
+        typeBuilder.schemaCache.prompt(for: .className(className), generation: typeBuilder.generation) {
+            renderUncached(className: className, from: typeBuilder)
         }
+    }
 
-        // Get descriptions from class builder
-        var descriptions: [String: String] = [:]
-        if let classBuilder = typeBuilder.allClassBuilders[className] {
-            for prop in classBuilder.allPropertyBuilders {
-                if let desc = prop.descriptionValue {
-                    descriptions[prop.name] = desc
-                }
-            }
+    private static func renderUncached(className: String, from typeBuilder: TypeBuilder) -> String {
+        let snapshot = typeBuilder.snapshot()
+        guard let dynamicClass = snapshot.classes[className] else {
+            return "Answer in JSON."
         }
 
-        return render(schema: schema, descriptions: descriptions, typeBuilder: typeBuilder)
+        // Get descriptions from class builder
+        return render(schema: dynamicClass.schema, descriptions: dynamicClass.descriptions, snapshot: snapshot)
     }
 
     // MARK: - Full Prompt Rendering (BAML Format)
@@ -116,7 +165,7 @@ public struct SchemaPromptRenderer {
     private static func renderFullPrompt(
         schema: JSONSchema,
         descriptions: [String: String] = [:],
-        typeBuilder: TypeBuilder? = nil
+        snapshot: TypeBuilderSnapshot? = nil
     ) -> String {
         switch schema {
         case .string:
@@ -135,7 +184,7 @@ public struct SchemaPromptRenderer {
             return "Answer with null"
 
         case .array(let items):
-            let itemSchema = renderSchema(items, descriptions: descriptions, typeBuilder: typeBuilder)
+            let itemSchema = renderSchema(items, descriptions: descriptions, snapshot: snapshot)
             return "Answer with a JSON Array using this schema:\n\(itemSchema)[]"
 
         case .enum(let values):
@@ -148,21 +197,21 @@ public struct SchemaPromptRenderer {
             return lines.joined(separator: "\n")
 
         case .object(_, _, _):
-            let schemaText = renderSchema(schema, descriptions: descriptions, typeBuilder: typeBuilder)
+            let schemaText = renderSchema(schema, descriptions: descriptions, snapshot: snapshot)
             return "Answer in JSON using this schema:\n\(schemaText)"
 
         case .ref(let name):
             // Check if it's a dynamic enum
-            if let builder = typeBuilder, let enumSchema = builder.buildEnumSchema(name) {
-                return renderFullPrompt(schema: enumSchema, descriptions: descriptions, typeBuilder: typeBuilder)
+            if let enumSchema = snapshot?.enumSchema(name) {
+                return renderFullPrompt(schema: enumSchema, descriptions: descriptions, snapshot: snapshot)
             }
             // Otherwise treat as object
-            let schemaText = renderSchema(schema, descriptions: descriptions, typeBuilder: typeBuilder)
+            let schemaText = renderSchema(schema, descriptions: descriptions, snapshot: snapshot)
             return "Answer in JSON using this schema:\n\(schemaText)"
 
         case .anyOf(let schemas):
             // For unions, render the types
-            let types = schemas.map { renderSchema($0, descriptions: descriptions, typeBuilder: typeBuilder) }
+            let types = schemas.map { renderSchema($0, descriptions: descriptions, snapshot: snapshot) }
             return "Answer with one of: \(types.joined(separator: " | "))"
         }
     }
@@ -175,6 +224,15 @@ public struct SchemaPromptRenderer {
         descriptions: [String: String] = [:],
         typeBuilder: TypeBuilder? = nil,
         indent: Int = 0
+    ) -> String {
+        renderSchema(schema, descriptions: descriptions, snapshot: typeBuilder?.snapshot(), indent: indent)
+    }
+
+    private static func renderSchema(
+        _ schema: JSONSchema,
+        descriptions: [String: String] = [:],
+        snapshot: TypeBuilderSnapshot?,
+        indent: Int = 0
     ) -> String {
         let indentStr = String(repeating: "  ", count: indent)
 
@@ -195,7 +253,7 @@ public struct SchemaPromptRenderer {
             return "null"
 
         case .array(let items):
-            let itemSchema = renderSchema(items, descriptions: descriptions, typeBuilder: typeBuilder, indent: indent)
+            let itemSchema = renderSchema(items, descriptions: descriptions, snapshot: snapshot, indent: indent)
             // BAML style: string[] not [string]
             return "\(itemSchema)[]"
 
@@ -218,7 +276,7 @@ public struct SchemaPromptRenderer {
                     }
                 }
 
-                let propType = renderSchema(propSchema, descriptions: descriptions, typeBuilder: typeBuilder, indent: indent + 1)
+                let propType = renderSchema(propSchema, descriptions: descriptions, snapshot: snapshot, indent: indent + 1)
                 let isOptional = !required.contains(key)
                 let optionalSuffix = isOptional ? "?" : ""
 
@@ -238,8 +296,8 @@ public struct SchemaPromptRenderer {
 
         case .ref(let name):
             // Check if TypeBuilder has this as a dynamic enum
-            if let builder = typeBuilder, let enumSchema = builder.buildEnumSchema(name) {
-                return renderSchema(enumSchema, descriptions: descriptions, typeBuilder: typeBuilder, indent: indent)
+            if let enumSchema = snapshot?.enumSchema(name) {
+                return renderSchema(enumSchema, descriptions: descriptions, snapshot: snapshot, indent: indent)
             }
             // Otherwise return as reference
             return name
@@ -248,17 +306,17 @@ public struct SchemaPromptRenderer {
             // Check for optional pattern (T | null)
             if schemas.count == 2 {
                 if case .null = schemas[1] {
-                    let inner = renderSchema(schemas[0], descriptions: descriptions, typeBuilder: typeBuilder, indent: indent)
+                    let inner = renderSchema(schemas[0], descriptions: descriptions, snapshot: snapshot, indent: indent)
                     return "\(inner) | null"
                 }
                 if case .null = schemas[0] {
-                    let inner = renderSchema(schemas[1], descriptions: descriptions, typeBuilder: typeBuilder, indent: indent)
+                    let inner = renderSchema(schemas[1], descriptions: descriptions, snapshot: snapshot, indent: indent)
                     return "\(inner) | null"
                 }
             }
             // General union
             return schemas.map {
-                renderSchema($0, descriptions: descriptions, typeBuilder: typeBuilder, indent: indent)
+                renderSchema($0, descriptions: descriptions, snapshot: snapshot, indent: indent)
             }.joined(separator: " | ")
         }
     }
@@ -272,20 +330,21 @@ public struct SchemaPromptRenderer {
         typeBuilder: TypeBuilder? = nil
     ) -> String {
         var sections: [String] = []
+        let snapshot = typeBuilder?.snapshot()
 
         // Render type definitions first
         if !definitions.isEmpty {
             sections.append("Type definitions:")
             for (name, schema) in definitions.sorted(by: { $0.key < $1.key }) {
-                let rendered = renderSchema(schema, typeBuilder: typeBuilder, indent: 1)
+                let rendered = renderSchema(schema, snapshot: snapshot, indent: 1)
                 sections.append("  \(name) = \(rendered)")
             }
             sections.append("")
         }
 
         // Render dynamic enums from TypeBuilder
-        if let builder = typeBuilder {
-            let dynamicEnums = builder.dynamicEnumValues()
+        if let snapshot = snapshot {
+            let dynamicEnums = snapshot.dynamicEnumValues
             if !dynamicEnums.isEmpty {
                 if definitions.isEmpty {
                     sections.append("Type definitions:")
@@ -299,7 +358,7 @@ public struct SchemaPromptRenderer {
         }
 
         // Render main schema
-        let rootSchema = renderSchema(root, typeBuilder: typeBuilder)
+        let rootSchema = renderSchema(root, snapshot: snapshot)
         sections.append("Answer in JSON using this schema:")
         sections.append(rootSchema)
 
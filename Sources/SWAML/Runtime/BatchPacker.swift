@@ -0,0 +1,128 @@
+import Foundation
+
+/// Packs several prompts of a batch into one structured request
+///
+/// Classification-style batches send many tiny prompts that all carry the
+/// same schema prompt, so the schema tokens and per-request overhead dwarf
+/// the inputs themselves. A packed request sends the schema once, followed by
+/// each input tagged with its id (in a tag no input contains), and asks for
+/// `{"results": [{"id": ..., "result": T}, ...]}`. `parse` scatters the
+/// answers back by id; items that are missing or don't decode are simply left
+/// out, for the caller to send again on their own.
+struct BatchPacker<T: SwamlTyped>: Sendable {
+    /// The system prompt of every packed request
+    let systemPrompt: String
+
+    private let repair: SchemaRepair
+
+    init(systemPrompt: String?, typeBuilder: TypeBuilder?) {
+        let schemaPrompt = SchemaPromptRenderer.render(
+            schema: Self.schema(for: T.swamlSchema),
+            descriptions: T.fieldDescriptions,
+            typeBuilder: typeBuilder
+        )
+        let instructions = """
+            You will be given several inputs, each with an id. Answer each input \
+            independently, as if it were the only one, and put the answer to every \
+            input in `results` together with its id.
+            """
+        self.systemPrompt = [systemPrompt, instructions, schemaPrompt]
+            .compactMap { $0 }
+            .joined(separator: "\n\n")
+        self.repair = SchemaRepair(for: T.self, typeBuilder: typeBuilder)
+    }
+
+    /// The response schema: one `{id, result}` entry per input
+    static func schema(for item: JSONSchema) -> JSONSchema {
+        .object(
+            properties: [
+                "results": .array(items: .object(
+                    properties: ["id": .string, "result": item],
+                    required: ["id", "result"]
+                )),
+            ],
+            required: ["results"]
+        )
+    }
+
+    /// Completion tokens allowed per input when the caller sets no budget but
+    /// the provider needs one
+    static let defaultTokensPerItem = 512
+
+    /// Messages asking for the answers to `items` (batch index and prompt)
+    func messages(for items: [(index: Int, prompt: String)]) -> [ChatMessage] {
+        let tag = Self.tag(avoiding: items.map(\.prompt))
+        let inputs = items.map { item in
+            "<\(tag) id=\"\(item.index)\">\n\(item.prompt)\n</\(tag)>"
+        }
+        return [
+            .system(systemPrompt, cacheable: true),
+            .user(inputs.joined(separator: "\n\n"))
+        ]
+    }
+
+    /// Completion budget of a request packing `count` inputs
+    ///
+    /// - Parameters:
+    ///   - perItem: The caller's budget per input, if any
+    ///   - required: Whether the provider needs a budget (Anthropic), rather
+    ///     than defaulting to the model's maximum
+    static func maxTokens(for count: Int, perItem: Int?, required: Bool) -> Int? {
+        if let perItem = perItem {
+            return perItem * count
+        }
+        // Never less than a single request's default budget
+        return required ? max(4096, defaultTokensPerItem * count) : nil
+    }
+
+    /// `input`, or `input-1`, `input-2`... if an input contains the tag, so
+    /// no input can close its own tag or open another
+    static func tag(avoiding prompts: [String]) -> String {
+        var tag = "input"
+        var suffix = 0
+        while prompts.contains(where: { $0.contains("<\(tag)") || $0.contains("</\(tag)") }) {
+            suffix += 1
+            tag = "input-\(suffix)"
+        }
+        return tag
+    }
+
+    /// Decoded answers by batch index, limited to `indices`
+    ///
+    /// A bare array of entries is accepted in place of the `results` object.
+    /// Answers that don't decode as they are get a `SchemaRepair` pass.
+    func parse(_ content: String, indices: Set<Int>) throws -> [Int: T] {
+        let value = try JsonishParser.parseValue(content)
+        guard let entries = value["results"]?.arrayValue ?? value.arrayValue else {
+            throw SwamlError.schemaValidationError("Expected a `results` array of packed answers")
+        }
+
+        var answers: [Int: T] = [:]
+        for entry in entries {
+            guard let id = entry["id"].flatMap(Self.index), indices.contains(id), answers[id] == nil,
+                  let result = entry["result"] else { continue }
+
+            if let decoded = try? SwamlValueDecoder().decode(T.self, from: result) {
+                answers[id] = decoded
+            } else if let repaired = repair.repair(result),
+                      let decoded = try? SwamlValueDecoder().decode(T.self, from: repaired.value) {
+                answers[id] = decoded
+            }
+        }
+        return answers
+    }
+
+    /// An id as the model wrote it back (`"3"`, `3` or `"id 3"`)
+    private static func index(_ id: SwamlValue) -> Int? {
+        switch id {
+        case .int(let index):
+            return index
+        case .float(let value):
+            return Int(exactly: value)
+        case .string(let text):
+            return Int(text.filter(\.isNumber))
+        default:
+            return nil
+        }
+    }
+}
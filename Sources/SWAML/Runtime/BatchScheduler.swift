@@ -0,0 +1,259 @@
+import Foundation
+
+/// Order in which batch results are delivered
+public enum BatchOrder: Sendable {
+    /// In input order. Results that finish early are held until their turn,
+    /// so a slow request delays (but doesn't block) the ones behind it.
+    case ordered
+
+    /// As soon as each request completes
+    case unordered
+}
+
+/// One completed request of a batch
+public struct BatchResult<Output: Sendable>: Sendable {
+    /// Position of the input in the batch
+    public let index: Int
+
+    /// The output, or the error the request failed with
+    public let result: Result<Output, Error>
+}
+
+/// Results of a batch, produced by a sliding-window scheduler.
+///
+/// Exactly `maxConcurrency` requests are kept in flight: a new one starts as
+/// soon as any finishes, not when a whole wave is done. Results are handed out
+/// as they complete and aren't accumulated, so memory stays proportional to the
+/// window rather than the batch. Requests only start while the consumer keeps
+/// up; in `.ordered` mode at most `2 * maxConcurrency` results are held back.
+///
+/// Rate-limit responses (HTTP 429/529) shrink the window, halving it on each
+/// one and growing it back by one per success, and the request is retried
+/// after the policy's backoff delay.
+///
+/// The batch is cancelled when the iterating task is cancelled or the
+/// iterator is released.
+public struct BatchSequence<Input: Sendable, Output: Sendable>: AsyncSequence {
+    public typealias Element = BatchResult<Output>
+
+    private let inputs: [Input]
+    private let maxConcurrency: Int
+    private let order: BatchOrder
+    private let rateLimitPolicy: RetryPolicy
+    private let operation: @Sendable (Input) async throws -> Output
+
+    /// Create a batch
+    ///
+    /// - Parameters:
+    ///   - inputs: Inputs, one request each
+    ///   - maxConcurrency: Maximum concurrent requests
+    ///   - order: Order in which results are delivered
+    ///   - rateLimitPolicy: Backoff and retry limit for rate-limited requests
+    ///   - operation: The request to run for each input
+    public init(
+        inputs: [Input],
+        maxConcurrency: Int,
+        order: BatchOrder = .ordered,
+        rateLimitPolicy: RetryPolicy = .standard,
+        operation: @escaping @Sendable (Input) async throws -> Output
+    ) {
+        self.inputs = inputs
+        self.maxConcurrency = max(1, maxConcurrency)
+        self.order = order
+        self.rateLimitPolicy = rateLimitPolicy
+        self.operation = operation
+    }
+
+    public func makeAsyncIterator() -> Iterator {
+        Iterator(window: BatchWindow(
+            inputs: inputs,
+            maxConcurrency: maxConcurrency,
+            order: order,
+            rateLimitPolicy: rateLimitPolicy,
+            operation: operation
+        ))
+    }
+
+    public struct Iterator: AsyncIteratorProtocol {
+        fileprivate let window: BatchWindow<Input, Output>
+
+        public mutating func next() async -> BatchResult<Output>? {
+            await window.next()
+        }
+    }
+}
+
+// MARK: - Window
+
+/// Scheduling state of a running batch
+fileprivate actor BatchWindow<Input: Sendable, Output: Sendable> {
+    private let inputs: [Input]
+    private let maxConcurrency: Int
+    private let order: BatchOrder
+    private let rateLimitPolicy: RetryPolicy
+    private let operation: @Sendable (Input) async throws -> Output
+
+    /// Maximum of in-flight plus undelivered results
+    private let capacity: Int
+
+    /// Current window, reduced while the provider is rate limiting
+    private var limit: Int
+
+    private var nextIndex = 0
+    private var nextToDeliver = 0
+    private var inFlight: [Int: Task<Void, Never>] = [:]
+
+    /// Completed results, by index (`.ordered`)
+    private var held: [Int: Result<Output, Error>] = [:]
+
+    /// Completed results, in completion order (`.unordered`)
+    private var queue: [BatchResult<Output>] = []
+
+    private var waiter: CheckedContinuation<BatchResult<Output>?, Never>?
+    private var isCancelled = false
+
+    init(
+        inputs: [Input],
+        maxConcurrency: Int,
+        order: BatchOrder,
+        rateLimitPolicy: RetryPolicy,
+        operation: @escaping @Sendable (Input) async throws -> Output
+    ) {
+        self.inputs = inputs
+        self.maxConcurrency = maxConcurrency
+        self.order = order
+        self.rateLimitPolicy = rateLimitPolicy
+        self.operation = operation
+        self.capacity = order == .ordered ? maxConcurrency * 2 : maxConcurrency
+        self.limit = maxConcurrency
+    }
+
+    deinit {
+        for task in inFlight.values {
+            task.cancel()
+        }
+    }
+
+    func next() async -> BatchResult<Output>? {
+        fill()
+        if let result = takeCompleted() {
+            fill()
+            return result
+        }
+        if isCancelled || (inFlight.isEmpty && nextIndex == inputs.count) {
+            return nil
+        }
+
+        return await withTaskCancellationHandler {
+            await withCheckedContinuation { continuation in
+                waiter = continuation
+            }
+        } onCancel: {
+            Task { await self.cancel() }
+        }
+    }
+
+    // MARK: Scheduling
+
+    /// Start requests until the window or the buffer is full
+    private func fill() {
+        guard !isCancelled else { return }
+
+        while nextIndex < inputs.count,
+              inFlight.count < limit,
+              inFlight.count + held.count + queue.count < capacity {
+            launch(nextIndex)
+            nextIndex += 1
+        }
+    }
+
+    private func launch(_ index: Int) {
+        let input = inputs[index]
+        let operation = operation
+        let policy = rateLimitPolicy
+
+        inFlight[index] = Task { [weak self] in
+            var attempt = 0
+            while true {
+                do {
+                    let output = try await operation(input)
+                    await self?.complete(index, .success(output))
+                    return
+                } catch {
+                    guard Self.isRateLimited(error), attempt < policy.maxRetries, !Task.isCancelled else {
+                        await self?.complete(index, .failure(error))
+                        return
+                    }
+                    await self?.didHitRateLimit()
+                    try? await Task.sleep(nanoseconds: UInt64(policy.delayForAttempt(attempt) * 1_000_000_000))
+                    attempt += 1
+                }
+            }
+        }
+    }
+
+    private func complete(_ index: Int, _ result: Result<Output, Error>) {
+        inFlight[index] = nil
+        guard !isCancelled else { return }
+
+        if case .success = result {
+            limit = min(limit + 1, maxConcurrency)
+        }
+
+        switch order {
+        case .ordered:
+            held[index] = result
+        case .unordered:
+            queue.append(BatchResult(index: index, result: result))
+        }
+
+        if let waiter = waiter, let result = takeCompleted() {
+            self.waiter = nil
+            waiter.resume(returning: result)
+        }
+        fill()
+
+        // Nothing left to deliver
+        if let waiter = waiter, inFlight.isEmpty, nextIndex == inputs.count {
+            self.waiter = nil
+            waiter.resume(returning: nil)
+        }
+    }
+
+    private func takeCompleted() -> BatchResult<Output>? {
+        switch order {
+        case .ordered:
+            guard let result = held.removeValue(forKey: nextToDeliver) else { return nil }
+            nextToDeliver += 1
+            return BatchResult(index: nextToDeliver - 1, result: result)
+        case .unordered:
+            return queue.isEmpty ? nil : queue.removeFirst()
+        }
+    }
+
+    private func didHitRateLimit() {
+        limit = max(1, limit / 2)
+    }
+
+    private func cancel() {
+        isCancelled = true
+        for task in inFlight.values {
+            task.cancel()
+        }
+        held.removeAll()
+        queue.removeAll()
+
+        if let waiter = waiter {
+            self.waiter = nil
+            waiter.resume(returning: nil)
+        }
+    }
+
+    private static func isRateLimited(_ error: Error) -> Bool {
+        if case SwamlError.apiError(let statusCode, _) = error {
+            // 529 is Anthropic's "overloaded"
+            return statusCode == 429 || statusCode == 529
+        }
+        return false
+    }
+}
@@ -0,0 +1,284 @@
+import Foundation
+#if canImport(os)
+import os
+#endif
+
+// MARK: - Metrics
+
+/// Phases of a call that are timed
+public enum CallPhase: String, Sendable, CaseIterable {
+    /// Rendering the schema prompt or resolving the output schema
+    case schema
+
+    /// Writing request bodies
+    case encode
+
+    /// Waiting for `RateLimiter` admission
+    case rateLimit
+
+    /// HTTP exchanges, from sending the request to the last byte
+    case network
+
+    /// Part of `network` until the response headers arrived (where the
+    /// platform reports task metrics)
+    case timeToFirstByte
+
+    /// Part of `network` spent receiving the response body (where the
+    /// platform reports task metrics)
+    case download
+
+    /// Extracting, repairing and coercing JSON from the output
+    case parse
+
+    /// Decoding the parsed value into the return type
+    case decode
+
+    /// LLM round trips asking the model to fix unparseable output
+    case repair
+}
+
+/// What happened during one call, reported when it finishes
+///
+/// Phase durations are summed over every occurrence (e.g. each retry's
+/// `network` time); counts and sizes likewise cover the whole call.
+public struct CallMetrics: Sendable {
+    /// The API that was called, e.g. `SwamlClient.call` or a function name
+    public let operation: String
+
+    /// `RuntimeContext.tags` of the call (or the client's metrics tags)
+    public let tags: [String: String]
+
+    /// Wall time of the whole call, in seconds
+    public internal(set) var duration: TimeInterval = 0
+
+    /// Time spent in each phase, in seconds
+    public internal(set) var phases: [CallPhase: TimeInterval] = [:]
+
+    /// HTTP requests sent, including retries and repairs
+    public internal(set) var requests = 0
+
+    /// Requests `RetryExecutor` retried
+    public internal(set) var retries = 0
+
+    /// LLM repair round trips
+    public internal(set) var repairs = 0
+
+    /// Outputs `SchemaRepair` fixed locally, without a repair round trip
+    public internal(set) var localRepairs = 0
+
+    /// Requests continuing output cut off by the token limit
+    public internal(set) var continuations = 0
+
+    /// Schema-constrained outputs decoded as-is, without the tolerant parser
+    public internal(set) var strictDecodes = 0
+
+    /// Bytes of request bodies sent
+    public internal(set) var requestBytes = 0
+
+    /// Bytes of response bodies received
+    public internal(set) var responseBytes = 0
+
+    /// Token usage summed over every response
+    public internal(set) var promptTokens = 0
+    public internal(set) var completionTokens = 0
+    public internal(set) var cachedPromptTokens = 0
+
+    /// Which `JsonishParser` stage produced each parsed value, in order
+    public internal(set) var parsePaths: [JsonishParser.ExtractionPath] = []
+
+    /// Description of the error the call failed with, if it did
+    ///
+    /// Nil for a cancelled call, which isn't a failure (see `cancelled`).
+    public internal(set) var error: String?
+
+    /// Whether the call was cancelled before it finished
+    public internal(set) var cancelled = false
+
+    init(operation: String, tags: [String: String]) {
+        self.operation = operation
+        self.tags = tags
+    }
+
+    /// Time spent in a phase (0 if it didn't occur)
+    public subscript(phase: CallPhase) -> TimeInterval {
+        phases[phase] ?? 0
+    }
+}
+
+/// Receives the metrics of finished calls
+///
+/// Called synchronously as each call finishes, from whatever task ran it;
+/// implementations should hand the metrics off rather than do slow work.
+public protocol CallMetricsObserver: Sendable {
+    func callDidFinish(_ metrics: CallMetrics)
+}
+
+/// Observer that forwards metrics to a closure
+public struct CallMetricsHandler: CallMetricsObserver {
+    private let handler: @Sendable (CallMetrics) -> Void
+
+    public init(_ handler: @escaping @Sendable (CallMetrics) -> Void) {
+        self.handler = handler
+    }
+
+    public func callDidFinish(_ metrics: CallMetrics) {
+        handler(metrics)
+    }
+}
+
+// MARK: - Tracing
+
+/// Collects the metrics of the call running in the current task
+///
+/// `SwamlClient` and `SwamlRuntime` start a trace per call and bind it as a
+/// task local, so the layers underneath (`LLMClient`, `RetryExecutor`, the
+/// parsers) record into it without it being passed around. Nested calls
+/// (e.g. `callWithRepair` calling `call`) join the outer trace.
+///
+/// Traces only exist when there's an observer or, on Apple platforms, when
+/// signposts are being recorded; otherwise every hook is a task-local read.
+/// Phases are also emitted as `os_signpost` intervals under the "com.swaml"
+/// subsystem.
+final class CallTrace: @unchecked Sendable {
+    @TaskLocal static var current: CallTrace?
+
+    private let lock = NSLock()
+    private var metrics: CallMetrics
+    private let observer: (any CallMetricsObserver)?
+
+    #if canImport(os)
+    private static let signposter = OSSignposter(subsystem: "com.swaml", category: "Call")
+    private let signpostID: OSSignpostID
+    #endif
+
+    private init(operation: String, tags: [String: String], observer: (any CallMetricsObserver)?) {
+        self.metrics = CallMetrics(operation: operation, tags: tags)
+        self.observer = observer
+        #if canImport(os)
+        self.signpostID = Self.signposter.makeSignpostID()
+        #endif
+    }
+
+    /// Run `body` as one traced call, reporting its metrics when it finishes
+    static func run<T>(
+        _ operation: String,
+        tags: [String: String] = [:],
+        observer: (any CallMetricsObserver)?,
+        body: () async throws -> T
+    ) async rethrows -> T {
+        guard current == nil, observer != nil || signpostsEnabled else {
+            return try await body()
+        }
+
+        let trace = CallTrace(operation: operation, tags: tags, observer: observer)
+        let start = ContinuousClock.now
+        do {
+            let result = try await $current.withValue(trace) {
+                try await body()
+            }
+            trace.finish(duration: start.duration(to: .now).timeInterval, error: nil)
+            return result
+        } catch {
+            trace.finish(duration: start.duration(to: .now).timeInterval, error: error)
+            throw error
+        }
+    }
+
+    private static var signpostsEnabled: Bool {
+        #if canImport(os)
+        return signposter.isEnabled
+        #else
+        return false
+        #endif
+    }
+
+    private func finish(duration: TimeInterval, error: Error?) {
+        lock.lock()
+        metrics.duration = duration
+        if let error = error, isCancellation(error) {
+            metrics.cancelled = true
+        } else {
+            metrics.error = error?.localizedDescription
+        }
+        let finished = metrics
+        lock.unlock()
+        observer?.callDidFinish(finished)
+    }
+
+    // MARK: Recording
+
+    /// Update the metrics of the current call, if it's traced
+    static func record(_ update: (inout CallMetrics) -> Void) {
+        current?.record(update)
+    }
+
+    func record(_ update: (inout CallMetrics) -> Void) {
+        lock.lock()
+        update(&metrics)
+        lock.unlock()
+    }
+
+    /// Add time to a phase without running it (e.g. from task metrics)
+    func add(_ phase: CallPhase, _ duration: TimeInterval) {
+        record { $0.phases[phase, default: 0] += duration }
+    }
+
+    /// Time `body` as `phase` of the current call, if it's traced
+    static func measure<T>(_ phase: CallPhase, _ body: () throws -> T) rethrows -> T {
+        guard let trace = current else { return try body() }
+        return try trace.measure(phase, body)
+    }
+
+    /// Time `body` as `phase` of the current call, if it's traced
+    static func measure<T>(_ phase: CallPhase, _ body: () async throws -> T) async rethrows -> T {
+        guard let trace = current else { return try await body() }
+        return try await trace.measure(phase, body)
+    }
+
+    func measure<T>(_ phase: CallPhase, _ body: () throws -> T) rethrows -> T {
+        #if canImport(os)
+        let interval = Self.signposter.beginInterval(phase.signpostName, id: signpostID)
+        defer { Self.signposter.endInterval(phase.signpostName, interval) }
+        #endif
+        let start = ContinuousClock.now
+        defer { add(phase, start.duration(to: .now).timeInterval) }
+        return try body()
+    }
+
+    func measure<T>(_ phase: CallPhase, _ body: () async throws -> T) async rethrows -> T {
+        #if canImport(os)
+        let interval = Self.signposter.beginInterval(phase.signpostName, id: signpostID)
+        defer { Self.signposter.endInterval(phase.signpostName, interval) }
+        #endif
+        let start = ContinuousClock.now
+        defer { add(phase, start.duration(to: .now).timeInterval) }
+        return try await body()
+    }
+}
+
+#if canImport(os)
+extension CallPhase {
+    /// Signpost names must be static strings
+    fileprivate var signpostName: StaticString {
+        switch self {
+        case .schema: return "schema"
+        case .encode: return "encode"
+        case .rateLimit: return "rateLimit"
+        case .network: return "network"
+        case .timeToFirstByte: return "timeToFirstByte"
+        case .download: return "download"
+        case .parse: return "parse"
+        case .decode: return "decode"
+        case .repair: return "repair"
+        }
+    }
+}
+#endif
+
+extension Duration {
+    /// The duration in seconds
+    var timeInterval: TimeInterval {
+        let parts = components
+        return Double(parts.seconds) + Double(parts.attoseconds) / 1e18
+    }
+}
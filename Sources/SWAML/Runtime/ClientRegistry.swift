@@ -9,13 +9,18 @@ public struct ClientConfig: Sendable {
     public let defaultTemperature: Double?
     public let defaultMaxTokens: Int?
 
+    /// Request and token budgets enforced before sending. Limits that aren't
+    /// set here are learned from the provider's rate-limit headers.
+    public let rateLimits: RateLimits
+
     public init(
         name: String,
         provider: LLMProvider,
         model: String,
         retryPolicy: RetryPolicy = .standard,
         defaultTemperature: Double? = nil,
-        defaultMaxTokens: Int? = nil
+        defaultMaxTokens: Int? = nil,
+        rateLimits: RateLimits = .unlimited
     ) {
         self.name = name
         self.provider = provider
@@ -23,6 +28,7 @@ public struct ClientConfig: Sendable {
         self.retryPolicy = retryPolicy
         self.defaultTemperature = defaultTemperature
         self.defaultMaxTokens = defaultMaxTokens
+        self.rateLimits = rateLimits
     }
 }
 
@@ -30,13 +36,21 @@ public struct ClientConfig: Sendable {
 public actor ClientRegistry {
     private var clients: [String: ClientConfig] = [:]
     private var llmClients: [String: LLMClient] = [:]
+    private var rateLimiters: [String: RateLimiter] = [:]
     private var defaultClientName: String?
 
-    public init() {}
+    /// Transport whose per-host sessions the clients send on
+    public let transport: HTTPTransport
+
+    public init(transport: HTTPTransport = .shared) {
+        self.transport = transport
+    }
 
     /// Register a client configuration
     public func register(_ config: ClientConfig, isDefault: Bool = false) {
         clients[config.name] = config
+        llmClients.removeValue(forKey: config.name)
+        rateLimiters.removeValue(forKey: config.name)
         if isDefault || defaultClientName == nil {
             defaultClientName = config.name
         }
@@ -50,6 +64,7 @@ public actor ClientRegistry {
         retryPolicy: RetryPolicy = .standard,
         defaultTemperature: Double? = nil,
         defaultMaxTokens: Int? = nil,
+        rateLimits: RateLimits = .unlimited,
         isDefault: Bool = false
     ) {
         let config = ClientConfig(
@@ -58,7 +73,8 @@ public actor ClientRegistry {
             model: model,
             retryPolicy: retryPolicy,
             defaultTemperature: defaultTemperature,
-            defaultMaxTokens: defaultMaxTokens
+            defaultMaxTokens: defaultMaxTokens,
+            rateLimits: rateLimits
         )
         register(config, isDefault: isDefault)
     }
@@ -84,11 +100,54 @@ public actor ClientRegistry {
             throw SwamlError.clientNotFound(name)
         }
 
-        let client = LLMClient(provider: config.provider)
+        let client = LLMClient(
+            provider: config.provider,
+            session: transport.session(for: config.provider),
+            rateLimiter: rateLimiter(for: config)
+        )
         llmClients[name] = client
         return client
     }
 
+    /// Get the rate limiter for a client
+    ///
+    /// Every client has one, shared by all calls through the registry.
+    public func getRateLimiter(_ name: String) throws -> RateLimiter {
+        guard let config = clients[name] else {
+            throw SwamlError.clientNotFound(name)
+        }
+        return rateLimiter(for: config)
+    }
+
+    private func rateLimiter(for config: ClientConfig) -> RateLimiter {
+        if let existing = rateLimiters[config.name] {
+            return existing
+        }
+        let limiter = RateLimiter(limits: config.rateLimits)
+        rateLimiters[config.name] = limiter
+        return limiter
+    }
+
+    /// Open connections to the hosts of the registered clients
+    ///
+    /// Call after registering clients so the first requests don't pay for
+    /// DNS and TLS handshakes. Each host is contacted once, concurrently.
+    public func warmUp() async {
+        var providers: [String: LLMProvider] = [:]
+        for config in clients.values {
+            providers[HTTPTransport.hostKey(for: config.provider.baseURL)] = config.provider
+        }
+
+        let transport = transport
+        await withTaskGroup(of: Void.self) { group in
+            for provider in providers.values {
+                group.addTask {
+                    await transport.warmUp(provider)
+                }
+            }
+        }
+    }
+
     /// Get the default LLMClient
     public func getDefaultClient() throws -> LLMClient {
         guard let name = defaultClientName else {
@@ -114,6 +173,7 @@ public actor ClientRegistry {
     public func remove(_ name: String) {
         clients.removeValue(forKey: name)
         llmClients.removeValue(forKey: name)
+        rateLimiters.removeValue(forKey: name)
         if defaultClientName == name {
             defaultClientName = clients.keys.first
         }
@@ -123,6 +183,7 @@ public actor ClientRegistry {
     public func clear() {
         clients.removeAll()
         llmClients.removeAll()
+        rateLimiters.removeAll()
         defaultClientName = nil
     }
 }
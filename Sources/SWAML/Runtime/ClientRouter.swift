@@ -0,0 +1,193 @@
+import Foundation
+
+/// How a runtime spreads calls across the clients in its registry
+///
+/// Without a policy every call goes to `ctx.clientName` or the default client.
+/// With one, calls that don't name a client go to the fastest healthy client
+/// among `clients`, judged by the latency and error rate the runtime has
+/// observed. With `hedgePercentile` set, a call that is still running after
+/// that percentile of its client's recent latencies is sent again to the next
+/// best client; the first result that parses wins and the other is cancelled.
+public struct RoutingPolicy: Sendable {
+    /// Clients to route between, by name; empty means every registered client
+    public let clients: [String]
+
+    /// Latency percentile (0...1) after which a duplicate request is sent to a
+    /// second client, or nil to never hedge
+    public let hedgePercentile: Double?
+
+    /// Shortest hedge delay, and the delay used until a client has
+    /// `minimumSamples` latencies recorded
+    public let minimumHedgeDelay: TimeInterval
+
+    /// Latencies recorded before the percentile is trusted
+    public let minimumSamples: Int
+
+    /// Clients whose recent error rate is above this are avoided while any
+    /// other client is healthy
+    public let maxErrorRate: Double
+
+    /// Weight of the newest observation in the latency and error averages
+    public let smoothing: Double
+
+    /// How long an idle client takes to win back traffic: its error rate
+    /// halves every interval without a call, and after one interval its
+    /// latency is forgotten so it gets tried again
+    public let recoveryInterval: TimeInterval
+
+    public init(
+        clients: [String] = [],
+        hedgePercentile: Double? = nil,
+        minimumHedgeDelay: TimeInterval = 1,
+        minimumSamples: Int = 20,
+        maxErrorRate: Double = 0.5,
+        smoothing: Double = 0.2,
+        recoveryInterval: TimeInterval = 60
+    ) {
+        self.clients = clients
+        self.hedgePercentile = hedgePercentile.map { min(max($0, 0), 1) }
+        self.minimumHedgeDelay = minimumHedgeDelay
+        self.minimumSamples = minimumSamples
+        self.maxErrorRate = maxErrorRate
+        self.smoothing = min(max(smoothing, 0.01), 1)
+        self.recoveryInterval = max(recoveryInterval, 0.001)
+    }
+
+    /// Pick the fastest healthy client, without hedging
+    public static let fastest = RoutingPolicy()
+
+    /// Pick the fastest healthy client and hedge calls slower than its p95
+    public static let hedged = RoutingPolicy(hedgePercentile: 0.95)
+}
+
+/// Latency and error statistics per client, used for routing
+///
+/// Latencies are tracked as an exponentially weighted moving average plus a
+/// fixed window of recent samples for percentiles; errors as a moving
+/// average of failures (1) and successes (0). Both age while a client isn't
+/// called (see `recoveryInterval`), so a client that was benched for errors
+/// or one slow call is eventually tried again.
+public final class ClientRouter: @unchecked Sendable {
+    /// Observed behaviour of one client
+    public struct Stats: Sendable, Equatable {
+        /// Moving average latency of successful calls, in seconds
+        public var latency: TimeInterval?
+
+        /// Moving average of the failure rate (0...1)
+        public var errorRate: Double = 0
+
+        /// Number of calls recorded
+        public var calls: Int = 0
+
+        /// Most recent latencies, oldest first once the window is full
+        fileprivate var recent: [TimeInterval] = []
+        fileprivate var nextSlot = 0
+
+        /// When the last call was recorded
+        fileprivate var updated: Date?
+    }
+
+    /// Number of recent latencies kept per client for percentiles
+    static let windowSize = 128
+
+    /// Half-life of an idle client's error rate, and how long its latency is
+    /// trusted without a new sample
+    public let recoveryInterval: TimeInterval
+
+    private let lock = NSLock()
+    private var stats: [String: Stats] = [:]
+
+    public init(recoveryInterval: TimeInterval = RoutingPolicy.fastest.recoveryInterval) {
+        self.recoveryInterval = max(recoveryInterval, 0.001)
+    }
+
+    /// Statistics for a client as last recorded
+    public func stats(for name: String) -> Stats {
+        lock.lock()
+        defer { lock.unlock() }
+        return stats[name] ?? Stats()
+    }
+
+    /// Record a successful call and how long it took
+    public func recordSuccess(_ name: String, latency: TimeInterval, smoothing: Double = 0.2, at now: Date = Date()) {
+        lock.lock()
+        defer { lock.unlock() }
+        var entry = current(stats[name] ?? Stats(), at: now)
+        entry.updated = now
+        entry.latency = entry.latency.map { $0 + smoothing * (latency - $0) } ?? latency
+        entry.errorRate -= smoothing * entry.errorRate
+        entry.calls += 1
+        if entry.recent.count < Self.windowSize {
+            entry.recent.append(latency)
+        } else {
+            entry.recent[entry.nextSlot] = latency
+            entry.nextSlot = (entry.nextSlot + 1) % Self.windowSize
+        }
+        stats[name] = entry
+    }
+
+    /// Record a failed call
+    public func recordFailure(_ name: String, smoothing: Double = 0.2, at now: Date = Date()) {
+        lock.lock()
+        defer { lock.unlock() }
+        var entry = current(stats[name] ?? Stats(), at: now)
+        entry.updated = now
+        entry.errorRate += smoothing * (1 - entry.errorRate)
+        entry.calls += 1
+        stats[name] = entry
+    }
+
+    /// Forget everything recorded
+    public func reset() {
+        lock.lock()
+        stats.removeAll()
+        lock.unlock()
+    }
+
+    /// Candidates ordered best first: healthy clients by latency, then the
+    /// rest by error rate
+    ///
+    /// Clients without a recorded latency sort first, so every client gets
+    /// tried before latencies are compared, and tried again once its latency
+    /// is older than `recoveryInterval`.
+    public func rank(_ names: [String], maxErrorRate: Double, at now: Date = Date()) -> [String] {
+        lock.lock()
+        defer { lock.unlock() }
+        let entries = names.map { (name: $0, stats: current(stats[$0] ?? Stats(), at: now)) }
+        let healthy = entries.filter { $0.stats.errorRate <= maxErrorRate }
+        let unhealthy = entries.filter { $0.stats.errorRate > maxErrorRate }
+        return healthy.sorted { ($0.stats.latency ?? 0) < ($1.stats.latency ?? 0) }.map(\.name)
+            + unhealthy.sorted { $0.stats.errorRate < $1.stats.errorRate }.map(\.name)
+    }
+
+    /// `entry` aged to `now`: the error rate halves every `recoveryInterval`
+    /// since the last call, and a latency that old is dropped
+    private func current(_ entry: Stats, at now: Date) -> Stats {
+        guard let updated = entry.updated else { return entry }
+        let elapsed = now.timeIntervalSince(updated)
+        guard elapsed > 0 else { return entry }
+        var entry = entry
+        entry.errorRate *= pow(0.5, elapsed / recoveryInterval)
+        if elapsed >= recoveryInterval {
+            entry.latency = nil
+        }
+        return entry
+    }
+
+    /// How long to wait on a client before hedging, per `policy`
+    ///
+    /// - Returns: nil if the policy doesn't hedge
+    public func hedgeDelay(for name: String, policy: RoutingPolicy) -> TimeInterval? {
+        guard let percentile = policy.hedgePercentile else { return nil }
+        lock.lock()
+        let recent = stats[name]?.recent ?? []
+        lock.unlock()
+
+        guard recent.count >= max(policy.minimumSamples, 1) else {
+            return policy.minimumHedgeDelay
+        }
+        let sorted = recent.sorted()
+        let index = min(Int((Double(sorted.count - 1) * percentile).rounded(.up)), sorted.count - 1)
+        return max(sorted[index], policy.minimumHedgeDelay)
+    }
+}
@@ -0,0 +1,232 @@
+import Foundation
+#if canImport(Darwin)
+import Darwin
+#elseif canImport(Glibc)
+import Glibc
+#endif
+
+/// Append-only on-disk response store that can be shared between processes.
+///
+/// Entries are appended to a single file with one `write` on an `O_APPEND`
+/// descriptor, so several worker processes can add to the same file without
+/// coordinating. Reads go through a memory-mapped view of the file and an
+/// in-memory index of key to offset; when a key isn't found, records appended
+/// since the last scan (by this or any other process) are indexed first.
+///
+/// A record that's only partly written is left for a later scan. One whose
+/// checksum doesn't match, or one cut short by a writer that died mid-write,
+/// is skipped by scanning forward to the next record that verifies. Later
+/// records win for the same key. The file is never compacted; delete it to
+/// reset the cache.
+public final class DiskResponseStore: ResponseCacheStore, @unchecked Sendable {
+    public let url: URL
+
+    private struct Location {
+        let offset: Int
+        let length: Int
+        let storedAt: Date
+    }
+
+    private let lock = NSLock()
+    private let descriptor: Int32
+    private var mapped = Data()
+    private var scannedOffset = 0
+    private var index: [ResponseCacheKey: Location] = [:]
+
+    /// Open (creating if needed) the store at `url`
+    public init(url: URL) throws {
+        self.url = url
+        try FileManager.default.createDirectory(
+            at: url.deletingLastPathComponent(),
+            withIntermediateDirectories: true
+        )
+
+        let fd = open(url.path, O_WRONLY | O_APPEND | O_CREAT, 0o644)
+        guard fd >= 0 else {
+            throw SwamlError.configurationError("Cannot open response cache at \(url.path): errno \(errno)")
+        }
+        self.descriptor = fd
+
+        lock.lock()
+        refresh()
+        lock.unlock()
+    }
+
+    deinit {
+        close(descriptor)
+    }
+
+    /// Number of distinct keys indexed so far
+    public var count: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return index.count
+    }
+
+    public func entry(for key: ResponseCacheKey) -> CachedResponse? {
+        lock.lock()
+        defer { lock.unlock() }
+
+        if index[key] == nil {
+            refresh()
+        }
+        guard let location = index[key] else { return nil }
+
+        let payload = mapped.subdata(in: location.offset..<(location.offset + location.length))
+        guard let record = try? JSONDecoder().decode(Record.self, from: payload) else {
+            return nil
+        }
+        return CachedResponse(response: record.response, storedAt: location.storedAt)
+    }
+
+    public func store(_ entry: CachedResponse, for key: ResponseCacheKey) {
+        guard let payload = try? JSONEncoder().encode(Record(entry.response)) else { return }
+
+        var bytes: [UInt8] = []
+        bytes.reserveCapacity(Self.headerSize + payload.count)
+        Self.append(Self.recordMagic, to: &bytes)
+        Self.append(key.high, to: &bytes)
+        Self.append(key.low, to: &bytes)
+        Self.append(entry.storedAt.timeIntervalSince1970.bitPattern, to: &bytes)
+        Self.append(UInt32(payload.count), to: &bytes)
+        Self.append(Self.checksum(payload), to: &bytes)
+        bytes.append(contentsOf: payload)
+
+        // One write keeps the record contiguous next to other writers
+        bytes.withUnsafeBytes { buffer in
+            var written = 0
+            while written < buffer.count {
+                let result = write(descriptor, buffer.baseAddress! + written, buffer.count - written)
+                if result < 0 {
+                    if errno == EINTR { continue }
+                    return
+                }
+                written += result
+            }
+        }
+    }
+
+    // MARK: - Index
+
+    /// Remap the file and index records appended since the last scan
+    /// (must be called with the lock held)
+    private func refresh() {
+        let attributes = try? FileManager.default.attributesOfItem(atPath: url.path)
+        guard let size = (attributes?[.size] as? NSNumber)?.intValue,
+              size > mapped.count,
+              let data = try? Data(contentsOf: url, options: .alwaysMapped) else {
+            return
+        }
+        mapped = data
+
+        var offset = scannedOffset
+        while offset + Self.headerSize <= data.count {
+            if let record = Self.record(at: offset, in: data) {
+                index[record.key] = record.location
+                offset = record.location.offset + record.location.length
+                continue
+            }
+
+            // Either still being written, or damaged. A record that verifies
+            // further on means this one will never be finished.
+            guard let next = Self.nextRecord(after: offset, in: data) else { break }
+            offset = next
+        }
+        scannedOffset = offset
+    }
+
+    /// The complete, verified record starting at `offset`, which must leave
+    /// room for a header
+    private static func record(at offset: Int, in data: Data) -> (key: ResponseCacheKey, location: Location)? {
+        guard read(UInt32.self, from: data, at: offset) == recordMagic else {
+            return nil
+        }
+        let high = read(UInt64.self, from: data, at: offset + 4)
+        let low = read(UInt64.self, from: data, at: offset + 12)
+        let storedAt = Double(bitPattern: read(UInt64.self, from: data, at: offset + 20))
+        let checksum = read(UInt32.self, from: data, at: offset + 32)
+
+        let start = offset + headerSize
+        guard let length = Int(exactly: read(UInt32.self, from: data, at: offset + 28)),
+              length <= data.count - start,
+              Self.checksum(data[start..<(start + length)]) == checksum else {
+            return nil
+        }
+
+        return (
+            ResponseCacheKey(high: high, low: low),
+            Location(offset: start, length: length, storedAt: Date(timeIntervalSince1970: storedAt))
+        )
+    }
+
+    /// Offset of the first complete, verified record after `offset`
+    private static func nextRecord(after offset: Int, in data: Data) -> Int? {
+        var candidate = offset + 1
+        while candidate + headerSize <= data.count {
+            if record(at: candidate, in: data) != nil {
+                return candidate
+            }
+            candidate += 1
+        }
+        return nil
+    }
+
+    // MARK: - Encoding
+
+    /// `"SRC1"`, marking the start of each record
+    private static let recordMagic: UInt32 = 0x3143_5253
+
+    /// magic, key (2 × 8), storedAt, length, checksum
+    private static let headerSize = 4 + 16 + 8 + 4 + 4
+
+    private static func append<T: FixedWidthInteger>(_ value: T, to bytes: inout [UInt8]) {
+        withUnsafeBytes(of: value.littleEndian) { bytes.append(contentsOf: $0) }
+    }
+
+    private static func read<T: FixedWidthInteger>(_ type: T.Type, from data: Data, at offset: Int) -> T {
+        data.withUnsafeBytes { buffer in
+            T(littleEndian: buffer.loadUnaligned(fromByteOffset: offset, as: T.self))
+        }
+    }
+
+    /// FNV-1a, folded to 32 bits
+    private static func checksum<Bytes: Sequence>(_ bytes: Bytes) -> UInt32 where Bytes.Element == UInt8 {
+        var hash: UInt64 = 0xcbf2_9ce4_8422_2325
+        for byte in bytes {
+            hash = (hash ^ UInt64(byte)) &* 0x0000_0100_0000_01b3
+        }
+        return UInt32(truncatingIfNeeded: hash ^ (hash >> 32))
+    }
+
+    /// Serialized form of a response
+    private struct Record: Codable {
+        let content: String
+        let model: String
+        let usage: LLMResponse.Usage?
+        let finishReason: String?
+        let id: String?
+
+        /// Absent from records written before it was added
+        let schemaConstrained: Bool?
+
+        init(_ response: LLMResponse) {
+            self.content = response.content
+            self.model = response.model
+            self.usage = response.usage
+            self.finishReason = response.finishReason?.rawValue
+            self.id = response.id
+            self.schemaConstrained = response.isSchemaConstrained ? true : nil
+        }
+
+        var response: LLMResponse {
+            LLMResponse(
+                content: content,
+                model: model,
+                usage: usage,
+                finishReason: finishReason.flatMap(LLMResponse.FinishReason.init(rawValue:)),
+                id: id,
+                isSchemaConstrained: schemaConstrained ?? false
+            )
+        }
+    }
+}
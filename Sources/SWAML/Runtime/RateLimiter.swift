@@ -0,0 +1,268 @@
+import Foundation
+#if canImport(FoundationNetworking)
+import FoundationNetworking
+#endif
+
+/// Request and token budgets for a client
+public struct RateLimits: Sendable, Equatable {
+    /// Maximum requests per minute, nil for no limit
+    public var requestsPerMinute: Int?
+
+    /// Maximum tokens (prompt plus completion) per minute, nil for no limit
+    public var tokensPerMinute: Int?
+
+    public init(requestsPerMinute: Int? = nil, tokensPerMinute: Int? = nil) {
+        self.requestsPerMinute = requestsPerMinute
+        self.tokensPerMinute = tokensPerMinute
+    }
+
+    /// No configured limits; the limiter only follows the provider's headers
+    public static let unlimited = RateLimits()
+}
+
+/// Admission control for requests to one client.
+///
+/// Keeps a token bucket each for requests and tokens per minute. Callers
+/// reserve capacity before sending; when a bucket runs dry they're queued and
+/// released in arrival order as it refills, so concurrent tasks are spread out
+/// instead of all hitting the limit and retrying in lockstep.
+///
+/// Buckets start from the configured `RateLimits` and are adjusted from the
+/// provider's response headers (`x-ratelimit-*`, `anthropic-ratelimit-*`),
+/// so limits that aren't configured are learned from the first response.
+/// A `retry-after` header pauses admission until it expires.
+public actor RateLimiter {
+    private var requests: TokenBucket?
+    private var tokens: TokenBucket?
+
+    /// Uptime until which no request is admitted
+    private var pausedUntil: TimeInterval = 0
+
+    private let now: @Sendable () -> TimeInterval
+
+    public init(limits: RateLimits = .unlimited) {
+        self.init(limits: limits, clock: { ProcessInfo.processInfo.systemUptime })
+    }
+
+    init(limits: RateLimits, clock: @escaping @Sendable () -> TimeInterval) {
+        self.now = clock
+        let start = clock()
+        self.requests = limits.requestsPerMinute.map { TokenBucket(perMinute: Double($0), at: start) }
+        self.tokens = limits.tokensPerMinute.map { TokenBucket(perMinute: Double($0), at: start) }
+    }
+
+    /// Limits currently in effect, including those learned from headers
+    public var limits: RateLimits {
+        RateLimits(
+            requestsPerMinute: requests.map { Int($0.capacity) },
+            tokensPerMinute: tokens.map { Int($0.capacity) }
+        )
+    }
+
+    /// Wait until a request of the given size may be sent
+    ///
+    /// - Parameter estimatedTokens: Expected prompt plus completion tokens
+    /// - Throws: `CancellationError` if the task is cancelled while queued;
+    ///   the reservation is returned in that case
+    public func acquire(estimatedTokens: Int = 0) async throws {
+        let delay = reserve(estimatedTokens: estimatedTokens)
+        guard delay > 0 else { return }
+
+        do {
+            try await Task.sleep(nanoseconds: UInt64(delay * 1_000_000_000))
+        } catch {
+            refund(requests: 1, tokens: estimatedTokens)
+            throw error
+        }
+    }
+
+    /// Correct the token bucket once the real usage of a request is known
+    public func settle(estimatedTokens: Int, actualTokens: Int) {
+        guard actualTokens != estimatedTokens else { return }
+        tokens?.available -= Double(actualTokens - estimatedTokens)
+    }
+
+    /// Adjust the buckets from a provider response
+    public func update(from response: HTTPURLResponse) {
+        update(statusCode: response.statusCode) { response.value(forHTTPHeaderField: $0) }
+    }
+
+    // MARK: - Internals
+
+    /// Take capacity for a request and return how long it must wait before sending
+    ///
+    /// Capacity is taken immediately, driving the bucket negative if needed, so
+    /// each queued caller waits for its own share of the refill.
+    func reserve(estimatedTokens: Int) -> TimeInterval {
+        let time = now()
+        var delay = max(0, pausedUntil - time)
+
+        if var bucket = requests {
+            delay = max(delay, bucket.reserve(1, at: time))
+            requests = bucket
+        }
+        if var bucket = tokens, estimatedTokens > 0 {
+            delay = max(delay, bucket.reserve(Double(estimatedTokens), at: time))
+            tokens = bucket
+        }
+        return delay
+    }
+
+    private func refund(requests count: Int, tokens amount: Int) {
+        if var bucket = requests {
+            bucket.available = min(bucket.capacity, bucket.available + Double(count))
+            requests = bucket
+        }
+        if var bucket = tokens {
+            bucket.available = min(bucket.capacity, bucket.available + Double(amount))
+            tokens = bucket
+        }
+    }
+
+    /// Adjust the buckets from response headers
+    ///
+    /// - Parameter header: Case-insensitive header lookup
+    func update(statusCode: Int, header: (String) -> String?) {
+        let time = now()
+
+        for (kind, prefixes) in [
+            (Kind.requests, ["x-ratelimit-%@-requests", "anthropic-ratelimit-requests-%@"]),
+            (Kind.tokens, ["x-ratelimit-%@-tokens", "anthropic-ratelimit-tokens-%@"])
+        ] {
+            for pattern in prefixes {
+                func field(_ part: String) -> String? {
+                    header(pattern.replacingOccurrences(of: "%@", with: part))
+                }
+                guard let limit = field("limit").flatMap(Double.init) else { continue }
+
+                var learned = bucket(for: kind) ?? TokenBucket(perMinute: limit, at: time)
+                learned.refill(at: time)
+                learned.capacity = max(1, limit)
+                if let remaining = field("remaining").flatMap(Double.init) {
+                    // Other processes may share the key, so only ever lower our estimate
+                    learned.available = min(learned.available, remaining)
+                    if remaining < 1, let reset = field("reset").flatMap({ Self.parseReset($0, now: Date()) }) {
+                        pausedUntil = max(pausedUntil, time + reset)
+                    }
+                }
+                learned.available = min(learned.available, learned.capacity)
+                setBucket(learned, for: kind)
+                break
+            }
+        }
+
+        if let retryAfter = Self.parseRetryAfter(header) {
+            pausedUntil = max(pausedUntil, time + retryAfter)
+        } else if statusCode == 429 || statusCode == 529 {
+            // Rejected without guidance: hold off briefly rather than retry immediately
+            pausedUntil = max(pausedUntil, time + 1)
+        }
+    }
+
+    private enum Kind {
+        case requests
+        case tokens
+    }
+
+    private func bucket(for kind: Kind) -> TokenBucket? {
+        kind == .requests ? requests : tokens
+    }
+
+    private func setBucket(_ bucket: TokenBucket, for kind: Kind) {
+        switch kind {
+        case .requests: requests = bucket
+        case .tokens: tokens = bucket
+        }
+    }
+
+    // MARK: - Header Parsing
+
+    /// Parse `retry-after-ms` or `retry-after` (seconds or an HTTP date)
+    static func parseRetryAfter(_ header: (String) -> String?) -> TimeInterval? {
+        if let ms = header("retry-after-ms").flatMap(Double.init) {
+            return max(0, ms / 1000)
+        }
+        guard let value = header("retry-after")?.trimmingCharacters(in: .whitespaces) else {
+            return nil
+        }
+        if let seconds = Double(value) {
+            return max(0, seconds)
+        }
+
+        let formatter = DateFormatter()
+        formatter.locale = Locale(identifier: "en_US_POSIX")
+        formatter.timeZone = TimeZone(identifier: "GMT")
+        formatter.dateFormat = "EEE, dd MMM yyyy HH:mm:ss zzz"
+        return formatter.date(from: value).map { max(0, $0.timeIntervalSinceNow) }
+    }
+
+    /// Parse a reset header: an OpenAI duration (`"1s"`, `"6m0s"`, `"20ms"`)
+    /// or an Anthropic RFC 3339 timestamp
+    static func parseReset(_ value: String, now: Date) -> TimeInterval? {
+        if let duration = parseDuration(value) {
+            return duration
+        }
+
+        let formatter = ISO8601DateFormatter()
+        formatter.formatOptions = [.withInternetDateTime, .withFractionalSeconds]
+        if let date = formatter.date(from: value) {
+            return max(0, date.timeIntervalSince(now))
+        }
+        formatter.formatOptions = [.withInternetDateTime]
+        return formatter.date(from: value).map { max(0, $0.timeIntervalSince(now)) }
+    }
+
+    /// Parse a Go-style duration such as `"1h2m3.5s"` or `"250ms"`
+    static func parseDuration(_ value: String) -> TimeInterval? {
+        let units: [(suffix: String, seconds: Double)] = [("ms", 0.001), ("h", 3600), ("m", 60), ("s", 1)]
+        var rest = Substring(value.trimmingCharacters(in: .whitespaces))
+        guard !rest.isEmpty else { return nil }
+
+        var total: TimeInterval = 0
+        while !rest.isEmpty {
+            let number = rest.prefix { $0.isNumber || $0 == "." }
+            guard let amount = Double(number) else { return nil }
+            rest = rest.dropFirst(number.count)
+
+            guard let unit = units.first(where: { rest.hasPrefix($0.suffix) }) else { return nil }
+            total += amount * unit.seconds
+            rest = rest.dropFirst(unit.suffix.count)
+        }
+        return total
+    }
+}
+
+// MARK: - Token Bucket
+
+/// A bucket refilled continuously at `capacity` per minute
+struct TokenBucket: Sendable {
+    var capacity: Double
+    var available: Double
+    private var updatedAt: TimeInterval
+
+    init(perMinute capacity: Double, at time: TimeInterval) {
+        self.capacity = max(1, capacity)
+        self.available = self.capacity
+        self.updatedAt = time
+    }
+
+    private var refillPerSecond: Double {
+        capacity / 60
+    }
+
+    mutating func refill(at time: TimeInterval) {
+        guard time > updatedAt else { return }
+        available = min(capacity, available + (time - updatedAt) * refillPerSecond)
+        updatedAt = time
+    }
+
+    /// Take `amount` and return the wait until the bucket is back to zero
+    ///
+    /// Requests larger than the whole bucket are clamped to it so they can
+    /// still get through once it's full.
+    mutating func reserve(_ amount: Double, at time: TimeInterval) -> TimeInterval {
+        refill(at: time)
+        available -= min(amount, capacity)
+        return available < 0 ? -available / refillPerSecond : 0
+    }
+}
@@ -0,0 +1,134 @@
+import Foundation
+
+/// Shares one in-flight operation between concurrent callers with the same key.
+///
+/// The first caller for a key starts the operation; callers arriving while it
+/// runs wait for the same result instead of starting their own. Cancellation
+/// is reference-counted: a cancelled caller stops waiting (with
+/// `CancellationError`) without affecting the others, and the operation itself
+/// is only cancelled once every waiter has gone. Keys are released as soon as
+/// the operation finishes, so this deduplicates concurrent work only; caching
+/// finished results is `ResponseCache`'s job.
+actor RequestCoalescer<Key: Hashable & Sendable> {
+    /// Results are handed between tasks type-erased; `FlightKey` includes the
+    /// result type, so the cast back in `run` always succeeds.
+    private struct SharedValue: @unchecked Sendable {
+        let value: Any
+    }
+
+    private struct FlightKey: Hashable {
+        let key: Key
+        let type: ObjectIdentifier
+    }
+
+    /// Only touched on the actor
+    private final class Flight: @unchecked Sendable {
+        var task: Task<Void, Never>?
+        var waiters: [Int: CheckedContinuation<SharedValue, Error>] = [:]
+        var nextWaiter = 0
+    }
+
+    private var flights: [FlightKey: Flight] = [:]
+
+    /// Number of operations currently running
+    var inFlightCount: Int {
+        flights.count
+    }
+
+    /// Number of callers waiting on running operations
+    var waiterCount: Int {
+        flights.values.reduce(0) { $0 + $1.waiters.count }
+    }
+
+    /// Run `operation`, or join the run already in progress for `key`
+    func run<Value>(
+        _ key: Key,
+        operation: @escaping @Sendable () async throws -> Value
+    ) async throws -> Value {
+        let flightKey = FlightKey(key: key, type: ObjectIdentifier(Value.self))
+        let flight = flights[flightKey] ?? start(flightKey, operation: operation)
+
+        let waiter = flight.nextWaiter
+        flight.nextWaiter += 1
+
+        let shared = try await withTaskCancellationHandler {
+            try await withCheckedThrowingContinuation { continuation in
+                flight.waiters[waiter] = continuation
+            }
+        } onCancel: {
+            Task { await self.leave(waiter, of: flight, key: flightKey) }
+        }
+        return shared.value as! Value
+    }
+
+    private func start<Value>(
+        _ key: FlightKey,
+        operation: @escaping @Sendable () async throws -> Value
+    ) -> Flight {
+        let flight = Flight()
+        flights[key] = flight
+
+        flight.task = Task {
+            let result: Result<SharedValue, Error>
+            do {
+                result = .success(SharedValue(value: try await operation()))
+            } catch {
+                result = .failure(error)
+            }
+            await self.finish(flight, key: key, with: result)
+        }
+        return flight
+    }
+
+    private func finish(_ flight: Flight, key: FlightKey, with result: Result<SharedValue, Error>) {
+        if flights[key] === flight {
+            flights[key] = nil
+        }
+
+        let waiters = flight.waiters
+        flight.waiters.removeAll()
+        for continuation in waiters.values {
+            continuation.resume(with: result)
+        }
+    }
+
+    /// A waiter was cancelled; cancel the operation if it was the last one
+    private func leave(_ waiter: Int, of flight: Flight, key: FlightKey) {
+        guard let continuation = flight.waiters.removeValue(forKey: waiter) else { return }
+        continuation.resume(throwing: CancellationError())
+
+        if flight.waiters.isEmpty {
+            flight.task?.cancel()
+            if flights[key] === flight {
+                flights[key] = nil
+            }
+        }
+    }
+}
+
+// MARK: - Coalescing Key
+
+/// What concurrent calls must have in common to share one request and its result
+///
+/// The request alone isn't enough: calls that allow a different number of
+/// continuations, or parse the response differently, would get back a
+/// result (truncated or stitched), or an error, they didn't ask for.
+struct CoalescingKey: Hashable, Sendable {
+    /// How a call turns the response into its result
+    enum Parsing: Hashable, Sendable {
+        /// The output type's usual parse
+        case standard
+
+        /// Parsed with local repair, failing with the unrepaired output so it
+        /// can be sent back for repair (`SwamlClient.callWithRepair`)
+        case repairing
+    }
+
+    /// `LLMClient.cacheKey` of the request
+    let request: ResponseCacheKey
+
+    /// Continuations allowed for a response cut off by the token limit
+    let maxContinuations: Int
+
+    var parsing: Parsing = .standard
+}
@@ -0,0 +1,286 @@
+import Foundation
+
+// MARK: - Key
+
+/// Stable 128-bit hash of a normalized request
+///
+/// Computed from the same bytes that would be sent (see `LLMClient.cacheKey`),
+/// so it's identical across processes and runs. The bits are the first half
+/// of a SHA-256 digest, so two different requests won't share a key by
+/// accident or by construction.
+public struct ResponseCacheKey: Hashable, Sendable, CustomStringConvertible {
+    public let high: UInt64
+    public let low: UInt64
+
+    public init(high: UInt64, low: UInt64) {
+        self.high = high
+        self.low = low
+    }
+
+    /// Hash a byte sequence
+    init<Bytes: Sequence>(hashing bytes: Bytes) where Bytes.Element == UInt8 {
+        let digest = SHA256.hash(bytes)
+        self.high = digest[0..<8].reduce(0) { $0 << 8 | UInt64($1) }
+        self.low = digest[8..<16].reduce(0) { $0 << 8 | UInt64($1) }
+    }
+
+    public var description: String {
+        String(format: "%016llx%016llx", high, low)
+    }
+}
+
+// MARK: - Policy
+
+/// How a call uses the response cache
+public struct ResponseCachePolicy: Sendable, Equatable {
+    public enum Mode: Sendable, Equatable {
+        /// Serve hits and store new responses
+        case readWrite
+
+        /// Serve hits but don't store new responses
+        case readOnly
+
+        /// Skip the cache entirely
+        case bypass
+    }
+
+    public let mode: Mode
+
+    /// Maximum age of a hit (in seconds); nil accepts entries of any age
+    public let ttl: TimeInterval?
+
+    public init(mode: Mode = .readWrite, ttl: TimeInterval? = nil) {
+        self.mode = mode
+        self.ttl = ttl
+    }
+
+    /// Read and write, entries never expire
+    public static let `default` = ResponseCachePolicy()
+
+    /// Serve hits without storing
+    public static let readOnly = ResponseCachePolicy(mode: .readOnly)
+
+    /// Always call the provider
+    public static let bypass = ResponseCachePolicy(mode: .bypass)
+
+    /// Read and write, accepting hits up to `seconds` old
+    public static func ttl(_ seconds: TimeInterval) -> ResponseCachePolicy {
+        ResponseCachePolicy(mode: .readWrite, ttl: seconds)
+    }
+}
+
+// MARK: - Stores
+
+/// A cached response and when it was stored
+public struct CachedResponse: Sendable {
+    public let response: LLMResponse
+    public let storedAt: Date
+
+    public init(response: LLMResponse, storedAt: Date = Date()) {
+        self.response = response
+        self.storedAt = storedAt
+    }
+
+    /// Approximate memory footprint, used for byte budgets
+    var cost: Int {
+        response.content.utf8.count + response.model.utf8.count + (response.id?.utf8.count ?? 0) + 96
+    }
+}
+
+/// Backend of a `ResponseCache`
+///
+/// Implementations must be safe to call from any thread.
+public protocol ResponseCacheStore: AnyObject, Sendable {
+    /// The entry for a key, if present
+    func entry(for key: ResponseCacheKey) -> CachedResponse?
+
+    /// Store an entry, replacing any previous one
+    func store(_ entry: CachedResponse, for key: ResponseCacheKey)
+}
+
+/// In-memory LRU store bounded by the total size of its entries
+public final class MemoryResponseStore: ResponseCacheStore, @unchecked Sendable {
+    /// Maximum total cost of the stored entries (in bytes)
+    public let byteBudget: Int
+
+    private final class Node {
+        let key: ResponseCacheKey
+        var entry: CachedResponse
+        var newer: Node?
+        weak var older: Node?
+
+        init(key: ResponseCacheKey, entry: CachedResponse) {
+            self.key = key
+            self.entry = entry
+        }
+    }
+
+    private let lock = NSLock()
+    private var nodes: [ResponseCacheKey: Node] = [:]
+    private var newest: Node?
+    private var oldest: Node?
+    private var totalCost = 0
+
+    public init(byteBudget: Int = 64 * 1024 * 1024) {
+        self.byteBudget = byteBudget
+    }
+
+    /// Number of stored entries
+    public var count: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return nodes.count
+    }
+
+    /// Total cost of the stored entries (in bytes)
+    public var byteCount: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return totalCost
+    }
+
+    public func entry(for key: ResponseCacheKey) -> CachedResponse? {
+        lock.lock()
+        defer { lock.unlock() }
+
+        guard let node = nodes[key] else { return nil }
+        moveToFront(node)
+        return node.entry
+    }
+
+    public func store(_ entry: CachedResponse, for key: ResponseCacheKey) {
+        let cost = entry.cost
+        guard cost <= byteBudget else { return }
+
+        lock.lock()
+        defer { lock.unlock() }
+
+        if let node = nodes[key] {
+            totalCost += cost - node.entry.cost
+            node.entry = entry
+            moveToFront(node)
+        } else {
+            let node = Node(key: key, entry: entry)
+            nodes[key] = node
+            totalCost += cost
+            insertAtFront(node)
+        }
+
+        while totalCost > byteBudget, let victim = oldest {
+            unlink(victim)
+            nodes[victim.key] = nil
+            totalCost -= victim.entry.cost
+        }
+    }
+
+    deinit {
+        breakChain()
+    }
+
+    /// Remove all entries
+    public func removeAll() {
+        lock.lock()
+        defer { lock.unlock() }
+        breakChain()
+        nodes.removeAll()
+        newest = nil
+        oldest = nil
+        totalCost = 0
+    }
+
+    // MARK: List (lock held)
+
+    /// Unlink the strong `newer` references one by one, so releasing a long
+    /// list doesn't recurse through every node
+    private func breakChain() {
+        var node = oldest
+        while let current = node {
+            node = current.newer
+            current.newer = nil
+        }
+    }
+
+    private func insertAtFront(_ node: Node) {
+        node.older = newest
+        node.newer = nil
+        newest?.newer = node
+        newest = node
+        if oldest == nil {
+            oldest = node
+        }
+    }
+
+    private func unlink(_ node: Node) {
+        if let older = node.older {
+            older.newer = node.newer
+        } else {
+            oldest = node.newer
+        }
+        if let newer = node.newer {
+            newer.older = node.older
+        } else {
+            newest = node.older
+        }
+        node.newer = nil
+        node.older = nil
+    }
+
+    private func moveToFront(_ node: Node) {
+        guard newest !== node else { return }
+        unlink(node)
+        insertAtFront(node)
+    }
+}
+
+// MARK: - Cache
+
+/// Exact-match cache of LLM responses.
+///
+/// Looks up responses by the hash of the normalized request, so a repeated
+/// call (same provider, model, messages, parameters and schema) is answered
+/// without a round-trip. Stores are consulted in order; a hit in a later one
+/// (e.g. the shared disk store) is copied into the earlier ones.
+///
+/// Attach one to `SwamlRuntime` and control it per call with
+/// `RuntimeContext.cachePolicy`.
+public final class ResponseCache: Sendable {
+    public let stores: [any ResponseCacheStore]
+
+    public init(stores: [any ResponseCacheStore]) {
+        self.stores = stores
+    }
+
+    /// In-memory LRU, optionally backed by a disk store
+    public convenience init(memoryBudget: Int = 64 * 1024 * 1024, disk: DiskResponseStore? = nil) {
+        var stores: [any ResponseCacheStore] = [MemoryResponseStore(byteBudget: memoryBudget)]
+        if let disk = disk {
+            stores.append(disk)
+        }
+        self.init(stores: stores)
+    }
+
+    /// Get a cached response
+    ///
+    /// - Parameter maxAge: Ignore entries older than this (in seconds)
+    public func response(for key: ResponseCacheKey, maxAge: TimeInterval? = nil) -> LLMResponse? {
+        for (index, store) in stores.enumerated() {
+            guard let entry = store.entry(for: key) else { continue }
+            if let maxAge = maxAge, Date().timeIntervalSince(entry.storedAt) > maxAge {
+                continue
+            }
+            for earlier in stores[..<index] {
+                earlier.store(entry, for: key)
+            }
+            return entry.response
+        }
+        return nil
+    }
+
+    /// Store a response in every store
+    public func store(_ response: LLMResponse, for key: ResponseCacheKey) {
+        let entry = CachedResponse(response: response)
+        for store in stores {
+            store.store(entry, for: key)
+        }
+    }
+}
@@ -51,14 +51,17 @@ public struct RetryPolicy: Sendable {
     }
 
     /// Check if an error should be retried
+    ///
+    /// Network errors, retryable status codes and streams aborted for
+    /// violating their schema are retried.
     public func shouldRetry(error: Error, attempt: Int) -> Bool {
-        guard attempt < maxRetries else { return false }
+        guard attempt < maxRetries, !isCancellation(error) else { return false }
 
         if let swamlError = error as? SwamlError {
             switch swamlError {
             case .apiError(let statusCode, _):
                 return retryableStatusCodes.contains(statusCode)
-            case .networkError:
+            case .networkError, .streamAborted:
                 return true
             default:
                 return false
@@ -89,10 +92,23 @@ public struct RetryPolicy: Sendable {
     )
 }
 
+/// Whether an error only reports that the call was cancelled
+///
+/// True for `CancellationError`, for a URL request cancelled along with its
+/// task (which surfaces as `NSURLErrorCancelled` rather than
+/// `CancellationError`), and for any error once the current task is cancelled.
+func isCancellation(_ error: Error) -> Bool {
+    if error is CancellationError || Task.isCancelled {
+        return true
+    }
+    let nsError = error as NSError
+    return nsError.domain == NSURLErrorDomain && nsError.code == NSURLErrorCancelled
+}
+
 // MARK: - Retry Executor
 
 /// Executes operations with retry logic
-public struct RetryExecutor {
+public struct RetryExecutor: Sendable {
     public let policy: RetryPolicy
 
     public init(policy: RetryPolicy = .standard) {
@@ -102,12 +118,23 @@ public struct RetryExecutor {
     /// Execute an async operation with retries
     public func execute<T>(
         operation: @Sendable () async throws -> T
+    ) async throws -> T {
+        try await execute { (_: Int) in try await operation() }
+    }
+
+    /// Execute an async operation with retries, passing it the attempt
+    /// number (0 for the first try)
+    ///
+    /// An aborted stream (`SwamlError.streamAborted`) is retried without a
+    /// backoff delay: the output was bad, not the service.
+    public func execute<T>(
+        operation: @Sendable (_ attempt: Int) async throws -> T
     ) async throws -> T {
         var lastError: Error?
 
         for attempt in 0...policy.maxRetries {
             do {
-                return try await operation()
+                return try await operation(attempt)
             } catch {
                 lastError = error
 
@@ -116,6 +143,10 @@ public struct RetryExecutor {
                 }
 
                 if attempt < policy.maxRetries {
+                    CallTrace.record { $0.retries += 1 }
+                    if case SwamlError.streamAborted = error {
+                        continue
+                    }
                     let delay = policy.delayForAttempt(attempt)
                     try await Task.sleep(nanoseconds: UInt64(delay * 1_000_000_000))
                 }
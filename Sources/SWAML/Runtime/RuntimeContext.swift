@@ -23,6 +23,13 @@ public struct RuntimeContext: Sendable {
     /// Timeout for the request (in seconds)
     public let timeout: TimeInterval?
 
+    /// How the call uses the runtime's response cache, if it has one
+    public let cachePolicy: ResponseCachePolicy
+
+    /// How many times a response cut off by the token limit is continued
+    /// before parsing (0 to parse it as it is)
+    public let maxContinuations: Int
+
     public init(
         tags: [String: String] = [:],
         clientName: String? = nil,
@@ -30,7 +37,9 @@ public struct RuntimeContext: Sendable {
         maxTokens: Int? = nil,
         responseFormat: ResponseFormat? = nil,
         customHeaders: [String: String] = [:],
-        timeout: TimeInterval? = nil
+        timeout: TimeInterval? = nil,
+        cachePolicy: ResponseCachePolicy = .default,
+        maxContinuations: Int = 0
     ) {
         self.tags = tags
         self.clientName = clientName
@@ -39,6 +48,8 @@ public struct RuntimeContext: Sendable {
         self.responseFormat = responseFormat
         self.customHeaders = customHeaders
         self.timeout = timeout
+        self.cachePolicy = cachePolicy
+        self.maxContinuations = max(maxContinuations, 0)
     }
 
     /// Create a child context with merged settings
@@ -48,7 +59,10 @@ public struct RuntimeContext: Sendable {
         temperature: Double? = nil,
         maxTokens: Int? = nil,
         responseFormat: ResponseFormat? = nil,
-        customHeaders: [String: String] = [:]
+        customHeaders: [String: String] = [:],
+        timeout: TimeInterval? = nil,
+        cachePolicy: ResponseCachePolicy? = nil,
+        maxContinuations: Int? = nil
     ) -> RuntimeContext {
         RuntimeContext(
             tags: self.tags.merging(tags) { _, new in new },
@@ -57,7 +71,9 @@ public struct RuntimeContext: Sendable {
             maxTokens: maxTokens ?? self.maxTokens,
             responseFormat: responseFormat ?? self.responseFormat,
             customHeaders: self.customHeaders.merging(customHeaders) { _, new in new },
-            timeout: self.timeout
+            timeout: timeout ?? self.timeout,
+            cachePolicy: cachePolicy ?? self.cachePolicy,
+            maxContinuations: maxContinuations ?? self.maxContinuations
         )
     }
 
@@ -76,6 +92,8 @@ public class RuntimeContextBuilder {
     private var responseFormat: ResponseFormat?
     private var customHeaders: [String: String] = [:]
     private var timeout: TimeInterval?
+    private var cachePolicy: ResponseCachePolicy = .default
+    private var maxContinuations = 0
 
     public init() {}
 
@@ -127,6 +145,18 @@ public class RuntimeContextBuilder {
         return self
     }
 
+    @discardableResult
+    public func cache(_ policy: ResponseCachePolicy) -> RuntimeContextBuilder {
+        cachePolicy = policy
+        return self
+    }
+
+    @discardableResult
+    public func continuations(_ max: Int) -> RuntimeContextBuilder {
+        maxContinuations = max
+        return self
+    }
+
     public func build() -> RuntimeContext {
         RuntimeContext(
             tags: tags,
@@ -135,7 +165,9 @@ public class RuntimeContextBuilder {
             maxTokens: maxTokens,
             responseFormat: responseFormat,
             customHeaders: customHeaders,
-            timeout: timeout
+            timeout: timeout,
+            cachePolicy: cachePolicy,
+            maxContinuations: maxContinuations
         )
     }
 }
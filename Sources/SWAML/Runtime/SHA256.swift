@@ -0,0 +1,161 @@
+import Foundation
+
+/// SHA-256 (FIPS 180-4), used for cache keys
+///
+/// Implemented here rather than taken from CryptoKit so the package keeps
+/// building on Linux without swift-crypto.
+struct SHA256 {
+    private var state = State()
+    private var block: [UInt8] = []
+    private var length: UInt64 = 0
+
+    init() {
+        block.reserveCapacity(64)
+    }
+
+    /// Digest of a byte sequence
+    static func hash<Bytes: Sequence>(_ bytes: Bytes) -> [UInt8] where Bytes.Element == UInt8 {
+        var hasher = SHA256()
+        hasher.update(bytes)
+        return hasher.finalize()
+    }
+
+    mutating func update<Bytes: Sequence>(_ bytes: Bytes) where Bytes.Element == UInt8 {
+        let handled: Void? = bytes.withContiguousStorageIfAvailable { buffer in
+            update(buffer)
+        }
+        guard handled == nil else { return }
+        for byte in bytes {
+            append(byte)
+        }
+    }
+
+    /// The 32-byte digest
+    mutating func finalize() -> [UInt8] {
+        let bitLength = length &* 8
+        append(0x80)
+        while block.count != 56 {
+            append(0)
+        }
+        for shift in stride(from: 56, through: 0, by: -8) {
+            append(UInt8(truncatingIfNeeded: bitLength >> UInt64(shift)))
+        }
+
+        var digest: [UInt8] = []
+        digest.reserveCapacity(32)
+        for word in state.words {
+            digest.append(UInt8(truncatingIfNeeded: word >> 24))
+            digest.append(UInt8(truncatingIfNeeded: word >> 16))
+            digest.append(UInt8(truncatingIfNeeded: word >> 8))
+            digest.append(UInt8(truncatingIfNeeded: word))
+        }
+        return digest
+    }
+
+    // MARK: - Blocks
+
+    private mutating func update(_ buffer: UnsafeBufferPointer<UInt8>) {
+        var index = 0
+        // Top up a partial block, then compress whole blocks straight from the buffer
+        while !block.isEmpty, index < buffer.count {
+            append(buffer[index])
+            index += 1
+        }
+        while buffer.count - index >= 64 {
+            state.compress(UnsafeBufferPointer(rebasing: buffer[index..<(index + 64)]))
+            length &+= 64
+            index += 64
+        }
+        while index < buffer.count {
+            append(buffer[index])
+            index += 1
+        }
+    }
+
+    private mutating func append(_ byte: UInt8) {
+        block.append(byte)
+        length &+= 1
+        if block.count == 64 {
+            state.compress(block)
+            block.removeAll(keepingCapacity: true)
+        }
+    }
+
+    /// The eight hash words, kept as scalars so compressing a block
+    /// allocates nothing and indexes no arrays
+    private struct State {
+        var h0: UInt32 = 0x6a09_e667, h1: UInt32 = 0xbb67_ae85
+        var h2: UInt32 = 0x3c6e_f372, h3: UInt32 = 0xa54f_f53a
+        var h4: UInt32 = 0x510e_527f, h5: UInt32 = 0x9b05_688c
+        var h6: UInt32 = 0x1f83_d9ab, h7: UInt32 = 0x5be0_cd19
+
+        var words: [UInt32] {
+            [h0, h1, h2, h3, h4, h5, h6, h7]
+        }
+
+        mutating func compress(_ chunk: [UInt8]) {
+            chunk.withUnsafeBufferPointer { compress($0) }
+        }
+
+        mutating func compress(_ chunk: UnsafeBufferPointer<UInt8>) {
+            var a = h0, b = h1, c = h2, d = h3
+            var e = h4, f = h5, g = h6, h = h7
+
+            // The message schedule lives on the stack for the one block
+            withUnsafeTemporaryAllocation(of: UInt32.self, capacity: 64) { w in
+                for i in 0..<16 {
+                    w[i] = UInt32(chunk[i * 4]) << 24
+                        | UInt32(chunk[i * 4 + 1]) << 16
+                        | UInt32(chunk[i * 4 + 2]) << 8
+                        | UInt32(chunk[i * 4 + 3])
+                }
+                for i in 16..<64 {
+                    let s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3)
+                    let s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10)
+                    w[i] = w[i - 16] &+ s0 &+ w[i - 7] &+ s1
+                }
+
+                for i in 0..<64 {
+                    let s1 = rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)
+                    let choice = (e & f) ^ (~e & g)
+                    let t1 = h &+ s1 &+ choice &+ SHA256.k[i] &+ w[i]
+                    let s0 = rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)
+                    let majority = (a & b) ^ (a & c) ^ (b & c)
+                    let t2 = s0 &+ majority
+                    h = g
+                    g = f
+                    f = e
+                    e = d &+ t1
+                    d = c
+                    c = b
+                    b = a
+                    a = t1 &+ t2
+                }
+            }
+
+            h0 &+= a
+            h1 &+= b
+            h2 &+= c
+            h3 &+= d
+            h4 &+= e
+            h5 &+= f
+            h6 &+= g
+            h7 &+= h
+        }
+
+        private func rotate(_ value: UInt32, _ count: UInt32) -> UInt32 {
+            (value >> count) | (value << (32 - count))
+        }
+    }
+
+    private static let k: [UInt32] = [
+        0x428a_2f98, 0x7137_4491, 0xb5c0_fbcf, 0xe9b5_dba5, 0x3956_c25b, 0x59f1_11f1, 0x923f_82a4, 0xab1c_5ed5,
+        0xd807_aa98, 0x1283_5b01, 0x2431_85be, 0x550c_7dc3, 0x72be_5d74, 0x80de_b1fe, 0x9bdc_06a7, 0xc19b_f174,
+        0xe49b_69c1, 0xefbe_4786, 0x0fc1_9dc6, 0x240c_a1cc, 0x2de9_2c6f, 0x4a74_84aa, 0x5cb0_a9dc, 0x76f9_88da,
+        0x983e_5152, 0xa831_c66d, 0xb003_27c8, 0xbf59_7fc7, 0xc6e0_0bf3, 0xd5a7_9147, 0x06ca_6351, 0x1429_2967,
+        0x27b7_0a85, 0x2e1b_2138, 0x4d2c_6dfc, 0x5338_0d13, 0x650a_7354, 0x766a_0abb, 0x81c2_c92e, 0x9272_2c85,
+        0xa2bf_e8a1, 0xa81a_664b, 0xc24b_8b70, 0xc76c_51a3, 0xd192_e819, 0xd699_0624, 0xf40e_3585, 0x106a_a070,
+        0x19a4_c116, 0x1e37_6c08, 0x2748_774c, 0x34b0_bcb5, 0x391c_0cb3, 0x4ed8_aa4a, 0x5b9c_ca4f, 0x682e_6ff3,
+        0x748f_82ee, 0x78a5_636f, 0x84c8_7814, 0x8cc7_0208, 0x90be_fffa, 0xa450_6ceb, 0xbef9_a3f7, 0xc671_78f2,
+    ]
+}
@@ -5,12 +5,39 @@ public actor SwamlRuntime {
     public let clientRegistry: ClientRegistry
     public let defaultRetryPolicy: RetryPolicy
 
+    /// Cache consulted before calling the provider, per `RuntimeContext.cachePolicy`
+    public let responseCache: ResponseCache?
+
+    /// Whether concurrent identical calls share one upstream request.
+    /// Calls with a `.bypass` cache policy are never shared.
+    public let coalescesRequests: Bool
+
+    /// How calls that don't name a client pick one, or nil to use the default
+    public let routing: RoutingPolicy?
+
+    /// Latency and error statistics of the clients called through this runtime
+    public let router: ClientRouter
+
+    /// Receives the metrics of each call, tagged with `RuntimeContext.tags`
+    public let metricsObserver: (any CallMetricsObserver)?
+
+    private let coalescer = RequestCoalescer<CoalescingKey>()
+
     public init(
         clientRegistry: ClientRegistry,
-        defaultRetryPolicy: RetryPolicy = .standard
+        defaultRetryPolicy: RetryPolicy = .standard,
+        responseCache: ResponseCache? = nil,
+        coalescesRequests: Bool = true,
+        routing: RoutingPolicy? = nil,
+        metricsObserver: (any CallMetricsObserver)? = nil
     ) {
         self.clientRegistry = clientRegistry
         self.defaultRetryPolicy = defaultRetryPolicy
+        self.responseCache = responseCache
+        self.coalescesRequests = coalescesRequests
+        self.routing = routing
+        self.router = ClientRouter(recoveryInterval: routing?.recoveryInterval ?? RoutingPolicy.fastest.recoveryInterval)
+        self.metricsObserver = metricsObserver
     }
 
     /// Call a SWAML function with the given arguments
@@ -22,59 +49,38 @@ public actor SwamlRuntime {
         typeBuilder: TypeBuilder? = nil,
         ctx: RuntimeContext = .default
     ) async throws -> SwamlValue {
-        // Get the client configuration
-        let clientConfig: ClientConfig
-        if let clientName = ctx.clientName {
-            guard let config = await clientRegistry.getConfig(clientName) else {
-                throw SwamlError.clientNotFound(clientName)
+        try await CallTrace.run(name, tags: ctx.tags, observer: metricsObserver) {
+            // Pick the client (and the hedge client, if any)
+            let route = try await resolveRoute(clientName: ctx.clientName)
+
+            // Build messages
+            let messages = [ChatMessage.user(prompt)]
+
+            // Merge TypeBuilder schemas with output schema
+            let (plan, responseFormat, encodedSchema) = CallTrace.measure(.schema) {
+                resolveOutputFormat(
+                    name,
+                    outputSchema: outputSchema,
+                    typeBuilder: typeBuilder,
+                    ctx: ctx
+                )
             }
-            clientConfig = config
-        } else {
-            guard let config = await clientRegistry.getDefaultConfig() else {
-                throw SwamlError.configurationError("No default client configured")
-            }
-            clientConfig = config
-        }
-
-        // Get the LLM client
-        let client = try await clientRegistry.getClient(clientConfig.name)
-
-        // Build messages
-        let messages = [ChatMessage.user(prompt)]
-
-        // Merge TypeBuilder schemas with output schema
-        let finalSchema = mergeSchemaWithTypeBuilder(outputSchema, typeBuilder: typeBuilder)
-
-        // Determine response format - always use JSON when we have a schema or typed output
-        let responseFormat: ResponseFormat?
-        if let schema = finalSchema {
-            responseFormat = .jsonSchema(
-                name: name,
-                schema: schema.toDictionary(),
-                strict: true
-            )
-        } else if ctx.responseFormat != nil {
-            responseFormat = ctx.responseFormat
-        } else {
-            // Default to JSON object format for typed outputs
-            responseFormat = .jsonObject
-        }
-
-        // Execute with retry
-        let retryExecutor = RetryExecutor(policy: clientConfig.retryPolicy)
 
-        let response = try await retryExecutor.execute {
-            try await client.complete(
-                model: clientConfig.model,
+            // Execute (or answer from the cache) and parse the response
+            return try await execute(
+                route: route,
                 messages: messages,
                 responseFormat: responseFormat,
-                temperature: ctx.temperature ?? clientConfig.defaultTemperature,
-                maxTokens: ctx.maxTokens ?? clientConfig.defaultMaxTokens
-            )
+                encodedSchema: encodedSchema,
+                temperature: ctx.temperature,
+                maxTokens: ctx.maxTokens,
+                timeout: ctx.timeout,
+                cachePolicy: ctx.cachePolicy,
+                maxContinuations: ctx.maxContinuations
+            ) { response in
+                try OutputParser.parseToValue(response, plan: plan)
+            }
         }
-
-        // Parse the response
-        return try OutputParser.parseToValue(response.content, schema: finalSchema)
     }
 
     /// Call a function with typed output
@@ -87,59 +93,38 @@ public actor SwamlRuntime {
         typeBuilder: TypeBuilder? = nil,
         ctx: RuntimeContext = .default
     ) async throws -> T {
-        // Get the client configuration
-        let clientConfig: ClientConfig
-        if let clientName = ctx.clientName {
-            guard let config = await clientRegistry.getConfig(clientName) else {
-                throw SwamlError.clientNotFound(clientName)
-            }
-            clientConfig = config
-        } else {
-            guard let config = await clientRegistry.getDefaultConfig() else {
-                throw SwamlError.configurationError("No default client configured")
+        try await CallTrace.run(name, tags: ctx.tags, observer: metricsObserver) {
+            // Pick the client (and the hedge client, if any)
+            let route = try await resolveRoute(clientName: ctx.clientName)
+
+            // Build messages
+            let messages = [ChatMessage.user(prompt)]
+
+            // Merge TypeBuilder schemas with output schema
+            let (plan, responseFormat, encodedSchema) = CallTrace.measure(.schema) {
+                resolveOutputFormat(
+                    name,
+                    outputSchema: outputSchema,
+                    typeBuilder: typeBuilder,
+                    ctx: ctx
+                )
             }
-            clientConfig = config
-        }
-
-        // Get the LLM client
-        let client = try await clientRegistry.getClient(clientConfig.name)
-
-        // Build messages
-        let messages = [ChatMessage.user(prompt)]
-
-        // Merge TypeBuilder schemas with output schema
-        let finalSchema = mergeSchemaWithTypeBuilder(outputSchema, typeBuilder: typeBuilder)
-
-        // Determine response format - always use JSON when we have a schema or typed output
-        let responseFormat: ResponseFormat?
-        if let schema = finalSchema {
-            responseFormat = .jsonSchema(
-                name: name,
-                schema: schema.toDictionary(),
-                strict: true
-            )
-        } else if ctx.responseFormat != nil {
-            responseFormat = ctx.responseFormat
-        } else {
-            // Default to JSON object format for typed outputs
-            responseFormat = .jsonObject
-        }
-
-        // Execute with retry
-        let retryExecutor = RetryExecutor(policy: clientConfig.retryPolicy)
 
-        let response = try await retryExecutor.execute {
-            try await client.complete(
-                model: clientConfig.model,
+            // Execute (or answer from the cache) and parse the response
+            return try await execute(
+                route: route,
                 messages: messages,
                 responseFormat: responseFormat,
-                temperature: ctx.temperature ?? clientConfig.defaultTemperature,
-                maxTokens: ctx.maxTokens ?? clientConfig.defaultMaxTokens
-            )
+                encodedSchema: encodedSchema,
+                temperature: ctx.temperature,
+                maxTokens: ctx.maxTokens,
+                timeout: ctx.timeout,
+                cachePolicy: ctx.cachePolicy,
+                maxContinuations: ctx.maxContinuations
+            ) { response in
+                try OutputParser.parse(response, plan: plan, type: T.self)
+            }
         }
-
-        // Parse the response
-        return try OutputParser.parse(response.content, schema: finalSchema, type: T.self)
     }
 
     /// Execute a raw completion (no function abstraction)
@@ -148,84 +133,322 @@ public actor SwamlRuntime {
         clientName: String? = nil,
         temperature: Double? = nil,
         maxTokens: Int? = nil,
-        responseFormat: ResponseFormat? = nil
+        responseFormat: ResponseFormat? = nil,
+        timeout: TimeInterval? = nil,
+        cachePolicy: ResponseCachePolicy = .default
     ) async throws -> LLMResponse {
-        // Get the client configuration
-        let clientConfig: ClientConfig
+        try await CallTrace.run("SwamlRuntime.complete", observer: metricsObserver) {
+            let route = try await resolveRoute(clientName: clientName)
+
+            return try await execute(
+                route: route,
+                messages: messages,
+                responseFormat: responseFormat,
+                encodedSchema: nil,
+                temperature: temperature,
+                maxTokens: maxTokens,
+                timeout: timeout,
+                cachePolicy: cachePolicy,
+                maxContinuations: 0
+            ) { $0 }
+        }
+    }
+
+    // MARK: - Prewarming
+
+    /// Get ready for traffic before the first call arrives
+    ///
+    /// Creates the client (and rate limiter) of every registered
+    /// configuration, opens connections to their hosts (see
+    /// `ClientRegistry.warmUp()`) and, meanwhile, resolves the output schema
+    /// of each of `functions` against `typeBuilder`, so the first calls skip
+    /// merging, encoding and compiling it. To start from prebuilt types, load
+    /// a TypeBuilder archive (`TypeBuilder.load(contentsOf:types:)`) first.
+    public func prewarm(functions: [String: JSONSchema] = [:], typeBuilder: TypeBuilder? = nil) async {
+        for name in await clientRegistry.clientNames {
+            _ = try? await clientRegistry.getClient(name)
+        }
+        async let connections: Void = clientRegistry.warmUp()
+
+        _ = typeBuilder?.snapshot()
+        for (name, schema) in functions {
+            _ = resolveOutputFormat(name, outputSchema: schema, typeBuilder: typeBuilder, ctx: .default)
+        }
+        await connections
+    }
+
+    // MARK: - Private Helpers
+
+    /// A client to send to, with its configuration
+    private struct Target: Sendable {
+        let config: ClientConfig
+        let client: LLMClient
+    }
+
+    /// Where a call goes: the chosen client, and the client to hedge with
+    private struct Route: Sendable {
+        let primary: Target
+        let hedge: Target?
+        let hedgeDelay: TimeInterval?
+    }
+
+    /// Results are handed out of the hedging task group without requiring
+    /// `Output: Sendable`; each value is only read by the caller
+    private struct HedgedOutput<Value>: @unchecked Sendable {
+        let value: Value
+    }
+
+    /// Resolve the client for a call
+    ///
+    /// A named client is always used as is. Otherwise, with a routing policy
+    /// the best-ranked client is chosen (and the runner-up as hedge, if the
+    /// policy hedges); without one, the default client.
+    private func resolveRoute(clientName: String?) async throws -> Route {
         if let name = clientName {
-            guard let config = await clientRegistry.getConfig(name) else {
-                throw SwamlError.clientNotFound(name)
-            }
-            clientConfig = config
-        } else {
+            return Route(primary: try await target(name), hedge: nil, hedgeDelay: nil)
+        }
+
+        guard let routing = routing else {
             guard let config = await clientRegistry.getDefaultConfig() else {
                 throw SwamlError.configurationError("No default client configured")
             }
-            clientConfig = config
+            return Route(primary: try await target(config.name), hedge: nil, hedgeDelay: nil)
+        }
+
+        let candidates = routing.clients.isEmpty ? await clientRegistry.clientNames.sorted() : routing.clients
+        let ranked = router.rank(candidates, maxErrorRate: routing.maxErrorRate)
+        guard let best = ranked.first else {
+            throw SwamlError.configurationError("No clients to route between")
         }
 
-        // Get the LLM client
-        let client = try await clientRegistry.getClient(clientConfig.name)
+        let primary = try await target(best)
+        guard let delay = router.hedgeDelay(for: best, policy: routing), ranked.count > 1 else {
+            return Route(primary: primary, hedge: nil, hedgeDelay: nil)
+        }
+        return Route(primary: primary, hedge: try await target(ranked[1]), hedgeDelay: delay)
+    }
 
-        // Execute with retry
-        let retryExecutor = RetryExecutor(policy: clientConfig.retryPolicy)
+    private func target(_ name: String) async throws -> Target {
+        guard let config = await clientRegistry.getConfig(name) else {
+            throw SwamlError.clientNotFound(name)
+        }
+        return Target(config: config, client: try await clientRegistry.getClient(name))
+    }
 
-        return try await retryExecutor.execute {
-            try await client.complete(
-                model: clientConfig.model,
+    /// Run a call on its route, hedging if the route has a second client
+    ///
+    /// The hedge is sent once the primary has run for `hedgeDelay`, or as
+    /// soon as the primary fails. The first result that parses is returned
+    /// and the other request is cancelled; if both fail, the last error is
+    /// thrown. Hedged requests aren't coalesced, so cancelling the loser never
+    /// cancels a request other calls are waiting on.
+    private func execute<Output>(
+        route: Route,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat?,
+        encodedSchema: EncodedJSON?,
+        temperature: Double?,
+        maxTokens: Int?,
+        timeout: TimeInterval?,
+        cachePolicy: ResponseCachePolicy,
+        maxContinuations: Int,
+        parse: @escaping @Sendable (LLMResponse) throws -> Output
+    ) async throws -> Output {
+        let run = { @Sendable (target: Target, coalesces: Bool) async throws -> HedgedOutput<Output> in
+            HedgedOutput(value: try await self.execute(
+                client: target.client,
+                config: target.config,
                 messages: messages,
                 responseFormat: responseFormat,
-                temperature: temperature ?? clientConfig.defaultTemperature,
-                maxTokens: maxTokens ?? clientConfig.defaultMaxTokens
-            )
+                encodedSchema: encodedSchema,
+                temperature: temperature,
+                maxTokens: maxTokens,
+                timeout: timeout,
+                cachePolicy: cachePolicy,
+                maxContinuations: maxContinuations,
+                coalesces: coalesces,
+                parse: parse
+            ))
+        }
+
+        guard let hedge = route.hedge, let delay = route.hedgeDelay else {
+            return try await run(route.primary, coalescesRequests).value
+        }
+
+        return try await withThrowingTaskGroup(of: HedgedOutput<Output>?.self) { group in
+            group.addTask { try await run(route.primary, false) }
+            group.addTask {
+                // nil marks the hedge timer firing
+                try await Task.sleep(nanoseconds: UInt64(delay * 1_000_000_000))
+                return nil
+            }
+
+            var hedged = false
+            var pending = 2
+            var lastError: Error?
+            while pending > 0 {
+                pending -= 1
+                do {
+                    guard let result = try await group.next() else { break }
+                    if let output = result {
+                        group.cancelAll()
+                        return output.value
+                    }
+                } catch {
+                    if Task.isCancelled {
+                        throw error
+                    }
+                    lastError = error
+                }
+                if !hedged {
+                    hedged = true
+                    pending += 1
+                    group.addTask { try await run(hedge, false) }
+                }
+            }
+            throw lastError ?? CancellationError()
         }
     }
 
-    // MARK: - Private Helpers
+    /// Run a completion with retries inside the deadline, then parse it
+    ///
+    /// A response cut off by the token limit is continued up to
+    /// `maxContinuations` times (see `LLMClient`) and cached stitched.
+    ///
+    /// With a response cache, an exact match of the request is handed straight
+    /// to `parse`. New responses are stored only once they parse, so a
+    /// malformed output is never replayed. With `coalesces`, identical calls
+    /// running at the same time share one request and its parsed result. Each
+    /// request's latency or failure is recorded in `router`; a cancelled one
+    /// is not recorded.
+    private func execute<Output>(
+        client: LLMClient,
+        config: ClientConfig,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat?,
+        encodedSchema: EncodedJSON?,
+        temperature: Double?,
+        maxTokens: Int?,
+        timeout: TimeInterval?,
+        cachePolicy: ResponseCachePolicy,
+        maxContinuations: Int,
+        coalesces: Bool,
+        parse: @escaping @Sendable (LLMResponse) throws -> Output
+    ) async throws -> Output {
+        let temperature = temperature ?? config.defaultTemperature
+        let maxTokens = maxTokens ?? config.defaultMaxTokens
+        let responseCache = responseCache
+        let router = router
+        let smoothing = routing?.smoothing ?? RoutingPolicy.fastest.smoothing
+
+        let send = { @Sendable (cacheKey: ResponseCacheKey?) async throws -> Output in
+            let retryExecutor = RetryExecutor(policy: config.retryPolicy)
+            let start = ContinuousClock.now
+            let response: LLMResponse
+            do {
+                response = try await withDeadline(timeout) {
+                    try await retryExecutor.execute {
+                        try await client.complete(
+                            model: config.model,
+                            messages: messages,
+                            responseFormat: responseFormat,
+                            encodedSchema: encodedSchema,
+                            temperature: temperature,
+                            maxTokens: maxTokens,
+                            maxContinuations: maxContinuations
+                        )
+                    }
+                }
+            } catch {
+                // A cancelled request (e.g. a hedging loser) says nothing about the client
+                if !isCancellation(error) {
+                    router.recordFailure(config.name, smoothing: smoothing)
+                }
+                throw error
+            }
+            router.recordSuccess(config.name, latency: start.duration(to: .now).timeInterval, smoothing: smoothing)
 
-    /// Merge TypeBuilder's dynamic enum values into the output schema
-    private func mergeSchemaWithTypeBuilder(_ schema: JSONSchema?, typeBuilder: TypeBuilder?) -> JSONSchema? {
-        guard let schema = schema, let tb = typeBuilder else {
-            return schema
+            let output = try parse(response)
+            if let key = cacheKey, cachePolicy.mode == .readWrite {
+                responseCache?.store(response, for: key)
+            }
+            return output
         }
 
-        let dynamicEnums = tb.dynamicEnumValues()
-        if dynamicEnums.isEmpty {
-            return schema
+        let usesCache = responseCache != nil && cachePolicy.mode != .bypass
+        let coalesces = coalesces && cachePolicy.mode != .bypass
+        guard usesCache || coalesces else {
+            return try await send(nil)
+        }
+
+        let key = await client.cacheKey(
+            model: config.model,
+            messages: messages,
+            responseFormat: responseFormat,
+            encodedSchema: encodedSchema,
+            temperature: temperature,
+            maxTokens: maxTokens
+        )
+        if usesCache, let cached = responseCache?.response(for: key, maxAge: cachePolicy.ttl) {
+            return try parse(cached)
         }
 
-        // Recursively update the schema to replace dynamic enum references
-        return updateSchemaWithDynamicEnums(schema, dynamicEnums: dynamicEnums)
+        let cacheKey = usesCache ? key : nil
+        guard coalesces else {
+            return try await send(cacheKey)
+        }
+        return try await coalescer.run(CoalescingKey(request: key, maxContinuations: maxContinuations)) {
+            try await send(cacheKey)
+        }
     }
 
-    /// Recursively update schema to include dynamic enum values
-    private func updateSchemaWithDynamicEnums(_ schema: JSONSchema, dynamicEnums: [String: [String]]) -> JSONSchema {
-        switch schema {
-        case .ref(let name):
-            // If this is a reference to a dynamic enum, replace with enum schema
-            if let values = dynamicEnums[name] {
-                return .enum(values: values)
-            }
-            return schema
+    /// Resolve the output schema and response format for a function call
+    ///
+    /// The merged schema, its dictionary form, its encoded JSON and its compiled
+    /// `SchemaPlan` are cached per function name and TypeBuilder generation, so
+    /// repeated calls skip the merge, `toDictionary()`, encoding the schema into
+    /// the request body and compiling it for parsing.
+    private func resolveOutputFormat(
+        _ name: String,
+        outputSchema: JSONSchema?,
+        typeBuilder: TypeBuilder?,
+        ctx: RuntimeContext
+    ) -> (plan: SchemaPlan?, responseFormat: ResponseFormat?, encodedSchema: EncodedJSON?) {
+        guard let outputSchema = outputSchema else {
+            // Default to JSON object format for typed outputs
+            return (nil, ctx.responseFormat ?? .jsonObject, nil)
+        }
 
-        case .object(let properties, let required, let additionalProps):
-            // Recursively update properties
-            var updatedProps: [String: JSONSchema] = [:]
-            for (key, propSchema) in properties {
-                updatedProps[key] = updateSchemaWithDynamicEnums(propSchema, dynamicEnums: dynamicEnums)
-            }
-            let updatedAdditional = additionalProps.map { updateSchemaWithDynamicEnums($0, dynamicEnums: dynamicEnums) }
-            return .object(properties: updatedProps, required: required, additionalProperties: updatedAdditional)
+        let cache = typeBuilder?.schemaCache ?? .standalone
+        let resolved = cache.resolvedSchema(
+            for: .function(name),
+            source: outputSchema,
+            generation: typeBuilder?.generation ?? 0
+        ) {
+            mergeSchemaWithTypeBuilder(outputSchema, typeBuilder: typeBuilder) ?? outputSchema
+        }
 
-        case .array(let items):
-            return .array(items: updateSchemaWithDynamicEnums(items, dynamicEnums: dynamicEnums))
+        // Always use JSON schema when we have a schema
+        return (
+            resolved.plan,
+            .jsonSchema(name: name, schema: resolved.dictionary, strict: true),
+            resolved.encoded
+        )
+    }
 
-        case .anyOf(let schemas):
-            return .anyOf(schemas.map { updateSchemaWithDynamicEnums($0, dynamicEnums: dynamicEnums) })
+    /// Merge TypeBuilder's dynamic enum values into the output schema
+    private func mergeSchemaWithTypeBuilder(_ schema: JSONSchema?, typeBuilder: TypeBuilder?) -> JSONSchema? {
+        guard let schema = schema, let tb = typeBuilder else {
+            return schema
+        }
 
-        default:
+        let dynamicEnums = tb.snapshot().dynamicEnumValues
+        if dynamicEnums.isEmpty {
             return schema
         }
+
+        // Replace references to dynamic enums with their values
+        return schema.resolvingEnums(dynamicEnums)
     }
 }
 
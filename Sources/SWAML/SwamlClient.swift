@@ -25,6 +25,24 @@ import Foundation
 public actor SwamlClient {
     private let llmClient: LLMClient
     private let typeBuilder: TypeBuilder
+    private let coalescer = RequestCoalescer<CoalescingKey>()
+
+    /// Whether concurrent identical calls share one upstream request
+    public private(set) var coalescesRequests = true
+
+    /// How many times a response cut off by the token limit is continued
+    /// before parsing (0 to parse it as it is)
+    public private(set) var maxContinuations = 0
+
+    /// Whether schemas are sent natively to providers that can hold output
+    /// to them, instead of as a prompt (see `setNativeStructuredOutput`)
+    public private(set) var usesNativeStructuredOutput = false
+
+    /// Receives the metrics of each call (see `CallMetrics`)
+    public private(set) var metricsObserver: (any CallMetricsObserver)?
+
+    /// Tags attached to the metrics of this client's calls
+    public private(set) var metricsTags: [String: String] = [:]
 
     /// Initialize with an LLM provider
     public init(provider: LLMProvider) {
@@ -81,41 +99,27 @@ public actor SwamlClient {
         temperature: Double? = nil,
         maxTokens: Int? = nil
     ) async throws -> T {
-        // 1. Build the schema prompt
-        let schemaPrompt = SchemaPromptRenderer.render(
-            for: T.self,
-            typeBuilder: typeBuilder,
-            includeDescriptions: true
-        )
-
-        // Combine system prompts if provided
-        let fullSystemPrompt: String
-        if let additionalPrompt = systemPrompt {
-            fullSystemPrompt = "\(additionalPrompt)\n\n\(schemaPrompt)"
-        } else {
-            fullSystemPrompt = schemaPrompt
+        try await traced("SwamlClient.call") {
+            // 1. Build the schema prompt (or native schema), 2. call the LLM, 3. parse with schema validation
+            let format = outputFormat(for: T.self)
+            return try await completeAndParse(
+                model: model,
+                messages: promptMessages(prompt: prompt, systemPrompt: systemPrompt, type: T.self, format: format),
+                format: format,
+                temperature: temperature,
+                maxTokens: maxTokens
+            ) { response in
+                try self.parseResponse(response, schema: T.swamlSchema, type: T.self)
+            }
         }
-
-        // 2. Call the LLM
-        let response = try await llmClient.complete(
-            model: model,
-            messages: [
-                .system(fullSystemPrompt),
-                .user(prompt)
-            ],
-            responseFormat: .jsonObject,
-            temperature: temperature,
-            maxTokens: maxTokens
-        )
-
-        // 3. Parse with schema validation (use Rust parser if available)
-        return try parseResponse(response.content, schema: T.swamlSchema, type: T.self)
     }
 
     /// Call an LLM with structured output and automatic error repair
     ///
-    /// If parsing fails, attempts to repair the output by asking the LLM
-    /// to fix the malformed JSON.
+    /// Output that parses but doesn't match the schema (wrong enum casing,
+    /// numbers as strings, aliased keys, a lone object instead of an array)
+    /// is first repaired locally with `SchemaRepair`. Only if that fails is
+    /// the LLM asked to fix the output.
     ///
     /// - Parameters:
     ///   - model: The model identifier (e.g., "openai/gpt-4o-mini")
@@ -135,40 +139,17 @@ public actor SwamlClient {
         maxTokens: Int? = nil,
         maxRepairAttempts: Int = 1
     ) async throws -> T {
-        do {
-            return try await call(
-                model: model,
-                prompt: prompt,
-                returnType: T.self,
-                systemPrompt: systemPrompt,
-                temperature: temperature,
-                maxTokens: maxTokens
-            )
-        } catch let error as SwamlError {
-            guard maxRepairAttempts > 0 else { throw error }
-
-            // Extract raw output from error if available
-            let rawOutput: String
-            switch error {
-            case .parseError(let message):
-                rawOutput = message
-            case .jsonExtractionError(let message):
-                rawOutput = message
-            default:
-                throw error
-            }
-
-            // Attempt repair
-            let repaired = try await repairOutput(
+        try await traced("SwamlClient.callWithRepair") {
+            let format = outputFormat(for: T.self)
+            return try await completeRepairing(
                 model: model,
+                messages: promptMessages(prompt: prompt, systemPrompt: systemPrompt, type: T.self, format: format),
+                format: format,
                 originalPrompt: prompt,
-                malformedOutput: rawOutput,
-                expectedSchema: T.swamlSchema,
-                temperature: temperature
+                temperature: temperature,
+                maxTokens: maxTokens,
+                maxRepairAttempts: maxRepairAttempts
             )
-
-            // Retry parsing with repaired output
-            return try parseResponse(repaired, schema: T.swamlSchema, type: T.self)
         }
     }
 
@@ -188,17 +169,21 @@ public actor SwamlClient {
         temperature: Double? = nil,
         maxTokens: Int? = nil
     ) async throws -> T {
-        let messages = prompt.build(returnType: T.self, typeBuilder: typeBuilder)
-
-        let response = try await llmClient.complete(
-            model: model,
-            messages: messages,
-            responseFormat: .jsonObject,
-            temperature: temperature,
-            maxTokens: maxTokens
-        )
+        try await traced("SwamlClient.call") {
+            let messages = CallTrace.measure(.schema) {
+                prompt.build(returnType: T.self, typeBuilder: typeBuilder)
+            }
 
-        return try parseResponse(response.content, schema: T.swamlSchema, type: T.self)
+            return try await completeAndParse(
+                model: model,
+                messages: messages,
+                format: .prompt,
+                temperature: temperature,
+                maxTokens: maxTokens
+            ) { response in
+                try self.parseResponse(response, schema: T.swamlSchema, type: T.self)
+            }
+        }
     }
 
     /// Call an LLM with PromptBuilder and automatic error repair
@@ -210,34 +195,20 @@ public actor SwamlClient {
         maxTokens: Int? = nil,
         maxRepairAttempts: Int = 1
     ) async throws -> T {
-        do {
-            return try await call(
-                model: model,
-                prompt: prompt,
-                returnType: T.self,
-                temperature: temperature,
-                maxTokens: maxTokens
-            )
-        } catch let error as SwamlError {
-            guard maxRepairAttempts > 0 else { throw error }
-
-            let rawOutput: String
-            switch error {
-            case .parseError(let message), .jsonExtractionError(let message):
-                rawOutput = message
-            default:
-                throw error
+        try await traced("SwamlClient.callWithRepair") {
+            let messages = CallTrace.measure(.schema) {
+                prompt.build(returnType: T.self, typeBuilder: typeBuilder)
             }
 
-            let repaired = try await repairOutput(
+            return try await completeRepairing(
                 model: model,
+                messages: messages,
+                format: .prompt,
                 originalPrompt: prompt.buildRaw().compactMap { $0.content.textValue }.joined(separator: "\n"),
-                malformedOutput: rawOutput,
-                expectedSchema: T.swamlSchema,
-                temperature: temperature
+                temperature: temperature,
+                maxTokens: maxTokens,
+                maxRepairAttempts: maxRepairAttempts
             )
-
-            return try parseResponse(repaired, schema: T.swamlSchema, type: T.self)
         }
     }
 
@@ -259,33 +230,42 @@ public actor SwamlClient {
         temperature: Double? = nil,
         maxTokens: Int? = nil
     ) async throws -> T {
-        var finalMessages = messages
+        try await traced("SwamlClient.call") {
+            var finalMessages = messages
 
-        // Prepend schema prompt if requested
-        if includeSchema {
-            let schemaPrompt = SchemaPromptRenderer.render(
-                for: T.self,
-                typeBuilder: typeBuilder
-            )
+            // Send the schema natively if the provider can hold output to it,
+            // otherwise prepend the schema prompt
+            let format = includeSchema ? outputFormat(for: T.self) : .prompt
+            if includeSchema, !format.isNative {
+                let request = messages
+                    .filter { $0.role == .user }
+                    .compactMap(\.content.textValue)
+                    .joined(separator: "\n")
+                let schemaPrompt = CallTrace.measure(.schema) {
+                    SchemaPromptRenderer.render(
+                        for: T.self,
+                        typeBuilder: typeBuilder,
+                        relevantTo: request
+                    )
+                }
 
-            // Find existing system message or create new one
-            if let systemIdx = finalMessages.firstIndex(where: { $0.role == .system }) {
-                let existing = finalMessages[systemIdx].content.textValue ?? ""
-                finalMessages[systemIdx] = .system("\(existing)\n\n\(schemaPrompt)")
-            } else {
-                finalMessages.insert(.system(schemaPrompt), at: 0)
+                // Its own message after the caller's system messages, so
+                // theirs stay byte for byte as given (and cacheable)
+                let systemEnd = finalMessages.firstIndex { $0.role != .system } ?? finalMessages.endIndex
+                let shortlisted = SchemaPromptRenderer.rendersShortlist(for: T.self, typeBuilder: typeBuilder)
+                finalMessages.insert(.system(schemaPrompt, cacheable: !shortlisted), at: systemEnd)
             }
-        }
-
-        let response = try await llmClient.complete(
-            model: model,
-            messages: finalMessages,
-            responseFormat: .jsonObject,
-            temperature: temperature,
-            maxTokens: maxTokens
-        )
 
-        return try parseResponse(response.content, schema: T.swamlSchema, type: T.self)
+            return try await completeAndParse(
+                model: model,
+                messages: finalMessages,
+                format: format,
+                temperature: temperature,
+                maxTokens: maxTokens
+            ) { response in
+                try self.parseResponse(response, schema: T.swamlSchema, type: T.self)
+            }
+        }
     }
 
     /// Call an LLM and return raw SwamlValue (for dynamic schemas)
@@ -306,30 +286,338 @@ public actor SwamlClient {
         temperature: Double? = nil,
         maxTokens: Int? = nil
     ) async throws -> SwamlValue {
-        let schemaPrompt = SchemaPromptRenderer.render(
-            schema: schema,
-            typeBuilder: typeBuilder
+        try await traced("SwamlClient.callDynamic") {
+            let format = outputFormat(for: schema, name: "output", key: .dynamicOutput)
+
+            var messages: [ChatMessage] = [.user(prompt)]
+            if !format.isNative {
+                let schemaPrompt = CallTrace.measure(.schema) {
+                    SchemaPromptRenderer.render(
+                        schema: schema,
+                        typeBuilder: typeBuilder,
+                        relevantTo: prompt
+                    )
+                }
+
+                messages.insert(
+                    contentsOf: Self.systemMessages(
+                        systemPrompt,
+                        schemaPrompt: schemaPrompt,
+                        shortlisted: SchemaPromptRenderer.rendersShortlist(typeBuilder: typeBuilder)
+                    ),
+                    at: 0
+                )
+            } else if let systemPrompt = systemPrompt {
+                messages.insert(.system(systemPrompt, cacheable: true), at: 0)
+            }
+
+            let plan = format.plan ?? SchemaPlan.cached(for: schema)
+            return try await completeAndParse(
+                model: model,
+                messages: messages,
+                format: format,
+                temperature: temperature,
+                maxTokens: maxTokens
+            ) { response in
+                try OutputParser.parseToValue(response, plan: plan)
+            }
+        }
+    }
+
+    // MARK: - Metrics
+
+    /// Report per-call metrics to `observer` (nil to stop)
+    ///
+    /// Calls are also emitted as signpost intervals on Apple platforms while
+    /// signposts are being recorded, with or without an observer.
+    public func setMetricsObserver(_ observer: (any CallMetricsObserver)?, tags: [String: String] = [:]) {
+        metricsObserver = observer
+        metricsTags = tags
+    }
+
+    /// Run a call as one traced operation
+    private func traced<T>(_ operation: String, _ body: () async throws -> T) async rethrows -> T {
+        try await CallTrace.run(operation, tags: metricsTags, observer: metricsObserver, body: body)
+    }
+
+    // MARK: - Continuation
+
+    /// Continue responses cut off by the token limit instead of failing or
+    /// repairing them
+    ///
+    /// A truncated response's output is sent back for the model to continue,
+    /// up to `maxContinuations` times, and the pieces are stitched together
+    /// before parsing. Off (0) by default.
+    public func setContinuation(maxContinuations: Int) {
+        self.maxContinuations = max(maxContinuations, 0)
+    }
+
+    // MARK: - Native Structured Output
+
+    /// Turn native structured output on or off
+    ///
+    /// Off by default, since not every model behind a provider supports it
+    /// (OpenAI's strict `json_schema` needs gpt-4o-2024-08-06 or later, and
+    /// older models reject the request). When on, and the provider can hold
+    /// output to a schema (`LLMProvider.structuredOutput`: OpenAI's strict
+    /// `json_schema`, an Anthropic forced tool call) and the schema
+    /// qualifies, it is sent in the request, with the type's field
+    /// descriptions, instead of being rendered into the system prompt.
+    /// Strict responses are decoded directly; tool inputs, which Anthropic
+    /// doesn't hold to the schema, still go through the parser. Streams,
+    /// `PromptBuilder` prompts and packed batches always use the schema prompt.
+    public func setNativeStructuredOutput(_ enabled: Bool) {
+        usesNativeStructuredOutput = enabled
+    }
+
+    /// How a call asks for its output
+    struct OutputFormat: Sendable {
+        let responseFormat: ResponseFormat
+
+        /// Pre-encoded schema of a native `responseFormat`
+        let encodedSchema: EncodedJSON?
+
+        /// The native schema compiled for validation
+        let plan: SchemaPlan?
+
+        /// JSON mode, with the schema in the prompt
+        static let prompt = OutputFormat(responseFormat: .jsonObject, encodedSchema: nil, plan: nil)
+
+        /// Whether the schema is sent natively rather than in the prompt
+        var isNative: Bool {
+            plan != nil
+        }
+    }
+
+    /// The output format for `T`: its schema sent natively if possible
+    ///
+    /// Dynamic classes keep the schema prompt, since TypeBuilder properties
+    /// aren't part of `swamlSchema`.
+    func outputFormat<T: SwamlTyped>(for type: T.Type) -> OutputFormat {
+        guard !T.isDynamic else { return .prompt }
+        return outputFormat(
+            for: T.swamlSchema,
+            descriptions: T.fieldDescriptions,
+            name: T.swamlTypeName,
+            key: .output(ObjectIdentifier(T.self))
         )
+    }
 
-        let fullSystemPrompt: String
-        if let additionalPrompt = systemPrompt {
-            fullSystemPrompt = "\(additionalPrompt)\n\n\(schemaPrompt)"
-        } else {
-            fullSystemPrompt = schemaPrompt
+    /// The output format for `schema`: sent natively if native output is on,
+    /// the provider supports it and the schema (with dynamic enums resolved)
+    /// qualifies; otherwise `.prompt`
+    private func outputFormat(
+        for schema: JSONSchema,
+        descriptions: [String: String] = [:],
+        name: String,
+        key: SchemaCache.Key
+    ) -> OutputFormat {
+        let mode = llmClient.provider.structuredOutput
+        guard usesNativeStructuredOutput, mode != .prompt else { return .prompt }
+
+        let typeBuilder = typeBuilder
+        let resolved = CallTrace.measure(.schema) {
+            typeBuilder.schemaCache.resolvedSchema(
+                for: key,
+                source: schema,
+                descriptions: descriptions,
+                generation: typeBuilder.generation
+            ) {
+                schema.resolvingEnums(typeBuilder.dynamicEnumValues())
+            }
         }
+        guard mode.accepts(resolved.schema) else { return .prompt }
 
-        let response = try await llmClient.complete(
+        return OutputFormat(
+            responseFormat: .jsonSchema(name: LLMClient.formatName(name), schema: resolved.dictionary, strict: true),
+            encodedSchema: resolved.encoded,
+            plan: resolved.plan
+        )
+    }
+
+    // MARK: - Request Coalescing
+
+    /// Turn sharing of concurrent identical requests on or off
+    ///
+    /// On by default. Turn it off when identical concurrent calls are meant
+    /// to produce independent samples (e.g. with a high temperature).
+    public func setRequestCoalescing(_ enabled: Bool) {
+        coalescesRequests = enabled
+    }
+
+    /// Complete a JSON-mode (or native schema) request and parse the response
+    ///
+    /// If an identical request (same model, messages, parameters and
+    /// continuation budget) is already in flight and parsed the same way
+    /// (`parsing`), waits for its parsed result instead of sending another
+    /// one. Cancelling one caller doesn't cancel the shared request while
+    /// others are still waiting for it.
+    private func completeAndParse<Output>(
+        model: String,
+        messages: [ChatMessage],
+        format: OutputFormat,
+        temperature: Double?,
+        maxTokens: Int?,
+        parsing: CoalescingKey.Parsing = .standard,
+        parse: @escaping @Sendable (LLMResponse) throws -> Output
+    ) async throws -> Output {
+        let llmClient = llmClient
+        let maxContinuations = maxContinuations
+        let send = { @Sendable () async throws -> Output in
+            let response = try await llmClient.complete(
+                model: model,
+                messages: messages,
+                responseFormat: format.responseFormat,
+                encodedSchema: format.encodedSchema,
+                temperature: temperature,
+                maxTokens: maxTokens,
+                maxContinuations: maxContinuations
+            )
+            return try parse(response)
+        }
+
+        guard coalescesRequests else {
+            return try await send()
+        }
+        let request = await llmClient.cacheKey(
             model: model,
-            messages: [
-                .system(fullSystemPrompt),
-                .user(prompt)
-            ],
-            responseFormat: .jsonObject,
+            messages: messages,
+            responseFormat: format.responseFormat,
+            encodedSchema: format.encodedSchema,
             temperature: temperature,
             maxTokens: maxTokens
         )
+        let key = CoalescingKey(request: request, maxContinuations: maxContinuations, parsing: parsing)
+        return try await coalescer.run(key, operation: send)
+    }
+
+    /// Schema system prompt plus the user prompt
+    ///
+    /// With a native `format` the schema is in the request instead, and only
+    /// `systemPrompt` (if any) goes before the user prompt.
+    private func promptMessages<T: SwamlTyped>(
+        prompt: String,
+        systemPrompt: String?,
+        type: T.Type,
+        format: OutputFormat
+    ) -> [ChatMessage] {
+        guard !format.isNative else {
+            guard let systemPrompt = systemPrompt else { return [.user(prompt)] }
+            return [.system(systemPrompt, cacheable: true), .user(prompt)]
+        }
+
+        let schemaPrompt = CallTrace.measure(.schema) {
+            SchemaPromptRenderer.render(
+                for: T.self,
+                typeBuilder: typeBuilder,
+                includeDescriptions: true,
+                relevantTo: prompt
+            )
+        }
 
-        return try OutputParser.parseToValue(response.content, schema: schema)
+        let shortlisted = SchemaPromptRenderer.rendersShortlist(for: T.self, typeBuilder: typeBuilder)
+        return Self.systemMessages(systemPrompt, schemaPrompt: schemaPrompt, shortlisted: shortlisted)
+            + [.user(prompt)]
+    }
+
+    /// System messages for an optional system prompt and the schema prompt
+    ///
+    /// Combined into one cacheable message, unless the schema prompt lists
+    /// enum values shortlisted for this request: then only the system prompt
+    /// is marked cacheable, and the schema prompt follows it uncached.
+    private static func systemMessages(
+        _ systemPrompt: String?,
+        schemaPrompt: String,
+        shortlisted: Bool
+    ) -> [ChatMessage] {
+        guard shortlisted else {
+            let combined = systemPrompt.map { "\($0)\n\n\(schemaPrompt)" } ?? schemaPrompt
+            return [.system(combined, cacheable: true)]
+        }
+        return (systemPrompt.map { [.system($0, cacheable: true)] } ?? []) + [.system(schemaPrompt)]
+    }
+
+    /// Complete a request and parse it, repairing output that doesn't fit
+    ///
+    /// Local repair is tried first; the output only goes back to the model
+    /// when `SchemaRepair` gives up.
+    private func completeRepairing<T: SwamlTyped>(
+        model: String,
+        messages: [ChatMessage],
+        format: OutputFormat,
+        originalPrompt: String,
+        temperature: Double?,
+        maxTokens: Int?,
+        maxRepairAttempts: Int
+    ) async throws -> T {
+        do {
+            return try await completeAndParse(
+                model: model,
+                messages: messages,
+                format: format,
+                temperature: temperature,
+                maxTokens: maxTokens,
+                parsing: .repairing
+            ) { response in
+                if response.isSchemaConstrained, let decoded = OutputParser.decodeStrict(response.content, as: T.self) {
+                    return decoded
+                }
+                return try self.parseRepairingLocally(response.content, type: T.self)
+            }
+        } catch {
+            guard maxRepairAttempts > 0 else {
+                throw (error as? UnrepairedOutput)?.error ?? error
+            }
+
+            guard let unrepaired = error as? UnrepairedOutput else {
+                throw error
+            }
+
+            let repaired = try await repairOutput(
+                model: model,
+                originalPrompt: originalPrompt,
+                malformedOutput: unrepaired.output,
+                expectedSchema: T.swamlSchema,
+                temperature: temperature
+            )
+
+            do {
+                return try parseRepairingLocally(repaired, type: T.self)
+            } catch let unrepaired as UnrepairedOutput {
+                throw unrepaired.error
+            }
+        }
+    }
+
+    // MARK: - Sessions
+
+    /// The provider calls are sent to
+    nonisolated var provider: LLMProvider {
+        llmClient.provider
+    }
+
+    /// Complete one turn of a `SwamlSession`, with `messages` sent as given
+    ///
+    /// - Returns: The parsed value and the response it was parsed from
+    func respond<T: SwamlTyped>(
+        model: String,
+        messages: [ChatMessage],
+        format: OutputFormat,
+        returnType: T.Type,
+        temperature: Double?,
+        maxTokens: Int?
+    ) async throws -> (value: T, response: LLMResponse) {
+        try await traced("SwamlSession.send") {
+            try await completeAndParse(
+                model: model,
+                messages: messages,
+                format: format,
+                temperature: temperature,
+                maxTokens: maxTokens
+            ) { response in
+                (try self.parseResponse(response, schema: T.swamlSchema, type: T.self), response)
+            }
+        }
     }
 
     // MARK: - TypeBuilder Access
@@ -408,13 +696,26 @@ public actor SwamlClient {
 extension SwamlClient {
     /// Call an LLM multiple times concurrently
     ///
+    /// With `itemsPerRequest` above 1, prompts are packed into requests of up
+    /// to that many inputs: the schema prompt is sent once per request and the
+    /// model answers every input in one `{"results": [{"id", "result"}]}`
+    /// object, which is scattered back to each prompt's slot. Inputs whose
+    /// answer is missing or doesn't decode (or whose whole request failed) are
+    /// then sent again on their own. Packing suits many small, independent
+    /// prompts such as classification; off (1) by default. A packed request's
+    /// token budget is `maxTokens` times its number of inputs (without
+    /// `maxTokens`, `BatchPacker.defaultTokensPerItem` each where the provider
+    /// needs a budget).
+    ///
     /// - Parameters:
     ///   - model: The model identifier
     ///   - prompts: Array of user prompts
     ///   - returnType: The expected return type
     ///   - systemPrompt: Optional additional system prompt
     ///   - temperature: Optional temperature
+    ///   - maxTokens: Optional completion token budget per prompt
     ///   - maxConcurrency: Maximum concurrent requests (default: 5)
+    ///   - itemsPerRequest: Prompts packed into each request (default: 1)
     /// - Returns: Array of results in the same order as prompts
     public func batch<T: SwamlTyped>(
         model: String,
@@ -422,47 +723,508 @@ extension SwamlClient {
         returnType: T.Type,
         systemPrompt: String? = nil,
         temperature: Double? = nil,
-        maxConcurrency: Int = 5
+        maxTokens: Int? = nil,
+        maxConcurrency: Int = 5,
+        itemsPerRequest: Int = 1
     ) async throws -> [Result<T, Error>] {
-        try await withThrowingTaskGroup(of: (Int, Result<T, Error>).self) { group in
-            var results: [(Int, Result<T, Error>)] = []
-            var index = 0
+        var results = [Result<T, Error>?](repeating: nil, count: prompts.count)
 
-            for prompt in prompts {
-                let currentIndex = index
-                index += 1
+        if itemsPerRequest > 1, prompts.count > 1 {
+            let packer = BatchPacker<T>(systemPrompt: systemPrompt, typeBuilder: typeBuilder)
+            let requiresBudget = !provider.isOpenAICompatible
+            let groups = stride(from: 0, to: prompts.count, by: itemsPerRequest).map {
+                Array($0..<min($0 + itemsPerRequest, prompts.count))
+            }
+            let packed = BatchSequence(
+                inputs: groups,
+                maxConcurrency: maxConcurrency,
+                order: .unordered
+            ) { indices in
+                try await self.completeAndParse(
+                    model: model,
+                    messages: packer.messages(for: indices.map { ($0, prompts[$0]) }),
+                    format: .prompt,
+                    temperature: temperature,
+                    maxTokens: BatchPacker<T>.maxTokens(for: indices.count, perItem: maxTokens, required: requiresBudget)
+                ) { response in
+                    try packer.parse(response.content, indices: Set(indices))
+                }
+            }
+            for await group in packed {
+                guard case .success(let answers) = group.result else { continue }
+                for (index, answer) in answers {
+                    results[index] = .success(answer)
+                }
+            }
+            try Task.checkCancellation()
+        }
 
-                group.addTask {
-                    do {
-                        let result = try await self.call(
-                            model: model,
-                            prompt: prompt,
-                            returnType: returnType,
-                            systemPrompt: systemPrompt,
-                            temperature: temperature
+        // Everything not answered by a packed request, one prompt per request
+        let remaining = results.indices.filter { results[$0] == nil }
+        let sequence = batchResults(
+            model: model,
+            prompts: remaining.map { prompts[$0] },
+            returnType: returnType,
+            systemPrompt: systemPrompt,
+            temperature: temperature,
+            maxTokens: maxTokens,
+            maxConcurrency: maxConcurrency,
+            order: .unordered
+        )
+        for await item in sequence {
+            results[remaining[item.index]] = item.result
+        }
+
+        try Task.checkCancellation()
+        return results.map { $0 ?? .failure(CancellationError()) }
+    }
+
+    /// Call an LLM multiple times concurrently, delivering results as they complete
+    ///
+    /// Keeps `maxConcurrency` requests in flight, backing off when the provider
+    /// rate limits, and holds only a window's worth of results in memory. Use
+    /// this instead of `batch` for large batches.
+    ///
+    /// ```swift
+    /// for await item in client.batchResults(model: model, prompts: prompts, returnType: Summary.self, order: .unordered) {
+    ///     store(item.index, item.result)
+    /// }
+    /// ```
+    ///
+    /// - Parameters:
+    ///   - model: The model identifier
+    ///   - prompts: Array of user prompts
+    ///   - returnType: The expected return type
+    ///   - systemPrompt: Optional additional system prompt
+    ///   - temperature: Optional temperature
+    ///   - maxTokens: Optional completion token budget per prompt
+    ///   - maxConcurrency: Maximum concurrent requests (default: 5)
+    ///   - order: Whether results arrive in prompt order or as they complete
+    ///   - rateLimitPolicy: Backoff and retry limit for rate-limited requests
+    /// - Returns: A sequence of results tagged with their prompt's index
+    public nonisolated func batchResults<T: SwamlTyped>(
+        model: String,
+        prompts: [String],
+        returnType: T.Type,
+        systemPrompt: String? = nil,
+        temperature: Double? = nil,
+        maxTokens: Int? = nil,
+        maxConcurrency: Int = 5,
+        order: BatchOrder = .ordered,
+        rateLimitPolicy: RetryPolicy = .standard
+    ) -> BatchSequence<String, T> {
+        BatchSequence(
+            inputs: prompts,
+            maxConcurrency: maxConcurrency,
+            order: order,
+            rateLimitPolicy: rateLimitPolicy
+        ) { prompt in
+            try await self.call(
+                model: model,
+                prompt: prompt,
+                returnType: T.self,
+                systemPrompt: systemPrompt,
+                temperature: temperature,
+                maxTokens: maxTokens
+            )
+        }
+    }
+}
+
+// MARK: - Provider Batch API
+
+extension SwamlClient {
+    /// Submit prompts to the provider's asynchronous batch API
+    ///
+    /// Provider batches (OpenAI `/batches`, Anthropic Message Batches) are
+    /// cheaper than synchronous calls and don't compete for rate limits, but
+    /// can take up to a day. Uploading the requests is retried according to
+    /// `retryPolicy`; creating the batch only on rate limiting (see
+    /// `LLMClient.submitBatch(_:retryPolicy:)`), so a retry never submits a
+    /// second billed batch.
+    ///
+    /// - Parameters:
+    ///   - model: The model identifier
+    ///   - prompts: Array of user prompts
+    ///   - returnType: The expected return type
+    ///   - systemPrompt: Optional additional system prompt
+    ///   - temperature: Optional temperature
+    ///   - maxTokens: Optional max tokens per response
+    ///   - retryPolicy: Retry behavior for the submission requests
+    /// - Returns: The submitted job; each request's `customId` is its prompt index
+    public func submitBatch<T: SwamlTyped>(
+        model: String,
+        prompts: [String],
+        returnType: T.Type,
+        systemPrompt: String? = nil,
+        temperature: Double? = nil,
+        maxTokens: Int? = nil,
+        retryPolicy: RetryPolicy = .standard
+    ) async throws -> LLMBatchJob {
+        let schemaPrompt = SchemaPromptRenderer.render(
+            for: T.self,
+            typeBuilder: typeBuilder,
+            includeDescriptions: true
+        )
+
+        let fullSystemPrompt: String
+        if let additionalPrompt = systemPrompt {
+            fullSystemPrompt = "\(additionalPrompt)\n\n\(schemaPrompt)"
+        } else {
+            fullSystemPrompt = schemaPrompt
+        }
+
+        let requests = prompts.enumerated().map { index, prompt in
+            LLMBatchRequest(
+                customId: String(index),
+                model: model,
+                messages: [.system(fullSystemPrompt, cacheable: true), .user(prompt)],
+                responseFormat: .jsonObject,
+                temperature: temperature,
+                maxTokens: maxTokens
+            )
+        }
+
+        return try await llmClient.submitBatch(requests, retryPolicy: retryPolicy)
+    }
+
+    /// Poll a batch until the provider has finished processing it
+    ///
+    /// - Parameters:
+    ///   - job: The submitted job
+    ///   - pollInterval: Seconds between status checks (default: 30)
+    ///   - retryPolicy: Retry behavior for each status check
+    /// - Returns: The finished job
+    public func waitForBatch(
+        _ job: LLMBatchJob,
+        pollInterval: TimeInterval = 30,
+        retryPolicy: RetryPolicy = .standard
+    ) async throws -> LLMBatchJob {
+        let llmClient = llmClient
+        let retryExecutor = RetryExecutor(policy: retryPolicy)
+
+        var current = job
+        while !current.status.isFinished {
+            try await Task.sleep(nanoseconds: UInt64(pollInterval * 1_000_000_000))
+            let id = current.id
+            current = try await retryExecutor.execute {
+                try await llmClient.batchStatus(id)
+            }
+        }
+        return current
+    }
+
+    /// Stream the typed results of a finished batch
+    ///
+    /// Each result file line is parsed with the same jsonish parser and decoder
+    /// as `call`. Results arrive in the provider's order and carry their
+    /// prompt index. Results whose `customId` isn't a prompt index (i.e. the
+    /// job wasn't submitted by `submitBatch`) can't be matched to a prompt:
+    /// after the others, the stream fails with a `parseError` naming them.
+    public nonisolated func batchJobResults<T: SwamlTyped>(
+        _ job: LLMBatchJob,
+        returnType: T.Type
+    ) -> AsyncThrowingStream<BatchResult<T>, Error> {
+        let results = llmClient.batchResults(job)
+
+        return AsyncThrowingStream { continuation in
+            let task = Task {
+                do {
+                    var unmatched: [String] = []
+                    for try await item in results {
+                        guard let index = Int(item.customId) else {
+                            unmatched.append(item.customId)
+                            continue
+                        }
+                        let result = item.result.flatMap { response in
+                            Result { try self.parseResponse(response, schema: T.swamlSchema, type: T.self) }
+                        }
+                        continuation.yield(BatchResult(index: index, result: result))
+                    }
+                    guard unmatched.isEmpty else {
+                        throw SwamlError.parseError(
+                            "Batch results without a prompt index: \(unmatched.prefix(10).joined(separator: ", "))"
+                                + (unmatched.count > 10 ? " and \(unmatched.count - 10) more" : "")
                         )
-                        return (currentIndex, .success(result))
-                    } catch {
-                        return (currentIndex, .failure(error))
                     }
+                    continuation.finish()
+                } catch {
+                    continuation.finish(throwing: error)
                 }
+            }
+            continuation.onTermination = { _ in
+                task.cancel()
+            }
+        }
+    }
 
-                // Limit concurrency
-                if index % maxConcurrency == 0 {
-                    if let result = try await group.next() {
-                        results.append(result)
+    /// Run prompts through the provider's batch API: submit, wait, and stream the results
+    ///
+    /// - Parameters:
+    ///   - model: The model identifier
+    ///   - prompts: Array of user prompts
+    ///   - returnType: The expected return type
+    ///   - systemPrompt: Optional additional system prompt
+    ///   - temperature: Optional temperature
+    ///   - maxTokens: Optional max tokens per response
+    ///   - pollInterval: Seconds between status checks (default: 30)
+    ///   - retryPolicy: Retry behavior for submission and status checks
+    /// - Returns: Results tagged with their prompt's index, in the provider's order
+    public nonisolated func providerBatch<T: SwamlTyped>(
+        model: String,
+        prompts: [String],
+        returnType: T.Type,
+        systemPrompt: String? = nil,
+        temperature: Double? = nil,
+        maxTokens: Int? = nil,
+        pollInterval: TimeInterval = 30,
+        retryPolicy: RetryPolicy = .standard
+    ) -> AsyncThrowingStream<BatchResult<T>, Error> {
+        AsyncThrowingStream { continuation in
+            let task = Task {
+                do {
+                    let submitted = try await self.submitBatch(
+                        model: model,
+                        prompts: prompts,
+                        returnType: T.self,
+                        systemPrompt: systemPrompt,
+                        temperature: temperature,
+                        maxTokens: maxTokens,
+                        retryPolicy: retryPolicy
+                    )
+                    let finished = try await self.waitForBatch(
+                        submitted,
+                        pollInterval: pollInterval,
+                        retryPolicy: retryPolicy
+                    )
+                    for try await result in self.batchJobResults(finished, returnType: T.self) {
+                        continuation.yield(result)
                     }
+                    continuation.finish()
+                } catch {
+                    continuation.finish(throwing: error)
                 }
             }
+            continuation.onTermination = { _ in
+                task.cancel()
+            }
+        }
+    }
+}
+
+// MARK: - Streaming
 
-            // Collect remaining results
-            for try await result in group {
-                results.append(result)
+extension SwamlClient {
+    /// Stream an LLM call with structured output
+    ///
+    /// The response is streamed from the provider and parsed incrementally, so
+    /// partial results can be shown while the model is still generating. An
+    /// update is yielded for every chunk after the output starts; the last one
+    /// has `isFinal` set and holds the fully parsed value.
+    ///
+    /// The stream stops reading once the top-level JSON value is closed, and
+    /// abandons an attempt as soon as a field can no longer match the schema
+    /// (a type mismatch, or an enum value no allowed value starts with).
+    /// Aborted and failed attempts are retried per `retryPolicy`, aborted ones
+    /// without delay; updates from a retry start over, with a higher `attempt`.
+    ///
+    /// Example usage:
+    /// ```swift
+    /// for try await update in client.stream(
+    ///     model: "openai/gpt-4o-mini",
+    ///     prompt: "Summarize this article...",
+    ///     returnType: Summary.self
+    /// ) {
+    ///     print(update.partial["title"]?.stringValue ?? "")
+    /// }
+    /// ```
+    ///
+    /// - Parameters:
+    ///   - model: The model identifier (e.g., "openai/gpt-4o-mini")
+    ///   - prompt: The user prompt
+    ///   - returnType: The expected return type (must conform to SwamlTyped)
+    ///   - systemPrompt: Optional additional system prompt (prepended to schema)
+    ///   - temperature: Optional temperature (0.0-2.0)
+    ///   - maxTokens: Optional max tokens for response
+    ///   - retryPolicy: Retry behavior for failed or aborted attempts
+    /// - Returns: A stream of partial results ending with the parsed response
+    public nonisolated func stream<T: SwamlTyped>(
+        model: String,
+        prompt: String,
+        returnType: T.Type,
+        systemPrompt: String? = nil,
+        temperature: Double? = nil,
+        maxTokens: Int? = nil,
+        retryPolicy: RetryPolicy = .standard
+    ) -> AsyncThrowingStream<SwamlStreamUpdate<T>, Error> {
+        let schemaPrompt = SchemaPromptRenderer.render(
+            for: T.self,
+            typeBuilder: typeBuilder,
+            includeDescriptions: true,
+            relevantTo: prompt
+        )
+
+        let shortlisted = SchemaPromptRenderer.rendersShortlist(for: T.self, typeBuilder: typeBuilder)
+
+        return streamStructured(
+            model: model,
+            messages: Self.systemMessages(systemPrompt, schemaPrompt: schemaPrompt, shortlisted: shortlisted)
+                + [.user(prompt)],
+            returnType: T.self,
+            temperature: temperature,
+            maxTokens: maxTokens,
+            retryPolicy: retryPolicy
+        )
+    }
+
+    /// Stream an LLM call built with a PromptBuilder
+    public nonisolated func stream<T: SwamlTyped>(
+        model: String,
+        prompt: PromptBuilder,
+        returnType: T.Type,
+        temperature: Double? = nil,
+        maxTokens: Int? = nil,
+        retryPolicy: RetryPolicy = .standard
+    ) -> AsyncThrowingStream<SwamlStreamUpdate<T>, Error> {
+        streamStructured(
+            model: model,
+            messages: prompt.build(returnType: T.self, typeBuilder: typeBuilder),
+            returnType: T.self,
+            temperature: temperature,
+            maxTokens: maxTokens,
+            retryPolicy: retryPolicy
+        )
+    }
+
+    /// Stream an LLM call and return the raw chunks (no parsing)
+    public nonisolated func rawStream(
+        model: String,
+        messages: [ChatMessage],
+        responseFormat: ResponseFormat? = nil,
+        temperature: Double? = nil,
+        maxTokens: Int? = nil
+    ) -> AsyncThrowingStream<LLMStreamChunk, Error> {
+        llmClient.stream(
+            model: model,
+            messages: messages,
+            responseFormat: responseFormat,
+            temperature: temperature,
+            maxTokens: maxTokens
+        )
+    }
+
+    private nonisolated func streamStructured<T: SwamlTyped>(
+        model: String,
+        messages: [ChatMessage],
+        returnType: T.Type,
+        temperature: Double?,
+        maxTokens: Int?,
+        retryPolicy: RetryPolicy
+    ) -> AsyncThrowingStream<SwamlStreamUpdate<T>, Error> {
+        let plan = SchemaPlan(schema: T.swamlSchema, typeBuilder: typeBuilder)
+
+        return AsyncThrowingStream { continuation in
+            let task = Task {
+                do {
+                    let final = try await RetryExecutor(policy: retryPolicy).execute { attempt in
+                        try await self.streamAttempt(
+                            model: model,
+                            messages: messages,
+                            returnType: T.self,
+                            temperature: temperature,
+                            maxTokens: maxTokens,
+                            plan: plan,
+                            attempt: attempt,
+                            continuation: continuation
+                        )
+                    }
+                    continuation.yield(final)
+                    continuation.finish()
+                } catch {
+                    continuation.finish(throwing: error)
+                }
             }
+            continuation.onTermination = { _ in
+                task.cancel()
+            }
+        }
+    }
+
+    /// Stream one attempt, yielding partial updates and returning the final one
+    ///
+    /// Reading stops as soon as the top-level value is closed, which cancels
+    /// the request rather than paying for trailing prose; such a stream ends
+    /// without the finish reason and usage the provider sends last. Each
+    /// time another value is closed, the partial output is checked with
+    /// `SchemaPlan.validatePrefix`, and the attempt is abandoned with
+    /// `SwamlError.streamAborted` as soon as it can no longer match.
+    private nonisolated func streamAttempt<T: SwamlTyped>(
+        model: String,
+        messages: [ChatMessage],
+        returnType: T.Type,
+        temperature: Double?,
+        maxTokens: Int?,
+        plan: SchemaPlan,
+        attempt: Int,
+        continuation: AsyncThrowingStream<SwamlStreamUpdate<T>, Error>.Continuation
+    ) async throws -> SwamlStreamUpdate<T> {
+        let chunks = llmClient.stream(
+            model: model,
+            messages: messages,
+            responseFormat: .jsonObject,
+            temperature: temperature,
+            maxTokens: maxTokens
+        )
 
-            // Sort by original index and return just the results
-            return results.sorted { $0.0 < $1.0 }.map { $0.1 }
+        var parser = JsonishStreamParser()
+        var content = ""
+        var revision = parser.revision
+        var completedValueCount = parser.completedValueCount
+        var latest: T?
+        var finishReason: LLMResponse.FinishReason?
+        var usage: LLMResponse.Usage?
+
+        for try await chunk in chunks {
+            finishReason = chunk.finishReason ?? finishReason
+            usage = chunk.usage ?? usage
+            guard !chunk.delta.isEmpty else { continue }
+
+            content += chunk.delta
+            parser.append(chunk.delta)
+            guard parser.revision != revision, let partial = parser.current else { continue }
+            revision = parser.revision
+
+            // Only re-check and retry decoding once another value has been closed
+            if parser.completedValueCount != completedValueCount {
+                completedValueCount = parser.completedValueCount
+                do {
+                    try plan.validatePrefix(partial)
+                } catch {
+                    throw SwamlError.streamAborted(error.localizedDescription)
+                }
+                if let decoded = try? SwamlValueDecoder().decode(T.self, from: partial) {
+                    latest = decoded
+                }
+            }
+
+            continuation.yield(SwamlStreamUpdate(partial: partial, value: latest, isFinal: false, attempt: attempt))
+
+            if parser.isComplete {
+                break
+            }
         }
+
+        // The complete output goes through the same extraction as `call`
+        let final = try JsonishParser.parseValue(content)
+        let result = try SwamlValueDecoder().decode(T.self, from: final)
+        return SwamlStreamUpdate(
+            partial: final,
+            value: result,
+            isFinal: true,
+            finishReason: finishReason,
+            usage: usage,
+            attempt: attempt
+        )
     }
 }
 
@@ -477,35 +1239,94 @@ extension SwamlClient {
     /// - Single quotes
     /// - Markdown code block extraction
     /// - Multiple JSON candidates
-    private func parseResponse<T: Codable>(
-        _ response: String,
+    ///
+    /// The parsed value is decoded directly, resolving snake_case keys and
+    /// `fieldAliases` and coercing scalars along the way. Output the provider
+    /// held to the schema is first decoded as-is, skipping the parser.
+    private nonisolated func parseResponse<T: Codable>(
+        _ response: LLMResponse,
         schema: JSONSchema,
         type: T.Type
     ) throws -> T {
-        // Parse with the Swift jsonish parser
-        let parsedJSON = try JsonishParser.parse(response)
-        guard let data = parsedJSON.data(using: .utf8) else {
-            throw SwamlError.parseError("Failed to convert parsed JSON to data")
+        if response.isSchemaConstrained, let decoded = OutputParser.decodeStrict(response.content, as: T.self) {
+            return decoded
+        }
+        let value = try CallTrace.measure(.parse) {
+            try JsonishParser.parseValue(response.content)
         }
+        return try CallTrace.measure(.decode) {
+            try SwamlValueDecoder().decode(T.self, from: value)
+        }
+    }
+
+    /// Output that failed to parse and couldn't be repaired locally
+    private struct UnrepairedOutput: Error {
+        let output: String
+        let error: Error
+    }
 
-        // Decode with schema coercion - try snake_case first, then raw
-        let decoder = JSONDecoder()
-        decoder.keyDecodingStrategy = .convertFromSnakeCase
+    /// Parse a response, falling back to `SchemaRepair` if it doesn't decode
+    ///
+    /// - Throws: `UnrepairedOutput` with the original output and error if the
+    ///   output can't be extracted or repaired
+    private nonisolated func parseRepairingLocally<T: SwamlTyped>(_ response: String, type: T.Type) throws -> T {
+        let value: SwamlValue
         do {
-            return try decoder.decode(T.self, from: data)
+            value = try CallTrace.measure(.parse) {
+                try JsonishParser.parseValue(response)
+            }
         } catch {
-            let decoder2 = JSONDecoder()
-            return try decoder2.decode(T.self, from: data)
+            throw UnrepairedOutput(output: response, error: error)
+        }
+
+        do {
+            return try CallTrace.measure(.decode) {
+                try SwamlValueDecoder().decode(T.self, from: value)
+            }
+        } catch {
+            let repaired = CallTrace.measure(.parse) {
+                SchemaRepair(for: T.self, typeBuilder: typeBuilder).repair(value)
+            }
+            guard let repaired, !repaired.fixes.isEmpty,
+                  let decoded = try? CallTrace.measure(.decode, {
+                      try SwamlValueDecoder().decode(T.self, from: repaired.value)
+                  })
+            else {
+                throw UnrepairedOutput(output: response, error: error)
+            }
+            CallTrace.record { $0.localRepairs += 1 }
+            return decoded
         }
     }
 
     /// Attempt to repair malformed LLM output
+    ///
+    /// Timed as the `repair` phase of the call, network time included.
     private func repairOutput(
         model: String,
         originalPrompt: String,
         malformedOutput: String,
         expectedSchema: JSONSchema,
         temperature: Double?
+    ) async throws -> String {
+        CallTrace.record { $0.repairs += 1 }
+        return try await CallTrace.measure(.repair) {
+            try await requestRepair(
+                model: model,
+                originalPrompt: originalPrompt,
+                malformedOutput: malformedOutput,
+                expectedSchema: expectedSchema,
+                temperature: temperature
+            )
+        }
+    }
+
+    private func requestRepair(
+        model: String,
+        originalPrompt: String,
+        malformedOutput: String,
+        expectedSchema: JSONSchema,
+        temperature: Double?
     ) async throws -> String {
         let schemaText = SchemaPromptRenderer.renderSchema(expectedSchema, typeBuilder: typeBuilder)
 
@@ -0,0 +1,258 @@
+import Foundation
+
+/// A multi-turn conversation with structured replies
+///
+/// The session owns the history, so agents don't rebuild and re-encode it
+/// on every turn:
+/// - Each message keeps its encoded request bytes, so a turn only encodes
+///   the new prompt; the history is spliced in as it was first written
+/// - The system prompt and the schema prompt are a fixed, cacheable prefix
+///   of separate messages. The schema is rendered without shortlisting
+///   (which varies with the prompt), only changes with the return type or
+///   the TypeBuilder, and is left out where the provider takes it natively
+/// - With a `ContextBudget`, the oldest turns are dropped or summarized once
+///   the conversation outgrows it, measured with the provider's token counts
+///
+/// ```swift
+/// let session = SwamlSession(client: client, model: "gpt-4o-mini", systemPrompt: "You triage tickets.")
+/// let first = try await session.send("My order is late", returnType: Triage.self)
+/// let second = try await session.send("It's been two weeks now", returnType: Triage.self)
+/// ```
+///
+/// Turns are sent one at a time; a `send` while another is in flight throws.
+public actor SwamlSession {
+    /// How a session keeps its history within a token limit
+    public struct ContextBudget: Sendable {
+        public enum Strategy: Sendable {
+            /// Drop the oldest turns
+            case truncate
+
+            /// Replace the oldest turns with a summary, written by `model`
+            /// (the session's model if nil) in up to `maxTokens` tokens
+            case summarize(model: String? = nil, maxTokens: Int = 512)
+        }
+
+        /// Most prompt tokens a turn may use, system and schema prompts included
+        public let maxTokens: Int
+
+        public let strategy: Strategy
+
+        /// Fraction of `maxTokens` compaction brings the conversation down
+        /// to, so that it happens every few turns rather than on every one
+        /// (each compaction changes the prefix providers have cached)
+        public let target: Double
+
+        public init(maxTokens: Int, strategy: Strategy = .truncate, target: Double = 0.75) {
+            self.maxTokens = maxTokens
+            self.strategy = strategy
+            self.target = min(max(target, 0), 1)
+        }
+    }
+
+    /// The model turns are sent to
+    public let model: String
+
+    /// The history's token limit, if any
+    public let budget: ContextBudget?
+
+    private let client: SwamlClient
+    private let system: ChatMessage?
+
+    /// The schema prompt of the latest return type (nil when sent natively)
+    private var schema: (type: ObjectIdentifier, message: ChatMessage?)?
+
+    /// Summary of the turns compacted away
+    private var summary: ChatMessage?
+
+    /// User and assistant turns, oldest first
+    public private(set) var history: [ChatMessage] = []
+
+    /// Token usage of the latest turn
+    public private(set) var lastUsage: LLMResponse.Usage?
+
+    /// Tokens of the conversation so far: the last turn's reported prompt
+    /// and completion tokens, adjusted by estimates for compaction since;
+    /// nil before the first reply
+    public private(set) var contextTokens: Int?
+
+    /// Reported prompt tokens per estimated token, as of the last turn
+    private var tokenScale = 1.0
+
+    private var isSending = false
+
+    public init(
+        client: SwamlClient,
+        model: String,
+        systemPrompt: String? = nil,
+        budget: ContextBudget? = nil
+    ) {
+        self.client = client
+        self.model = model
+        self.system = systemPrompt.map { ChatMessage.system($0, cacheable: true).withEncodings() }
+        self.budget = budget
+    }
+
+    /// Everything the next turn sends before its prompt
+    public var messages: [ChatMessage] {
+        prefix + history
+    }
+
+    private var prefix: [ChatMessage] {
+        [system, schema?.message, summary].compactMap { $0 }
+    }
+
+    // MARK: - Turns
+
+    /// Send a prompt and parse the reply as `T`
+    ///
+    /// The prompt and the raw reply are appended to the history once the
+    /// reply has parsed; a failed turn leaves the history as it was.
+    public func send<T: SwamlTyped>(
+        _ prompt: String,
+        returnType: T.Type,
+        temperature: Double? = nil,
+        maxTokens: Int? = nil
+    ) async throws -> T {
+        guard !isSending else {
+            throw SwamlError.configurationError("SwamlSession sends one turn at a time")
+        }
+        isSending = true
+        defer { isSending = false }
+
+        let user = ChatMessage.user(prompt).withEncodings()
+        let format = await prepare(for: T.self)
+        try await compactIfNeeded(adding: user)
+
+        let sent = messages + [user]
+        let (value, response) = try await client.respond(
+            model: model,
+            messages: sent,
+            format: format,
+            returnType: T.self,
+            temperature: temperature,
+            maxTokens: maxTokens
+        )
+
+        // Anthropic caches up to the last breakpoint, so replies carry one
+        // and the cached prefix grows with the conversation; OpenAI caches
+        // prefixes on its own and keys them by the fixed prefix
+        let reply = ChatMessage(
+            role: .assistant,
+            content: response.content,
+            cacheable: !client.provider.isOpenAICompatible
+        )
+        history.append(user)
+        history.append(reply.withEncodings())
+        record(response.usage, sent: sent)
+        return value
+    }
+
+    /// Append messages to the history without sending them (e.g. context
+    /// gathered between turns)
+    public func append(_ newMessages: [ChatMessage]) {
+        history.append(contentsOf: newMessages.map { $0.withEncodings() })
+    }
+
+    /// Forget the history and its summary, keeping the system prompt
+    public func reset() {
+        history.removeAll()
+        summary = nil
+        lastUsage = nil
+        contextTokens = nil
+    }
+
+    /// Get the output format for `T` and bring the schema prompt up to date
+    ///
+    /// The message is only replaced when the rendered text changes, so the
+    /// prefix stays byte for byte the same across turns.
+    func prepare<T: SwamlTyped>(for type: T.Type) async -> SwamlClient.OutputFormat {
+        let format = await client.outputFormat(for: T.self)
+        guard !format.isNative else {
+            schema = (ObjectIdentifier(T.self), nil)
+            return format
+        }
+
+        let rendered = SchemaPromptRenderer.render(for: T.self, typeBuilder: client.types, includeDescriptions: true)
+        if schema?.type != ObjectIdentifier(T.self) || schema?.message?.content.textValue != rendered {
+            schema = (ObjectIdentifier(T.self), ChatMessage.system(rendered, cacheable: true).withEncodings())
+        }
+        return format
+    }
+
+    // MARK: - Token Budget
+
+    /// Record a turn's usage, calibrating estimates against it
+    private func record(_ usage: LLMResponse.Usage?, sent: [ChatMessage]) {
+        lastUsage = usage
+        guard let usage = usage else {
+            contextTokens = nil
+            return
+        }
+        let estimated = LLMClient.estimatedTokens(messages: sent, maxTokens: nil)
+        if estimated > 0, usage.promptTokens > 0 {
+            tokenScale = Double(usage.promptTokens) / Double(estimated)
+        }
+        contextTokens = usage.promptTokens + usage.completionTokens
+    }
+
+    /// Estimated tokens of `messages`, scaled to the provider's counts
+    private func tokens(_ messages: [ChatMessage]) -> Int {
+        Int((Double(LLMClient.estimatedTokens(messages: messages, maxTokens: nil)) * tokenScale).rounded(.up))
+    }
+
+    /// Compact the history if sending `prompt` would exceed the budget
+    ///
+    /// Whole turns (a user message and what follows it) are taken from the
+    /// front until the conversation is down to the budget's `target`, then
+    /// dropped or folded into the summary.
+    func compactIfNeeded(adding prompt: ChatMessage) async throws {
+        guard let budget = budget else { return }
+        let promptTokens = tokens([prompt])
+        var total = contextTokens ?? tokens(messages)
+        guard total + promptTokens > budget.maxTokens else { return }
+
+        let target = Int(Double(budget.maxTokens) * budget.target) - promptTokens
+        var count = 0
+        while total > target, count < history.count {
+            var end = count + 1
+            while end < history.count, history[end].role != .user {
+                end += 1
+            }
+            total -= tokens(Array(history[count..<end]))
+            count = end
+        }
+        guard count > 0 else { return }
+
+        if case .summarize(let summaryModel, let maxTokens) = budget.strategy {
+            let updated = try await summarize(history.prefix(count), model: summaryModel ?? model, maxTokens: maxTokens)
+            total += tokens([updated]) - (summary.map { tokens([$0]) } ?? 0)
+            summary = updated
+        }
+        history.removeFirst(count)
+        contextTokens = max(total, 0)
+    }
+
+    /// A summary of the current one (if any) and `turns`
+    private func summarize(_ turns: ArraySlice<ChatMessage>, model: String, maxTokens: Int) async throws -> ChatMessage {
+        var transcript: [String] = []
+        if let previous = summary?.content.textValue {
+            transcript.append(previous)
+        }
+        for message in turns {
+            transcript.append("\(message.role.rawValue): \(message.content.textValue ?? "")")
+        }
+
+        let response = try await client.rawComplete(
+            model: model,
+            messages: [
+                .system("""
+                    Summarize this conversation for the assistant continuing it. Keep facts, decisions, \
+                    open questions and anything the user asked to remember. Reply with the summary only.
+                    """),
+                .user(transcript.joined(separator: "\n\n"))
+            ],
+            maxTokens: maxTokens
+        )
+        return ChatMessage.system("Summary of the conversation so far:\n\(response.content)", cacheable: true).withEncodings()
+    }
+}
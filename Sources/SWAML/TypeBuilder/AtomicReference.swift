@@ -0,0 +1,62 @@
+import Foundation
+import CSwamlAtomics
+
+/// A reference that's read without locking
+///
+/// A reader registers in the current epoch, loads and retains the object, and
+/// leaves again. A writer swaps the new object in, moves later readers to the
+/// other epoch and waits for the one it replaced to drain before releasing
+/// the old object, so a reader never retains an object that's being freed.
+/// Reads never block; writes must be serialized by the caller.
+final class AtomicReference<Object: AnyObject>: @unchecked Sendable {
+    /// Retained object (0 for nil), epoch, then readers in epoch 0 and 1
+    private let words: UnsafeMutablePointer<Int>
+
+    init(_ object: Object? = nil) {
+        words = .allocate(capacity: 4)
+        words.initialize(repeating: 0, count: 4)
+        words[0] = Self.retainedBits(object)
+    }
+
+    deinit {
+        Self.release(words[0])
+        words.deallocate()
+    }
+
+    func load() -> Object? {
+        var epoch = 0
+        while true {
+            epoch = swaml_atomic_load(words + 1)
+            swaml_atomic_fetch_add(words + 2 + epoch, 1)
+            // A writer flipped the epoch in between and may not wait for us
+            if swaml_atomic_load(words + 1) == epoch { break }
+            swaml_atomic_fetch_add(words + 2 + epoch, -1)
+        }
+
+        let retained = UnsafeRawPointer(bitPattern: swaml_atomic_load(words))
+            .map { Unmanaged<Object>.fromOpaque($0).retain() }
+        swaml_atomic_fetch_add(words + 2 + epoch, -1)
+        return retained?.takeRetainedValue()
+    }
+
+    func store(_ object: Object?) {
+        let old = swaml_atomic_exchange(words, Self.retainedBits(object))
+        guard old != 0 else { return }
+
+        let epoch = swaml_atomic_load(words + 1)
+        swaml_atomic_store(words + 1, 1 - epoch)
+        while swaml_atomic_load(words + 2 + epoch) != 0 {
+            sched_yield()
+        }
+        Self.release(old)
+    }
+
+    private static func retainedBits(_ object: Object?) -> Int {
+        object.map { Int(bitPattern: Unmanaged.passRetained($0).toOpaque()) } ?? 0
+    }
+
+    private static func release(_ bits: Int) {
+        guard let pointer = UnsafeRawPointer(bitPattern: bits) else { return }
+        Unmanaged<Object>.fromOpaque(pointer).release()
+    }
+}
@@ -0,0 +1,161 @@
+import Foundation
+
+// MARK: - Dynamic Enum Index
+
+/// Hashed lookups over the values of a dynamic enum
+///
+/// Built once per `TypeBuilderSnapshot`, so enums with thousands of values
+/// cost a dictionary lookup per check rather than a scan:
+/// - `contains` is an exact, hashed membership test
+/// - `resolve` maps a value, an alias or a case- and punctuation-folded
+///   spelling of either (`"Order ID"` for `orderId`) to the value's name;
+///   folded spellings shared by two values resolve to neither
+/// - `shortlist` ranks values by the words they share with a request, from
+///   an inverted index over their names, aliases and descriptions
+public struct DynamicEnumIndex: Sendable, Equatable {
+    /// The enum's values, in insertion order
+    public let values: [String]
+
+    /// `values` as a set
+    public let valueSet: Set<String>
+
+    /// Value position by alias
+    private let aliases: [String: Int]
+
+    /// Value position by folded name or alias; nil where the spelling is ambiguous
+    private let folded: [String: Int?]
+
+    /// Value positions by word
+    private let postings: [String: [Int]]
+
+    public init(values: [TypeBuilderSnapshot.Value]) {
+        self.values = values.map(\.name)
+        self.valueSet = Set(self.values)
+
+        var aliases: [String: Int] = [:]
+        var folded: [String: Int?] = [:]
+        var postings: [String: [Int]] = [:]
+
+        func fold(_ spelling: String, _ position: Int) {
+            let key = SchemaRepair.normalizedKey(spelling)
+            guard !key.isEmpty else { return }
+            if let existing = folded[key], existing != position {
+                folded[key] = .some(nil)
+            } else {
+                folded[key] = position
+            }
+        }
+
+        for (position, value) in values.enumerated() {
+            fold(value.name, position)
+            if let alias = value.alias {
+                if aliases[alias] == nil {
+                    aliases[alias] = position
+                }
+                fold(alias, position)
+            }
+
+            var words = Self.words(in: value.name)
+            words.formUnion(Self.words(in: value.alias ?? ""))
+            words.formUnion(Self.words(in: value.description ?? ""))
+            for word in words {
+                postings[word, default: []].append(position)
+            }
+        }
+
+        self.aliases = aliases
+        self.folded = folded
+        self.postings = postings
+    }
+
+    public var count: Int {
+        values.count
+    }
+
+    public func contains(_ value: String) -> Bool {
+        valueSet.contains(value)
+    }
+
+    /// The value `text` names: the value itself, an alias, or a folded
+    /// spelling of either
+    public func resolve(_ text: String) -> String? {
+        if valueSet.contains(text) {
+            return text
+        }
+        if let position = aliases[text] {
+            return values[position]
+        }
+        let trimmed = text.trimmingCharacters(in: .whitespacesAndNewlines)
+        if let position = aliases[trimmed] {
+            return values[position]
+        }
+        guard let match = folded[SchemaRepair.normalizedKey(trimmed)], let position = match else {
+            return nil
+        }
+        return values[position]
+    }
+
+    /// The `limit` values most relevant to `query`, in insertion order
+    ///
+    /// Values score the inverse document frequency of each query word they
+    /// contain, so rare, specific words count for more than common ones. When
+    /// fewer than `limit` values share a word with the query, the rest are
+    /// filled in insertion order.
+    public func shortlist(for query: String, limit: Int) -> [String] {
+        guard limit < values.count else { return values }
+        guard limit > 0 else { return [] }
+
+        var scores: [Int: Double] = [:]
+        let total = Double(values.count)
+        for word in Self.words(in: query) {
+            guard let positions = postings[word] else { continue }
+            let weight = log(1 + total / Double(positions.count))
+            for position in positions {
+                scores[position, default: 0] += weight
+            }
+        }
+
+        var chosen = scores
+            .sorted { $0.value != $1.value ? $0.value > $1.value : $0.key < $1.key }
+            .prefix(limit)
+            .map(\.key)
+        if chosen.count < limit {
+            let taken = Set(chosen)
+            chosen += values.indices.lazy.filter { !taken.contains($0) }.prefix(limit - chosen.count)
+        }
+        return chosen.sorted().map { values[$0] }
+    }
+
+    /// Lowercased words of two or more letters or digits, with a plural `s`
+    /// dropped; camelCase and snake_case names split into their words
+    static func words(in text: String) -> Set<String> {
+        var words = Set<String>()
+        var current = ""
+        var previousIsLower = false
+
+        func flush() {
+            if current.count >= 2 {
+                if current.count > 3, current.hasSuffix("s"), !current.hasSuffix("ss") {
+                    current.removeLast()
+                }
+                words.insert(current)
+            }
+            current = ""
+        }
+
+        for character in text {
+            guard character.isLetter || character.isNumber else {
+                flush()
+                previousIsLower = false
+                continue
+            }
+            if character.isUppercase, previousIsLower {
+                flush()
+            }
+            current += character.lowercased()
+            previousIsLower = character.isLowercase
+        }
+        flush()
+        return words
+    }
+}
@@ -1,7 +1,7 @@
 import Foundation
 
 /// JSON Schema representation for validation and LLM structured output
-public indirect enum JSONSchema: Sendable, Equatable {
+public indirect enum JSONSchema: Sendable, Hashable {
     case string
     case integer
     case number
@@ -15,6 +15,12 @@ public indirect enum JSONSchema: Sendable, Equatable {
 
     /// Convert to dictionary representation for JSON serialization
     public func toDictionary() -> [String: Any] {
+        toDictionary(descriptions: [:])
+    }
+
+    /// Convert to a dictionary, with a `description` on each object property
+    /// named in `descriptions` (at any depth, like the schema prompt's comments)
+    public func toDictionary(descriptions: [String: String]) -> [String: Any] {
         switch self {
         case .string:
             return ["type": "string"]
@@ -29,18 +35,24 @@ public indirect enum JSONSchema: Sendable, Equatable {
         case .array(let items):
             return [
                 "type": "array",
-                "items": items.toDictionary()
+                "items": items.toDictionary(descriptions: descriptions)
             ]
         case .object(let properties, let required, let additionalProperties):
             var dict: [String: Any] = [
                 "type": "object",
-                "properties": properties.mapValues { $0.toDictionary() }
+                "properties": properties.reduce(into: [String: Any]()) { result, property in
+                    var schema = property.value.toDictionary(descriptions: descriptions)
+                    if let description = descriptions[property.key] {
+                        schema["description"] = description
+                    }
+                    result[property.key] = schema
+                }
             ]
             if !required.isEmpty {
                 dict["required"] = required
             }
             if let additional = additionalProperties {
-                dict["additionalProperties"] = additional.toDictionary()
+                dict["additionalProperties"] = additional.toDictionary(descriptions: descriptions)
             } else {
                 dict["additionalProperties"] = false
             }
@@ -53,7 +65,7 @@ public indirect enum JSONSchema: Sendable, Equatable {
         case .ref(let name):
             return ["$ref": "#/$defs/\(name)"]
         case .anyOf(let schemas):
-            return ["anyOf": schemas.map { $0.toDictionary() }]
+            return ["anyOf": schemas.map { $0.toDictionary(descriptions: descriptions) }]
         }
     }
 
@@ -70,6 +82,66 @@ public indirect enum JSONSchema: Sendable, Equatable {
     }
 }
 
+// MARK: - Native Structured Output
+
+extension JSONSchema {
+    /// Whether the schema has no `.ref`s, so its dictionary stands on its own
+    var isSelfContained: Bool {
+        switch self {
+        case .ref:
+            return false
+        case .array(let items):
+            return items.isSelfContained
+        case .object(let properties, _, let additionalProperties):
+            return properties.values.allSatisfy(\.isSelfContained) && additionalProperties?.isSelfContained != false
+        case .anyOf(let schemas):
+            return schemas.allSatisfy(\.isSelfContained)
+        case .string, .integer, .number, .boolean, .null, .enum:
+            return true
+        }
+    }
+
+    /// Whether OpenAI's strict mode accepts the schema: every object requires
+    /// all of its properties and allows no others
+    var isStrictCompatible: Bool {
+        switch self {
+        case .array(let items):
+            return items.isStrictCompatible
+        case .object(let properties, let required, let additionalProperties):
+            return additionalProperties == nil
+                && Set(required) == Set(properties.keys)
+                && properties.values.allSatisfy(\.isStrictCompatible)
+        case .anyOf(let schemas):
+            return schemas.allSatisfy(\.isStrictCompatible)
+        case .ref, .string, .integer, .number, .boolean, .null, .enum:
+            return true
+        }
+    }
+
+    /// The schema with references to dynamic enums replaced by their values
+    func resolvingEnums(_ enums: [String: [String]]) -> JSONSchema {
+        switch self {
+        case .ref(let name):
+            if let values = enums[name] {
+                return .enum(values: values)
+            }
+            return self
+        case .object(let properties, let required, let additionalProperties):
+            return .object(
+                properties: properties.mapValues { $0.resolvingEnums(enums) },
+                required: required,
+                additionalProperties: additionalProperties.map { $0.resolvingEnums(enums) }
+            )
+        case .array(let items):
+            return .array(items: items.resolvingEnums(enums))
+        case .anyOf(let schemas):
+            return .anyOf(schemas.map { $0.resolvingEnums(enums) })
+        case .string, .integer, .number, .boolean, .null, .enum:
+            return self
+        }
+    }
+}
+
 // MARK: - Schema Builder Helpers
 
 extension JSONSchema {
@@ -0,0 +1,228 @@
+import Foundation
+
+// MARK: - Generation Counter
+
+/// Monotonic counter bumped whenever a TypeBuilder or one of its builders changes
+///
+/// Also holds the TypeBuilder's published snapshot. Changes drop it under the
+/// lock, and readers load it without one.
+final class GenerationCounter: @unchecked Sendable {
+    private let lock = NSLock()
+    private var _value: UInt64 = 0
+
+    private final class Published {
+        let snapshot: TypeBuilderSnapshot
+
+        init(_ snapshot: TypeBuilderSnapshot) {
+            self.snapshot = snapshot
+        }
+    }
+
+    private let published = AtomicReference<Published>()
+
+    var value: UInt64 {
+        lock.lock()
+        defer { lock.unlock() }
+        return _value
+    }
+
+    /// - Returns: the new value
+    @discardableResult
+    func increment() -> UInt64 {
+        lock.lock()
+        defer { lock.unlock() }
+        _value &+= 1
+        published.store(nil)
+        return _value
+    }
+
+    /// The snapshot of the current generation, if one has been published
+    var snapshot: TypeBuilderSnapshot? {
+        published.load()?.snapshot
+    }
+
+    /// Publish a snapshot, unless something changed while it was being built
+    func publish(_ snapshot: TypeBuilderSnapshot) {
+        lock.lock()
+        defer { lock.unlock() }
+        if snapshot.generation == _value {
+            published.store(Published(snapshot))
+        }
+    }
+}
+
+// MARK: - Schema Cache
+
+/// Cache of rendered output-format prompts and JSON Schema dictionaries.
+///
+/// Entries are stamped with the owning TypeBuilder's generation. The first lookup
+/// after a builder changes drops every entry, so the hot path is a dictionary
+/// lookup and stale output is never returned. Renders that race with a change
+/// (i.e. carry an older generation) are computed but not stored.
+final class SchemaCache: @unchecked Sendable {
+    /// Cache used when rendering without a TypeBuilder
+    static let standalone = SchemaCache()
+
+    /// What a cache entry was rendered for
+    enum Key: Hashable {
+        /// `render(for:)` of a SwamlTyped type; keyed by type identity, since
+        /// `swamlTypeName` isn't unique across modules
+        case type(ObjectIdentifier, includeDescriptions: Bool)
+
+        /// `render(className:from:)` of a dynamic class
+        case className(String)
+
+        /// Output schema of a runtime function
+        case function(String)
+
+        /// Native output schema of a SwamlTyped type, sent by `SwamlClient`
+        case output(ObjectIdentifier)
+
+        /// Native output schema of the latest `callDynamic` (replaced
+        /// whenever the schema changes)
+        case dynamicOutput
+
+        /// Whether different source schemas can be looked up under this key,
+        /// so a hit has to be checked against the caller's
+        ///
+        /// A type's schema and descriptions are fixed for its identity.
+        var sourceCanChange: Bool {
+            switch self {
+            case .function, .dynamicOutput:
+                return true
+            case .type, .className, .output:
+                return false
+            }
+        }
+    }
+
+    /// JSON Schema resolved against a TypeBuilder, ready to send as `response_format`
+    struct ResolvedSchema {
+        /// The schema as passed in by the caller (used to validate hits on
+        /// keys whose source can change)
+        let source: JSONSchema
+
+        /// The schema with dynamic enums merged in
+        let schema: JSONSchema
+
+        /// Property descriptions carried into `dictionary`
+        let descriptions: [String: String]
+
+        /// `schema.toDictionary(descriptions:)`
+        let dictionary: [String: Any]
+
+        /// `dictionary` encoded as JSON, spliced into request bodies
+        let encoded: EncodedJSON
+
+        /// `schema` compiled for coercing and validating responses
+        let plan: SchemaPlan
+
+        /// Derive the dictionary, encoding (unless already `encoded`) and plan of `schema`
+        init(source: JSONSchema, schema: JSONSchema, descriptions: [String: String] = [:], encoded: EncodedJSON? = nil) {
+            self.source = source
+            self.schema = schema
+            self.descriptions = descriptions
+            self.dictionary = schema.toDictionary(descriptions: descriptions)
+            self.encoded = encoded ?? EncodedJSON(any: dictionary)
+            self.plan = SchemaPlan(schema: schema)
+        }
+    }
+
+    private let lock = NSLock()
+    private var generation: UInt64 = 0
+    private var prompts: [Key: String] = [:]
+    private var resolvedSchemas: [Key: ResolvedSchema] = [:]
+
+    /// Number of cached prompts and schemas
+    var count: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return prompts.count + resolvedSchemas.count
+    }
+
+    /// Get a rendered prompt, rendering and storing it on a miss
+    func prompt(for key: Key, generation: UInt64, render: () -> String) -> String {
+        lock.lock()
+        let isCurrent = synchronize(generation)
+        if isCurrent, let cached = prompts[key] {
+            lock.unlock()
+            return cached
+        }
+        lock.unlock()
+
+        let rendered = render()
+
+        if isCurrent {
+            lock.lock()
+            if self.generation == generation {
+                prompts[key] = rendered
+            }
+            lock.unlock()
+        }
+        return rendered
+    }
+
+    /// Get a resolved schema, building and storing it on a miss
+    ///
+    /// For keys whose source can change (`Key.sourceCanChange`), a hit is
+    /// only returned if it was built from the same source schema and
+    /// descriptions; other hits are returned without comparing them.
+    func resolvedSchema(
+        for key: Key,
+        source: JSONSchema,
+        descriptions: [String: String] = [:],
+        generation: UInt64,
+        resolve: () -> JSONSchema
+    ) -> ResolvedSchema {
+        lock.lock()
+        let isCurrent = synchronize(generation)
+        if isCurrent, let cached = resolvedSchemas[key],
+           !key.sourceCanChange || (cached.source == source && cached.descriptions == descriptions) {
+            lock.unlock()
+            return cached
+        }
+        lock.unlock()
+
+        let resolved = ResolvedSchema(source: source, schema: resolve(), descriptions: descriptions)
+
+        if isCurrent {
+            lock.lock()
+            if self.generation == generation {
+                resolvedSchemas[key] = resolved
+            }
+            lock.unlock()
+        }
+        return resolved
+    }
+
+    /// Store a prompt rendered elsewhere (e.g. restored from an archive),
+    /// unless `generation` is out of date
+    func insert(prompt: String, for key: Key, generation: UInt64) {
+        lock.lock()
+        defer { lock.unlock() }
+        if synchronize(generation) {
+            prompts[key] = prompt
+        }
+    }
+
+    /// Store a schema resolved elsewhere, unless `generation` is out of date
+    func insert(_ resolved: ResolvedSchema, for key: Key, generation: UInt64) {
+        lock.lock()
+        defer { lock.unlock() }
+        if synchronize(generation) {
+            resolvedSchemas[key] = resolved
+        }
+    }
+
+    /// Drop entries from older generations (must be called with the lock held)
+    ///
+    /// - Returns: false if `generation` is older than what the cache has seen
+    private func synchronize(_ generation: UInt64) -> Bool {
+        if generation > self.generation {
+            self.generation = generation
+            prompts.removeAll()
+            resolvedSchemas.removeAll()
+        }
+        return generation == self.generation
+    }
+}
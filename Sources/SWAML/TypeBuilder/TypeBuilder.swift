@@ -23,6 +23,12 @@ open class TypeBuilder: @unchecked Sendable {
     /// Registered dynamic types (types that can be extended at runtime)
     private var dynamicTypes: Set<String> = []
 
+    /// Bumped on every change to this TypeBuilder or one of its builders
+    let generationCounter = GenerationCounter()
+
+    /// Rendered prompts and schemas, invalidated by `generation`
+    let schemaCache = SchemaCache()
+
     /// Initialize with known types from the SWAML schema
     public init(classes: Set<String> = [], enums: Set<String> = []) {
         self.knownClasses = classes
@@ -38,7 +44,9 @@ open class TypeBuilder: @unchecked Sendable {
     public func registerDynamicType(_ name: String) {
         lock.lock()
         defer { lock.unlock() }
-        dynamicTypes.insert(name)
+        if dynamicTypes.insert(name).inserted {
+            generationCounter.increment()
+        }
     }
 
     /// Register a SwamlTyped type as dynamic (if it declares isDynamic = true)
@@ -62,6 +70,14 @@ open class TypeBuilder: @unchecked Sendable {
         return dynamicTypes
     }
 
+    /// Counter that changes whenever this TypeBuilder or any of its enum, class,
+    /// value or property builders is modified
+    ///
+    /// Used to invalidate cached schema prompts and JSON Schema dictionaries.
+    public var generation: UInt64 {
+        generationCounter.value
+    }
+
     // MARK: - Primitive Type Factories
 
     /// Create a string type
@@ -130,7 +146,9 @@ open class TypeBuilder: @unchecked Sendable {
         }
 
         let builder = DynamicEnumBuilder(name: name)
+        builder.generation = generationCounter
         enumBuilders[name] = builder
+        generationCounter.increment()
         return builder
     }
 
@@ -149,7 +167,9 @@ open class TypeBuilder: @unchecked Sendable {
         }
 
         let builder = DynamicClassBuilder(name: name)
+        builder.generation = generationCounter
         classBuilders[name] = builder
+        generationCounter.increment()
         return builder
     }
 
@@ -248,46 +268,46 @@ open class TypeBuilder: @unchecked Sendable {
 
     /// Build JSON Schema for a dynamic enum (with added values)
     public func buildEnumSchema(_ name: String) -> JSONSchema? {
-        lock.lock()
-        defer { lock.unlock() }
-
-        guard let builder = enumBuilders[name] else {
-            return nil
-        }
-
-        let values = builder.allValues
-        if values.isEmpty {
-            return nil
-        }
-
-        return .enum(values: values)
+        snapshot().enumSchema(name)
     }
 
     /// Build JSON Schema for a dynamic class
     public func buildClassSchema(_ name: String) -> JSONSchema? {
-        lock.lock()
-        defer { lock.unlock() }
-
-        guard let builder = classBuilders[name] else {
-            return nil
-        }
-
-        return builder.buildSchema()
+        snapshot().classSchema(name)
     }
 
     /// Get all dynamic enum values as a dictionary
     public func dynamicEnumValues() -> [String: [String]] {
-        lock.lock()
-        defer { lock.unlock() }
+        snapshot().dynamicEnumValues
+    }
 
-        var result: [String: [String]] = [:]
-        for (name, builder) in enumBuilders {
-            let values = builder.allValues
-            if !values.isEmpty {
-                result[name] = values
-            }
+    // MARK: - Snapshots
+
+    /// An immutable view of the current dynamic types
+    ///
+    /// Returns the published snapshot while nothing has changed, without
+    /// taking a lock; the first call after a change builds and publishes a
+    /// new one.
+    public func snapshot() -> TypeBuilderSnapshot {
+        if let published = generationCounter.snapshot {
+            return published
         }
-        return result
+
+        let generation = generationCounter.value
+        lock.lock()
+        let dynamicTypes = self.dynamicTypes
+        let enumBuilders = self.enumBuilders
+        let classBuilders = self.classBuilders
+        lock.unlock()
+
+        let snapshot = TypeBuilderSnapshot(
+            generation: generation,
+            dynamicTypes: dynamicTypes,
+            enums: enumBuilders.mapValues { $0.snapshot() },
+            classes: classBuilders.mapValues { $0.snapshot() }
+        )
+        generationCounter.publish(snapshot)
+        return snapshot
     }
 
     // MARK: - FFI Serialization
@@ -325,6 +345,165 @@ open class TypeBuilder: @unchecked Sendable {
         }
         return string
     }
+
+    // MARK: - Archives
+
+    /// Write the dynamic types, with prompts and schemas ready for `types`
+    /// and `functions`, in a binary form for `load(_:types:)`
+    ///
+    /// For workers that build the same types at every start (e.g. replaying
+    /// enum values from a database): build them once, archive, and load the
+    /// archive at startup instead. Along with the types it holds:
+    /// - the schema prompt of each of `types` without a compile-time one, and
+    ///   of every dynamic class
+    /// - the native output schema of each non-dynamic type in `types`, and the
+    ///   output schema of each runtime function in `functions` (by function
+    ///   name), resolved against the dynamic enums and encoded for requests
+    ///
+    /// A type's prompt and schema are stored by `swamlTypeName`, with a
+    /// fingerprint of its schema and descriptions; on load they're skipped
+    /// for a type whose fingerprint no longer matches, rather than served
+    /// stale.
+    public func archive(types: [any SwamlTyped.Type] = [], functions: [String: JSONSchema] = [:]) -> Data {
+        let snapshot = self.snapshot()
+        var archive = TypeBuilderArchive(
+            dynamicTypes: snapshot.dynamicTypes,
+            enums: snapshot.enums.values.sorted { $0.name < $1.name },
+            classes: snapshot.classes.values.sorted { $0.name < $1.name }
+        )
+
+        for type in types {
+            archiveEntries(for: type, snapshot: snapshot, into: &archive)
+        }
+        for dynamicClass in archive.classes where !dynamicClass.properties.isEmpty {
+            archive.prompts.append(.init(
+                key: .className(dynamicClass.name),
+                text: SchemaPromptRenderer.render(className: dynamicClass.name, from: self)
+            ))
+        }
+        for (name, schema) in functions.sorted(by: { $0.key < $1.key }) {
+            let resolved = resolvedSchema(schema, for: .function(name), snapshot: snapshot)
+            archive.schemas.append(.init(key: .function(name), source: schema, schema: resolved.schema, encoded: resolved.encoded))
+        }
+        return archive.encoded()
+    }
+
+    private func archiveEntries<T: SwamlTyped>(
+        for type: T.Type,
+        snapshot: TypeBuilderSnapshot,
+        into archive: inout TypeBuilderArchive
+    ) {
+        let fingerprint = TypeBuilderArchive.fingerprint(of: T.self)
+        if T.swamlSchemaPrompt == nil {
+            archive.prompts.append(.init(
+                key: .type(T.swamlTypeName),
+                text: SchemaPromptRenderer.render(for: T.self, typeBuilder: self),
+                fingerprint: fingerprint
+            ))
+        }
+        // Dynamic types keep the schema prompt (see `SwamlClient.outputFormat(for:)`)
+        if !T.isDynamic {
+            let resolved = resolvedSchema(
+                T.swamlSchema,
+                descriptions: T.fieldDescriptions,
+                for: .output(ObjectIdentifier(T.self)),
+                snapshot: snapshot
+            )
+            archive.schemas.append(.init(
+                key: .output(T.swamlTypeName),
+                fingerprint: fingerprint,
+                source: T.swamlSchema,
+                schema: resolved.schema,
+                encoded: resolved.encoded
+            ))
+        }
+    }
+
+    private func resolvedSchema(
+        _ schema: JSONSchema,
+        descriptions: [String: String] = [:],
+        for key: SchemaCache.Key,
+        snapshot: TypeBuilderSnapshot
+    ) -> SchemaCache.ResolvedSchema {
+        schemaCache.resolvedSchema(for: key, source: schema, descriptions: descriptions, generation: snapshot.generation) {
+            schema.resolvingEnums(snapshot.dynamicEnumValues)
+        }
+    }
+
+    /// Load an archive written by `archive(types:functions:)`, replacing
+    /// this TypeBuilder's dynamic types
+    ///
+    /// The builders, the snapshot and the cached prompts and schemas are
+    /// restored as a whole, in one generation change, rather than rebuilt call
+    /// by call. Pass the types the archive was written with to restore their
+    /// prompts and schemas; entries of other types, and of types whose schema
+    /// or descriptions have changed since, are skipped.
+    ///
+    /// Builders obtained before loading are replaced, not updated: changes
+    /// made through them afterwards no longer reach this TypeBuilder. Get
+    /// them again with `enumBuilder(_:)` and `addClass(_:)`.
+    public func load(_ data: Data, types: [any SwamlTyped.Type] = []) throws {
+        let archive = try TypeBuilderArchive.decode(data)
+
+        var loadedTypes: [String: TypeBuilderArchive.LoadedType] = [:]
+        for type in types where loadedTypes[type.swamlTypeName] == nil {
+            loadedTypes[type.swamlTypeName] = TypeBuilderArchive.LoadedType(type)
+        }
+
+        let enums = Dictionary(archive.enums.map { ($0.name, $0) }, uniquingKeysWith: { _, last in last })
+        let classes = Dictionary(archive.classes.map { ($0.name, $0) }, uniquingKeysWith: { _, last in last })
+
+        lock.lock()
+        let replaced = (enums: Array(enumBuilders.values), classes: Array(classBuilders.values))
+        dynamicTypes = archive.dynamicTypes
+        enumBuilders = enums.mapValues { DynamicEnumBuilder($0, generation: generationCounter) }
+        classBuilders = classes.mapValues { DynamicClassBuilder($0, generation: generationCounter) }
+        let generation = generationCounter.increment()
+        lock.unlock()
+
+        for builder in replaced.enums {
+            builder.detach()
+        }
+        for builder in replaced.classes {
+            builder.detach()
+        }
+
+        generationCounter.publish(TypeBuilderSnapshot(
+            generation: generation,
+            dynamicTypes: archive.dynamicTypes,
+            enums: enums,
+            classes: classes
+        ))
+
+        for prompt in archive.prompts {
+            guard let key = prompt.key.cacheKey(types: loadedTypes, fingerprint: prompt.fingerprint) else { continue }
+            schemaCache.insert(prompt: prompt.text, for: key, generation: generation)
+        }
+        for schema in archive.schemas {
+            guard let key = schema.key.cacheKey(types: loadedTypes, fingerprint: schema.fingerprint) else { continue }
+            let typeDescriptions: [String: String]
+            if case .output(let name) = schema.key {
+                typeDescriptions = loadedTypes[name]?.descriptions ?? [:]
+            } else {
+                typeDescriptions = [:]
+            }
+            schemaCache.insert(
+                SchemaCache.ResolvedSchema(
+                    source: schema.source,
+                    schema: schema.schema,
+                    descriptions: typeDescriptions,
+                    encoded: schema.encoded
+                ),
+                for: key,
+                generation: generation
+            )
+        }
+    }
+
+    /// Load an archive file, memory-mapped rather than read (see `load(_:types:)`)
+    public func load(contentsOf url: URL, types: [any SwamlTyped.Type] = []) throws {
+        try load(Data(contentsOf: url, options: .alwaysMapped), types: types)
+    }
 }
 
 /// Errors that can occur during TypeBuilder operations
@@ -332,6 +511,7 @@ public enum TypeBuilderError: Error, LocalizedError {
     case serializationFailed
     case typeNotDynamic(String)
     case typeNotRegistered(String)
+    case invalidArchive(String)
 
     public var errorDescription: String? {
         switch self {
@@ -341,6 +521,8 @@ public enum TypeBuilderError: Error, LocalizedError {
             return "Cannot extend non-dynamic type '\(name)'. Add @SwamlDynamic to allow runtime extension."
         case .typeNotRegistered(let name):
             return "Type '\(name)' is not registered for dynamic extension"
+        case .invalidArchive(let reason):
+            return "Invalid TypeBuilder archive: \(reason)"
         }
     }
 }
@@ -357,16 +539,35 @@ public final class EnumValueBuilder: @unchecked Sendable {
     private var _description: String?
     private var _alias: String?
 
+    /// Counter of the owning TypeBuilder, bumped on change
+    var generation: GenerationCounter?
+
     public init(name: String) {
         self.name = name
     }
 
+    /// Restore a value from a snapshot
+    init(_ value: TypeBuilderSnapshot.Value, generation: GenerationCounter) {
+        self.name = value.name
+        self._description = value.description
+        self._alias = value.alias
+        self.generation = generation
+    }
+
+    /// Stop reporting changes to the owning TypeBuilder
+    func detach() {
+        lock.lock()
+        defer { lock.unlock() }
+        generation = nil
+    }
+
     /// Set the description for this enum value
     @discardableResult
     public func description(_ desc: String) -> EnumValueBuilder {
         lock.lock()
         defer { lock.unlock() }
         _description = desc
+        generation?.increment()
         return self
     }
 
@@ -376,6 +577,7 @@ public final class EnumValueBuilder: @unchecked Sendable {
         lock.lock()
         defer { lock.unlock() }
         _alias = alias
+        generation?.increment()
         return self
     }
 
@@ -393,6 +595,12 @@ public final class EnumValueBuilder: @unchecked Sendable {
         return _alias
     }
 
+    func snapshot() -> TypeBuilderSnapshot.Value {
+        lock.lock()
+        defer { lock.unlock() }
+        return TypeBuilderSnapshot.Value(name: name, description: _description, alias: _alias)
+    }
+
     /// Convert to serializable dictionary
     public func toSerializable() -> [String: Any] {
         lock.lock()
@@ -422,10 +630,49 @@ public class DynamicEnumBuilder: @unchecked Sendable {
     private var valueOrder: [String] = []
     private var valueBuilders: [String: EnumValueBuilder] = [:]
 
+    private var _shortlistLimit: Int?
+
+    /// Index built at a TypeBuilder generation
+    private var cachedIndex: (generation: UInt64, index: DynamicEnumIndex)?
+
+    /// Counter of the owning TypeBuilder, bumped on change
+    var generation: GenerationCounter? {
+        get {
+            lock.lock()
+            defer { lock.unlock() }
+            return _generation
+        }
+        set {
+            lock.lock()
+            defer { lock.unlock() }
+            _generation = newValue
+        }
+    }
+    private var _generation: GenerationCounter?
+
     public init(name: String) {
         self.name = name
     }
 
+    /// Restore an enum from a snapshot, without a change per value
+    init(_ snapshot: TypeBuilderSnapshot.Enum, generation: GenerationCounter) {
+        self.name = snapshot.name
+        for value in snapshot.values where valueBuilders[value.name] == nil {
+            valueOrder.append(value.name)
+            valueBuilders[value.name] = EnumValueBuilder(value, generation: generation)
+        }
+        self._shortlistLimit = snapshot.shortlistLimit
+        self._generation = generation
+    }
+
+    /// Stop reporting changes, to this enum or its values, to the owning TypeBuilder
+    func detach() {
+        generation = nil
+        for builder in allValueBuilders {
+            builder.detach()
+        }
+    }
+
     /// Add a value to this dynamic enum, returning a builder for metadata
     @discardableResult
     public func addValue(_ value: String) -> EnumValueBuilder {
@@ -437,8 +684,10 @@ public class DynamicEnumBuilder: @unchecked Sendable {
         }
 
         let builder = EnumValueBuilder(name: value)
+        builder.generation = _generation
         valueOrder.append(value)
         valueBuilders[value] = builder
+        _generation?.increment()
         return builder
     }
 
@@ -475,6 +724,68 @@ public class DynamicEnumBuilder: @unchecked Sendable {
         .reference(name)
     }
 
+    // MARK: Large Enums
+
+    /// Render only the `limit` values most relevant to each request
+    ///
+    /// For enums too large to list in every prompt. Prompts rendered for a
+    /// request (`SchemaPromptRenderer`'s `relevantTo:` parameter, which
+    /// `SwamlClient` passes the prompt to) list the values that share the most
+    /// words with it (see `DynamicEnumIndex.shortlist`); validation still
+    /// accepts every value. Pass nil to render all values again.
+    @discardableResult
+    public func shortlist(_ limit: Int?) -> DynamicEnumBuilder {
+        lock.lock()
+        defer { lock.unlock() }
+        _shortlistLimit = limit.map { max(0, $0) }
+        _generation?.increment()
+        return self
+    }
+
+    /// Number of values rendered per request, or nil for all of them
+    public var shortlistLimit: Int? {
+        lock.lock()
+        defer { lock.unlock() }
+        return _shortlistLimit
+    }
+
+    /// Hashed lookups over the values, rebuilt after a change
+    public var index: DynamicEnumIndex {
+        lock.lock()
+        let generation = _generation?.value
+        if let generation = generation, let cached = cachedIndex, cached.generation == generation {
+            lock.unlock()
+            return cached.index
+        }
+        lock.unlock()
+
+        let index = snapshot().index
+        if let generation = generation {
+            lock.lock()
+            cachedIndex = (generation, index)
+            lock.unlock()
+        }
+        return index
+    }
+
+    /// The value `text` names: the value itself, an alias, or a case- and
+    /// punctuation-folded spelling of either
+    public func resolve(_ text: String) -> String? {
+        index.resolve(text)
+    }
+
+    func snapshot() -> TypeBuilderSnapshot.Enum {
+        lock.lock()
+        let builders = valueOrder.compactMap { valueBuilders[$0] }
+        let shortlistLimit = _shortlistLimit
+        lock.unlock()
+        return TypeBuilderSnapshot.Enum(
+            name: name,
+            values: builders.map { $0.snapshot() },
+            shortlistLimit: shortlistLimit
+        )
+    }
+
     /// Convert to serializable dictionary
     public func toSerializable() -> [String: Any] {
         lock.lock()
@@ -502,17 +813,37 @@ public final class ClassPropertyBuilder: @unchecked Sendable {
     private var _description: String?
     private var _alias: String?
 
+    /// Counter of the owning TypeBuilder, bumped on change
+    var generation: GenerationCounter?
+
     public init(name: String, type: FieldType) {
         self.name = name
         self._type = type
     }
 
+    /// Restore a property from a snapshot
+    init(_ property: TypeBuilderSnapshot.Property, generation: GenerationCounter) {
+        self.name = property.name
+        self._type = property.type
+        self._description = property.description
+        self._alias = property.alias
+        self.generation = generation
+    }
+
+    /// Stop reporting changes to the owning TypeBuilder
+    func detach() {
+        lock.lock()
+        defer { lock.unlock() }
+        generation = nil
+    }
+
     /// Set the description for this property
     @discardableResult
     public func description(_ desc: String) -> ClassPropertyBuilder {
         lock.lock()
         defer { lock.unlock() }
         _description = desc
+        generation?.increment()
         return self
     }
 
@@ -522,6 +853,7 @@ public final class ClassPropertyBuilder: @unchecked Sendable {
         lock.lock()
         defer { lock.unlock() }
         _alias = alias
+        generation?.increment()
         return self
     }
 
@@ -546,6 +878,12 @@ public final class ClassPropertyBuilder: @unchecked Sendable {
         return _alias
     }
 
+    func snapshot() -> TypeBuilderSnapshot.Property {
+        lock.lock()
+        defer { lock.unlock() }
+        return TypeBuilderSnapshot.Property(name: name, type: _type, description: _description, alias: _alias)
+    }
+
     /// Convert to serializable dictionary
     public func toSerializable() -> [String: Any] {
         lock.lock()
@@ -578,10 +916,43 @@ public final class DynamicClassBuilder: @unchecked Sendable {
     private var propertyOrder: [String] = []
     private var propertyBuilders: [String: ClassPropertyBuilder] = [:]
 
+    /// Counter of the owning TypeBuilder, bumped on change
+    var generation: GenerationCounter? {
+        get {
+            lock.lock()
+            defer { lock.unlock() }
+            return _generation
+        }
+        set {
+            lock.lock()
+            defer { lock.unlock() }
+            _generation = newValue
+        }
+    }
+    private var _generation: GenerationCounter?
+
     public init(name: String) {
         self.name = name
     }
 
+    /// Restore a class from a snapshot, without a change per property
+    init(_ snapshot: TypeBuilderSnapshot.Class, generation: GenerationCounter) {
+        self.name = snapshot.name
+        for property in snapshot.properties where propertyBuilders[property.name] == nil {
+            propertyOrder.append(property.name)
+            propertyBuilders[property.name] = ClassPropertyBuilder(property, generation: generation)
+        }
+        self._generation = generation
+    }
+
+    /// Stop reporting changes, to this class or its properties, to the owning TypeBuilder
+    func detach() {
+        generation = nil
+        for builder in allPropertyBuilders {
+            builder.detach()
+        }
+    }
+
     /// Add a property to this class
     @discardableResult
     public func addProperty(_ propertyName: String, _ type: FieldType) -> ClassPropertyBuilder {
@@ -593,8 +964,10 @@ public final class DynamicClassBuilder: @unchecked Sendable {
         }
 
         let builder = ClassPropertyBuilder(name: propertyName, type: type)
+        builder.generation = _generation
         propertyOrder.append(propertyName)
         propertyBuilders[propertyName] = builder
+        _generation?.increment()
         return builder
     }
 
@@ -631,6 +1004,13 @@ public final class DynamicClassBuilder: @unchecked Sendable {
         .reference(name)
     }
 
+    func snapshot() -> TypeBuilderSnapshot.Class {
+        lock.lock()
+        let builders = propertyOrder.compactMap { propertyBuilders[$0] }
+        lock.unlock()
+        return TypeBuilderSnapshot.Class(name: name, properties: builders.map { $0.snapshot() })
+    }
+
     /// Convert to serializable dictionary
     public func toSerializable() -> [String: Any] {
         lock.lock()
@@ -0,0 +1,544 @@
+import Foundation
+
+// MARK: - TypeBuilder Archive
+
+/// Binary form of a built TypeBuilder, with the prompts and schemas cached for it
+///
+/// Written by `TypeBuilder.archive(types:functions:)` and read back by
+/// `TypeBuilder.load(_:types:)`, so a worker starts from the finished types
+/// rather than replaying every builder call, and from rendered prompts and
+/// resolved schemas rather than producing them on its first requests.
+///
+/// Layout, little-endian: the `"STB1"` magic, then the dynamic type names,
+/// enums, classes, prompts and schemas, each a `UInt32` count followed by its
+/// entries. Strings are a `UInt32` byte count and UTF-8, optionals a presence
+/// byte, and `FieldType`s and `JSONSchema`s a case tag followed by its
+/// payload. A type's prompt and schema carry the fingerprint of the type they
+/// were produced from (two `UInt64`s). Decoding reads straight from the
+/// (memory-mapped) bytes and checks every length and integer, so a truncated
+/// or foreign file throws.
+struct TypeBuilderArchive {
+    /// What a cached entry was produced for, by name: type identities don't
+    /// outlive the process
+    enum Key: Equatable {
+        /// `SchemaPromptRenderer.render(for:)` of a SwamlTyped type, with descriptions
+        case type(String)
+
+        /// `SchemaPromptRenderer.render(className:from:)` of a dynamic class
+        case className(String)
+
+        /// Output schema of a runtime function
+        case function(String)
+
+        /// Native output schema of a SwamlTyped type
+        case output(String)
+
+        /// The cache key in this process, or nil for a type that wasn't
+        /// passed in or that has changed since the entry was written
+        func cacheKey(types: [String: LoadedType], fingerprint: ResponseCacheKey?) -> SchemaCache.Key? {
+            switch self {
+            case .type(let name):
+                guard let type = types[name], type.fingerprint == fingerprint else { return nil }
+                return .type(type.identity, includeDescriptions: true)
+            case .className(let name):
+                return .className(name)
+            case .function(let name):
+                return .function(name)
+            case .output(let name):
+                guard let type = types[name], type.fingerprint == fingerprint else { return nil }
+                return .output(type.identity)
+            }
+        }
+    }
+
+    /// A type passed to `TypeBuilder.load(_:types:)`
+    struct LoadedType {
+        let identity: ObjectIdentifier
+        let fingerprint: ResponseCacheKey
+        let descriptions: [String: String]
+
+        init(_ type: any SwamlTyped.Type) {
+            self.identity = ObjectIdentifier(type)
+            self.fingerprint = TypeBuilderArchive.fingerprint(of: type)
+            self.descriptions = type.fieldDescriptions
+        }
+    }
+
+    /// Hash of the schema and descriptions a type's entries are produced from
+    static func fingerprint(of type: any SwamlTyped.Type) -> ResponseCacheKey {
+        var writer = Writer()
+        writer.schema(type.swamlSchema)
+        let descriptions = type.fieldDescriptions.sorted { $0.key < $1.key }
+        writer.count(descriptions.count)
+        for (name, description) in descriptions {
+            writer.string(name)
+            writer.string(description)
+        }
+        return ResponseCacheKey(hashing: writer.bytes)
+    }
+
+    struct Prompt {
+        let key: Key
+        let text: String
+
+        /// `fingerprint(of:)` of the type, for a `.type` entry
+        var fingerprint: ResponseCacheKey? = nil
+    }
+
+    struct Schema {
+        let key: Key
+
+        /// `fingerprint(of:)` of the type, for an `.output` entry
+        var fingerprint: ResponseCacheKey? = nil
+
+        /// The schema as passed in by the caller
+        let source: JSONSchema
+
+        /// The schema with dynamic enums merged in
+        let schema: JSONSchema
+
+        /// `schema` encoded for request bodies
+        let encoded: EncodedJSON
+    }
+
+    var dynamicTypes: Set<String> = []
+    var enums: [TypeBuilderSnapshot.Enum] = []
+    var classes: [TypeBuilderSnapshot.Class] = []
+    var prompts: [Prompt] = []
+    var schemas: [Schema] = []
+
+    /// `"STB1"`, at the start of every archive
+    static let magic: UInt32 = 0x3142_5453
+
+    // MARK: Encoding
+
+    func encoded() -> Data {
+        var writer = Writer()
+        writer.integer(Self.magic)
+
+        writer.count(dynamicTypes.count)
+        for name in dynamicTypes.sorted() {
+            writer.string(name)
+        }
+
+        writer.count(enums.count)
+        for dynamicEnum in enums {
+            writer.string(dynamicEnum.name)
+            writer.optional(dynamicEnum.shortlistLimit) { $0.integer(Int64($1)) }
+            writer.count(dynamicEnum.values.count)
+            for value in dynamicEnum.values {
+                writer.string(value.name)
+                writer.optional(value.description) { $0.string($1) }
+                writer.optional(value.alias) { $0.string($1) }
+            }
+        }
+
+        writer.count(classes.count)
+        for dynamicClass in classes {
+            writer.string(dynamicClass.name)
+            writer.count(dynamicClass.properties.count)
+            for property in dynamicClass.properties {
+                writer.string(property.name)
+                writer.fieldType(property.type)
+                writer.optional(property.description) { $0.string($1) }
+                writer.optional(property.alias) { $0.string($1) }
+            }
+        }
+
+        writer.count(prompts.count)
+        for prompt in prompts {
+            writer.key(prompt.key)
+            writer.optional(prompt.fingerprint) { $0.fingerprint($1) }
+            writer.string(prompt.text)
+        }
+
+        writer.count(schemas.count)
+        for schema in schemas {
+            writer.key(schema.key)
+            writer.optional(schema.fingerprint) { $0.fingerprint($1) }
+            writer.schema(schema.source)
+            writer.schema(schema.schema)
+            writer.count(schema.encoded.bytes.count)
+            writer.bytes.append(contentsOf: schema.encoded.bytes)
+        }
+
+        return Data(writer.bytes)
+    }
+
+    static func decode(_ data: Data) throws -> TypeBuilderArchive {
+        try data.withUnsafeBytes { buffer in
+            var reader = Reader(buffer)
+            guard try reader.integer(UInt32.self) == Self.magic else {
+                throw TypeBuilderError.invalidArchive("not a TypeBuilder archive")
+            }
+
+            var archive = TypeBuilderArchive()
+            for _ in 0..<(try reader.count()) {
+                archive.dynamicTypes.insert(try reader.string())
+            }
+
+            for _ in 0..<(try reader.count()) {
+                let name = try reader.string()
+                let shortlistLimit = try reader.optional { try $0.int() }
+                var values: [TypeBuilderSnapshot.Value] = []
+                for _ in 0..<(try reader.count()) {
+                    values.append(TypeBuilderSnapshot.Value(
+                        name: try reader.string(),
+                        description: try reader.optional { try $0.string() },
+                        alias: try reader.optional { try $0.string() }
+                    ))
+                }
+                archive.enums.append(TypeBuilderSnapshot.Enum(name: name, values: values, shortlistLimit: shortlistLimit))
+            }
+
+            for _ in 0..<(try reader.count()) {
+                let name = try reader.string()
+                var properties: [TypeBuilderSnapshot.Property] = []
+                for _ in 0..<(try reader.count()) {
+                    properties.append(TypeBuilderSnapshot.Property(
+                        name: try reader.string(),
+                        type: try reader.fieldType(),
+                        description: try reader.optional { try $0.string() },
+                        alias: try reader.optional { try $0.string() }
+                    ))
+                }
+                archive.classes.append(TypeBuilderSnapshot.Class(name: name, properties: properties))
+            }
+
+            for _ in 0..<(try reader.count()) {
+                let key = try reader.key()
+                let fingerprint = try reader.optional { try $0.fingerprint() }
+                archive.prompts.append(Prompt(key: key, text: try reader.string(), fingerprint: fingerprint))
+            }
+
+            for _ in 0..<(try reader.count()) {
+                let key = try reader.key()
+                let fingerprint = try reader.optional { try $0.fingerprint() }
+                let source = try reader.schema()
+                let schema = try reader.schema()
+                let length = try reader.count()
+                let encoded = EncodedJSON(bytes: Array(try reader.bytes(length)))
+                archive.schemas.append(Schema(
+                    key: key,
+                    fingerprint: fingerprint,
+                    source: source,
+                    schema: schema,
+                    encoded: encoded
+                ))
+            }
+
+            guard reader.isAtEnd else {
+                throw TypeBuilderError.invalidArchive("unexpected bytes after the last section")
+            }
+            return archive
+        }
+    }
+
+    // MARK: Writer
+
+    private struct Writer {
+        var bytes: [UInt8] = []
+
+        mutating func integer<T: FixedWidthInteger>(_ value: T) {
+            withUnsafeBytes(of: value.littleEndian) { bytes.append(contentsOf: $0) }
+        }
+
+        mutating func count(_ count: Int) {
+            integer(UInt32(count))
+        }
+
+        mutating func tag(_ tag: UInt8) {
+            bytes.append(tag)
+        }
+
+        mutating func string(_ string: String) {
+            count(string.utf8.count)
+            bytes.append(contentsOf: string.utf8)
+        }
+
+        mutating func optional<T>(_ value: T?, _ write: (inout Writer, T) -> Void) {
+            guard let value = value else {
+                tag(0)
+                return
+            }
+            tag(1)
+            write(&self, value)
+        }
+
+        mutating func fingerprint(_ fingerprint: ResponseCacheKey) {
+            integer(fingerprint.high)
+            integer(fingerprint.low)
+        }
+
+        mutating func key(_ key: Key) {
+            switch key {
+            case .type(let name):
+                tag(0)
+                string(name)
+            case .className(let name):
+                tag(1)
+                string(name)
+            case .function(let name):
+                tag(2)
+                string(name)
+            case .output(let name):
+                tag(3)
+                string(name)
+            }
+        }
+
+        mutating func fieldType(_ type: FieldType) {
+            switch type {
+            case .string:
+                tag(0)
+            case .int:
+                tag(1)
+            case .float:
+                tag(2)
+            case .bool:
+                tag(3)
+            case .null:
+                tag(4)
+            case .literalString(let value):
+                tag(5)
+                string(value)
+            case .literalInt(let value):
+                tag(6)
+                integer(Int64(value))
+            case .literalBool(let value):
+                tag(7)
+                tag(value ? 1 : 0)
+            case .list(let inner):
+                tag(8)
+                fieldType(inner)
+            case .map(let key, let value):
+                tag(9)
+                fieldType(key)
+                fieldType(value)
+            case .optional(let inner):
+                tag(10)
+                fieldType(inner)
+            case .union(let types):
+                tag(11)
+                count(types.count)
+                types.forEach { fieldType($0) }
+            case .reference(let name):
+                tag(12)
+                string(name)
+            }
+        }
+
+        mutating func schema(_ schema: JSONSchema) {
+            switch schema {
+            case .string:
+                tag(0)
+            case .integer:
+                tag(1)
+            case .number:
+                tag(2)
+            case .boolean:
+                tag(3)
+            case .null:
+                tag(4)
+            case .array(let items):
+                tag(5)
+                self.schema(items)
+            case .object(let properties, let required, let additionalProperties):
+                tag(6)
+                count(properties.count)
+                for name in properties.keys.sorted() {
+                    string(name)
+                    self.schema(properties[name]!)
+                }
+                count(required.count)
+                required.forEach { string($0) }
+                optional(additionalProperties) { $0.schema($1) }
+            case .enum(let values):
+                tag(7)
+                count(values.count)
+                values.forEach { string($0) }
+            case .ref(let name):
+                tag(8)
+                string(name)
+            case .anyOf(let schemas):
+                tag(9)
+                count(schemas.count)
+                schemas.forEach { self.schema($0) }
+            }
+        }
+    }
+
+    // MARK: Reader
+
+    private struct Reader {
+        private let buffer: UnsafeRawBufferPointer
+        private var offset = 0
+
+        init(_ buffer: UnsafeRawBufferPointer) {
+            self.buffer = buffer
+        }
+
+        var isAtEnd: Bool {
+            offset == buffer.count
+        }
+
+        mutating func bytes(_ count: Int) throws -> UnsafeRawBufferPointer {
+            guard count <= buffer.count - offset else {
+                throw TypeBuilderError.invalidArchive("truncated at byte \(offset)")
+            }
+            defer { offset += count }
+            return UnsafeRawBufferPointer(rebasing: buffer[offset..<(offset + count)])
+        }
+
+        mutating func integer<T: FixedWidthInteger>(_ type: T.Type) throws -> T {
+            let bytes = try bytes(MemoryLayout<T>.size)
+            return T(littleEndian: bytes.loadUnaligned(fromByteOffset: 0, as: T.self))
+        }
+
+        /// An `Int` written as `Int64`, which may not fit on 32-bit platforms
+        mutating func int() throws -> Int {
+            let value = try integer(Int64.self)
+            guard let int = Int(exactly: value) else {
+                throw TypeBuilderError.invalidArchive("integer \(value) out of range before byte \(offset)")
+            }
+            return int
+        }
+
+        /// A count of entries or bytes; every entry takes at least a byte,
+        /// so one larger than what's left is rejected before allocating
+        mutating func count() throws -> Int {
+            let value = try integer(UInt32.self)
+            guard let count = Int(exactly: value), count <= buffer.count - offset else {
+                throw TypeBuilderError.invalidArchive("truncated at byte \(offset)")
+            }
+            return count
+        }
+
+        mutating func fingerprint() throws -> ResponseCacheKey {
+            ResponseCacheKey(high: try integer(UInt64.self), low: try integer(UInt64.self))
+        }
+
+        mutating func tag() throws -> UInt8 {
+            try integer(UInt8.self)
+        }
+
+        mutating func string() throws -> String {
+            let length = try count()
+            return String(decoding: try bytes(length), as: UTF8.self)
+        }
+
+        mutating func optional<T>(_ read: (inout Reader) throws -> T) throws -> T? {
+            switch try tag() {
+            case 0:
+                return nil
+            case 1:
+                return try read(&self)
+            case let tag:
+                throw invalidTag(tag)
+            }
+        }
+
+        mutating func key() throws -> Key {
+            switch try tag() {
+            case 0:
+                return .type(try string())
+            case 1:
+                return .className(try string())
+            case 2:
+                return .function(try string())
+            case 3:
+                return .output(try string())
+            case let tag:
+                throw invalidTag(tag)
+            }
+        }
+
+        mutating func fieldType() throws -> FieldType {
+            switch try tag() {
+            case 0:
+                return .string
+            case 1:
+                return .int
+            case 2:
+                return .float
+            case 3:
+                return .bool
+            case 4:
+                return .null
+            case 5:
+                return .literalString(try string())
+            case 6:
+                return .literalInt(try int())
+            case 7:
+                return .literalBool(try tag() != 0)
+            case 8:
+                return .list(try fieldType())
+            case 9:
+                return .map(key: try fieldType(), value: try fieldType())
+            case 10:
+                return .optional(try fieldType())
+            case 11:
+                var types: [FieldType] = []
+                for _ in 0..<(try count()) {
+                    types.append(try fieldType())
+                }
+                return .union(types)
+            case 12:
+                return .reference(try string())
+            case let tag:
+                throw invalidTag(tag)
+            }
+        }
+
+        mutating func schema() throws -> JSONSchema {
+            switch try tag() {
+            case 0:
+                return .string
+            case 1:
+                return .integer
+            case 2:
+                return .number
+            case 3:
+                return .boolean
+            case 4:
+                return .null
+            case 5:
+                return .array(items: try schema())
+            case 6:
+                var properties: [String: JSONSchema] = [:]
+                for _ in 0..<(try count()) {
+                    properties[try string()] = try schema()
+                }
+                var required: [String] = []
+                for _ in 0..<(try count()) {
+                    required.append(try string())
+                }
+                return .object(
+                    properties: properties,
+                    required: required,
+                    additionalProperties: try optional { try $0.schema() }
+                )
+            case 7:
+                var values: [String] = []
+                for _ in 0..<(try count()) {
+                    values.append(try string())
+                }
+                return .enum(values: values)
+            case 8:
+                return .ref(try string())
+            case 9:
+                var schemas: [JSONSchema] = []
+                for _ in 0..<(try count()) {
+                    schemas.append(try schema())
+                }
+                return .anyOf(schemas)
+            case let tag:
+                throw invalidTag(tag)
+            }
+        }
+
+        private func invalidTag(_ tag: UInt8) -> TypeBuilderError {
+            .invalidArchive("unknown tag \(tag) before byte \(offset)")
+        }
+    }
+}
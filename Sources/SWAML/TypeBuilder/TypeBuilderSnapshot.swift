@@ -0,0 +1,168 @@
+import Foundation
+
+// MARK: - TypeBuilder Snapshot
+
+/// Immutable view of a TypeBuilder's dynamic types at one generation.
+///
+/// Reading a `TypeBuilder` takes a lock per accessor (and one per enum value or
+/// property builder touched). Request paths that read it many times, such as
+/// schema merging and prompt rendering, take one snapshot up front with
+/// `TypeBuilder.snapshot()` and read plain values from then on.
+///
+/// Snapshots are built on the first read after a change and shared until the
+/// next one, so a burst of writes costs one rebuild, not one per write.
+public struct TypeBuilderSnapshot: Sendable {
+    /// A value of a dynamic enum
+    public struct Value: Sendable, Equatable {
+        public let name: String
+        public let description: String?
+        public let alias: String?
+    }
+
+    /// A dynamic enum and its values, in insertion order
+    public struct Enum: Sendable, Equatable {
+        public let name: String
+        public let values: [Value]
+
+        /// Number of values rendered into prompts for a request, or nil for
+        /// all of them (see `DynamicEnumBuilder.shortlist(_:)`)
+        public let shortlistLimit: Int?
+
+        /// Hashed lookups over `values`
+        public let index: DynamicEnumIndex
+
+        init(name: String, values: [Value], shortlistLimit: Int? = nil) {
+            self.name = name
+            self.values = values
+            self.shortlistLimit = shortlistLimit
+            self.index = DynamicEnumIndex(values: values)
+        }
+
+        public var valueNames: [String] {
+            index.values
+        }
+
+        /// The values to render for a request
+        public func renderedValues(for query: String?) -> [String] {
+            guard let limit = shortlistLimit, let query = query else { return index.values }
+            return index.shortlist(for: query, limit: limit)
+        }
+    }
+
+    /// A property of a dynamic class
+    public struct Property: Sendable, Equatable {
+        public let name: String
+        public let type: FieldType
+        public let description: String?
+        public let alias: String?
+    }
+
+    /// A dynamic class and its properties, in insertion order
+    public struct Class: Sendable, Equatable {
+        public let name: String
+        public let properties: [Property]
+
+        /// JSON Schema of the class (see `DynamicClassBuilder.buildSchema`)
+        public let schema: JSONSchema
+
+        /// Property descriptions, by property name
+        public let descriptions: [String: String]
+
+        init(name: String, properties: [Property]) {
+            self.name = name
+            self.properties = properties
+
+            var schemas: [String: JSONSchema] = [:]
+            var descriptions: [String: String] = [:]
+            var required: [String] = []
+            for property in properties {
+                schemas[property.name] = property.type.toJSONSchema()
+                if let description = property.description {
+                    descriptions[property.name] = description
+                }
+                // All properties are required by default (non-optional)
+                if case .optional = property.type.kind {
+                    continue
+                }
+                required.append(property.name)
+            }
+            self.schema = .object(properties: schemas, required: required)
+            self.descriptions = descriptions
+        }
+    }
+
+    /// `TypeBuilder.generation` the snapshot was taken at
+    public let generation: UInt64
+
+    /// Types registered as dynamically extensible
+    public let dynamicTypes: Set<String>
+
+    /// Dynamic enums, by name (including ones without values yet)
+    public let enums: [String: Enum]
+
+    /// Dynamic classes, by name
+    public let classes: [String: Class]
+
+    /// Values of every dynamic enum that has at least one
+    public let dynamicEnumValues: [String: [String]]
+
+    /// Snapshot with no dynamic types
+    public static let empty = TypeBuilderSnapshot(generation: 0, dynamicTypes: [], enums: [:], classes: [:])
+
+    init(generation: UInt64, dynamicTypes: Set<String>, enums: [String: Enum], classes: [String: Class]) {
+        self.generation = generation
+        self.dynamicTypes = dynamicTypes
+        self.enums = enums
+        self.classes = classes
+
+        var values: [String: [String]] = [:]
+        for (name, dynamicEnum) in enums where !dynamicEnum.values.isEmpty {
+            values[name] = dynamicEnum.valueNames
+        }
+        self.dynamicEnumValues = values
+    }
+
+    /// Lookups over every dynamic enum that has at least one value
+    public var enumIndexes: [String: DynamicEnumIndex] {
+        enums.compactMapValues { $0.values.isEmpty ? nil : $0.index }
+    }
+
+    /// Whether any dynamic enum renders a shortlist rather than every value
+    public var hasShortlistedEnums: Bool {
+        enums.values.contains { $0.shortlistLimit != nil }
+    }
+
+    /// This snapshot with each shortlisted enum cut down to the values most
+    /// relevant to `query`, for rendering one request's prompt
+    ///
+    /// Only for rendering: validate against the full snapshot, so a correct
+    /// value that didn't make the shortlist is still accepted.
+    public func shortlisted(for query: String) -> TypeBuilderSnapshot {
+        guard hasShortlistedEnums else { return self }
+        return TypeBuilderSnapshot(
+            generation: generation,
+            dynamicTypes: dynamicTypes,
+            enums: enums.mapValues { dynamicEnum in
+                guard dynamicEnum.shortlistLimit != nil else { return dynamicEnum }
+                let kept = Set(dynamicEnum.renderedValues(for: query))
+                return Enum(name: dynamicEnum.name, values: dynamicEnum.values.filter { kept.contains($0.name) })
+            },
+            classes: classes
+        )
+    }
+
+    /// Check if a type is registered as dynamic
+    public func isDynamicType(_ name: String) -> Bool {
+        dynamicTypes.contains(name)
+    }
+
+    /// JSON Schema for a dynamic enum, or nil if it has no values
+    public func enumSchema(_ name: String) -> JSONSchema? {
+        dynamicEnumValues[name].map { .enum(values: $0) }
+    }
+
+    /// JSON Schema for a dynamic class
+    public func classSchema(_ name: String) -> JSONSchema? {
+        classes[name]?.schema
+    }
+}
@@ -0,0 +1,367 @@
+import Foundation
+
+// MARK: - Shapes
+
+/// Ordered key list shared by every object with the same keys
+///
+/// Objects store only their values, in key order; the keys (and the lookup
+/// index for wider objects) live here once per distinct shape.
+public final class SwamlShape: Sendable, Equatable {
+    public let keys: [String]
+
+    /// Key positions, only built for shapes too wide for a linear scan
+    private let index: [String: Int]?
+
+    /// Shapes up to this many keys are searched linearly
+    private static let linearScanLimit = 8
+
+    init(keys: [String]) {
+        self.keys = keys
+        if keys.count > Self.linearScanLimit {
+            self.index = Dictionary(keys.enumerated().map { ($1, $0) }, uniquingKeysWith: { first, _ in first })
+        } else {
+            self.index = nil
+        }
+    }
+
+    /// Position of a key, or nil if the shape doesn't have it
+    public func position(of key: String) -> Int? {
+        if let index = index {
+            return index[key]
+        }
+        return keys.firstIndex(of: key)
+    }
+
+    public static func == (lhs: SwamlShape, rhs: SwamlShape) -> Bool {
+        lhs === rhs || lhs.keys == rhs.keys
+    }
+}
+
+/// Interns shapes while building a compact value, so identical objects share
+/// one `SwamlShape` (and one copy of each key string)
+final class SwamlShapeInterner {
+    private var shapes: [[String]: SwamlShape] = [:]
+
+    func shape(for keys: [String]) -> SwamlShape {
+        if let shape = shapes[keys] {
+            return shape
+        }
+        let shape = SwamlShape(keys: keys)
+        shapes[keys] = shape
+        return shape
+    }
+}
+
+// MARK: - Compact Value
+
+/// Memory-compact, ordered representation of a parsed `SwamlValue`.
+///
+/// `SwamlValue.map` gives every object its own hashed dictionary with its own
+/// key strings, which dominates memory for large extraction results (arrays of
+/// thousands of same-shape records). `CompactSwamlValue` instead stores:
+/// - objects as a shared, interned `SwamlShape` plus a value vector, in a
+///   stable key order (the schema's required fields first, then the rest
+///   sorted)
+/// - arrays of objects that all have the same keys as a table: one column per
+///   key, with `Int`, `Double`, `Bool` and `String` columns unboxed and nested
+///   same-shape objects stored as nested tables
+///
+/// Reading goes through `SwamlValue`-like accessors; `swamlValue` materializes
+/// the ordinary tree when needed.
+public struct CompactSwamlValue: Sendable, Equatable {
+    enum Storage: Sendable, Equatable {
+        case scalar(SwamlValue)
+        case array([CompactSwamlValue])
+        case object(SwamlShape, [CompactSwamlValue])
+        case table(CompactTable)
+    }
+
+    let storage: Storage
+
+    init(storage: Storage) {
+        self.storage = storage
+    }
+
+    /// Compact a value, using `schema` (if given) to order object keys
+    public init(_ value: SwamlValue, schema: JSONSchema? = nil) {
+        self = CompactValueBuilder().compact(value, schema: schema)
+    }
+
+    // MARK: Access
+
+    /// Number of elements (arrays) or fields (objects); 0 for scalars
+    public var count: Int {
+        switch storage {
+        case .scalar:
+            return 0
+        case .array(let elements):
+            return elements.count
+        case .object(let shape, _):
+            return shape.keys.count
+        case .table(let table):
+            return table.count
+        }
+    }
+
+    /// Keys of an object, in order; empty for other values
+    public var keys: [String] {
+        if case .object(let shape, _) = storage {
+            return shape.keys
+        }
+        return []
+    }
+
+    /// Whether this is an array stored as columns
+    public var isTable: Bool {
+        if case .table = storage { return true }
+        return false
+    }
+
+    public var isArray: Bool {
+        switch storage {
+        case .array, .table:
+            return true
+        case .scalar, .object:
+            return false
+        }
+    }
+
+    public var isMap: Bool {
+        if case .object = storage { return true }
+        return false
+    }
+
+    /// The value itself, if it's not an array or object
+    public var scalarValue: SwamlValue? {
+        if case .scalar(let value) = storage { return value }
+        return nil
+    }
+
+    public var stringValue: String? { scalarValue?.stringValue }
+    public var intValue: Int? { scalarValue?.intValue }
+    public var doubleValue: Double? { scalarValue?.doubleValue }
+    public var boolValue: Bool? { scalarValue?.boolValue }
+
+    public var isNull: Bool {
+        scalarValue?.isNull ?? false
+    }
+
+    /// Access an object field by key
+    public subscript(key: String) -> CompactSwamlValue? {
+        guard case .object(let shape, let values) = storage,
+              let position = shape.position(of: key) else {
+            return nil
+        }
+        return values[position]
+    }
+
+    /// Access an array element by index
+    ///
+    /// For tables the row is assembled from the columns on each access.
+    public subscript(index: Int) -> CompactSwamlValue? {
+        guard index >= 0, index < count else { return nil }
+        switch storage {
+        case .array(let elements):
+            return elements[index]
+        case .table(let table):
+            return table.row(index)
+        case .scalar, .object:
+            return nil
+        }
+    }
+
+    /// One field of every row of a table, without assembling the rows
+    public func column(_ key: String) -> [CompactSwamlValue]? {
+        guard case .table(let table) = storage,
+              let position = table.shape.position(of: key) else {
+            return nil
+        }
+        let column = table.columns[position]
+        return (0..<table.count).map { column[$0] }
+    }
+
+    /// The equivalent `SwamlValue` tree
+    public var swamlValue: SwamlValue {
+        switch storage {
+        case .scalar(let value):
+            return value
+        case .array(let elements):
+            return .array(elements.map(\.swamlValue))
+        case .object(let shape, let values):
+            var dict: [String: SwamlValue] = [:]
+            dict.reserveCapacity(values.count)
+            for (key, value) in zip(shape.keys, values) {
+                dict[key] = value.swamlValue
+            }
+            return .map(dict)
+        case .table(let table):
+            return .array((0..<table.count).map { table.row($0).swamlValue })
+        }
+    }
+}
+
+extension SwamlValue {
+    /// A compact, ordered copy of this value (see `CompactSwamlValue`)
+    public func compacted(schema: JSONSchema? = nil) -> CompactSwamlValue {
+        CompactSwamlValue(self, schema: schema)
+    }
+}
+
+// MARK: - Tables
+
+/// Columnar storage for an array of objects with identical keys
+struct CompactTable: Sendable, Equatable {
+    let shape: SwamlShape
+    let count: Int
+
+    /// One column per key of `shape`, in the same order
+    let columns: [CompactColumn]
+
+    func row(_ index: Int) -> CompactSwamlValue {
+        CompactSwamlValue(storage: .object(shape, columns.map { $0[index] }))
+    }
+}
+
+/// The values of one key across the rows of a table
+enum CompactColumn: Sendable, Equatable {
+    case ints([Int])
+    case floats([Double])
+    case bools([Bool])
+    case strings([String])
+    case table(CompactTable)
+    case values([CompactSwamlValue])
+
+    subscript(row: Int) -> CompactSwamlValue {
+        switch self {
+        case .ints(let values):
+            return CompactSwamlValue(storage: .scalar(.int(values[row])))
+        case .floats(let values):
+            return CompactSwamlValue(storage: .scalar(.float(values[row])))
+        case .bools(let values):
+            return CompactSwamlValue(storage: .scalar(.bool(values[row])))
+        case .strings(let values):
+            return CompactSwamlValue(storage: .scalar(.string(values[row])))
+        case .table(let table):
+            return table.row(row)
+        case .values(let values):
+            return values[row]
+        }
+    }
+}
+
+// MARK: - Building
+
+struct CompactValueBuilder {
+    private let shapes = SwamlShapeInterner()
+
+    func compact(_ value: SwamlValue, schema: JSONSchema?) -> CompactSwamlValue {
+        switch value {
+        case .null, .bool, .int, .float, .string:
+            return CompactSwamlValue(storage: .scalar(value))
+
+        case .map(let dict):
+            let shape = shape(of: dict, schema: schema)
+            let values = shape.keys.map { key in
+                compact(dict[key]!, schema: Self.propertySchema(key, in: schema))
+            }
+            return CompactSwamlValue(storage: .object(shape, values))
+
+        case .array(let elements):
+            let itemSchema = Self.itemSchema(schema)
+            if let table = table(elements, schema: itemSchema) {
+                return CompactSwamlValue(storage: .table(table))
+            }
+            return CompactSwamlValue(storage: .array(elements.map { compact($0, schema: itemSchema) }))
+        }
+    }
+
+    /// Store `rows` as a table if they're all objects with the same keys
+    private func table(_ rows: [SwamlValue], schema: JSONSchema?) -> CompactTable? {
+        guard case .map(let first)? = rows.first else { return nil }
+        let keys = Set(first.keys)
+        for row in rows {
+            guard case .map(let dict) = row, dict.count == keys.count,
+                  dict.keys.allSatisfy(keys.contains) else {
+                return nil
+            }
+        }
+
+        let shape = shape(of: first, schema: schema)
+        let columns = shape.keys.map { key -> CompactColumn in
+            let values = rows.map { $0[key]! }
+            return column(values, schema: Self.propertySchema(key, in: schema))
+        }
+        return CompactTable(shape: shape, count: rows.count, columns: columns)
+    }
+
+    private func column(_ values: [SwamlValue], schema: JSONSchema?) -> CompactColumn {
+        if let ints = Self.unboxed(values, \.intStorage) {
+            return .ints(ints)
+        }
+        if let floats = Self.unboxed(values, \.floatStorage) {
+            return .floats(floats)
+        }
+        if let bools = Self.unboxed(values, \.boolValue) {
+            return .bools(bools)
+        }
+        if let strings = Self.unboxed(values, \.stringValue) {
+            return .strings(strings)
+        }
+        if let table = table(values, schema: schema) {
+            return .table(table)
+        }
+        return .values(values.map { compact($0, schema: schema) })
+    }
+
+    private static func unboxed<T>(_ values: [SwamlValue], _ extract: (SwamlValue) -> T?) -> [T]? {
+        var result: [T] = []
+        result.reserveCapacity(values.count)
+        for value in values {
+            guard let unboxed = extract(value) else { return nil }
+            result.append(unboxed)
+        }
+        return result
+    }
+
+    /// Interned shape of an object: the schema's required keys first, in
+    /// schema order, then the remaining keys sorted
+    private func shape(of dict: [String: SwamlValue], schema: JSONSchema?) -> SwamlShape {
+        var keys: [String] = []
+        keys.reserveCapacity(dict.count)
+        if case .object(_, let required, _)? = schema {
+            keys = required.filter { dict[$0] != nil }
+        }
+        if keys.count < dict.count {
+            let listed = Set(keys)
+            keys += dict.keys.filter { !listed.contains($0) }.sorted()
+        }
+        return shapes.shape(for: keys)
+    }
+
+    private static func propertySchema(_ key: String, in schema: JSONSchema?) -> JSONSchema? {
+        if case .object(let properties, _, let additional)? = schema {
+            return properties[key] ?? additional
+        }
+        return nil
+    }
+
+    private static func itemSchema(_ schema: JSONSchema?) -> JSONSchema? {
+        if case .array(let items)? = schema {
+            return items
+        }
+        return nil
+    }
+}
+
+private extension SwamlValue {
+    /// Exact-type extractors (`intValue` would also accept floats)
+    var intStorage: Int? {
+        if case .int(let value) = self { return value }
+        return nil
+    }
+
+    var floatStorage: Double? {
+        if case .float(let value) = self { return value }
+        return nil
+    }
+}
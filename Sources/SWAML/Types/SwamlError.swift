@@ -26,6 +26,12 @@ public enum SwamlError: Error, LocalizedError, Sendable {
     /// Client not found in registry
     case clientNotFound(String)
 
+    /// The call didn't finish within its deadline
+    case timeout(seconds: TimeInterval)
+
+    /// A streamed output was abandoned because it already violated its schema
+    case streamAborted(String)
+
     /// Retry limit exceeded
     case retryLimitExceeded(attempts: Int, lastError: String)
 
@@ -59,6 +65,10 @@ public enum SwamlError: Error, LocalizedError, Sendable {
             return "Invalid function call '\(name)': \(reason)"
         case .clientNotFound(let name):
             return "Client not found: \(name)"
+        case .timeout(let seconds):
+            return "Timed out after \(seconds) seconds"
+        case .streamAborted(let message):
+            return "Stream aborted: \(message)"
         case .retryLimitExceeded(let attempts, let lastError):
             return "Retry limit exceeded after \(attempts) attempts. Last error: \(lastError)"
         case .configurationError(let message):
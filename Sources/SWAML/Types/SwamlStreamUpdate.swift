@@ -0,0 +1,44 @@
+import Foundation
+
+/// A snapshot of a structured LLM call while its output is streaming in
+///
+/// `partial` always reflects everything received so far. `value` is the most
+/// recent snapshot that decodes as `T`, so it stays nil until every required
+/// field has arrived. The last update of a stream has `isFinal` set and carries
+/// the fully parsed result.
+public struct SwamlStreamUpdate<T: SwamlTyped>: Sendable {
+    /// The output parsed so far, with open strings, arrays and objects closed
+    public let partial: SwamlValue
+
+    /// The latest snapshot that decodes as the return type
+    public let value: T?
+
+    /// Whether this is the final, fully parsed result
+    public let isFinal: Bool
+
+    /// The reason the model stopped generating (final update only)
+    public let finishReason: LLMResponse.FinishReason?
+
+    /// Token usage, if the provider reported it (final update only)
+    public let usage: LLMResponse.Usage?
+
+    /// Which try produced this update (0 for the first); a retry's partials
+    /// replace those of earlier attempts
+    public let attempt: Int
+
+    public init(
+        partial: SwamlValue,
+        value: T?,
+        isFinal: Bool,
+        finishReason: LLMResponse.FinishReason? = nil,
+        usage: LLMResponse.Usage? = nil,
+        attempt: Int = 0
+    ) {
+        self.partial = partial
+        self.value = value
+        self.isFinal = isFinal
+        self.finishReason = finishReason
+        self.usage = usage
+        self.attempt = attempt
+    }
+}
@@ -39,6 +39,11 @@ public protocol SwamlTyped: Codable, Sendable {
     /// Alias mappings for properties (property name -> alias).
     /// Aliases are alternative names that can be used in LLM output.
     static var fieldAliases: [String: String] { get }
+
+    /// Output-format prompt rendered at compile time, if available.
+    /// `@SwamlType` fills this in for static types whose schema doesn't depend on
+    /// a TypeBuilder; otherwise the prompt is rendered at runtime.
+    static var swamlSchemaPrompt: String? { get }
 }
 
 // MARK: - Default Implementations
@@ -52,6 +57,9 @@ extension SwamlTyped {
 
     /// By default, no field aliases
     public static var fieldAliases: [String: String] { [:] }
+
+    /// By default, the schema prompt is rendered at runtime
+    public static var swamlSchemaPrompt: String? { nil }
 }
 
 // MARK: - Primitive Type Conformance
@@ -35,6 +35,10 @@ import SWAML
 /// - `swamlSchema`: JSON Schema representation
 /// - `fieldDescriptions`: Property descriptions from `@Description`
 /// - `isDynamic`: Whether the type can be extended at runtime
+/// - `swamlSchemaPrompt`: The output-format prompt, rendered at compile time
+///
+/// Schemas of static types are stored as `static let`. `@SwamlDynamic` types,
+/// and types referencing other types, have their prompt rendered at runtime.
 ///
 /// Example:
 /// ```swift
@@ -49,16 +53,16 @@ import SWAML
 /// ```swift
 /// extension Person: SwamlTyped {
 ///     static var swamlTypeName: String { "Person" }
-///     static var swamlSchema: JSONSchema {
-///         .object()
-///             .property("name", .string)
-///             .property("age", .integer)
-///             .build()
-///     }
+///     static let swamlSchema: JSONSchema = .object(
+///         properties: ["age": .integer, "name": .string],
+///         required: ["age", "name"]
+///     )
 ///     static var isDynamic: Bool { false }
+///     static let swamlSchemaPrompt: String? =
+///         "Answer in JSON using this schema:\n{\n  age: int,\n  name: string,\n}"
 /// }
 /// ```
-@attached(extension, conformances: SwamlTyped, names: named(swamlTypeName), named(swamlSchema), named(isDynamic), named(fieldDescriptions), named(fieldAliases))
+@attached(extension, conformances: SwamlTyped, names: named(swamlTypeName), named(swamlSchema), named(isDynamic), named(fieldDescriptions), named(fieldAliases), named(swamlSchemaPrompt))
 public macro SwamlType() = #externalMacro(module: "SwamlMacrosPlugin", type: "SwamlTypeMacro")
 
 // MARK: - SwamlDynamic Macro
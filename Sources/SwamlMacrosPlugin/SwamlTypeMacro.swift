@@ -90,7 +90,10 @@ public struct SwamlTypeMacro: ExtensionMacro {
         }
 
         // Build schema code
-        let schemaCode = buildObjectSchema(properties: properties)
+        let fields = properties
+            .map { (name: $0.name, node: schemaNode(for: $0.type), isOptional: $0.isOptional) }
+            .sorted { $0.name < $1.name }
+        let schemaCode = buildObjectSchema(fields: fields)
 
         // Build descriptions dictionary
         let descriptionsCode = buildDictionaryLiteral(descriptions)
@@ -98,15 +101,35 @@ public struct SwamlTypeMacro: ExtensionMacro {
         // Build aliases dictionary
         let aliasesCode = buildDictionaryLiteral(aliases)
 
+        // Freeze everything for static types. Dynamic types (and generic types,
+        // which can't have static stored properties) keep the runtime path.
+        guard !isDynamic, structDecl.genericParameterClause == nil else {
+            let extensionDecl: DeclSyntax = """
+            extension \(raw: typeName): SwamlTyped {
+                public static var swamlTypeName: String { "\(raw: typeName)" }
+                public static var swamlSchema: JSONSchema {
+                    \(raw: schemaCode)
+                }
+                public static var isDynamic: Bool { \(raw: isDynamic ? "true" : "false") }
+                public static var fieldDescriptions: [String: String] { \(raw: descriptionsCode) }
+                public static var fieldAliases: [String: String] { \(raw: aliasesCode) }
+            }
+            """
+
+            return [extensionDecl.cast(ExtensionDeclSyntax.self)]
+        }
+
+        let promptCode = renderObjectPrompt(fields: fields, descriptions: descriptions)
+            .map(swiftStringLiteral) ?? "nil"
+
         let extensionDecl: DeclSyntax = """
         extension \(raw: typeName): SwamlTyped {
             public static var swamlTypeName: String { "\(raw: typeName)" }
-            public static var swamlSchema: JSONSchema {
-                \(raw: schemaCode)
-            }
-            public static var isDynamic: Bool { \(raw: isDynamic ? "true" : "false") }
-            public static var fieldDescriptions: [String: String] { \(raw: descriptionsCode) }
-            public static var fieldAliases: [String: String] { \(raw: aliasesCode) }
+            public static let swamlSchema: JSONSchema = \(raw: schemaCode)
+            public static var isDynamic: Bool { false }
+            public static let fieldDescriptions: [String: String] = \(raw: descriptionsCode)
+            public static let fieldAliases: [String: String] = \(raw: aliasesCode)
+            public static let swamlSchemaPrompt: String? = \(raw: promptCode)
         }
         """
 
@@ -162,13 +185,32 @@ public struct SwamlTypeMacro: ExtensionMacro {
 
         let descriptionsCode = buildDictionaryLiteral(descriptions)
 
+        guard !isDynamic, enumDecl.genericParameterClause == nil else {
+            let extensionDecl: DeclSyntax = """
+            extension \(raw: typeName): SwamlTyped {
+                public static var swamlTypeName: String { "\(raw: typeName)" }
+                public static var swamlSchema: JSONSchema { .enum(values: [\(raw: enumValues)]) }
+                public static var isDynamic: Bool { \(raw: isDynamic ? "true" : "false") }
+                public static var fieldDescriptions: [String: String] { \(raw: descriptionsCode) }
+                public static var fieldAliases: [String: String] { [:] }
+            }
+            """
+
+            return [extensionDecl.cast(ExtensionDeclSyntax.self)]
+        }
+
+        // Same output as SchemaPromptRenderer for .enum schemas
+        let prompt = (["Answer with any of the categories:", "----"] + cases.map { "- \($0)" })
+            .joined(separator: "\n")
+
         let extensionDecl: DeclSyntax = """
         extension \(raw: typeName): SwamlTyped {
             public static var swamlTypeName: String { "\(raw: typeName)" }
-            public static var swamlSchema: JSONSchema { .enum(values: [\(raw: enumValues)]) }
-            public static var isDynamic: Bool { \(raw: isDynamic ? "true" : "false") }
-            public static var fieldDescriptions: [String: String] { \(raw: descriptionsCode) }
-            public static var fieldAliases: [String: String] { [:] }
+            public static let swamlSchema: JSONSchema = .enum(values: [\(raw: enumValues)])
+            public static var isDynamic: Bool { false }
+            public static let fieldDescriptions: [String: String] = \(raw: descriptionsCode)
+            public static let fieldAliases: [String: String] = [:]
+            public static let swamlSchemaPrompt: String? = \(raw: swiftStringLiteral(prompt))
         }
         """
 
@@ -177,22 +219,13 @@ public struct SwamlTypeMacro: ExtensionMacro {
 
     // MARK: - Helpers
 
-    private static func buildObjectSchema(properties: [(name: String, type: String, isOptional: Bool)]) -> String {
-        if properties.isEmpty {
+    private static func buildObjectSchema(fields: [(name: String, node: SchemaNode, isOptional: Bool)]) -> String {
+        if fields.isEmpty {
             return ".object(properties: [:], required: [])"
         }
 
-        var propLines: [String] = []
-        var requiredProps: [String] = []
-
-        for prop in properties {
-            let jsonSchema = swiftTypeToJSONSchema(prop.type)
-            propLines.append("\"\(prop.name)\": \(jsonSchema)")
-
-            if !prop.isOptional {
-                requiredProps.append("\"\(prop.name)\"")
-            }
-        }
+        let propLines = fields.map { "\"\($0.name)\": \($0.node.code)" }
+        let requiredProps = fields.filter { !$0.isOptional }.map { "\"\($0.name)\"" }
 
         let propsDict = "[\(propLines.joined(separator: ", "))]"
         let requiredArray = "[\(requiredProps.joined(separator: ", "))]"
@@ -200,56 +233,98 @@ public struct SwamlTypeMacro: ExtensionMacro {
         return ".object(properties: \(propsDict), required: \(requiredArray))"
     }
 
-    private static func swiftTypeToJSONSchema(_ swiftType: String) -> String {
+    /// Render the schema prompt for a struct at compile time
+    ///
+    /// Mirrors `SchemaPromptRenderer.render(for:)` without a TypeBuilder. Returns
+    /// nil when the output could differ at runtime: type references may resolve to
+    /// dynamic enums, and descriptions with escape sequences aren't unescaped here.
+    private static func renderObjectPrompt(
+        fields: [(name: String, node: SchemaNode, isOptional: Bool)],
+        descriptions: [String: String]
+    ) -> String? {
+        guard !fields.contains(where: { $0.node.containsReference }),
+              !descriptions.values.contains(where: { $0.contains("\\") }) else {
+            return nil
+        }
+
+        guard !fields.isEmpty else {
+            return "Answer in JSON using this schema:\n{}"
+        }
+
+        var lines = ["{"]
+        for field in fields {
+            if let description = descriptions[field.name] {
+                for line in description.split(separator: "\n") {
+                    lines.append("  // \(line)")
+                }
+            }
+            lines.append("  \(field.name)\(field.isOptional ? "?" : ""): \(field.node.text),")
+        }
+        lines.append("}")
+
+        return "Answer in JSON using this schema:\n\(lines.joined(separator: "\n"))"
+    }
+
+    private static func schemaNode(for swiftType: String) -> SchemaNode {
         let trimmed = swiftType.trimmingCharacters(in: .whitespaces)
 
         // Handle optionals
         if trimmed.hasSuffix("?") {
-            let inner = String(trimmed.dropLast())
-            return ".anyOf([\(swiftTypeToJSONSchema(inner)), .null])"
+            return .optional(schemaNode(for: String(trimmed.dropLast())))
         }
 
         if trimmed.hasPrefix("Optional<") && trimmed.hasSuffix(">") {
-            let inner = String(trimmed.dropFirst(9).dropLast())
-            return ".anyOf([\(swiftTypeToJSONSchema(inner)), .null])"
+            return .optional(schemaNode(for: String(trimmed.dropFirst(9).dropLast())))
         }
 
-        // Handle arrays
-        if trimmed.hasPrefix("[") && trimmed.hasSuffix("]") {
-            let inner = String(trimmed.dropFirst().dropLast())
-            return ".array(items: \(swiftTypeToJSONSchema(inner)))"
+        // Handle dictionaries (before arrays, which share the brackets)
+        if trimmed.hasPrefix("[String:") && trimmed.hasSuffix("]") {
+            return .map(schemaNode(for: String(trimmed.dropFirst(8).dropLast())))
         }
 
-        if trimmed.hasPrefix("Array<") && trimmed.hasSuffix(">") {
-            let inner = String(trimmed.dropFirst(6).dropLast())
-            return ".array(items: \(swiftTypeToJSONSchema(inner)))"
+        if trimmed.hasPrefix("Dictionary<String,") && trimmed.hasSuffix(">") {
+            return .map(schemaNode(for: String(trimmed.dropFirst(18).dropLast())))
         }
 
-        // Handle dictionaries
-        if trimmed.hasPrefix("[String:") && trimmed.hasSuffix("]") {
-            let valueType = String(trimmed.dropFirst(8).dropLast()).trimmingCharacters(in: .whitespaces)
-            return ".object(properties: [:], required: [], additionalProperties: \(swiftTypeToJSONSchema(valueType)))"
+        // Handle arrays
+        if trimmed.hasPrefix("[") && trimmed.hasSuffix("]") {
+            return .array(schemaNode(for: String(trimmed.dropFirst().dropLast())))
         }
 
-        if trimmed.hasPrefix("Dictionary<String,") && trimmed.hasSuffix(">") {
-            let rest = String(trimmed.dropFirst(18).dropLast()).trimmingCharacters(in: .whitespaces)
-            return ".object(properties: [:], required: [], additionalProperties: \(swiftTypeToJSONSchema(rest)))"
+        if trimmed.hasPrefix("Array<") && trimmed.hasSuffix(">") {
+            return .array(schemaNode(for: String(trimmed.dropFirst(6).dropLast())))
         }
 
         // Primitive types
         switch trimmed {
         case "String":
-            return ".string"
+            return .string
         case "Int", "Int8", "Int16", "Int32", "Int64", "UInt", "UInt8", "UInt16", "UInt32", "UInt64":
-            return ".integer"
+            return .integer
         case "Double", "Float", "Float32", "Float64", "CGFloat":
-            return ".number"
+            return .number
         case "Bool":
-            return ".boolean"
+            return .boolean
         default:
             // Assume it's a reference to another type
-            return ".ref(\"\(trimmed)\")"
+            return .reference(trimmed)
+        }
+    }
+
+    /// Escape text as a Swift string literal
+    private static func swiftStringLiteral(_ text: String) -> String {
+        var literal = "\""
+        for scalar in text.unicodeScalars {
+            switch scalar {
+            case "\\": literal += "\\\\"
+            case "\"": literal += "\\\""
+            case "\n": literal += "\\n"
+            case "\r": literal += "\\r"
+            case "\t": literal += "\\t"
+            default: literal.unicodeScalars.append(scalar)
+            }
         }
+        return literal + "\""
     }
 
     private static func buildDictionaryLiteral(_ dict: [String: String]) -> String {
@@ -257,11 +332,64 @@ public struct SwamlTypeMacro: ExtensionMacro {
             return "[:]"
         }
 
-        let pairs = dict.map { "\"\($0.key)\": \"\($0.value)\"" }
+        let pairs = dict.sorted { $0.key < $1.key }.map { "\"\($0.key)\": \"\($0.value)\"" }
         return "[\(pairs.joined(separator: ", "))]"
     }
 }
 
+// MARK: - Schema Node
+
+/// Property type as understood by the macro, as `JSONSchema` source and prompt text
+indirect enum SchemaNode {
+    case string
+    case integer
+    case number
+    case boolean
+    case array(SchemaNode)
+    case map(SchemaNode)
+    case optional(SchemaNode)
+    case reference(String)
+
+    /// `JSONSchema` expression
+    var code: String {
+        switch self {
+        case .string: return ".string"
+        case .integer: return ".integer"
+        case .number: return ".number"
+        case .boolean: return ".boolean"
+        case .array(let items): return ".array(items: \(items.code))"
+        case .map(let value): return ".object(properties: [:], required: [], additionalProperties: \(value.code))"
+        case .optional(let wrapped): return ".anyOf([\(wrapped.code), .null])"
+        case .reference(let name): return ".ref(\"\(name)\")"
+        }
+    }
+
+    /// Schema text, as `SchemaPromptRenderer.renderSchema` renders it
+    var text: String {
+        switch self {
+        case .string: return "string"
+        case .integer: return "int"
+        case .number: return "float"
+        case .boolean: return "bool"
+        case .array(let items): return "\(items.text)[]"
+        case .map: return "{}"
+        case .optional(let wrapped): return "\(wrapped.text) | null"
+        case .reference(let name): return name
+        }
+    }
+
+    var containsReference: Bool {
+        switch self {
+        case .string, .integer, .number, .boolean:
+            return false
+        case .array(let inner), .map(let inner), .optional(let inner):
+            return inner.containsReference
+        case .reference:
+            return true
+        }
+    }
+}
+
 /// Error type for macro expansion failures
 enum MacroError: Error, CustomStringConvertible {
     case message(String)
@@ -0,0 +1,213 @@
+import XCTest
+#if canImport(FoundationNetworking)
+import FoundationNetworking
+#endif
+@testable import SWAML
+
+final class AttachmentTests: XCTestCase {
+
+    private let pixel = Data([0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0xFF])
+
+    private func parse(_ data: Data) throws -> [String: Any] {
+        try XCTUnwrap(try JSONSerialization.jsonObject(with: data) as? [String: Any])
+    }
+
+    private func contentParts(_ body: [String: Any]) throws -> [[String: Any]] {
+        let messages = try XCTUnwrap(body["messages"] as? [[String: Any]])
+        return try XCTUnwrap(messages.last?["content"] as? [[String: Any]])
+    }
+
+    // MARK: - Request Bodies
+
+    func testOpenAIBodyEncodesAttachmentAsDataURL() async throws {
+        let client = LLMClient(provider: .openAI(apiKey: "test"))
+        let image = ChatMessage.Attachment(data: pixel, mediaType: "image/png")
+
+        var writer = JSONBodyWriter()
+        await client.writeOpenAIRequestBody(
+            into: &writer,
+            model: "gpt-4o",
+            messages: [.user("What is this?", attachments: [image])],
+            responseFormat: nil,
+            temperature: nil,
+            maxTokens: nil,
+            topP: nil,
+            stop: nil
+        )
+        XCTAssertEqual(writer.attachments.count, 1)
+
+        guard case .data(let data) = try RequestBody(writer, cache: EncodedAttachmentCache()) else {
+            return XCTFail("Expected an in-memory body")
+        }
+        let parts = try contentParts(try parse(data))
+        let url = (parts[1]["image_url"] as? [String: Any])?["url"] as? String
+        XCTAssertEqual(url, "data:image/png;base64,\(pixel.base64EncodedString())")
+    }
+
+    func testAnthropicBodyEncodesAttachmentAsSource() async throws {
+        let client = LLMClient(provider: .anthropic(apiKey: "test"))
+        let document = ChatMessage.Attachment(data: pixel, mediaType: "application/pdf")
+
+        var writer = JSONBodyWriter()
+        await client.writeAnthropicRequestBody(
+            into: &writer,
+            model: "claude",
+            messages: [.user("Summarize", attachments: [document])],
+            temperature: nil,
+            maxTokens: 50,
+            topP: nil,
+            stop: nil
+        )
+
+        guard case .data(let data) = try RequestBody(writer, cache: EncodedAttachmentCache()) else {
+            return XCTFail("Expected an in-memory body")
+        }
+        let part = try contentParts(try parse(data))[1]
+        XCTAssertEqual(part["type"] as? String, "document")
+        let source = try XCTUnwrap(part["source"] as? [String: Any])
+        XCTAssertEqual(source["media_type"] as? String, "application/pdf")
+        XCTAssertEqual(source["data"] as? String, pixel.base64EncodedString())
+    }
+
+    func testLargeFileBodyIsSpooledToDisk() async throws {
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("swaml-test-\(UUID().uuidString).jpg")
+        let contents = Data((0..<(RequestBody.spoolThreshold)).map { UInt8(truncatingIfNeeded: $0) })
+        try contents.write(to: url)
+        defer { try? FileManager.default.removeItem(at: url) }
+
+        let image = ChatMessage.Attachment(fileURL: url)
+        XCTAssertEqual(image.mediaType, "image/jpeg")
+
+        let client = LLMClient(provider: .anthropic(apiKey: "test"))
+        var writer = JSONBodyWriter()
+        await client.writeAnthropicRequestBody(
+            into: &writer,
+            model: "claude",
+            messages: [.user("Describe", attachments: [image])],
+            temperature: nil,
+            maxTokens: 50,
+            topP: nil,
+            stop: nil
+        )
+
+        let body = try RequestBody(writer, cache: EncodedAttachmentCache())
+        guard case .file(let file, let length) = body else {
+            return XCTFail("Expected a spooled body")
+        }
+        let spooled = try Data(contentsOf: file.url)
+        XCTAssertEqual(spooled.count, length)
+        let source = try XCTUnwrap(try contentParts(try parse(spooled))[1]["source"] as? [String: Any])
+        XCTAssertEqual(source["data"] as? String, contents.base64EncodedString())
+
+        var request = URLRequest(url: URL(string: "https://example.com")!)
+        try body.attach(to: &request)
+        XCTAssertNil(request.httpBodyStream)
+        XCTAssertEqual(request.httpBody, spooled)
+    }
+
+    func testFileDigestIsKeptUntilTheFileChanges() throws {
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("swaml-test-\(UUID().uuidString).png")
+        try pixel.write(to: url)
+        defer { try? FileManager.default.removeItem(at: url) }
+        let digest = FileDigest()
+
+        var reads = 0
+        func key() throws -> ResponseCacheKey {
+            try digest.key(of: url) {
+                reads += 1
+                return try Data(contentsOf: url)
+            }
+        }
+
+        let first = try key()
+        XCTAssertEqual(try key(), first)
+        XCTAssertEqual(reads, 1)
+
+        try (pixel + pixel).write(to: url)
+        XCTAssertNotEqual(try key(), first)
+        XCTAssertEqual(reads, 2)
+    }
+
+    func testCacheKeyDependsOnAttachmentContents() async {
+        let client = LLMClient(provider: .openAI(apiKey: "test"))
+
+        func key(_ data: Data) async -> ResponseCacheKey {
+            await client.cacheKey(
+                model: "gpt-4o",
+                messages: [.user("What is this?", attachments: [.init(data: data, mediaType: "image/png")])],
+                responseFormat: nil,
+                temperature: nil,
+                maxTokens: nil
+            )
+        }
+
+        let first = await key(pixel)
+        let same = await key(pixel)
+        let other = await key(Data(pixel.reversed()))
+        XCTAssertEqual(first, same)
+        XCTAssertNotEqual(first, other)
+    }
+
+    // MARK: - Encoding Cache
+
+    func testRepeatedContentIsEncodedOnce() throws {
+        let cache = EncodedAttachmentCache()
+        let image = ChatMessage.Attachment(data: pixel, mediaType: "image/png")
+
+        for _ in 0..<3 {
+            var output = Data()
+            try cache.encode(pixel, key: image.contentKey(of: pixel)) { output.append($0) }
+            XCTAssertEqual(output, pixel.base64EncodedData())
+        }
+        XCTAssertEqual(cache.count, 1)
+    }
+
+    func testLargeContentIsEncodedInChunks() throws {
+        let cache = EncodedAttachmentCache(maxEntryBytes: 0)
+        let contents = Data((0..<200_001).map { UInt8(truncatingIfNeeded: $0 &* 31) })
+
+        var chunks = 0
+        var output = Data()
+        try cache.encode(contents, key: ResponseCacheKey(hashing: contents)) {
+            chunks += 1
+            output.append($0)
+        }
+
+        XCTAssertGreaterThan(chunks, 1)
+        XCTAssertEqual(output, contents.base64EncodedData())
+        XCTAssertEqual(cache.count, 0)
+    }
+
+    func testCacheEvictsOldestPastCapacity() throws {
+        let cache = EncodedAttachmentCache(capacity: 20)
+        let a = Data(repeating: 1, count: 9)
+        let b = Data(repeating: 2, count: 9)
+
+        try cache.encode(a, key: ResponseCacheKey(hashing: a)) { _ in }
+        try cache.encode(b, key: ResponseCacheKey(hashing: b)) { _ in }
+
+        XCTAssertEqual(cache.count, 1)
+    }
+
+    // MARK: - Codable
+
+    func testDocumentAttachmentRoundTrips() throws {
+        let original = ChatMessage.user("Summarize", attachments: [.init(data: pixel, mediaType: "application/pdf")])
+
+        let decoded = try JSONDecoder().decode(ChatMessage.self, from: try JSONEncoder().encode(original))
+
+        XCTAssertEqual(decoded, original)
+    }
+
+    func testImageAttachmentDecodesAsBase64Image() throws {
+        let message = ChatMessage.user("Look", attachments: [.init(data: pixel, mediaType: "image/png")])
+
+        let decoded = try JSONDecoder().decode(ChatMessage.self, from: try JSONEncoder().encode(message))
+
+        guard case .multipart(let parts) = decoded.content, case .imageBase64(let data, let mediaType) = parts[1] else {
+            return XCTFail("Expected an imageBase64 part")
+        }
+        XCTAssertEqual(data, pixel.base64EncodedString())
+        XCTAssertEqual(mediaType, "image/png")
+    }
+}
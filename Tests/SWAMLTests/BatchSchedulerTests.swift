@@ -0,0 +1,197 @@
+import XCTest
+@testable import SWAML
+
+final class BatchSchedulerTests: XCTestCase {
+
+    /// Tracks how many operations run at once
+    actor ConcurrencyProbe {
+        private(set) var current = 0
+        private(set) var peak = 0
+        private(set) var started = 0
+
+        func enter() {
+            current += 1
+            started += 1
+            peak = max(peak, current)
+        }
+
+        func leave() {
+            current -= 1
+        }
+    }
+
+    actor AttemptCounter {
+        private var attempts: [Int: Int] = [:]
+
+        func next(_ index: Int) -> Int {
+            attempts[index, default: 0] += 1
+            return attempts[index]!
+        }
+    }
+
+    private static func sleep(milliseconds: Int) async {
+        try? await Task.sleep(nanoseconds: UInt64(milliseconds) * 1_000_000)
+    }
+
+    // MARK: - Ordering
+
+    func testOrderedResultsFollowInputOrder() async {
+        let batch = BatchSequence(inputs: Array(0..<20), maxConcurrency: 4) { value in
+            // Later inputs finish first
+            await Self.sleep(milliseconds: (20 - value) % 5)
+            return value * 2
+        }
+
+        var indices: [Int] = []
+        var outputs: [Int] = []
+        for await item in batch {
+            indices.append(item.index)
+            outputs.append(try! item.result.get())
+        }
+
+        XCTAssertEqual(indices, Array(0..<20))
+        XCTAssertEqual(outputs, (0..<20).map { $0 * 2 })
+    }
+
+    func testUnorderedResultsArriveAsTheyComplete() async {
+        let batch = BatchSequence(inputs: [0, 1, 2], maxConcurrency: 3, order: .unordered) { value in
+            await Self.sleep(milliseconds: value == 0 ? 200 : 0)
+            return value
+        }
+
+        var indices: [Int] = []
+        for await item in batch {
+            indices.append(item.index)
+        }
+
+        XCTAssertEqual(indices.count, 3)
+        XCTAssertEqual(indices.last, 0)
+        XCTAssertEqual(Set(indices), [0, 1, 2])
+    }
+
+    func testFailuresAreDeliveredInPlace() async {
+        struct Failure: Error {}
+
+        let batch = BatchSequence(inputs: [1, 2, 3], maxConcurrency: 2) { value -> Int in
+            if value == 2 { throw Failure() }
+            return value
+        }
+
+        var results: [Result<Int, Error>] = []
+        for await item in batch {
+            results.append(item.result)
+        }
+
+        XCTAssertEqual(results.count, 3)
+        XCTAssertEqual(try? results[0].get(), 1)
+        XCTAssertNil(try? results[1].get())
+        XCTAssertEqual(try? results[2].get(), 3)
+    }
+
+    func testEmptyBatch() async {
+        let batch = BatchSequence(inputs: [Int](), maxConcurrency: 4) { $0 }
+
+        var count = 0
+        for await _ in batch {
+            count += 1
+        }
+        XCTAssertEqual(count, 0)
+    }
+
+    // MARK: - Window
+
+    func testKeepsWindowFull() async {
+        let probe = ConcurrencyProbe()
+        let batch = BatchSequence(inputs: Array(0..<30), maxConcurrency: 5, order: .unordered) { value in
+            await probe.enter()
+            await Self.sleep(milliseconds: value % 3 == 0 ? 30 : 5)
+            await probe.leave()
+            return value
+        }
+
+        var count = 0
+        for await _ in batch {
+            count += 1
+        }
+
+        let peak = await probe.peak
+        XCTAssertEqual(count, 30)
+        XCTAssertEqual(peak, 5)
+    }
+
+    func testSlowConsumerStopsNewRequests() async {
+        let probe = ConcurrencyProbe()
+        let batch = BatchSequence(inputs: Array(0..<100), maxConcurrency: 3, order: .unordered) { value in
+            await probe.enter()
+            await probe.leave()
+            return value
+        }
+
+        var iterator = batch.makeAsyncIterator()
+        _ = await iterator.next()
+        await Self.sleep(milliseconds: 50)
+
+        // One delivered plus at most a window of undelivered results
+        let started = await probe.started
+        XCTAssertLessThanOrEqual(started, 4)
+    }
+
+    // MARK: - Rate Limits
+
+    func testRateLimitedRequestsAreRetried() async {
+        let counter = AttemptCounter()
+        let policy = RetryPolicy(maxRetries: 2, initialDelay: 0.01, jitter: false)
+
+        let batch = BatchSequence(inputs: [0, 1], maxConcurrency: 2, rateLimitPolicy: policy) { value -> Int in
+            let attempt = await counter.next(value)
+            if value == 1 && attempt == 1 {
+                throw SwamlError.apiError(statusCode: 429, message: "Too many requests")
+            }
+            return attempt
+        }
+
+        var attempts: [Int] = []
+        for await item in batch {
+            attempts.append(try! item.result.get())
+        }
+        XCTAssertEqual(attempts, [1, 2])
+    }
+
+    func testRateLimitRetriesAreBounded() async {
+        let policy = RetryPolicy(maxRetries: 1, initialDelay: 0.01, jitter: false)
+
+        let batch = BatchSequence(inputs: [0], maxConcurrency: 1, rateLimitPolicy: policy) { _ -> Int in
+            throw SwamlError.apiError(statusCode: 429, message: "Too many requests")
+        }
+
+        for await item in batch {
+            guard case .failure(SwamlError.apiError(let statusCode, _)) = item.result else {
+                return XCTFail("Expected rate limit error")
+            }
+            XCTAssertEqual(statusCode, 429)
+        }
+    }
+
+    // MARK: - Cancellation
+
+    func testCancellationEndsIteration() async {
+        let batch = BatchSequence(inputs: Array(0..<10), maxConcurrency: 2) { value in
+            await Self.sleep(milliseconds: 10_000)
+            return value
+        }
+
+        let task = Task {
+            var count = 0
+            for await _ in batch {
+                count += 1
+            }
+            return count
+        }
+
+        await Self.sleep(milliseconds: 20)
+        task.cancel()
+
+        let count = await task.value
+        XCTAssertEqual(count, 0)
+    }
+}
@@ -0,0 +1,125 @@
+import XCTest
+@testable import SWAML
+
+final class CallMetricsTests: XCTestCase {
+
+    /// Collects reported metrics
+    private final class Recorder: CallMetricsObserver, @unchecked Sendable {
+        private let lock = NSLock()
+        private var finished: [CallMetrics] = []
+
+        var calls: [CallMetrics] {
+            lock.lock()
+            defer { lock.unlock() }
+            return finished
+        }
+
+        func callDidFinish(_ metrics: CallMetrics) {
+            lock.lock()
+            finished.append(metrics)
+            lock.unlock()
+        }
+    }
+
+    // MARK: - Tracing
+
+    func testTraceRecordsPhasesAndParsePath() async throws {
+        let recorder = Recorder()
+        let value = try await CallTrace.run("test", tags: ["team": "search"], observer: recorder) {
+            try CallTrace.measure(.parse) {
+                try JsonishParser.parseValue("Sure! ```json\n{\"a\": 1,}\n```")
+            }
+        }
+
+        XCTAssertEqual(value["a"], .int(1))
+        let metrics = try XCTUnwrap(recorder.calls.first)
+        XCTAssertEqual(metrics.operation, "test")
+        XCTAssertEqual(metrics.tags, ["team": "search"])
+        XCTAssertEqual(metrics.parsePaths, [.codeBlock])
+        XCTAssertNotNil(metrics.phases[.parse])
+        XCTAssertGreaterThanOrEqual(metrics.duration, metrics[.parse])
+        XCTAssertNil(metrics.error)
+    }
+
+    func testNestedCallsJoinOuterTrace() async {
+        let recorder = Recorder()
+        await CallTrace.run("outer", observer: recorder) {
+            await CallTrace.run("inner", observer: recorder) {
+                CallTrace.record { $0.repairs += 1 }
+            }
+            CallTrace.record { $0.retries += 1 }
+        }
+
+        XCTAssertEqual(recorder.calls.map(\.operation), ["outer"])
+        XCTAssertEqual(recorder.calls.first?.repairs, 1)
+        XCTAssertEqual(recorder.calls.first?.retries, 1)
+    }
+
+    func testFailureIsReported() async {
+        let recorder = Recorder()
+        do {
+            _ = try await CallTrace.run("failing", observer: recorder) {
+                try JsonishParser.parseValue("no json here")
+            }
+            XCTFail("Expected a parse error")
+        } catch {}
+        XCTAssertNotNil(recorder.calls.first?.error)
+    }
+
+    func testCancellationIsNotAFailure() async {
+        let recorder = Recorder()
+        do {
+            _ = try await CallTrace.run("cancelled", observer: recorder) { () async throws -> Int in
+                throw NSError(domain: NSURLErrorDomain, code: NSURLErrorCancelled)
+            }
+        } catch {}
+        XCTAssertEqual(recorder.calls.first?.cancelled, true)
+        XCTAssertNil(recorder.calls.first?.error)
+    }
+
+    func testUntracedHooksAreNoOps() {
+        XCTAssertNil(CallTrace.current)
+        XCTAssertEqual(CallTrace.measure(.decode) { 42 }, 42)
+        CallTrace.record { $0.requests += 1 }
+    }
+
+    // MARK: - Runtime
+
+    func testRuntimeReportsTaggedMetrics() async throws {
+        let registry = ClientRegistry()
+        await registry.register(
+            name: "offline",
+            provider: .custom(baseURL: URL(string: "http://127.0.0.1:9")!, apiKey: "test"),
+            model: "m",
+            retryPolicy: .none
+        )
+        let recorder = Recorder()
+        let cache = ResponseCache()
+        let runtime = SwamlRuntime(clientRegistry: registry, responseCache: cache, metricsObserver: recorder)
+
+        let key = try await registry.getClient("offline").cacheKey(
+            model: "m",
+            messages: [.user("Name a color")],
+            responseFormat: .jsonObject,
+            temperature: nil,
+            maxTokens: nil
+        )
+        cache.store(
+            LLMResponse(content: "{\"color\": \"red\"}", model: "m", usage: nil, finishReason: .stop, id: "r"),
+            for: key
+        )
+
+        _ = try await runtime.callFunction(
+            "Color",
+            args: [:],
+            prompt: "Name a color",
+            ctx: RuntimeContext(tags: ["route": "colors"])
+        )
+
+        let metrics = try XCTUnwrap(recorder.calls.first)
+        XCTAssertEqual(metrics.operation, "Color")
+        XCTAssertEqual(metrics.tags, ["route": "colors"])
+        XCTAssertEqual(metrics.requests, 0)
+        XCTAssertNotNil(metrics.phases[.parse])
+    }
+}
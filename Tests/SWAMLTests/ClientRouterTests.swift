@@ -0,0 +1,120 @@
+import XCTest
+@testable import SWAML
+
+final class ClientRouterTests: XCTestCase {
+
+    // MARK: - Statistics
+
+    func testMovingAverages() {
+        let router = ClientRouter()
+        router.recordSuccess("a", latency: 1.0, smoothing: 0.5)
+        router.recordSuccess("a", latency: 2.0, smoothing: 0.5)
+        router.recordFailure("a", smoothing: 0.5)
+
+        let stats = router.stats(for: "a")
+        XCTAssertEqual(stats.latency, 1.5)
+        XCTAssertEqual(stats.errorRate, 0.5)
+        XCTAssertEqual(stats.calls, 3)
+        XCTAssertNil(router.stats(for: "b").latency)
+    }
+
+    // MARK: - Ranking
+
+    func testRanksHealthyClientsByLatency() {
+        let router = ClientRouter()
+        router.recordSuccess("slow", latency: 3)
+        router.recordSuccess("fast", latency: 1)
+        router.recordSuccess("flaky", latency: 0.5)
+        for _ in 0..<5 {
+            router.recordFailure("flaky")
+        }
+
+        XCTAssertEqual(router.rank(["slow", "flaky", "fast"], maxErrorRate: 0.5), ["fast", "slow", "flaky"])
+        XCTAssertEqual(router.rank(["slow", "new"], maxErrorRate: 0.5), ["new", "slow"])
+    }
+
+    func testUnhealthyClientRecovers() {
+        let router = ClientRouter(recoveryInterval: 10)
+        let start = Date()
+        router.recordSuccess("a", latency: 1, at: start)
+        router.recordSuccess("b", latency: 2, at: start)
+        for _ in 0..<5 {
+            router.recordFailure("a", at: start)
+        }
+        XCTAssertEqual(router.rank(["a", "b"], maxErrorRate: 0.5, at: start), ["b", "a"])
+
+        // Only "b" is called while "a" is benched
+        for second in stride(from: 1.0, through: 20, by: 1) {
+            router.recordSuccess("b", latency: 2, at: start + second)
+        }
+        XCTAssertEqual(router.rank(["a", "b"], maxErrorRate: 0.5, at: start + 20), ["a", "b"])
+
+        router.recordSuccess("a", latency: 1, at: start + 20)
+        XCTAssertEqual(router.rank(["a", "b"], maxErrorRate: 0.5, at: start + 20), ["a", "b"])
+    }
+
+    func testSlowSampleIsRetried() {
+        let router = ClientRouter(recoveryInterval: 10)
+        let start = Date()
+        router.recordSuccess("a", latency: 5, at: start)
+        router.recordSuccess("b", latency: 2, at: start)
+        XCTAssertEqual(router.rank(["a", "b"], maxErrorRate: 0.5, at: start + 5), ["b", "a"])
+
+        router.recordSuccess("b", latency: 2, at: start + 10)
+        XCTAssertEqual(router.rank(["a", "b"], maxErrorRate: 0.5, at: start + 10), ["a", "b"])
+
+        router.recordSuccess("a", latency: 1, at: start + 10)
+        XCTAssertEqual(router.stats(for: "a").latency, 1)
+        XCTAssertEqual(router.rank(["a", "b"], maxErrorRate: 0.5, at: start + 10), ["a", "b"])
+    }
+
+    // MARK: - Hedging
+
+    func testHedgeDelay() {
+        let router = ClientRouter()
+        let policy = RoutingPolicy(hedgePercentile: 0.9, minimumHedgeDelay: 0.5, minimumSamples: 10)
+
+        XCTAssertNil(router.hedgeDelay(for: "a", policy: .fastest))
+        XCTAssertEqual(router.hedgeDelay(for: "a", policy: policy), 0.5)
+
+        for i in 1...10 {
+            router.recordSuccess("a", latency: Double(i))
+        }
+        XCTAssertEqual(router.hedgeDelay(for: "a", policy: policy), 10)
+    }
+
+    func testWindowKeepsRecentLatencies() {
+        let router = ClientRouter()
+        let policy = RoutingPolicy(hedgePercentile: 1, minimumHedgeDelay: 0, minimumSamples: 1)
+        router.recordSuccess("a", latency: 100)
+        for _ in 0..<ClientRouter.windowSize {
+            router.recordSuccess("a", latency: 1)
+        }
+        XCTAssertEqual(router.hedgeDelay(for: "a", policy: policy), 1)
+    }
+
+    // MARK: - Runtime
+
+    func testRuntimeRoutesAndRecordsFailures() async throws {
+        let registry = ClientRegistry()
+        for name in ["a", "b"] {
+            await registry.register(
+                name: name,
+                provider: .custom(baseURL: URL(string: "http://127.0.0.1:9")!, apiKey: "test"),
+                model: "m",
+                retryPolicy: .none,
+                isDefault: name == "a"
+            )
+        }
+        let runtime = SwamlRuntime(clientRegistry: registry, routing: RoutingPolicy(clients: ["b"]))
+
+        do {
+            _ = try await runtime.callFunction("Color", args: [:], prompt: "Name a color")
+            XCTFail("Offline client should fail")
+        } catch {}
+
+        XCTAssertEqual(runtime.router.stats(for: "b").calls, 1)
+        XCTAssertGreaterThan(runtime.router.stats(for: "b").errorRate, 0)
+        XCTAssertEqual(runtime.router.stats(for: "a").calls, 0)
+    }
+}
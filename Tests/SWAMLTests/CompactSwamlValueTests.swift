@@ -0,0 +1,111 @@
+import XCTest
+@testable import SWAML
+
+final class CompactSwamlValueTests: XCTestCase {
+
+    private func records(_ count: Int) -> SwamlValue {
+        .array((0..<count).map { i in
+            .map([
+                "id": .int(i),
+                "name": .string("item \(i)"),
+                "score": .float(Double(i) / 2),
+                "active": .bool(i % 2 == 0),
+                "tags": .array([.string("a")]),
+            ])
+        })
+    }
+
+    // MARK: - Round Trip
+
+    func testRoundTrip() {
+        let values: [SwamlValue] = [
+            .null,
+            .string("x"),
+            records(3),
+            ["nested": ["list": [1, "two", nil], "empty": [:]], "n": 1.5],
+            .array([.map(["a": 1]), .map(["b": 2])]),
+            .array([]),
+        ]
+        for value in values {
+            XCTAssertEqual(value.compacted().swamlValue, value)
+        }
+    }
+
+    // MARK: - Objects
+
+    func testObjectKeysFollowSchema() {
+        let schema = JSONSchema.object(
+            properties: ["name": .string, "age": .integer, "email": .string],
+            required: ["name", "age"]
+        )
+        let compact = SwamlValue.map(["email": "a@b.c", "age": 30, "name": "Ada"]).compacted(schema: schema)
+
+        XCTAssertEqual(compact.keys, ["name", "age", "email"])
+        XCTAssertEqual(compact["age"]?.intValue, 30)
+        XCTAssertNil(compact["missing"])
+    }
+
+    func testWideShapeLookup() {
+        var dict: [String: SwamlValue] = [:]
+        for i in 0..<20 {
+            dict["field\(i)"] = .int(i)
+        }
+        let compact = SwamlValue.map(dict).compacted()
+        XCTAssertEqual(compact.count, 20)
+        XCTAssertEqual(compact["field17"]?.intValue, 17)
+    }
+
+    // MARK: - Tables
+
+    func testHomogeneousArrayIsColumnar() throws {
+        let compact = records(1000).compacted()
+        XCTAssertTrue(compact.isTable)
+        XCTAssertEqual(compact.count, 1000)
+
+        guard case .table(let table) = compact.storage else { return XCTFail("Not a table") }
+        XCTAssertEqual(table.shape.keys, ["active", "id", "name", "score", "tags"])
+        guard case .ints(let ids) = table.columns[1] else { return XCTFail("ids not unboxed") }
+        XCTAssertEqual(ids.count, 1000)
+        guard case .floats = table.columns[3] else { return XCTFail("scores not unboxed") }
+
+        let row = try XCTUnwrap(compact[42])
+        XCTAssertEqual(row["name"]?.stringValue, "item 42")
+        XCTAssertEqual(row["active"]?.boolValue, true)
+        XCTAssertEqual(compact.column("score")?[3].doubleValue, 1.5)
+    }
+
+    func testRowsShareOneShape() throws {
+        let compact = SwamlValue.array([
+            .map(["x": 1, "y": .null]),
+            .map(["x": "mixed", "y": 2]),
+        ]).compacted()
+
+        let first = try XCTUnwrap(compact[0])
+        let second = try XCTUnwrap(compact[1])
+        guard case .object(let a, _) = first.storage, case .object(let b, _) = second.storage else {
+            return XCTFail("Rows should be objects")
+        }
+        XCTAssertTrue(a === b)
+        XCTAssertEqual(second["x"]?.stringValue, "mixed")
+        XCTAssertTrue(first["y"]?.isNull ?? false)
+    }
+
+    func testMixedShapesStayArray() {
+        let compact = SwamlValue.array([.map(["a": 1]), .map(["a": 1, "b": 2]), .int(3)]).compacted()
+        XCTAssertFalse(compact.isTable)
+        XCTAssertTrue(compact.isArray)
+        XCTAssertEqual(compact[2]?.intValue, 3)
+        XCTAssertNil(compact[3])
+    }
+
+    // MARK: - Parsing
+
+    func testParseToCompactValue() throws {
+        let schema = JSONSchema.array(items: .object(properties: ["id": .integer, "label": .string], required: ["label", "id"]))
+        let compact = try OutputParser.parseToCompactValue(#"[{"id": 1, "label": "a"}, {"id": 2, "label": "b"}]"#, schema: schema)
+
+        XCTAssertTrue(compact.isTable)
+        XCTAssertEqual(compact[1]?.keys, ["label", "id"])
+        XCTAssertEqual(compact[1]?["id"]?.intValue, 2)
+    }
+}
@@ -0,0 +1,82 @@
+import XCTest
+@testable import SWAML
+
+final class CompiledPromptTests: XCTestCase {
+
+    // MARK: - Parsing
+
+    func testParsesPlaceholders() {
+        let template = PromptTemplate("Hi {{name}}, see {{ ctx.output_format }}.")
+        XCTAssertEqual(template.segments, [
+            .literal("Hi "),
+            .variable(name: "name", source: "{{name}}"),
+            .literal(", see "),
+            .variable(name: "ctx.output_format", source: "{{ ctx.output_format }}"),
+            .literal("."),
+        ])
+    }
+
+    func testMalformedPlaceholdersAreLiteral() {
+        let template = PromptTemplate("{ {{ }} {{1x}} {{ a b }} {{{ ok }} é")
+        XCTAssertEqual(template.variableNames, ["ok"])
+        XCTAssertEqual(template.render([:]), "{ {{ }} {{1x}} {{ a b }} {{{ ok }} é")
+        XCTAssertEqual(template.render(["ok": "yes"]), "{ {{ }} {{1x}} {{ a b }} {yes é")
+    }
+
+    func testBindingMergesLiterals() {
+        let bound = PromptTemplate("A {{ x }} B {{ y }}").binding(["x": "1", "y": "2"], except: ["y"])
+        XCTAssertEqual(bound.segments, [.literal("A 1 B "), .variable(name: "y", source: "{{ y }}")])
+        XCTAssertTrue(PromptTemplate("A {{ x }}").binding(["x": "1"]).isConstant)
+    }
+
+    // MARK: - Compiled Prompts
+
+    func testRenderMatchesBuild() throws {
+        let builder = PromptBuilder()
+            .system("Be {{ tone }}.\n{{ ctx.output_format }}")
+            .user("Analyze: {{ text }}")
+            .variable("tone", "brief")
+            .variable("text", "I love it")
+        let schema = JSONSchema.object(properties: ["score": .number], required: ["score"])
+
+        let compiled = try builder.compile(schema: schema, variables: ["tone", "text"])
+        XCTAssertEqual(try compiled.render(["tone": "brief", "text": "I love it"]), builder.build(schema: schema))
+    }
+
+    func testUndeclaredVariableFailsAtCompile() {
+        XCTAssertThrowsError(try PromptBuilder().user("Hi {{ name }}").compileRaw()) { error in
+            XCTAssertTrue(error.localizedDescription.contains("name"))
+        }
+        XCTAssertNoThrow(try PromptBuilder().user("Hi {{ name }}").compileRaw(variables: ["name"]))
+    }
+
+    func testMissingValueFailsAtRender() throws {
+        let compiled = try PromptBuilder().user("Hi {{ name }}").compileRaw(variables: ["name"])
+        XCTAssertThrowsError(try compiled.render([:]))
+        XCTAssertEqual(try compiled.render(["name": "Ada", "extra": "x"]), [.user("Hi Ada")])
+    }
+
+    func testDeclaredVariableOverridesBuilderValue() throws {
+        let compiled = try PromptBuilder()
+            .system("Locale: {{ locale }}")
+            .variable("locale", "en")
+            .compileRaw(variables: ["locale"])
+
+        let messages = try compiled.render(["locale": "fr"])
+        XCTAssertEqual(messages.first?.content.textValue, "Locale: fr")
+        XCTAssertEqual(messages.first?.cacheable, false)
+    }
+
+    func testFullyBoundSystemPromptIsCacheable() throws {
+        let messages = try PromptBuilder()
+            .cacheablePrefix("{{ ctx.output_format }}")
+            .system("Locale: {{ locale }}")
+            .variable("locale", "en")
+            .user("{{ q }}")
+            .compileRaw(variables: ["q"])
+            .render(["q": "Why?"])
+
+        XCTAssertEqual(messages.map(\.cacheable), [true, true, false])
+        XCTAssertEqual(messages[1].content.textValue, "Locale: en")
+    }
+}
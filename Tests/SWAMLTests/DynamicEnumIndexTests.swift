@@ -0,0 +1,129 @@
+import XCTest
+@testable import SWAML
+
+final class DynamicEnumIndexTests: XCTestCase {
+
+    struct Ticket: SwamlTyped {
+        let category: String
+
+        static var swamlTypeName: String { "Ticket" }
+        static var swamlSchema: JSONSchema {
+            .object(properties: ["category": .ref("Category")], required: ["category"])
+        }
+    }
+
+    private func categories(_ count: Int = 0) -> TypeBuilder {
+        let tb = TypeBuilder()
+        let builder = tb.enumBuilder("Category")
+        builder.addValue("Billing").alias("invoices")
+        builder.addValue("ShippingDelay").description("Orders arriving late")
+        builder.addValue("RefundRequest").description("Customer wants their money back")
+        for n in 0..<count {
+            builder.addValue("Category\(n)")
+        }
+        return tb
+    }
+
+    // MARK: - Lookups
+
+    func testResolvesValuesAliasesAndFoldedSpellings() {
+        let index = categories().enumBuilder("Category").index
+
+        XCTAssertTrue(index.contains("Billing"))
+        XCTAssertFalse(index.contains("billing"))
+        XCTAssertEqual(index.resolve("Billing"), "Billing")
+        XCTAssertEqual(index.resolve("invoices"), "Billing")
+        XCTAssertEqual(index.resolve("INVOICES"), "Billing")
+        XCTAssertEqual(index.resolve("shipping_delay"), "ShippingDelay")
+        XCTAssertEqual(index.resolve(" Refund request "), "RefundRequest")
+        XCTAssertNil(index.resolve("Returns"))
+    }
+
+    func testAmbiguousFoldedSpellingResolvesToNeither() {
+        let builder = DynamicEnumBuilder(name: "Status")
+        builder.addValue("in-progress")
+        builder.addValue("InProgress")
+
+        XCTAssertNil(builder.resolve("in progress"))
+        XCTAssertEqual(builder.resolve("InProgress"), "InProgress")
+    }
+
+    func testIndexIsRebuiltAfterChange() {
+        let tb = categories()
+        let builder = tb.enumBuilder("Category")
+        XCTAssertNil(builder.resolve("Warranty"))
+
+        builder.addValue("WarrantyClaim").alias("warranty")
+
+        XCTAssertEqual(builder.resolve("Warranty"), "WarrantyClaim")
+        XCTAssertEqual(tb.snapshot().enums["Category"]?.index.count, 4)
+    }
+
+    func testRepairResolvesAliases() throws {
+        let repair = SchemaRepair(for: Ticket.self, typeBuilder: categories())
+
+        let result = try XCTUnwrap(repair.repair(["category": "Invoices"]))
+
+        XCTAssertEqual(result.value, ["category": "Billing"])
+        XCTAssertEqual(result.fixes, [.matchedEnum])
+    }
+
+    // MARK: - Shortlists
+
+    func testShortlistRanksByRelevance() {
+        let index = categories(100).enumBuilder("Category").index
+
+        let shortlist = index.shortlist(for: "My order is late and I want a refund", limit: 2)
+
+        XCTAssertEqual(shortlist, ["ShippingDelay", "RefundRequest"])
+    }
+
+    func testShortlistFillsInInsertionOrder() {
+        let index = categories(10).enumBuilder("Category").index
+
+        XCTAssertEqual(index.shortlist(for: "nothing relevant", limit: 2), ["Billing", "ShippingDelay"])
+        XCTAssertEqual(index.shortlist(for: "anything", limit: 50).count, 13)
+    }
+
+    func testShortlistedPromptListsRelevantValues() {
+        let tb = categories(500)
+        tb.enumBuilder("Category").shortlist(3)
+
+        let prompt = SchemaPromptRenderer.render(
+            for: Ticket.self,
+            typeBuilder: tb,
+            relevantTo: "Where is my refund? The parcel arrived late."
+        )
+
+        XCTAssertTrue(prompt.contains("\"RefundRequest\""))
+        XCTAssertTrue(prompt.contains("\"ShippingDelay\""))
+        XCTAssertFalse(prompt.contains("\"Category499\""))
+
+        // Without a request, and in validation, every value still counts
+        XCTAssertTrue(SchemaPromptRenderer.render(for: Ticket.self, typeBuilder: tb).contains("\"Category499\""))
+        let plan = SchemaPlan(schema: Ticket.swamlSchema, typeBuilder: tb)
+        XCTAssertNoThrow(try plan.validate(["category": "Category499"]))
+    }
+
+    func testShortlistedPromptsAreNotCacheable() {
+        let tb = categories(50)
+        XCTAssertFalse(SchemaPromptRenderer.rendersShortlist(for: Ticket.self, typeBuilder: tb))
+        tb.enumBuilder("Category").shortlist(3)
+        XCTAssertTrue(SchemaPromptRenderer.rendersShortlist(for: Ticket.self, typeBuilder: tb))
+
+        let prompt = PromptBuilder()
+            .cacheablePrefix("You sort support tickets.")
+            .system("{{ ctx.output_format }}")
+            .user("{{ text }}")
+            .variable("text", "Where is my refund?")
+
+        let shortlisted = prompt.build(returnType: Ticket.self, typeBuilder: tb, relevantTo: "Where is my refund?")
+        XCTAssertEqual(shortlisted.map(\.cacheable), [true, false, false])
+        XCTAssertEqual(prompt.build(returnType: Ticket.self, typeBuilder: tb).map(\.cacheable), [true, true, false])
+    }
+
+    func testWords() {
+        XCTAssertEqual(DynamicEnumIndex.words(in: "ShippingDelay"), ["shipping", "delay"])
+        XCTAssertEqual(DynamicEnumIndex.words(in: "refund_requests, a"), ["refund", "request"])
+    }
+}
@@ -0,0 +1,76 @@
+import XCTest
+@testable import SWAML
+
+final class HTTPTransportTests: XCTestCase {
+
+    // MARK: - Sessions
+
+    func testSessionIsReusedPerHost() {
+        let transport = HTTPTransport()
+        let first = transport.session(for: URL(string: "https://api.openai.com/v1/chat/completions")!)
+        let second = transport.session(for: URL(string: "https://API.openai.com/v1/files")!)
+        XCTAssertTrue(first === second)
+    }
+
+    func testDifferentHostsGetDifferentSessions() {
+        let transport = HTTPTransport()
+        let openAI = transport.session(for: .openAI(apiKey: "test"))
+        let anthropic = transport.session(for: .anthropic(apiKey: "test"))
+        XCTAssertFalse(openAI === anthropic)
+    }
+
+    func testHostKeyIncludesPort() {
+        XCTAssertEqual(HTTPTransport.hostKey(for: URL(string: "https://example.com/v1")!), "https://example.com:443")
+        XCTAssertEqual(HTTPTransport.hostKey(for: URL(string: "http://localhost:8080/v1")!), "http://localhost:8080")
+    }
+
+    func testSessionConfiguration() {
+        let transport = HTTPTransport(configuration: HTTPTransportConfiguration(
+            maxConnectionsPerHost: 12,
+            requestTimeout: 30,
+            resourceTimeout: 90
+        ))
+        let config = transport.session(for: .openAI(apiKey: "test")).configuration
+
+        XCTAssertEqual(config.httpMaximumConnectionsPerHost, 12)
+        XCTAssertEqual(config.timeoutIntervalForRequest, 30)
+        XCTAssertEqual(config.timeoutIntervalForResource, 90)
+        XCTAssertNil(config.urlCache)
+    }
+
+    func testRegistryClientsUseTransportSession() async throws {
+        let transport = HTTPTransport()
+        let registry = ClientRegistry(transport: transport)
+        await registry.register(name: "a", provider: .openAI(apiKey: "test"), model: "gpt-4o")
+
+        let client = try await registry.getClient("a")
+        let session = await client.session
+        XCTAssertTrue(session === transport.session(for: .openAI(apiKey: "test")))
+    }
+
+    // MARK: - Deadlines
+
+    func testDeadlineReturnsResultInTime() async throws {
+        let value = try await withDeadline(5) { 42 }
+        XCTAssertEqual(value, 42)
+    }
+
+    func testDeadlineThrowsTimeout() async {
+        do {
+            _ = try await withDeadline(0.05) { () -> Int in
+                try await Task.sleep(nanoseconds: 5_000_000_000)
+                return 1
+            }
+            XCTFail("Expected a timeout")
+        } catch SwamlError.timeout(let seconds) {
+            XCTAssertEqual(seconds, 0.05)
+        } catch {
+            XCTFail("Expected timeout, got \(error)")
+        }
+    }
+
+    func testNoDeadlineRunsOperation() async throws {
+        let value = try await withDeadline(nil) { "done" }
+        XCTAssertEqual(value, "done")
+    }
+}
@@ -0,0 +1,166 @@
+import XCTest
+@testable import SWAML
+
+final class JSONBodyWriterTests: XCTestCase {
+
+    private func parse(_ bytes: [UInt8]) throws -> Any {
+        try JSONSerialization.jsonObject(with: Data(bytes), options: [.fragmentsAllowed])
+    }
+
+    // MARK: - Writer
+
+    func testWritesNestedContainers() throws {
+        var writer = JSONBodyWriter()
+        writer.beginObject()
+        writer.key("a")
+        writer.value(1)
+        writer.key("b")
+        writer.beginArray()
+        writer.value("x")
+        writer.value(true)
+        writer.null()
+        writer.endArray()
+        writer.key("c")
+        writer.beginObject()
+        writer.endObject()
+        writer.endObject()
+
+        XCTAssertEqual(String(decoding: writer.bytes, as: UTF8.self), #"{"a":1,"b":["x",true,null],"c":{}}"#)
+    }
+
+    func testEscapesStrings() throws {
+        let text = "quote \" backslash \\ newline \n tab \t bell \u{07} unicode é 🎉"
+        var writer = JSONBodyWriter()
+        writer.value(text)
+        XCTAssertEqual(try parse(writer.bytes) as? String, text)
+    }
+
+    func testDoubles() throws {
+        var writer = JSONBodyWriter()
+        writer.beginArray()
+        writer.value(0.7)
+        writer.value(1e-05)
+        writer.value(Double.nan)
+        writer.endArray()
+
+        let array = try parse(writer.bytes) as? [Any]
+        XCTAssertEqual(array?[0] as? Double, 0.7)
+        XCTAssertEqual(array?[1] as? Double, 1e-05)
+        XCTAssertTrue(array?[2] is NSNull)
+    }
+
+    func testAnyValueSortsKeys() {
+        let encoded = EncodedJSON(any: ["b": 1, "a": ["z": false, "y": [1.5, "s"]]] as [String: Any])
+        XCTAssertEqual(String(decoding: encoded.bytes, as: UTF8.self), #"{"a":{"y":[1.5,"s"],"z":false},"b":1}"#)
+    }
+
+    func testAnyValueFromJSONSerializationKeepsNumbers() throws {
+        let parsed = try JSONSerialization.jsonObject(with: Data(#"{"minimum":1,"flag":true,"ratio":0.5}"#.utf8))
+        let encoded = EncodedJSON(any: parsed)
+        let reparsed = try parse(encoded.bytes) as? [String: Any]
+
+        XCTAssertEqual(reparsed?["minimum"] as? Int, 1)
+        XCTAssertEqual(reparsed?["flag"] as? Bool, true)
+        XCTAssertEqual(reparsed?["ratio"] as? Double, 0.5)
+    }
+
+    func testSplicesEncodedValues() {
+        let schema = EncodedJSON(any: ["type": "string"])
+        var writer = JSONBodyWriter()
+        writer.beginObject()
+        writer.key("schema")
+        writer.value(schema)
+        writer.key("n")
+        writer.value(2)
+        writer.endObject()
+
+        XCTAssertEqual(String(decoding: writer.bytes, as: UTF8.self), #"{"schema":{"type":"string"},"n":2}"#)
+    }
+
+    // MARK: - Request Bodies
+
+    func testOpenAIRequestBody() async throws {
+        let client = LLMClient(provider: .openAI(apiKey: "test"))
+        let schema = JSONSchema.object(properties: ["name": .string], required: ["name"])
+
+        var writer = JSONBodyWriter()
+        await client.writeOpenAIRequestBody(
+            into: &writer,
+            model: "gpt-4o",
+            messages: [.system("Answer in JSON:\n{ name: string }"), .user("Hi \"there\"")],
+            responseFormat: .jsonSchema(name: "Person", schema: schema.toDictionary(), strict: true),
+            temperature: 0.2,
+            maxTokens: 100,
+            topP: nil,
+            stop: ["END"],
+            stream: true
+        )
+
+        let body = try XCTUnwrap(try parse(writer.bytes) as? [String: Any])
+        XCTAssertEqual(body["model"] as? String, "gpt-4o")
+        XCTAssertEqual(body["temperature"] as? Double, 0.2)
+        XCTAssertEqual(body["max_tokens"] as? Int, 100)
+        XCTAssertEqual(body["stop"] as? [String], ["END"])
+        XCTAssertEqual(body["stream"] as? Bool, true)
+        XCTAssertNil(body["top_p"])
+
+        let messages = try XCTUnwrap(body["messages"] as? [[String: Any]])
+        XCTAssertEqual(messages.map { $0["role"] as? String }, ["system", "user"])
+        XCTAssertEqual(messages[0]["content"] as? String, "Answer in JSON:\n{ name: string }")
+        XCTAssertEqual(messages[1]["content"] as? String, "Hi \"there\"")
+
+        let format = try XCTUnwrap(body["response_format"] as? [String: Any])
+        let jsonSchema = try XCTUnwrap(format["json_schema"] as? [String: Any])
+        XCTAssertEqual(format["type"] as? String, "json_schema")
+        XCTAssertEqual(jsonSchema["name"] as? String, "Person")
+        XCTAssertEqual((jsonSchema["schema"] as? [String: Any])?["required"] as? [String], ["name"])
+    }
+
+    func testPreEncodedSchemaMatchesDictionary() async {
+        let client = LLMClient(provider: .openAI(apiKey: "test"))
+        let schema = JSONSchema.object(properties: ["a": .integer, "b": .array(items: .string)], required: ["a"])
+        let dictionary = schema.toDictionary()
+
+        func body(_ encoded: EncodedJSON?) async -> [UInt8] {
+            var writer = JSONBodyWriter()
+            await client.writeOpenAIRequestBody(
+                into: &writer,
+                model: "m",
+                messages: [.user("x")],
+                responseFormat: .jsonSchema(name: "S", schema: dictionary, strict: true),
+                encodedSchema: encoded,
+                temperature: nil,
+                maxTokens: nil,
+                topP: nil,
+                stop: nil
+            )
+            return writer.bytes
+        }
+
+        let plain = await body(nil)
+        let spliced = await body(EncodedJSON(any: dictionary))
+        XCTAssertEqual(plain, spliced)
+    }
+
+    func testAnthropicRequestBodySeparatesSystem() async throws {
+        let client = LLMClient(provider: .anthropic(apiKey: "test"))
+
+        var writer = JSONBodyWriter()
+        await client.writeAnthropicRequestBody(
+            into: &writer,
+            model: "claude",
+            messages: [.system("Be brief"), .user("Hello")],
+            temperature: nil,
+            maxTokens: 50,
+            topP: nil,
+            stop: nil
+        )
+
+        let body = try XCTUnwrap(try parse(writer.bytes) as? [String: Any])
+        XCTAssertEqual(body["system"] as? String, "Be brief")
+        XCTAssertEqual(body["max_tokens"] as? Int, 50)
+        let messages = try XCTUnwrap(body["messages"] as? [[String: Any]])
+        XCTAssertEqual(messages.count, 1)
+        XCTAssertEqual(messages[0]["role"] as? String, "user")
+    }
+}
@@ -0,0 +1,98 @@
+import XCTest
+@testable import SWAML
+
+final class JSONContinuationTests: XCTestCase {
+
+    func testTracksOpenStructure() {
+        let output = JSONContinuation(#"{"items": [{"name": "wid"#)
+
+        XCTAssertTrue(output.hasStarted)
+        XCTAssertFalse(output.isComplete)
+        XCTAssertEqual(output.closingSuffix, "\"}]}")
+        XCTAssertEqual(output.openContext, "a string in an object in an array in an object")
+    }
+
+    func testStitchesContinuations() throws {
+        var output = JSONContinuation(#"{"items": ["a", "b"#)
+        output.append(#"", "c"], "count": 3"#)
+        XCTAssertFalse(output.isComplete)
+        output.append("}")
+
+        XCTAssertTrue(output.isComplete)
+        XCTAssertEqual(try JsonishParser.parseValue(output.text), ["items": ["a", "b", "c"], "count": 3])
+    }
+
+    func testStructureInsideStringsIsIgnored() {
+        var output = JSONContinuation(#"{"text": "a } and ] and \" "#)
+        XCTAssertEqual(output.openContext, "a string in an object")
+
+        output.append(#"here"}"#)
+        XCTAssertTrue(output.isComplete)
+    }
+
+    func testProseBeforeValueIsIgnored() {
+        let output = JSONContinuation(#"Here's the "data": ```json"# + "\n[1, 2")
+
+        XCTAssertEqual(output.closingSuffix, "]")
+        XCTAssertFalse(output.isComplete)
+    }
+
+    func testDropsRepeatedElement() {
+        var output = JSONContinuation(#"{"description": "a long sentence that"#)
+        output.append(#" "a long sentence that ends here"}"#)
+
+        XCTAssertEqual(output.text, #"{"description": "a long sentence that ends here"}"#)
+        XCTAssertTrue(output.isComplete)
+    }
+
+    func testKeepsPartialOverlapsAsNewText() {
+        var output = JSONContinuation(#"{"chant": "na na na na"#)
+        output.append(#" na na na na"}"#)
+
+        XCTAssertEqual(output.text, #"{"chant": "na na na na na na na na"}"#)
+    }
+
+    func testKeepsShortOverlapsAsNewText() {
+        var output = JSONContinuation("[1, 2")
+        output.append("2, 3]")
+
+        XCTAssertEqual(output.text, "[1, 22, 3]")
+    }
+
+    func testDropsCodeFenceOpeningContinuation() {
+        var output = JSONContinuation(#"{"a": 1, "#)
+        output.append("```json\n" + #""b": 2}"#)
+
+        XCTAssertEqual(output.text, #"{"a": 1, "b": 2}"#)
+    }
+
+    func testRestartReplacesOutput() {
+        var output = JSONContinuation(#"{"customer": {"name": "Ada", "em"#)
+        output.append(#"{"customer": {"name": "Ada", "email": "ada@example.com"}}"#)
+
+        XCTAssertEqual(output.text, #"{"customer": {"name": "Ada", "email": "ada@example.com"}}"#)
+        XCTAssertTrue(output.isComplete)
+    }
+
+    func testTextAfterCompletionIsKept() {
+        var output = JSONContinuation("[1]")
+        output.append(" done")
+
+        XCTAssertTrue(output.isComplete)
+        XCTAssertEqual(output.text, "[1] done")
+    }
+
+    func testTruncationFinishReasons() {
+        XCTAssertTrue(LLMResponse.FinishReason.length.isTruncation)
+        XCTAssertTrue(LLMResponse.FinishReason.maxTokens.isTruncation)
+        XCTAssertFalse(LLMResponse.FinishReason.stop.isTruncation)
+    }
+
+    func testRuntimeContextContinuations() {
+        let ctx = RuntimeContext.builder().continuations(2).build()
+
+        XCTAssertEqual(ctx.maxContinuations, 2)
+        XCTAssertEqual(ctx.child(temperature: 0.5).maxContinuations, 2)
+        XCTAssertEqual(RuntimeContext.default.maxContinuations, 0)
+    }
+}
@@ -184,6 +184,50 @@ final class JsonishParserTests: XCTestCase {
         XCTAssertEqual(result, #"{"sentiment": "positive", "confidence": 0.95}"#)
     }
 
+    // MARK: - Candidate Ranking
+
+    func testPrefersOutermostCandidate() throws {
+        let input = """
+            Result: {"outer": {"inner": [1, 2]}, "ok": true}
+            """
+        let result = try JsonishParser.parse(input)
+        XCTAssertEqual(result, #"{"outer": {"inner": [1, 2]}, "ok": true}"#)
+    }
+
+    func testUnclosedBraceDoesNotHideLaterCandidates() throws {
+        let input = #"Partial { oops, then {"a": 1}"#
+        let result = try JsonishParser.parse(input)
+        XCTAssertEqual(result, #"{"a": 1}"#)
+    }
+
+    func testQuotesInProseDoNotAffectScanning() throws {
+        let input = #"The 27" monitor costs {"price": 300} today"#
+        let result = try JsonishParser.parse(input)
+        XCTAssertEqual(result, #"{"price": 300}"#)
+    }
+
+    func testLargeChattyOutput() throws {
+        let items = (0..<1_000).map { #"{"id": \#($0), "tags": ["a", "b"], "meta": {"x": [1, {"y": 2}]}}"# }
+        let input = "Here you go {not json} ...
+" + "[" + items.joined(separator: ", ") + "]
+Done."
+        let result = try JsonishParser.parse(input)
+        let value = try SwamlValue.fromJSONString(result)
+        XCTAssertEqual(value.arrayValue?.count, 1_000)
+    }
+
+    func testStructuralIndexRanksByDepthThenPosition() {
+        let bytes = Array(#"x {"a": [1]} y [{"b": 2}] {"#.utf8)
+        let spans = JsonishStructuralIndex(bytes: bytes).spans
+        XCTAssertEqual(spans.map(\.depth), [0, 0, 1, 1])
+        XCTAssertEqual(spans.map { String(decoding: bytes[$0.range], as: UTF8.self) }, [
+            #"{"a": [1]}"#,
+            #"[{"b": 2}]"#,
+            "[1]",
+            #"{"b": 2}"#,
+        ])
+    }
+
     // MARK: - Complex Combined Cases
 
     func testCombinedFixes() throws {
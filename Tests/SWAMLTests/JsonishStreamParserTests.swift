@@ -0,0 +1,147 @@
+import XCTest
+@testable import SWAML
+
+final class JsonishStreamParserTests: XCTestCase {
+
+    private func parse(_ chunks: [String]) -> JsonishStreamParser {
+        var parser = JsonishStreamParser()
+        for chunk in chunks {
+            parser.append(chunk)
+        }
+        return parser
+    }
+
+    private func parseByCharacter(_ input: String) -> JsonishStreamParser {
+        parse(input.map { String($0) })
+    }
+
+    // MARK: - Complete Output
+
+    func testMatchesValueParserWhenFedByCharacter() throws {
+        let inputs = [
+            #"{"name": "test", "value": 42, "ratio": 0.5, "ok": true, "none": null}"#,
+            #"{name: 'test', tags: ['a', 'b',], nested: {"x": [1, [2, 3]]},}"#,
+            "{\n  // comment\n  \"a\": 1, /* inline */ \"b\": -2.5e1\n}",
+            #"{"text": "a\"b\\c\/d\n\u00e9\ud83d\udc4b", "path": "C:\temp\xyz"}"#,
+            "{\"body\": \"\"\"first\n\"quoted\" second\"\"\", \"empty\": \"\"}",
+            #"[{"id": 1}, {"id": 2}]"#,
+        ]
+
+        for input in inputs {
+            let parser = parseByCharacter(input)
+            XCTAssertTrue(parser.isComplete, input)
+            XCTAssertEqual(parser.current, try JsonishParser.parseValue(input), input)
+        }
+    }
+
+    func testSkipsSurroundingProseAndCodeFence() {
+        let parser = parse(["Sure! Here you go:\n```json\n{\"ok\"", ": true}\n```\nAnything else?"])
+        XCTAssertTrue(parser.isComplete)
+        XCTAssertEqual(parser.current, ["ok": true])
+    }
+
+    func testRecoversFromBracesInProse() {
+        let parser = parseByCharacter(#"Use {braces} or {this one} like {"a": 1}"#)
+        XCTAssertEqual(parser.current, ["a": 1])
+    }
+
+    func testIgnoresOutputAfterCompletion() {
+        var parser = parse([#"{"a": 1}"#])
+        let revision = parser.revision
+        parser.append(#" and {"b": 2}"#)
+        XCTAssertEqual(parser.current, ["a": 1])
+        XCTAssertEqual(parser.revision, revision)
+    }
+
+    // MARK: - Partial Output
+
+    func testPartialStringIsShown() {
+        let parser = parse([#"{"name": "Al"#])
+        XCTAssertFalse(parser.isComplete)
+        XCTAssertEqual(parser.current, ["name": "Al"])
+    }
+
+    func testPartialContainersAreClosed() {
+        let parser = parse([#"{"items": [1, 2, {"id""#, #": 3, "tags": ["x"#])
+        XCTAssertEqual(parser.current, ["items": [1, 2, ["id": 3, "tags": ["x"]]]])
+    }
+
+    func testIncompleteMembersAreDropped() {
+        XCTAssertEqual(parse([#"{"a": 1, "b"#]).current, ["a": 1])
+        XCTAssertEqual(parse([#"{"a": 1, "b": "#]).current, ["a": 1])
+        XCTAssertEqual(parse([#"{"a": 1, "done": tr"#]).current, ["a": 1])
+    }
+
+    func testPartialNumberIsTrimmed() {
+        XCTAssertEqual(parse([#"{"n": 12"#]).current, ["n": 12])
+        XCTAssertEqual(parse([#"{"n": 1.5e"#]).current, ["n": 1.5])
+        XCTAssertEqual(parse([#"{"n": -"#]).current, [:])
+    }
+
+    func testStreamedChunksProduceIncreasingPartials() {
+        let deltas = [#"{"title": "Stre"#, #"aming", "points": ["#, #""one", "tw"#, #"o"]}"#]
+
+        var parser = JsonishStreamParser()
+        var snapshots: [SwamlValue] = []
+        for delta in deltas {
+            parser.append(delta)
+            if let partial = parser.current {
+                snapshots.append(partial)
+            }
+        }
+
+        XCTAssertEqual(snapshots, [
+            ["title": "Stre"],
+            ["title": "Streaming", "points": []],
+            ["title": "Streaming", "points": ["one", "tw"]],
+            ["title": "Streaming", "points": ["one", "two"]],
+        ])
+    }
+
+    func testEscapeSplitAcrossChunks() {
+        let parser = parse([#"{"s": "a\"#, #"u00"#, #"e9\"#, #"nb"}"#])
+        XCTAssertEqual(parser.current, ["s": "aé\nb"])
+    }
+
+    func testNoValueBeforeStructure() {
+        var parser = JsonishStreamParser()
+        parser.append("Thinking about it...")
+        XCTAssertNil(parser.current)
+        XCTAssertEqual(parser.revision, 0)
+
+        parser.append("[")
+        XCTAssertEqual(parser.current, [])
+        XCTAssertEqual(parser.revision, 1)
+    }
+
+    func testCompletedValueCountTracksClosedValues() {
+        var parser = JsonishStreamParser()
+        parser.append(#"{"a": "par"#)
+        XCTAssertEqual(parser.completedValueCount, 0)
+
+        parser.append(#"tial", "b": [1"#)
+        XCTAssertEqual(parser.completedValueCount, 1)
+
+        parser.append("]}")
+        XCTAssertEqual(parser.completedValueCount, 4)
+    }
+
+    // MARK: - Performance
+
+    func testLargeOutputInSmallChunks() {
+        let items = (0..<1_000).map { #"{"id": \#($0), "name": "item \#($0)"}"# }
+        let input = "[" + items.joined(separator: ", ") + "]"
+
+        var parser = JsonishStreamParser()
+        var index = input.startIndex
+        while index < input.endIndex {
+            let end = input.index(index, offsetBy: 7, limitedBy: input.endIndex) ?? input.endIndex
+            parser.append(String(input[index..<end]))
+            index = end
+        }
+
+        XCTAssertTrue(parser.isComplete)
+        XCTAssertEqual(parser.current?.arrayValue?.count, 1_000)
+        XCTAssertEqual(parser.current?[999]?["name"], "item 999")
+    }
+}
@@ -0,0 +1,189 @@
+import XCTest
+@testable import SWAML
+
+final class JsonishValueParserTests: XCTestCase {
+
+    // MARK: - Valid JSON
+
+    func testValidJSONObject() throws {
+        let value = try JsonishParser.parseValue(#"{"name": "test", "value": 42, "ratio": 0.5}"#)
+        XCTAssertEqual(value, ["name": "test", "value": 42, "ratio": 0.5])
+    }
+
+    func testValidJSONArray() throws {
+        let value = try JsonishParser.parseValue(#"["a", "b", "c"]"#)
+        XCTAssertEqual(value, ["a", "b", "c"])
+    }
+
+    func testLiteralsAndNumbers() throws {
+        let value = try JsonishParser.parseValue(#"[true, false, null, -3, 1e3, 2.5E-1]"#)
+        XCTAssertEqual(value, [true, false, nil, -3, 1000.0, 0.25])
+    }
+
+    func testNestedStructures() throws {
+        let value = try JsonishParser.parseValue(#"{"user": {"tags": [1, [2, 3]]}}"#)
+        XCTAssertEqual(value["user"]?["tags"]?[1], [2, 3])
+    }
+
+    // MARK: - Repairs
+
+    func testTrailingCommas() throws {
+        let value = try JsonishParser.parseValue(#"{"items": [1, 2,], "count": 2,}"#)
+        XCTAssertEqual(value, ["items": [1, 2], "count": 2])
+    }
+
+    func testComments() throws {
+        let input = """
+            {
+              // the name
+              "name": "test", /* inline */ "value": 42
+            }
+            """
+        let value = try JsonishParser.parseValue(input)
+        XCTAssertEqual(value, ["name": "test", "value": 42])
+    }
+
+    func testCommentMarkersInsideStringsArePreserved() throws {
+        let value = try JsonishParser.parseValue(#"{"url": "https://example.com/*path*/"}"#)
+        XCTAssertEqual(value["url"], "https://example.com/*path*/")
+    }
+
+    func testUnquotedKeys() throws {
+        let value = try JsonishParser.parseValue(#"{user_name: "Alice", $id: 7}"#)
+        XCTAssertEqual(value, ["user_name": "Alice", "$id": 7])
+    }
+
+    func testSingleQuotedStrings() throws {
+        let value = try JsonishParser.parseValue(#"{'name': 'say "hi"', 'it\'s': true}"#)
+        XCTAssertEqual(value["name"], #"say "hi""#)
+        XCTAssertEqual(value["it's"], true)
+    }
+
+    func testUnescapedNewlinesAndTabs() throws {
+        let value = try JsonishParser.parseValue("{\"text\": \"line1\r\nline2\tend\"}")
+        XCTAssertEqual(value["text"], "line1\nline2\tend")
+    }
+
+    func testTripleQuotedStrings() throws {
+        let value = try JsonishParser.parseValue("{\"body\": \"\"\"first\n\"quoted\" second\"\"\"}")
+        XCTAssertEqual(value["body"], "first\n\"quoted\" second")
+    }
+
+    func testEscapes() throws {
+        let value = try JsonishParser.parseValue(#"{"text": "a\"b\\c\/d\n\u00e9\ud83d\udc4b"}"#)
+        XCTAssertEqual(value["text"], "a\"b\\c/d\né👋")
+    }
+
+    func testInvalidEscapeIsKeptVerbatim() throws {
+        let value = try JsonishParser.parseValue(#"{"path": "C:\temp\xyz"}"#)
+        XCTAssertEqual(value["path"], "C:\temp\\xyz")
+    }
+
+    func testUnicodeContent() throws {
+        let value = try JsonishParser.parseValue(#"{"emoji": "👋 Hello 世界"}"#)
+        XCTAssertEqual(value["emoji"], "👋 Hello 世界")
+    }
+
+    // MARK: - Extraction
+
+    func testMarkdownCodeBlock() throws {
+        let input = """
+            Here is the result:
+            ```json
+            {
+              name: 'Alice',
+              age: 30,
+            }
+            ```
+            Hope that helps.
+            """
+        let value = try JsonishParser.parseValue(input)
+        XCTAssertEqual(value, ["name": "Alice", "age": 30])
+    }
+
+    func testSkipsNonJSONCodeBlock() throws {
+        let input = """
+            ```python
+            print("hi")
+            ```
+            ```json
+            {"ok": true}
+            ```
+            """
+        let value = try JsonishParser.parseValue(input)
+        XCTAssertEqual(value, ["ok": true])
+    }
+
+    func testJSONBetweenText() throws {
+        let input = """
+            Based on my analysis:
+            {"sentiment": "positive", "confidence": 0.95}
+            Let me know if you need more details.
+            """
+        let value = try JsonishParser.parseValue(input)
+        XCTAssertEqual(value, ["sentiment": "positive", "confidence": 0.95])
+    }
+
+    func testSkipsBrokenCandidate() throws {
+        let input = "Try {this one} or maybe [1, 2, 3]"
+        let value = try JsonishParser.parseValue(input)
+        XCTAssertEqual(value, [1, 2, 3])
+    }
+
+    func testMatchesStringParser() throws {
+        let inputs = [
+            #"{"a": 1, "b": [true, null], "c": {"d": "e"}}"#,
+            #"{name: 'test', value: 42,}"#,
+            "Sure!\n```json\n{\"items\": [1, 2, 3,]}\n```",
+        ]
+        for input in inputs {
+            let expected = try SwamlValue.fromJSONString(try JsonishParser.parse(input))
+            XCTAssertEqual(try JsonishParser.parseValue(input), expected, input)
+        }
+    }
+
+    // MARK: - Streaming
+
+    func testPartialObjectIsClosed() throws {
+        let value = try JsonishParser.parseValue(#"{"name": "te"#, isDone: false)
+        XCTAssertEqual(value, ["name": "te"])
+    }
+
+    func testPartialDropsIncompleteMembers() throws {
+        let value = try JsonishParser.parseValue(#"{"a": [1, 2], "done": tr"#, isDone: false)
+        XCTAssertEqual(value, ["a": [1, 2]])
+
+        let dangling = try JsonishParser.parseValue(#"{"a": 1, "b""#, isDone: false)
+        XCTAssertEqual(dangling, ["a": 1])
+    }
+
+    func testPartialWithoutStructureReturnsEmptyObject() throws {
+        let value = try JsonishParser.parseValue("Thinking...", isDone: false)
+        XCTAssertEqual(value, [:])
+    }
+
+    func testIncompleteInputThrowsWhenDone() {
+        XCTAssertThrowsError(try JsonishParser.parseValue(#"{"name": "te"#)) { error in
+            XCTAssertTrue(error is SwamlError)
+        }
+    }
+
+    // MARK: - Error Cases
+
+    func testNoJSONThrows() {
+        XCTAssertThrowsError(try JsonishParser.parseValue("Hello, world!")) { error in
+            XCTAssertTrue(error is SwamlError)
+        }
+    }
+
+    func testEmptyInputThrows() {
+        XCTAssertThrowsError(try JsonishParser.parseValue("")) { error in
+            XCTAssertTrue(error is SwamlError)
+        }
+    }
+
+    func testDeepNestingDoesNotOverflow() throws {
+        let input = String(repeating: "[", count: 2_000) + String(repeating: "]", count: 2_000)
+        XCTAssertTrue(try JsonishParser.parseValue(input).isArray)
+    }
+}
@@ -0,0 +1,111 @@
+import XCTest
+@testable import SWAML
+
+final class LLMBatchDecoderTests: XCTestCase {
+
+    // MARK: - OpenAI-Compatible
+
+    func testOpenAISucceededLine() throws {
+        let decoder = LLMBatchDecoder(provider: .openAI(apiKey: "test"))
+        let line = #"{"id":"batch_req_1","custom_id":"3","response":{"status_code":200,"request_id":"r1","body":{"id":"c1","object":"chat.completion","created":1,"model":"gpt-4o-mini","choices":[{"index":0,"message":{"role":"assistant","content":"{\"a\": 1}"},"finish_reason":"stop"}],"usage":{"prompt_tokens":10,"completion_tokens":5,"total_tokens":15}}},"error":null}"#
+
+        let result = try XCTUnwrap(try decoder.decode(line: line))
+        XCTAssertEqual(result.customId, "3")
+
+        let response = try result.result.get()
+        XCTAssertEqual(response.content, #"{"a": 1}"#)
+        XCTAssertEqual(response.finishReason, .stop)
+        XCTAssertEqual(response.usage?.totalTokens, 15)
+    }
+
+    func testOpenAIFailedRequestLine() throws {
+        let decoder = LLMBatchDecoder(provider: .openAI(apiKey: "test"))
+        let line = #"{"id":"batch_req_2","custom_id":"4","response":{"status_code":400,"body":{"error":{"message":"Invalid model","type":"invalid_request_error"}}},"error":null}"#
+
+        let result = try XCTUnwrap(try decoder.decode(line: line))
+        XCTAssertThrowsError(try result.result.get()) { error in
+            guard case SwamlError.apiError(let statusCode, let message) = error else {
+                return XCTFail("Expected apiError, got \(error)")
+            }
+            XCTAssertEqual(statusCode, 400)
+            XCTAssertEqual(message, "Invalid model")
+        }
+    }
+
+    func testOpenAIErrorFileLine() throws {
+        let decoder = LLMBatchDecoder(provider: .openAI(apiKey: "test"))
+        let line = #"{"id":"batch_req_3","custom_id":"5","response":null,"error":{"code":"batch_expired","message":"This request could not be executed before the completion window expired."}}"#
+
+        let result = try XCTUnwrap(try decoder.decode(line: line))
+        XCTAssertEqual(result.customId, "5")
+        XCTAssertThrowsError(try result.result.get())
+    }
+
+    func testBlankLinesAreSkipped() throws {
+        let decoder = LLMBatchDecoder(provider: .openAI(apiKey: "test"))
+        XCTAssertNil(try decoder.decode(line: ""))
+        XCTAssertNil(try decoder.decode(line: "  "))
+    }
+
+    func testOpenAIBatchObjectStatus() throws {
+        let json = #"{"id":"batch_1","object":"batch","status":"in_progress","output_file_id":null,"error_file_id":null,"request_counts":{"total":10,"completed":4,"failed":1}}"#
+        let job = try JSONDecoder().decode(OpenAIBatchObject.self, from: Data(json.utf8)).job
+
+        XCTAssertEqual(job.id, "batch_1")
+        XCTAssertEqual(job.status, .inProgress)
+        XCTAssertFalse(job.status.isFinished)
+        XCTAssertEqual(job.succeededCount, 4)
+        XCTAssertEqual(job.failedCount, 1)
+    }
+
+    // MARK: - Anthropic
+
+    func testAnthropicSucceededLine() throws {
+        let decoder = LLMBatchDecoder(provider: .anthropic(apiKey: "test"))
+        let line = #"{"custom_id":"0","result":{"type":"succeeded","message":{"id":"msg_1","type":"message","role":"assistant","model":"claude-sonnet-4-20250514","content":[{"type":"text","text":"{\"a\": 1}"}],"stop_reason":"end_turn","usage":{"input_tokens":12,"output_tokens":6}}}}"#
+
+        let result = try XCTUnwrap(try decoder.decode(line: line))
+        let response = try result.result.get()
+        XCTAssertEqual(response.content, #"{"a": 1}"#)
+        XCTAssertEqual(response.finishReason, .endTurn)
+        XCTAssertEqual(response.usage?.totalTokens, 18)
+    }
+
+    func testAnthropicErroredAndExpiredLines() throws {
+        let decoder = LLMBatchDecoder(provider: .anthropic(apiKey: "test"))
+        let errored = #"{"custom_id":"1","result":{"type":"errored","error":{"type":"error","error":{"type":"invalid_request_error","message":"max_tokens too large"}}}}"#
+        let expired = #"{"custom_id":"2","result":{"type":"expired"}}"#
+
+        let erroredResult = try XCTUnwrap(try decoder.decode(line: errored))
+        XCTAssertThrowsError(try erroredResult.result.get()) { error in
+            guard case SwamlError.apiError(_, let message) = error else {
+                return XCTFail("Expected apiError, got \(error)")
+            }
+            XCTAssertEqual(message, "max_tokens too large")
+        }
+
+        let expiredResult = try XCTUnwrap(try decoder.decode(line: expired))
+        XCTAssertEqual(expiredResult.customId, "2")
+        XCTAssertThrowsError(try expiredResult.result.get())
+    }
+
+    func testAnthropicBatchObjectStatus() throws {
+        let json = #"{"id":"msgbatch_1","type":"message_batch","processing_status":"ended","request_counts":{"processing":0,"succeeded":8,"errored":1,"canceled":0,"expired":1},"results_url":"https://api.anthropic.com/v1/messages/batches/msgbatch_1/results"}"#
+        let job = try JSONDecoder().decode(AnthropicBatchObject.self, from: Data(json.utf8)).job
+
+        XCTAssertEqual(job.status, .completed)
+        XCTAssertTrue(job.status.isFinished)
+        XCTAssertEqual(job.succeededCount, 8)
+        XCTAssertEqual(job.failedCount, 2)
+        XCTAssertEqual(job.resultsURL?.lastPathComponent, "results")
+    }
+
+    // MARK: - Providers
+
+    func testBatchAPISupport() {
+        XCTAssertTrue(LLMProvider.openAI(apiKey: "test").supportsBatchAPI)
+        XCTAssertTrue(LLMProvider.anthropic(apiKey: "test").supportsBatchAPI)
+        XCTAssertFalse(LLMProvider.openRouter(apiKey: "test").supportsBatchAPI)
+        XCTAssertFalse(LLMProvider.custom(baseURL: URL(string: "http://localhost:8080/v1")!, apiKey: "test").supportsBatchAPI)
+    }
+}
@@ -0,0 +1,78 @@
+import XCTest
+@testable import SWAML
+
+final class LLMStreamDecoderTests: XCTestCase {
+
+    private func decode(_ lines: [String], provider: LLMProvider) throws -> (chunks: [LLMStreamChunk], finished: Bool) {
+        var decoder = LLMStreamDecoder(provider: provider)
+        var chunks: [LLMStreamChunk] = []
+        for line in lines {
+            if let chunk = try decoder.decode(line: line) {
+                chunks.append(chunk)
+            }
+        }
+        return (chunks, decoder.isFinished)
+    }
+
+    // MARK: - OpenAI-Compatible
+
+    func testOpenAIDeltas() throws {
+        let lines = [
+            ": OPENROUTER PROCESSING",
+            #"data: {"id":"c1","model":"gpt-4o-mini","choices":[{"index":0,"delta":{"role":"assistant","content":""},"finish_reason":null}]}"#,
+            #"data: {"id":"c1","model":"gpt-4o-mini","choices":[{"index":0,"delta":{"content":"{\"a\":"},"finish_reason":null}]}"#,
+            #"data: {"id":"c1","model":"gpt-4o-mini","choices":[{"index":0,"delta":{"content":" 1}"},"finish_reason":null}]}"#,
+            #"data: {"id":"c1","model":"gpt-4o-mini","choices":[{"index":0,"delta":{},"finish_reason":"stop"}]}"#,
+            #"data: {"id":"c1","model":"gpt-4o-mini","choices":[],"usage":{"prompt_tokens":10,"completion_tokens":5,"total_tokens":15}}"#,
+            "data: [DONE]",
+        ]
+
+        let result = try decode(lines, provider: .openAI(apiKey: "test"))
+        XCTAssertTrue(result.finished)
+        XCTAssertEqual(result.chunks.map(\.delta).joined(), #"{"a": 1}"#)
+        XCTAssertEqual(result.chunks.compactMap(\.finishReason), [.stop])
+        XCTAssertEqual(result.chunks.compactMap(\.usage).first?.totalTokens, 15)
+    }
+
+    func testOpenAIMidStreamErrorThrows() {
+        var decoder = LLMStreamDecoder(provider: .openRouter(apiKey: "test"))
+        XCTAssertThrowsError(try decoder.decode(line: #"data: {"error":{"code":502,"message":"Provider disconnected"}}"#)) { error in
+            guard case SwamlError.networkError(let message) = error else {
+                return XCTFail("Expected networkError, got \(error)")
+            }
+            XCTAssertTrue(message.contains("Provider disconnected"))
+        }
+    }
+
+    // MARK: - Anthropic
+
+    func testAnthropicEvents() throws {
+        let lines = [
+            "event: message_start",
+            #"data: {"type":"message_start","message":{"id":"msg_1","type":"message","role":"assistant","content":[],"model":"claude-sonnet","usage":{"input_tokens":12,"output_tokens":1}}}"#,
+            "event: content_block_start",
+            #"data: {"type":"content_block_start","index":0,"content_block":{"type":"text","text":""}}"#,
+            #"data: {"type":"ping"}"#,
+            #"data: {"type":"content_block_delta","index":0,"delta":{"type":"text_delta","text":"{\"ok\""}}"#,
+            #"data: {"type":"content_block_delta","index":0,"delta":{"type":"text_delta","text":": true}"}}"#,
+            #"data: {"type":"content_block_stop","index":0}"#,
+            #"data: {"type":"message_delta","delta":{"stop_reason":"end_turn","stop_sequence":null},"usage":{"output_tokens":7}}"#,
+            #"data: {"type":"message_stop"}"#,
+        ]
+
+        let result = try decode(lines, provider: .anthropic(apiKey: "test"))
+        XCTAssertTrue(result.finished)
+        XCTAssertEqual(result.chunks.map(\.delta).joined(), #"{"ok": true}"#)
+        XCTAssertEqual(result.chunks.compactMap(\.finishReason), [.endTurn])
+
+        let usage = try XCTUnwrap(result.chunks.compactMap(\.usage).first)
+        XCTAssertEqual(usage.promptTokens, 12)
+        XCTAssertEqual(usage.completionTokens, 7)
+        XCTAssertEqual(usage.totalTokens, 19)
+    }
+
+    func testAnthropicErrorEventThrows() {
+        var decoder = LLMStreamDecoder(provider: .anthropic(apiKey: "test"))
+        XCTAssertThrowsError(try decoder.decode(line: #"data: {"type":"error","error":{"type":"overloaded_error","message":"Overloaded"}}"#))
+    }
+}
@@ -129,6 +129,13 @@ final class OutputParserTests: XCTestCase {
         XCTAssertEqual(result.metadata?.source, "test")
     }
 
+    func testParseReadsJsonishOutput() throws {
+        let output = "Here you go:\n```json\n{name: 'Alice', age: 30, // years\n}\n```"
+
+        XCTAssertEqual(try OutputParser.parse(output, type: TestPerson.self), TestPerson(name: "Alice", age: 30))
+        XCTAssertEqual(try OutputParser.parseToValue(output)["name"], "Alice")
+    }
+
     // MARK: - Error Cases
 
     func testParseInvalidJSON() {
@@ -0,0 +1,188 @@
+import XCTest
+@testable import SWAML
+
+final class PromptCachingTests: XCTestCase {
+
+    private func parse(_ bytes: [UInt8]) throws -> [String: Any] {
+        try XCTUnwrap(try JSONSerialization.jsonObject(with: Data(bytes)) as? [String: Any])
+    }
+
+    // MARK: - PromptBuilder
+
+    func testStaticSystemTemplateIsCacheable() {
+        let messages = PromptBuilder()
+            .system("Extract the person.\n{{ ctx.output_format }}")
+            .user("Text: {{ text }}")
+            .variable("text", "Ada")
+            .buildRaw()
+
+        XCTAssertEqual(messages.map(\.cacheable), [true, false])
+    }
+
+    func testPrefixComesBeforeDynamicSystemPrompt() {
+        let messages = PromptBuilder()
+            .cacheablePrefix("Format:\n{{ ctx.output_format }}")
+            .system("Locale: {{ locale }}")
+            .user("Hi")
+            .variable("locale", "en-GB")
+            .build(schema: .object(properties: ["name": .string], required: ["name"]))
+
+        XCTAssertEqual(messages.map(\.role), [.system, .system, .user])
+        XCTAssertEqual(messages.map(\.cacheable), [true, false, false])
+        XCTAssertTrue(messages[0].content.textValue?.contains("name") ?? false)
+        XCTAssertEqual(messages[1].content.textValue, "Locale: en-GB")
+    }
+
+    func testCacheableFlagRoundTrips() throws {
+        let original = ChatMessage.system("Schema", cacheable: true)
+        let data = try JSONEncoder().encode(original)
+        XCTAssertEqual(try JSONDecoder().decode(ChatMessage.self, from: data), original)
+
+        // Messages encoded before the flag existed still decode
+        let legacy = try JSONDecoder().decode(ChatMessage.self, from: Data(#"{"role":"user","content":"Hi"}"#.utf8))
+        XCTAssertFalse(legacy.cacheable)
+    }
+
+    // MARK: - OpenAI
+
+    func testOpenAIPromptCacheKeyFollowsPrefix() async throws {
+        let client = LLMClient(provider: .openAI(apiKey: "test"))
+
+        func body(_ messages: [ChatMessage]) async throws -> [String: Any] {
+            var writer = JSONBodyWriter()
+            await client.writeOpenAIRequestBody(
+                into: &writer,
+                model: "gpt-4o",
+                messages: messages,
+                responseFormat: nil,
+                temperature: nil,
+                maxTokens: nil,
+                topP: nil,
+                stop: nil
+            )
+            return try parse(writer.bytes)
+        }
+
+        let first = try await body([.system("Schema", cacheable: true), .user("One")])
+        let second = try await body([.system("Schema", cacheable: true), .user("Two")])
+        let other = try await body([.system("Other schema", cacheable: true), .user("One")])
+        let uncached = try await body([.system("Schema"), .user("One")])
+
+        let key = try XCTUnwrap(first["prompt_cache_key"] as? String)
+        XCTAssertEqual(second["prompt_cache_key"] as? String, key)
+        XCTAssertNotEqual(other["prompt_cache_key"] as? String, key)
+        XCTAssertNil(uncached["prompt_cache_key"])
+
+        // The flag itself isn't part of the wire format
+        let messages = try XCTUnwrap(first["messages"] as? [[String: Any]])
+        XCTAssertNil(messages[0]["cacheable"])
+    }
+
+    func testCacheKeyOmittedForOtherCompatibleProviders() async throws {
+        let client = LLMClient(provider: .openRouter(apiKey: "test"))
+        var writer = JSONBodyWriter()
+        await client.writeOpenAIRequestBody(
+            into: &writer,
+            model: "m",
+            messages: [.system("Schema", cacheable: true), .user("One")],
+            responseFormat: nil,
+            temperature: nil,
+            maxTokens: nil,
+            topP: nil,
+            stop: nil
+        )
+        XCTAssertNil(try parse(writer.bytes)["prompt_cache_key"])
+    }
+
+    // MARK: - Anthropic
+
+    func testAnthropicSystemBreakpoint() async throws {
+        let client = LLMClient(provider: .anthropic(apiKey: "test"))
+        var writer = JSONBodyWriter()
+        await client.writeAnthropicRequestBody(
+            into: &writer,
+            model: "claude",
+            messages: [.system("Schema", cacheable: true), .system("Locale: fr"), .user("Hello")],
+            temperature: nil,
+            maxTokens: 50,
+            topP: nil,
+            stop: nil
+        )
+
+        let body = try parse(writer.bytes)
+        let system = try XCTUnwrap(body["system"] as? [[String: Any]])
+        XCTAssertEqual(system.map { $0["text"] as? String }, ["Schema", "Locale: fr"])
+        XCTAssertEqual((system[0]["cache_control"] as? [String: String])?["type"], "ephemeral")
+        XCTAssertNil(system[1]["cache_control"])
+
+        let messages = try XCTUnwrap(body["messages"] as? [[String: Any]])
+        XCTAssertEqual(messages[0]["content"] as? String, "Hello")
+    }
+
+    func testAnthropicMessageBreakpointUsesContentBlock() async throws {
+        let client = LLMClient(provider: .anthropic(apiKey: "test"))
+        var writer = JSONBodyWriter()
+        await client.writeAnthropicRequestBody(
+            into: &writer,
+            model: "claude",
+            messages: [
+                .user("Long document"),
+                ChatMessage(role: .assistant, content: "Read it.", cacheable: true),
+                .user("Question")
+            ],
+            temperature: nil,
+            maxTokens: 50,
+            topP: nil,
+            stop: nil
+        )
+
+        let messages = try XCTUnwrap(try parse(writer.bytes)["messages"] as? [[String: Any]])
+        let blocks = try XCTUnwrap(messages[1]["content"] as? [[String: Any]])
+        XCTAssertEqual(blocks[0]["text"] as? String, "Read it.")
+        XCTAssertNotNil(blocks[0]["cache_control"])
+        XCTAssertEqual(messages[2]["content"] as? String, "Question")
+    }
+
+    func testAnthropicKeepsLastFourBreakpoints() {
+        let messages = (0..<6).map { ChatMessage(role: .user, content: "\($0)", cacheable: true) }
+            + [.system("Schema", cacheable: true)]
+
+        // System is cached first, so it's the one dropped along with the first user message
+        XCTAssertEqual(LLMClient.anthropicCacheBreakpoints(messages), [2, 3, 4, 5])
+    }
+
+    // MARK: - Usage
+
+    func testOpenAIUsageReportsCachedTokens() throws {
+        let json = #"{"prompt_tokens":2006,"completion_tokens":300,"total_tokens":2306,"prompt_tokens_details":{"cached_tokens":1920}}"#
+        let usage = try JSONDecoder().decode(LLMResponse.Usage.self, from: Data(json.utf8))
+        XCTAssertEqual(usage.cachedPromptTokens, 1920)
+        XCTAssertNil(usage.cacheCreationTokens)
+
+        // Survives the response cache's round trip
+        let reencoded = try JSONDecoder().decode(LLMResponse.Usage.self, from: JSONEncoder().encode(usage))
+        XCTAssertEqual(reencoded.cachedPromptTokens, 1920)
+        XCTAssertEqual(reencoded.totalTokens, 2306)
+    }
+
+    func testAnthropicUsageFoldsCacheTokensIntoPrompt() throws {
+        let json = #"{"input_tokens":50,"output_tokens":10,"cache_read_input_tokens":2000,"cache_creation_input_tokens":100}"#
+        let usage = try JSONDecoder()
+            .decode(AnthropicCompletionResponse.AnthropicUsage.self, from: Data(json.utf8))
+            .toLLMUsage
+
+        XCTAssertEqual(usage.promptTokens, 2150)
+        XCTAssertEqual(usage.totalTokens, 2160)
+        XCTAssertEqual(usage.cachedPromptTokens, 2000)
+        XCTAssertEqual(usage.cacheCreationTokens, 100)
+    }
+
+    func testAnthropicStreamReportsCacheTokens() throws {
+        var decoder = LLMStreamDecoder(provider: .anthropic(apiKey: "test"))
+        _ = try decoder.decode(line: #"data: {"type":"message_start","message":{"id":"m","model":"claude","usage":{"input_tokens":5,"output_tokens":1,"cache_read_input_tokens":1000}}}"#)
+        let chunk = try decoder.decode(line: #"data: {"type":"message_delta","delta":{"stop_reason":"end_turn"},"usage":{"output_tokens":7}}"#)
+
+        XCTAssertEqual(chunk?.usage?.promptTokens, 1005)
+        XCTAssertEqual(chunk?.usage?.cachedPromptTokens, 1000)
+    }
+}
@@ -0,0 +1,234 @@
+import XCTest
+@testable import SWAML
+
+final class RateLimiterTests: XCTestCase {
+
+    /// Clock advanced by hand
+    final class ManualClock: @unchecked Sendable {
+        private let lock = NSLock()
+        private var time: TimeInterval = 1000
+
+        var now: TimeInterval {
+            lock.lock()
+            defer { lock.unlock() }
+            return time
+        }
+
+        func advance(_ seconds: TimeInterval) {
+            lock.lock()
+            time += seconds
+            lock.unlock()
+        }
+    }
+
+    private func headers(_ fields: [String: String]) -> (String) -> String? {
+        { name in fields.first { $0.key.lowercased() == name.lowercased() }?.value }
+    }
+
+    // MARK: - Token Buckets
+
+    func testUnlimitedNeverWaits() async {
+        let limiter = RateLimiter(limits: .unlimited, clock: { 0 })
+        for _ in 0..<100 {
+            let delay = await limiter.reserve(estimatedTokens: 10_000)
+            XCTAssertEqual(delay, 0)
+        }
+    }
+
+    func testRequestBucketSpacesCallersOut() async {
+        let clock = ManualClock()
+        let limiter = RateLimiter(limits: RateLimits(requestsPerMinute: 60), clock: { clock.now })
+
+        for _ in 0..<60 {
+            let delay = await limiter.reserve(estimatedTokens: 0)
+            XCTAssertEqual(delay, 0)
+        }
+
+        // One request per second refill: queued callers wait 1s, 2s, 3s...
+        let first = await limiter.reserve(estimatedTokens: 0)
+        let second = await limiter.reserve(estimatedTokens: 0)
+        XCTAssertEqual(first, 1, accuracy: 0.001)
+        XCTAssertEqual(second, 2, accuracy: 0.001)
+    }
+
+    func testBucketRefillsOverTime() async {
+        let clock = ManualClock()
+        let limiter = RateLimiter(limits: RateLimits(requestsPerMinute: 60), clock: { clock.now })
+
+        for _ in 0..<60 {
+            _ = await limiter.reserve(estimatedTokens: 0)
+        }
+        clock.advance(5)
+
+        for _ in 0..<5 {
+            let delay = await limiter.reserve(estimatedTokens: 0)
+            XCTAssertEqual(delay, 0)
+        }
+        let delay = await limiter.reserve(estimatedTokens: 0)
+        XCTAssertGreaterThan(delay, 0)
+    }
+
+    func testTokenBucket() async {
+        let clock = ManualClock()
+        let limiter = RateLimiter(limits: RateLimits(tokensPerMinute: 6000), clock: { clock.now })
+
+        let first = await limiter.reserve(estimatedTokens: 6000)
+        XCTAssertEqual(first, 0)
+
+        // 100 tokens per second
+        let second = await limiter.reserve(estimatedTokens: 500)
+        XCTAssertEqual(second, 5, accuracy: 0.001)
+    }
+
+    func testSettleReturnsUnusedTokens() async {
+        let clock = ManualClock()
+        let limiter = RateLimiter(limits: RateLimits(tokensPerMinute: 6000), clock: { clock.now })
+
+        _ = await limiter.reserve(estimatedTokens: 6000)
+        await limiter.settle(estimatedTokens: 6000, actualTokens: 1000)
+
+        let delay = await limiter.reserve(estimatedTokens: 5000)
+        XCTAssertEqual(delay, 0)
+    }
+
+    func testOversizedRequestIsClampedToCapacity() async {
+        let limiter = RateLimiter(limits: RateLimits(tokensPerMinute: 1000), clock: { 0 })
+        let delay = await limiter.reserve(estimatedTokens: 50_000)
+        XCTAssertEqual(delay, 0)
+    }
+
+    func testCancelledAcquireRefundsReservation() async throws {
+        let clock = ManualClock()
+        let limiter = RateLimiter(limits: RateLimits(requestsPerMinute: 1), clock: { clock.now })
+        _ = await limiter.reserve(estimatedTokens: 0)
+
+        let task = Task { try await limiter.acquire() }
+        task.cancel()
+        await XCTAssertThrowsErrorAsync(try await task.value)
+
+        // Only the first reservation remains, so the next caller waits one slot
+        let delay = await limiter.reserve(estimatedTokens: 0)
+        XCTAssertEqual(delay, 60, accuracy: 0.001)
+    }
+
+    // MARK: - Headers
+
+    func testLearnsOpenAILimitsFromHeaders() async {
+        let clock = ManualClock()
+        let limiter = RateLimiter(limits: .unlimited, clock: { clock.now })
+
+        await limiter.update(statusCode: 200, header: headers([
+            "x-ratelimit-limit-requests": "500",
+            "x-ratelimit-remaining-requests": "0",
+            "x-ratelimit-reset-requests": "2s",
+            "x-ratelimit-limit-tokens": "30000",
+            "x-ratelimit-remaining-tokens": "29000",
+            "x-ratelimit-reset-tokens": "2ms"
+        ]))
+
+        let limits = await limiter.limits
+        XCTAssertEqual(limits, RateLimits(requestsPerMinute: 500, tokensPerMinute: 30000))
+
+        // No requests remaining: paused until the reset
+        let delay = await limiter.reserve(estimatedTokens: 0)
+        XCTAssertGreaterThanOrEqual(delay, 2)
+    }
+
+    func testLearnsAnthropicLimitsFromHeaders() async {
+        let limiter = RateLimiter(limits: .unlimited, clock: { 0 })
+
+        await limiter.update(statusCode: 200, header: headers([
+            "anthropic-ratelimit-requests-limit": "50",
+            "anthropic-ratelimit-requests-remaining": "49",
+            "anthropic-ratelimit-tokens-limit": "40000",
+            "anthropic-ratelimit-tokens-remaining": "39000"
+        ]))
+
+        let limits = await limiter.limits
+        XCTAssertEqual(limits, RateLimits(requestsPerMinute: 50, tokensPerMinute: 40000))
+    }
+
+    func testRetryAfterPausesAdmission() async {
+        let clock = ManualClock()
+        let limiter = RateLimiter(limits: .unlimited, clock: { clock.now })
+
+        await limiter.update(statusCode: 429, header: headers(["Retry-After": "7"]))
+
+        let delay = await limiter.reserve(estimatedTokens: 0)
+        XCTAssertEqual(delay, 7, accuracy: 0.001)
+
+        clock.advance(7)
+        let after = await limiter.reserve(estimatedTokens: 0)
+        XCTAssertEqual(after, 0)
+    }
+
+    func testParseDuration() {
+        XCTAssertEqual(RateLimiter.parseDuration("1s"), 1)
+        XCTAssertEqual(RateLimiter.parseDuration("6m0s"), 360)
+        XCTAssertEqual(RateLimiter.parseDuration("1h2m3.5s"), 3723.5)
+        XCTAssertEqual(RateLimiter.parseDuration("20ms")!, 0.02, accuracy: 0.0001)
+        XCTAssertNil(RateLimiter.parseDuration("soon"))
+        XCTAssertNil(RateLimiter.parseDuration(""))
+    }
+
+    func testParseResetTimestamp() {
+        let now = Date(timeIntervalSince1970: 1_700_000_000)
+        let reset = RateLimiter.parseReset("2023-11-14T22:13:30Z", now: now)
+        XCTAssertEqual(reset, 10)
+    }
+
+    func testParseRetryAfterMilliseconds() {
+        let delay = RateLimiter.parseRetryAfter(headers(["retry-after-ms": "1500"]))
+        XCTAssertEqual(delay, 1.5)
+    }
+
+    // MARK: - Estimation
+
+    func testEstimatedTokensIncludesCompletionBudget() {
+        let messages = [ChatMessage.user(String(repeating: "a", count: 400))]
+        XCTAssertEqual(LLMClient.estimatedTokens(messages: messages, maxTokens: 50), 150)
+    }
+
+    func testEstimateUsesTheBudgetSentToTheProvider() async {
+        let anthropic = LLMClient(provider: .anthropic(apiKey: "test"))
+        let openAI = LLMClient(provider: .openAI(apiKey: "test"))
+
+        let anthropicDefault = await anthropic.completionBudget(nil)
+        let openAIDefault = await openAI.completionBudget(nil)
+        let explicit = await anthropic.completionBudget(100)
+        XCTAssertEqual(anthropicDefault, LLMClient.defaultAnthropicMaxTokens)
+        XCTAssertNil(openAIDefault)
+        XCTAssertEqual(explicit, 100)
+    }
+
+    // MARK: - Registry
+
+    func testRegistrySharesLimiterPerClient() async throws {
+        let registry = ClientRegistry()
+        await registry.register(
+            name: "limited",
+            provider: .openAI(apiKey: "test"),
+            model: "gpt-4o",
+            rateLimits: RateLimits(requestsPerMinute: 10)
+        )
+
+        let client = try await registry.getClient("limited")
+        let limiter = try await registry.getRateLimiter("limited")
+        let clientLimiter = await client.rateLimiter
+        XCTAssertTrue(clientLimiter === limiter)
+
+        let limits = await limiter.limits
+        XCTAssertEqual(limits.requestsPerMinute, 10)
+    }
+}
+
+private func XCTAssertThrowsErrorAsync<T>(
+    _ expression: @autoclosure () async throws -> T,
+    file: StaticString = #filePath,
+    line: UInt = #line
+) async {
+    do {
+        _ = try await expression()
+        XCTFail("Expected an error", file: file, line: line)
+    } catch {}
+}
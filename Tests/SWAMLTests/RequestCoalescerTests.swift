@@ -0,0 +1,281 @@
+import XCTest
+#if canImport(FoundationNetworking)
+import FoundationNetworking
+#endif
+@testable import SWAML
+
+final class RequestCoalescerTests: XCTestCase {
+
+    /// Holds operations until opened
+    actor Gate {
+        private var isOpen = false
+        private var waiters: [CheckedContinuation<Void, Never>] = []
+        private(set) var starts = 0
+
+        func wait() async {
+            starts += 1
+            guard !isOpen else { return }
+            await withCheckedContinuation { waiters.append($0) }
+        }
+
+        func open() {
+            isOpen = true
+            for waiter in waiters {
+                waiter.resume()
+            }
+            waiters.removeAll()
+        }
+    }
+
+    private func waitForWaiters(_ coalescer: RequestCoalescer<String>, count: Int) async {
+        for _ in 0..<1000 {
+            if await coalescer.waiterCount == count { return }
+            await Task.yield()
+        }
+        XCTFail("Expected \(count) waiters")
+    }
+
+    // MARK: - Coalescing
+
+    func testConcurrentCallsShareOneOperation() async throws {
+        let coalescer = RequestCoalescer<String>()
+        let gate = Gate()
+
+        let tasks = (0..<5).map { _ in
+            Task {
+                try await coalescer.run("key") { () -> Int in
+                    await gate.wait()
+                    return 42
+                }
+            }
+        }
+        await waitForWaiters(coalescer, count: 5)
+        await gate.open()
+
+        for task in tasks {
+            let value = try await task.value
+            XCTAssertEqual(value, 42)
+        }
+        let starts = await gate.starts
+        XCTAssertEqual(starts, 1)
+        let inFlight = await coalescer.inFlightCount
+        XCTAssertEqual(inFlight, 0)
+    }
+
+    func testDifferentKeysRunSeparately() async throws {
+        let coalescer = RequestCoalescer<String>()
+        async let a = coalescer.run("a") { "A" }
+        async let b = coalescer.run("b") { "B" }
+        let results = try await [a, b]
+        XCTAssertEqual(results, ["A", "B"])
+    }
+
+    func testFinishedKeyIsReleased() async throws {
+        let coalescer = RequestCoalescer<String>()
+        let gate = Gate()
+        await gate.open()
+
+        _ = try await coalescer.run("key") { await gate.wait() }
+        _ = try await coalescer.run("key") { await gate.wait() }
+
+        let starts = await gate.starts
+        XCTAssertEqual(starts, 2)
+    }
+
+    func testErrorIsShared() async {
+        struct Failure: Error {}
+        let coalescer = RequestCoalescer<String>()
+        let gate = Gate()
+
+        let tasks = (0..<2).map { _ in
+            Task {
+                try await coalescer.run("key") { () -> Int in
+                    await gate.wait()
+                    throw Failure()
+                }
+            }
+        }
+        await waitForWaiters(coalescer, count: 2)
+        await gate.open()
+
+        for task in tasks {
+            do {
+                _ = try await task.value
+                XCTFail("Expected an error")
+            } catch {
+                XCTAssertTrue(error is Failure)
+            }
+        }
+    }
+
+    // MARK: - Cancellation
+
+    func testCancellingOneWaiterKeepsSharedOperation() async throws {
+        let coalescer = RequestCoalescer<String>()
+        let gate = Gate()
+
+        let operation: @Sendable () async throws -> String = {
+            await gate.wait()
+            try Task.checkCancellation()
+            return "done"
+        }
+        let cancelled = Task { try await coalescer.run("key", operation: operation) }
+        let kept = Task { try await coalescer.run("key", operation: operation) }
+        await waitForWaiters(coalescer, count: 2)
+
+        cancelled.cancel()
+        await waitForWaiters(coalescer, count: 1)
+        await gate.open()
+
+        let value = try await kept.value
+        XCTAssertEqual(value, "done")
+        do {
+            _ = try await cancelled.value
+            XCTFail("Expected cancellation")
+        } catch {
+            XCTAssertTrue(error is CancellationError)
+        }
+    }
+
+    func testCancellingAllWaitersCancelsOperation() async throws {
+        let coalescer = RequestCoalescer<String>()
+        let gate = Gate()
+        let sawCancellation = Gate()
+
+        let task = Task {
+            try await coalescer.run("key") { () -> String in
+                await gate.wait()
+                if Task.isCancelled {
+                    await sawCancellation.open()
+                }
+                return "done"
+            }
+        }
+        await waitForWaiters(coalescer, count: 1)
+        task.cancel()
+        await waitForWaiters(coalescer, count: 0)
+        await gate.open()
+
+        // The operation observes the cancellation once it resumes
+        await sawCancellation.wait()
+        let inFlight = await coalescer.inFlightCount
+        XCTAssertEqual(inFlight, 0)
+    }
+
+    // MARK: - SwamlClient
+
+    struct Answer: SwamlTyped {
+        let answer: String
+
+        static var swamlTypeName: String { "Answer" }
+        static var swamlSchema: JSONSchema {
+            .object(properties: ["answer": .string], required: ["answer"])
+        }
+    }
+
+    /// Answers each chat completion with `content`, a little later, and counts them
+    final class DelayedCompletionProtocol: URLProtocol {
+        private static let lock = NSLock()
+        private static var _requests = 0
+        static var content = ""
+
+        static var requests: Int {
+            lock.lock()
+            defer { lock.unlock() }
+            return _requests
+        }
+
+        static func reset(content: String) {
+            lock.lock()
+            defer { lock.unlock() }
+            _requests = 0
+            self.content = content
+        }
+
+        static func session() -> URLSession {
+            let configuration = URLSessionConfiguration.ephemeral
+            configuration.protocolClasses = [DelayedCompletionProtocol.self]
+            return URLSession(configuration: configuration)
+        }
+
+        override class func canInit(with request: URLRequest) -> Bool {
+            true
+        }
+
+        override class func canonicalRequest(for request: URLRequest) -> URLRequest {
+            request
+        }
+
+        override func startLoading() {
+            Self.lock.lock()
+            Self._requests += 1
+            let content = Self.content
+            Self.lock.unlock()
+
+            let body: [String: Any] = [
+                "id": "c1", "object": "chat.completion", "created": 0, "model": "m",
+                "choices": [["index": 0, "message": ["role": "assistant", "content": content], "finish_reason": "stop"]],
+            ]
+            DispatchQueue.global().asyncAfter(deadline: .now() + 0.3) {
+                let response = HTTPURLResponse(url: self.request.url!, statusCode: 200, httpVersion: "HTTP/1.1", headerFields: nil)!
+                self.client?.urlProtocol(self, didReceive: response, cacheStoragePolicy: .notAllowed)
+                self.client?.urlProtocol(self, didLoad: try! JSONSerialization.data(withJSONObject: body))
+                self.client?.urlProtocolDidFinishLoading(self)
+            }
+        }
+
+        override func stopLoading() {}
+    }
+
+    func testCallAndCallWithRepairDontShareAFlight() async throws {
+        DelayedCompletionProtocol.reset(content: "I'd rather not say.")
+        let client = SwamlClient(llmClient: LLMClient(
+            provider: .openAI(apiKey: "test"),
+            session: DelayedCompletionProtocol.session()
+        ))
+        let prompt = PromptBuilder().system("{{ ctx.output_format }}").user("Answer me")
+
+        async let plain: Answer = client.call(model: "m", prompt: prompt, returnType: Answer.self)
+        async let repairing: Answer = client.callWithRepair(
+            model: "m",
+            prompt: prompt,
+            returnType: Answer.self,
+            maxRepairAttempts: 0
+        )
+
+        // Each fails with its own parse error, not the other's
+        do {
+            _ = try await plain
+            XCTFail("Expected a parse failure")
+        } catch {
+            XCTAssertTrue(error is SwamlError, "\(error)")
+        }
+        do {
+            _ = try await repairing
+            XCTFail("Expected a parse failure")
+        } catch {
+            XCTAssertTrue(error is SwamlError, "\(error)")
+        }
+        XCTAssertEqual(DelayedCompletionProtocol.requests, 2)
+    }
+
+    func testCallsWithDifferentContinuationBudgetsDontShareAFlight() async throws {
+        DelayedCompletionProtocol.reset(content: #"{"answer": "yes"}"#)
+        let client = SwamlClient(llmClient: LLMClient(
+            provider: .openAI(apiKey: "test"),
+            session: DelayedCompletionProtocol.session()
+        ))
+        let prompt = PromptBuilder().system("{{ ctx.output_format }}").user("Answer me")
+
+        let first = Task { try await client.call(model: "m", prompt: prompt, returnType: Answer.self) }
+        for _ in 0..<1000 where DelayedCompletionProtocol.requests == 0 {
+            try await Task.sleep(nanoseconds: 1_000_000)
+        }
+        await client.setContinuation(maxContinuations: 2)
+        let second = try await client.call(model: "m", prompt: prompt, returnType: Answer.self)
+
+        XCTAssertEqual(second.answer, "yes")
+        XCTAssertEqual(try await first.value.answer, "yes")
+        XCTAssertEqual(DelayedCompletionProtocol.requests, 2)
+    }
+}
@@ -0,0 +1,250 @@
+import XCTest
+@testable import SWAML
+
+final class ResponseCacheTests: XCTestCase {
+
+    private func response(_ content: String) -> LLMResponse {
+        LLMResponse(
+            content: content,
+            model: "test-model",
+            usage: LLMResponse.Usage(promptTokens: 1, completionTokens: 2, totalTokens: 3),
+            finishReason: .stop,
+            id: "resp-1"
+        )
+    }
+
+    private func temporaryStoreURL() -> URL {
+        FileManager.default.temporaryDirectory
+            .appendingPathComponent("swaml-cache-\(UUID().uuidString)")
+            .appendingPathComponent("responses.bin")
+    }
+
+    // MARK: - Keys
+
+    func testKeyIsStable() {
+        let a = ResponseCacheKey(hashing: Array("hello".utf8))
+        let b = ResponseCacheKey(hashing: Array("hello".utf8))
+        let c = ResponseCacheKey(hashing: Array("hellp".utf8))
+
+        XCTAssertEqual(a, b)
+        XCTAssertNotEqual(a, c)
+        XCTAssertEqual(a.description.count, 32)
+    }
+
+    func testKeyIsTruncatedSHA256() {
+        XCTAssertEqual(SHA256.hash(Array("abc".utf8)).prefix(4), [0xba, 0x78, 0x16, 0xbf])
+        XCTAssertEqual(ResponseCacheKey(hashing: Array("abc".utf8)).description, "ba7816bf8f01cfea414140de5dae2223")
+        // Longer than one block, fed from contiguous and non-contiguous storage
+        let long = Array(repeating: UInt8(ascii: "x"), count: 200)
+        XCTAssertEqual(ResponseCacheKey(hashing: long), ResponseCacheKey(hashing: long.lazy.map { $0 }))
+    }
+
+    func testSHA256MatchesNISTVectors() {
+        func hex(_ bytes: [UInt8]) -> String {
+            bytes.map { String(format: "%02x", $0) }.joined()
+        }
+
+        XCTAssertEqual(hex(SHA256.hash([UInt8]())), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855")
+        // 56 bytes: the length no longer fits, so padding spills into a second block
+        XCTAssertEqual(
+            hex(SHA256.hash(Array("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq".utf8))),
+            "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"
+        )
+        XCTAssertEqual(
+            hex(SHA256.hash(Array(
+                "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu".utf8
+            ))),
+            "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"
+        )
+
+        // One million "a", whole blocks and a partial block fed in pieces
+        let a = [UInt8](repeating: UInt8(ascii: "a"), count: 1_000_000)
+        var hasher = SHA256()
+        hasher.update(a[..<100])
+        hasher.update(a[100..<999_937])
+        hasher.update(a[999_937...].lazy.map { $0 })
+        XCTAssertEqual(hex(hasher.finalize()), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0")
+        XCTAssertEqual(hex(SHA256.hash(a)), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0")
+    }
+
+    func testClientKeyCoversRequestParameters() async {
+        let client = LLMClient(provider: .openAI(apiKey: "test"))
+        let messages: [ChatMessage] = [.user("Hi")]
+
+        let base = await client.cacheKey(model: "m", messages: messages, responseFormat: .jsonObject, temperature: 0, maxTokens: nil)
+        let same = await client.cacheKey(model: "m", messages: messages, responseFormat: .jsonObject, temperature: 0, maxTokens: nil)
+        let otherModel = await client.cacheKey(model: "n", messages: messages, responseFormat: .jsonObject, temperature: 0, maxTokens: nil)
+        let otherTemperature = await client.cacheKey(model: "m", messages: messages, responseFormat: .jsonObject, temperature: 1, maxTokens: nil)
+
+        XCTAssertEqual(base, same)
+        XCTAssertNotEqual(base, otherModel)
+        XCTAssertNotEqual(base, otherTemperature)
+
+        let otherProvider = await LLMClient(provider: .anthropic(apiKey: "test"))
+            .cacheKey(model: "m", messages: messages, responseFormat: .jsonObject, temperature: 0, maxTokens: nil)
+        XCTAssertNotEqual(base, otherProvider)
+    }
+
+    // MARK: - Memory Store
+
+    func testMemoryStoreEvictsLeastRecentlyUsed() {
+        let entry = CachedResponse(response: response(String(repeating: "x", count: 100)))
+        // Room for two entries
+        let store = MemoryResponseStore(byteBudget: entry.cost * 2)
+        let keys = (0..<3).map { ResponseCacheKey(high: 0, low: UInt64($0)) }
+
+        store.store(entry, for: keys[0])
+        store.store(entry, for: keys[1])
+        _ = store.entry(for: keys[0])
+        store.store(entry, for: keys[2])
+
+        XCTAssertNotNil(store.entry(for: keys[0]))
+        XCTAssertNil(store.entry(for: keys[1]))
+        XCTAssertNotNil(store.entry(for: keys[2]))
+        XCTAssertLessThanOrEqual(store.byteCount, store.byteBudget)
+    }
+
+    func testMemoryStoreSkipsOversizedEntries() {
+        let store = MemoryResponseStore(byteBudget: 10)
+        store.store(CachedResponse(response: response("too large")), for: ResponseCacheKey(high: 1, low: 1))
+        XCTAssertEqual(store.count, 0)
+    }
+
+    // MARK: - Disk Store
+
+    func testDiskStoreIsSharedBetweenInstances() throws {
+        let url = temporaryStoreURL()
+        defer { try? FileManager.default.removeItem(at: url.deletingLastPathComponent()) }
+
+        let writer = try DiskResponseStore(url: url)
+        let reader = try DiskResponseStore(url: url)
+        let key = ResponseCacheKey(high: 7, low: 9)
+
+        XCTAssertNil(reader.entry(for: key))
+        writer.store(CachedResponse(response: response("{\"a\": 1}")), for: key)
+
+        // Picked up by the other instance without reopening
+        let entry = try XCTUnwrap(reader.entry(for: key))
+        XCTAssertEqual(entry.response.content, "{\"a\": 1}")
+        XCTAssertEqual(entry.response.usage?.totalTokens, 3)
+        XCTAssertEqual(entry.response.finishReason, .stop)
+    }
+
+    func testDiskStoreIgnoresTornRecord() throws {
+        let url = temporaryStoreURL()
+        defer { try? FileManager.default.removeItem(at: url.deletingLastPathComponent()) }
+
+        let store = try DiskResponseStore(url: url)
+        let key = ResponseCacheKey(high: 1, low: 2)
+        store.store(CachedResponse(response: response("first")), for: key)
+
+        // Simulate another process that has only written half a record
+        let handle = try FileHandle(forWritingTo: url)
+        handle.seekToEndOfFile()
+        handle.write(Data([0x53, 0x52, 0x43, 0x31, 0x00, 0x01]))
+        handle.closeFile()
+
+        let reopened = try DiskResponseStore(url: url)
+        XCTAssertEqual(reopened.entry(for: key)?.response.content, "first")
+        XCTAssertEqual(reopened.count, 1)
+    }
+
+    func testDiskStoreResyncsAfterTornRecord() throws {
+        let url = temporaryStoreURL()
+        defer { try? FileManager.default.removeItem(at: url.deletingLastPathComponent()) }
+
+        let first = ResponseCacheKey(high: 1, low: 1)
+        let torn = ResponseCacheKey(high: 2, low: 2)
+        let later = ResponseCacheKey(high: 3, low: 3)
+
+        let store = try DiskResponseStore(url: url)
+        store.store(CachedResponse(response: response("first")), for: first)
+        let intact = try Data(contentsOf: url).count
+        store.store(CachedResponse(response: response(String(repeating: "torn", count: 200))), for: torn)
+
+        // Cut the second record short, as if its writer died mid-write, then
+        // let another writer append after it
+        let handle = try FileHandle(forWritingTo: url)
+        handle.truncateFile(atOffset: UInt64(intact + 60))
+        handle.closeFile()
+        try DiskResponseStore(url: url).store(CachedResponse(response: response("later")), for: later)
+
+        let reopened = try DiskResponseStore(url: url)
+        XCTAssertEqual(reopened.entry(for: first)?.response.content, "first")
+        XCTAssertNil(reopened.entry(for: torn))
+        XCTAssertEqual(reopened.entry(for: later)?.response.content, "later")
+    }
+
+    // MARK: - Cache
+
+    func testDiskHitIsPromotedToMemory() throws {
+        let url = temporaryStoreURL()
+        defer { try? FileManager.default.removeItem(at: url.deletingLastPathComponent()) }
+
+        let key = ResponseCacheKey(high: 3, low: 4)
+        try DiskResponseStore(url: url).store(CachedResponse(response: response("cached")), for: key)
+
+        let memory = MemoryResponseStore()
+        let cache = ResponseCache(stores: [memory, try DiskResponseStore(url: url)])
+
+        XCTAssertEqual(cache.response(for: key)?.content, "cached")
+        XCTAssertNotNil(memory.entry(for: key))
+    }
+
+    func testMaxAgeRejectsOldEntries() {
+        let memory = MemoryResponseStore()
+        let cache = ResponseCache(stores: [memory])
+        let key = ResponseCacheKey(high: 5, low: 6)
+        memory.store(CachedResponse(response: response("old"), storedAt: Date().addingTimeInterval(-120)), for: key)
+
+        XCTAssertNil(cache.response(for: key, maxAge: 60))
+        XCTAssertEqual(cache.response(for: key, maxAge: 600)?.content, "old")
+    }
+
+    // MARK: - Runtime
+
+    func testRuntimeAnswersFromCacheWithoutNetwork() async throws {
+        let registry = ClientRegistry()
+        // Nothing listens here; a cache miss would fail
+        await registry.register(
+            name: "offline",
+            provider: .custom(baseURL: URL(string: "http://127.0.0.1:9")!, apiKey: "test"),
+            model: "m",
+            retryPolicy: .none
+        )
+        let cache = ResponseCache()
+        let runtime = SwamlRuntime(clientRegistry: registry, responseCache: cache)
+
+        let client = try await registry.getClient("offline")
+        let key = await client.cacheKey(
+            model: "m",
+            messages: [.user("Name a color")],
+            responseFormat: .jsonObject,
+            temperature: nil,
+            maxTokens: nil
+        )
+        cache.store(response("{\"color\": \"red\"}"), for: key)
+
+        let value = try await runtime.callFunction("Color", args: [:], prompt: "Name a color")
+        XCTAssertEqual(value["color"]?.stringValue, "red")
+
+        do {
+            _ = try await runtime.callFunction(
+                "Color",
+                args: [:],
+                prompt: "Name a color",
+                ctx: RuntimeContext(cachePolicy: .bypass)
+            )
+            XCTFail("Bypass should have gone to the network")
+        } catch {}
+    }
+
+    func testContextCachePolicy() {
+        XCTAssertEqual(RuntimeContext.default.cachePolicy, .default)
+
+        let ctx = RuntimeContext.builder().cache(.ttl(30)).build()
+        XCTAssertEqual(ctx.cachePolicy, ResponseCachePolicy(mode: .readWrite, ttl: 30))
+        XCTAssertEqual(ctx.child(cachePolicy: .readOnly).cachePolicy, .readOnly)
+        XCTAssertEqual(ctx.child().cachePolicy.ttl, 30)
+    }
+}
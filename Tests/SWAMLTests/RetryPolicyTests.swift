@@ -89,6 +89,15 @@ final class RetryPolicyTests: XCTestCase {
         XCTAssertTrue(policy.shouldRetry(error: error, attempt: 0))
     }
 
+    func testShouldNotRetryCancellation() {
+        let policy = RetryPolicy.standard
+
+        let cancelled = NSError(domain: NSURLErrorDomain, code: NSURLErrorCancelled)
+        XCTAssertFalse(policy.shouldRetry(error: cancelled, attempt: 0))
+        XCTAssertFalse(policy.shouldRetry(error: CancellationError(), attempt: 0))
+        XCTAssertTrue(policy.shouldRetry(error: NSError(domain: NSURLErrorDomain, code: NSURLErrorTimedOut), attempt: 0))
+    }
+
     func testShouldNotRetryOnParseError() {
         let policy = RetryPolicy.standard
 
@@ -96,6 +105,28 @@ final class RetryPolicyTests: XCTestCase {
         XCTAssertFalse(policy.shouldRetry(error: error, attempt: 0))
     }
 
+    func testShouldRetryAbortedStream() {
+        let policy = RetryPolicy(maxRetries: 1)
+
+        XCTAssertTrue(policy.shouldRetry(error: SwamlError.streamAborted("bad enum"), attempt: 0))
+        XCTAssertFalse(policy.shouldRetry(error: SwamlError.streamAborted("bad enum"), attempt: 1))
+    }
+
+    func testAbortedStreamRetriesWithoutDelay() async throws {
+        let executor = RetryExecutor(policy: RetryPolicy(maxRetries: 2, initialDelay: 60, jitter: false))
+        let start = Date()
+
+        let result = try await executor.execute { attempt in
+            if attempt < 2 {
+                throw SwamlError.streamAborted("attempt \(attempt)")
+            }
+            return attempt
+        }
+
+        XCTAssertEqual(result, 2)
+        XCTAssertLessThan(Date().timeIntervalSince(start), 5)
+    }
+
     func testShouldNotRetryAfterMaxAttempts() {
         let policy = RetryPolicy(maxRetries: 3)
 
@@ -0,0 +1,158 @@
+import XCTest
+@testable import SWAML
+
+final class SchemaPlanTests: XCTestCase {
+
+    private let person = JSONSchema.object(
+        properties: [
+            "name": .string,
+            "age": .integer,
+            "score": .number,
+            "active": .boolean,
+            "tags": .array(items: .string),
+        ],
+        required: ["name", "age"]
+    )
+
+    // MARK: - Coercion
+
+    func testCoercesScalars() throws {
+        let plan = SchemaPlan(schema: person)
+        let value = try plan.coerce(["name": 7, "age": "42", "score": 3, "active": "yes", "tags": [1, true]])
+
+        XCTAssertEqual(value, ["name": "7", "age": 42, "score": 3.0, "active": true, "tags": ["1", "true"]])
+        XCTAssertNoThrow(try plan.validate(value))
+    }
+
+    func testErrorsMatchTypeCoercion() {
+        let plan = SchemaPlan(schema: .integer)
+        XCTAssertThrowsError(try plan.coerce("abc")) { error in
+            XCTAssertEqual(error.localizedDescription, SwamlError.typeCoercionError(expected: "int", actual: "string 'abc'").localizedDescription)
+        }
+        XCTAssertThrowsError(try plan.coerce(1.5)) { error in
+            XCTAssertEqual(error.localizedDescription, SwamlError.typeCoercionError(expected: "int", actual: "float with decimal").localizedDescription)
+        }
+    }
+
+    func testOutOfRangeIntegersFailValidation() {
+        let plan = SchemaPlan(schema: .integer)
+        XCTAssertThrowsError(try plan.coerce(1e300)) { error in
+            XCTAssertEqual(error.localizedDescription, SwamlError.typeCoercionError(expected: "int", actual: "float out of range").localizedDescription)
+        }
+        XCTAssertThrowsError(try plan.coerce("1e300"))
+        XCTAssertThrowsError(try plan.coerce(.float(.infinity)))
+        XCTAssertEqual(try plan.coerce("3.0"), 3)
+    }
+
+    // MARK: - Validation
+
+    func testValidationErrors() {
+        let plan = SchemaPlan(schema: person)
+        XCTAssertThrowsError(try plan.validate(["name": "Ada"])) { error in
+            XCTAssertEqual(error.localizedDescription, SwamlError.schemaValidationError("Missing required property: age").localizedDescription)
+        }
+
+        let status = SchemaPlan(schema: .enum(values: ["open", "closed"]))
+        XCTAssertNoThrow(try status.validate("open"))
+        XCTAssertThrowsError(try status.validate("pending")) { error in
+            XCTAssertEqual(error.localizedDescription, SwamlError.schemaValidationError("Invalid enum value: pending. Expected one of: open, closed").localizedDescription)
+        }
+    }
+
+    func testDynamicEnumRefs() {
+        let plan = SchemaPlan(schema: .ref("Color"), dynamicEnums: ["Color": ["RED", "GREEN"]])
+        XCTAssertNoThrow(try plan.validate("RED"))
+        XCTAssertThrowsError(try plan.validate("BLUE"))
+
+        // Unknown refs accept anything
+        XCTAssertNoThrow(try SchemaPlan(schema: .ref("Other")).validate(["x": 1]))
+    }
+
+    // MARK: - anyOf
+
+    func testAnyOfSkipsBranchesByKind() throws {
+        let plan = SchemaPlan(schema: .anyOf([.null, .array(items: .integer), .integer]))
+        XCTAssertEqual(try plan.coerce(.null), .null)
+        XCTAssertEqual(try plan.coerce(["1", 2]), [1, 2])
+        XCTAssertEqual(try plan.coerce("3"), 3)
+        XCTAssertThrowsError(try plan.coerce(["a": 1])) { error in
+            XCTAssertEqual(error.localizedDescription, SwamlError.schemaValidationError("Value doesn't match any schema in anyOf").localizedDescription)
+        }
+    }
+
+    func testDiscriminatedAnyOf() throws {
+        let circle = JSONSchema.object(
+            properties: ["kind": .enum(values: ["circle"]), "radius": .number],
+            required: ["kind", "radius"]
+        )
+        let label = JSONSchema.object(
+            properties: ["kind": .enum(values: ["label"]), "radius": .string],
+            required: ["kind", "radius"]
+        )
+        let plan = SchemaPlan(schema: .array(items: .anyOf([circle, label])))
+
+        // Without the discriminator the label would match the circle branch, radius coerced to 2.0
+        let value = try plan.coerce([["kind": "circle", "radius": "2"], ["kind": "label", "radius": 2]])
+        XCTAssertEqual(value, [["kind": "circle", "radius": 2.0], ["kind": "label", "radius": "2"]])
+        XCTAssertNoThrow(try plan.validate(value))
+
+        XCTAssertThrowsError(try plan.validate([["kind": "square", "radius": 1.0]]))
+    }
+
+    // MARK: - Prefix Validation
+
+    func testPrefixAcceptsPartialOutput() {
+        let plan = SchemaPlan(schema: .object(
+            properties: [
+                "status": .enum(values: ["active", "archived"]),
+                "count": .integer,
+                "done": .boolean,
+                "tags": .array(items: .string),
+            ],
+            required: ["status", "count", "done", "tags"]
+        ))
+
+        XCTAssertNoThrow(try plan.validatePrefix([:]))
+        XCTAssertNoThrow(try plan.validatePrefix(["status": "ar", "count": "1", "done": "tr", "tags": []]))
+        XCTAssertNoThrow(try plan.validatePrefix(["status": "ACT"]))
+    }
+
+    func testPrefixRejectsUnmatchableOutput() {
+        let plan = SchemaPlan(schema: .object(
+            properties: ["status": .enum(values: ["active", "archived"]), "tags": .array(items: .string)],
+            required: ["status", "tags"]
+        ))
+
+        XCTAssertThrowsError(try plan.validatePrefix(["status": "pe"]))
+        XCTAssertThrowsError(try plan.validatePrefix(["tags": "a"]))
+        XCTAssertThrowsError(try plan.validatePrefix(["status": "active", "tags": [["x": 1]]]))
+        XCTAssertThrowsError(try plan.validatePrefix([["status": "active"]]))
+        XCTAssertThrowsError(try SchemaPlan(schema: .integer).validatePrefix("twelve"))
+    }
+
+    func testPrefixUsesDynamicEnumValues() {
+        let plan = SchemaPlan(schema: .ref("Category"), dynamicEnums: ["Category": ["Billing", "Shipping"]])
+
+        XCTAssertNoThrow(try plan.validatePrefix("Ship"))
+        XCTAssertThrowsError(try plan.validatePrefix("Refund"))
+    }
+
+    func testPrefixAcceptsAnyOfBranch() {
+        let plan = SchemaPlan(schema: .anyOf([.integer, .null]))
+
+        XCTAssertNoThrow(try plan.validatePrefix("4"))
+        XCTAssertNoThrow(try plan.validatePrefix(nil))
+        XCTAssertThrowsError(try plan.validatePrefix(["a"]))
+    }
+
+    // MARK: - Caching
+
+    func testCachedPlansAreShared() {
+        XCTAssertTrue(SchemaPlan.cached(for: person) === SchemaPlan.cached(for: person))
+    }
+
+    func testParserUsesPlan() throws {
+        let value = try OutputParser.parseToValue(#"{"name": "Ada", "age": "36"}"#, plan: SchemaPlan(schema: person))
+        XCTAssertEqual(value["age"], .int(36))
+    }
+}
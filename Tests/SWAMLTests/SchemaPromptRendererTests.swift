@@ -317,6 +317,34 @@ final class SchemaPromptRendererTests: XCTestCase {
         XCTAssertFalse(result.contains("Should not appear"))
     }
 
+    func testRenderUsesPrecomputedPrompt() {
+        struct Precomputed: SwamlTyped {
+            let name: String
+            let tags: [String]?
+
+            static var swamlTypeName: String { "Precomputed" }
+            static let swamlSchema: JSONSchema = .object(
+                properties: ["name": .string, "tags": .anyOf([.array(items: .string), .null])],
+                required: ["name"]
+            )
+            static let fieldDescriptions: [String: String] = ["name": "Display name"]
+            // Matches what @SwamlType emits for this type
+            static let swamlSchemaPrompt: String? =
+                "Answer in JSON using this schema:\n{\n  // Display name\n  name: string,\n  tags?: string[] | null,\n}"
+        }
+
+        let runtime = SchemaPromptRenderer.render(
+            schema: Precomputed.swamlSchema,
+            descriptions: Precomputed.fieldDescriptions
+        )
+        XCTAssertEqual(Precomputed.swamlSchemaPrompt, runtime)
+        XCTAssertEqual(SchemaPromptRenderer.render(for: Precomputed.self), runtime)
+
+        // Without descriptions the prompt is still rendered at runtime
+        let bare = SchemaPromptRenderer.render(for: Precomputed.self, includeDescriptions: false)
+        XCTAssertFalse(bare.contains("Display name"))
+    }
+
     // MARK: - Render from Class Name
 
     func testRenderFromClassName() {
@@ -340,4 +368,112 @@ final class SchemaPromptRendererTests: XCTestCase {
 
         XCTAssertEqual(result, "Answer in JSON.")
     }
+
+    // MARK: - Caching
+
+    func testCachedRenderMatchesUncachedOutput() {
+        struct CachedType: SwamlTyped {
+            let label: String
+
+            static var swamlTypeName: String { "CachedType" }
+            static var swamlSchema: JSONSchema {
+                .object(properties: ["label": .string], required: ["label"])
+            }
+            static var fieldDescriptions: [String: String] {
+                ["label": "A label"]
+            }
+        }
+
+        let tb = TypeBuilder()
+        let first = SchemaPromptRenderer.render(for: CachedType.self, typeBuilder: tb)
+        let second = SchemaPromptRenderer.render(for: CachedType.self, typeBuilder: tb)
+        let withoutDescriptions = SchemaPromptRenderer.render(for: CachedType.self, typeBuilder: tb, includeDescriptions: false)
+
+        XCTAssertEqual(first, second)
+        XCTAssertTrue(first.contains("// A label"))
+        XCTAssertFalse(withoutDescriptions.contains("// A label"))
+        XCTAssertEqual(tb.schemaCache.count, 2)
+    }
+
+    func testCacheIsInvalidatedWhenDynamicEnumChanges() {
+        struct Ticket: SwamlTyped {
+            let status: String
+
+            static var swamlTypeName: String { "Ticket" }
+            static var swamlSchema: JSONSchema {
+                .object(properties: ["status": .ref("TicketStatus")], required: ["status"])
+            }
+        }
+
+        let tb = TypeBuilder()
+        let status = tb.enumBuilder("TicketStatus")
+        status.addValue("open")
+
+        let before = SchemaPromptRenderer.render(for: Ticket.self, typeBuilder: tb)
+        XCTAssertTrue(before.contains("\"open\""))
+        XCTAssertFalse(before.contains("\"closed\""))
+
+        status.addValue("closed")
+
+        let after = SchemaPromptRenderer.render(for: Ticket.self, typeBuilder: tb)
+        XCTAssertTrue(after.contains("\"open\" | \"closed\""))
+    }
+
+    func testCacheIsInvalidatedWhenPropertyDescriptionChanges() {
+        let tb = TypeBuilder()
+        let property = tb.addClass("Report").addProperty("title", .string)
+
+        let before = SchemaPromptRenderer.render(className: "Report", from: tb)
+        XCTAssertFalse(before.contains("// Headline"))
+
+        property.description("Headline")
+
+        let after = SchemaPromptRenderer.render(className: "Report", from: tb)
+        XCTAssertTrue(after.contains("// Headline"))
+    }
+
+    func testOnlyFunctionSchemaHitsAreCheckedAgainstTheSource() {
+        let cache = SchemaCache()
+        let first = JSONSchema.object(properties: ["a": .integer], required: ["a"])
+        let second = JSONSchema.object(properties: ["b": .integer], required: ["b"])
+        var resolves = 0
+        func resolve(_ key: SchemaCache.Key, _ source: JSONSchema) -> JSONSchema {
+            cache.resolvedSchema(for: key, source: source, generation: 0) {
+                resolves += 1
+                return source
+            }.schema
+        }
+
+        // A type's schema is fixed, so its entry is trusted as is
+        let output = SchemaCache.Key.output(ObjectIdentifier(Int.self))
+        XCTAssertEqual(resolve(output, first), first)
+        XCTAssertEqual(resolve(output, first), first)
+        XCTAssertEqual(resolves, 1)
+
+        // A function can be called with a different schema under the same name
+        XCTAssertEqual(resolve(.function("F"), first), first)
+        XCTAssertEqual(resolve(.function("F"), second), second)
+        XCTAssertEqual(resolve(.function("F"), second), second)
+        XCTAssertEqual(resolves, 3)
+    }
+
+    func testTypesWithSameNameDoNotShareCacheEntries() {
+        enum First {
+            struct Item: SwamlTyped {
+                let a: Int
+                static var swamlTypeName: String { "Item" }
+                static var swamlSchema: JSONSchema { .object(properties: ["a": .integer], required: ["a"]) }
+            }
+        }
+        enum Second {
+            struct Item: SwamlTyped {
+                let b: Int
+                static var swamlTypeName: String { "Item" }
+                static var swamlSchema: JSONSchema { .object(properties: ["b": .integer], required: ["b"]) }
+            }
+        }
+
+        XCTAssertTrue(SchemaPromptRenderer.render(for: First.Item.self).contains("a: int"))
+        XCTAssertTrue(SchemaPromptRenderer.render(for: Second.Item.self).contains("b: int"))
+    }
 }
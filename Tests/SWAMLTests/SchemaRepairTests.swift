@@ -0,0 +1,173 @@
+import XCTest
+@testable import SWAML
+
+final class SchemaRepairTests: XCTestCase {
+
+    enum Status: String, Codable {
+        case active, pending, archived
+    }
+
+    struct Order: SwamlTyped {
+        let orderId: Int
+        let total: Double
+        let status: Status
+        let note: String?
+        let items: [String]
+
+        static var swamlTypeName: String { "Order" }
+        static var swamlSchema: JSONSchema {
+            .object(
+                properties: [
+                    "orderId": .integer,
+                    "total": .number,
+                    "status": .enum(values: ["active", "pending", "archived"]),
+                    "note": .anyOf([.string, .null]),
+                    "items": .array(items: .string),
+                ],
+                required: ["orderId", "total", "status", "note", "items"]
+            )
+        }
+        static var fieldAliases: [String: String] { ["total": "amount"] }
+    }
+
+    // MARK: - Fixes
+
+    func testMatchesEnumCasing() {
+        let repair = SchemaRepair(schema: .enum(values: ["active", "pending"]))
+
+        let result = repair.repair("ACTIVE")
+
+        XCTAssertEqual(result?.value, "active")
+        XCTAssertEqual(result?.fixes, [.matchedEnum])
+    }
+
+    func testMatchesEnumWithinProseAndTypos() {
+        let values = ["positive", "negative", "neutral"]
+
+        XCTAssertEqual(SchemaRepair.matchEnum("Positive.", values), "positive")
+        XCTAssertEqual(SchemaRepair.matchEnum("The sentiment is negative", values), "negative")
+        XCTAssertEqual(SchemaRepair.matchEnum("neutrl", values), "neutral")
+        XCTAssertNil(SchemaRepair.matchEnum("mixed", values))
+    }
+
+    func testAmbiguousEnumIsNotGuessed() {
+        XCTAssertNil(SchemaRepair.matchEnum("positive or negative", ["positive", "negative"]))
+        XCTAssertNil(SchemaRepair.matchEnum("cay", ["cat", "car"]))
+    }
+
+    func testEnumMustBeNamedAsAWholeWord() {
+        let values = ["positive", "negative", "neutral"]
+
+        XCTAssertNil(SchemaRepair.matchEnum("not positive", values))
+        XCTAssertNil(SchemaRepair.matchEnum("It isn't negative", values))
+        XCTAssertNil(SchemaRepair.matchEnum("nonpositive", values))
+        XCTAssertEqual(SchemaRepair.matchEnum("Overall: NEUTRAL, mostly", values), "neutral")
+        XCTAssertEqual(SchemaRepair.matchEnum("a shipping delay", ["shipping delay", "billing"]), "shipping delay")
+    }
+
+    func testCoercesNumbersSentAsStrings() {
+        let schema = JSONSchema.object(properties: ["count": .integer, "price": .number], required: ["count", "price"])
+
+        let result = SchemaRepair(schema: schema).repair(["count": " 42", "price": "9.5"])
+
+        XCTAssertEqual(result?.value, ["count": 42, "price": 9.5])
+    }
+
+    func testFillsMissingNullableField() {
+        let schema = JSONSchema.object(properties: ["note": .anyOf([.string, .null])], required: ["note"])
+
+        let result = SchemaRepair(schema: schema).repair([:])
+
+        XCTAssertEqual(result?.value, ["note": nil])
+        XCTAssertEqual(result?.fixes, [.filledNull])
+    }
+
+    func testWrapsSingleObjectInArray() {
+        let schema = JSONSchema.array(items: .object(properties: ["id": .integer], required: ["id"]))
+
+        XCTAssertEqual(SchemaRepair(schema: schema).repair(["id": 1])?.value, [["id": 1]])
+        XCTAssertEqual(SchemaRepair(schema: schema).repair(["results": [["id": 1]]])?.value, [["id": 1]])
+    }
+
+    func testUnwrapsSingleElementArrayForObject() {
+        let schema = JSONSchema.object(properties: ["id": .integer], required: ["id"])
+
+        let result = SchemaRepair(schema: schema).repair([["id": 1]])
+
+        XCTAssertEqual(result?.value, ["id": 1])
+        XCTAssertEqual(result?.fixes, [.unwrappedObject])
+    }
+
+    func testRenamesAliasedAndMisspelledKeys() {
+        let result = SchemaRepair(for: Order.self).repair([
+            "order_id": 7,
+            "amount": "19.99",
+            "Status": "Pending",
+            "items": "widget",
+        ])
+
+        XCTAssertEqual(result?.value, [
+            "orderId": 7,
+            "total": 19.99,
+            "status": "pending",
+            "note": nil,
+            "items": ["widget"],
+        ])
+    }
+
+    func testRepairedValueDecodes() throws {
+        let value = try JsonishParser.parseValue(#"{"OrderID": "3", "amount": 5, "status": "ARCHIVED", "items": []}"#)
+        XCTAssertThrowsError(try SwamlValueDecoder().decode(Order.self, from: value))
+
+        let repaired = try XCTUnwrap(SchemaRepair(for: Order.self).repair(value))
+        let order = try SwamlValueDecoder().decode(Order.self, from: repaired.value)
+
+        XCTAssertEqual(order.orderId, 3)
+        XCTAssertEqual(order.status, .archived)
+        XCTAssertNil(order.note)
+    }
+
+    func testPicksRepairableUnionBranch() {
+        let schema = JSONSchema.anyOf([.integer, .enum(values: ["none"])])
+
+        XCTAssertEqual(SchemaRepair(schema: schema).repair("12")?.value, 12)
+        XCTAssertEqual(SchemaRepair(schema: schema).repair("None")?.value, "none")
+    }
+
+    func testDynamicEnumReference() {
+        let repair = SchemaRepair(schema: .ref("Category"), dynamicEnums: ["Category": ["Billing", "Shipping"]])
+
+        XCTAssertEqual(repair.repair("shipping")?.value, "Shipping")
+    }
+
+    // MARK: - Giving Up
+
+    func testMatchingValueIsUnchanged() {
+        let result = SchemaRepair(schema: .array(items: .string)).repair(["a", "b"])
+
+        XCTAssertEqual(result?.value, ["a", "b"])
+        XCTAssertEqual(result?.fixes, [])
+    }
+
+    func testGivesUpOnUnrepairableValue() {
+        let schema = JSONSchema.object(properties: ["id": .integer], required: ["id"])
+
+        XCTAssertNil(SchemaRepair(schema: schema).repair(["id": "seven"]))
+        XCTAssertNil(SchemaRepair(schema: schema).repair(["name": "x"]))
+        XCTAssertNil(SchemaRepair(schema: .enum(values: ["a", "b"])).repair("zzz"))
+    }
+
+    // MARK: - Helpers
+
+    func testNormalizedKey() {
+        XCTAssertEqual(SchemaRepair.normalizedKey("order_id"), "orderid")
+        XCTAssertEqual(SchemaRepair.normalizedKey("Order ID"), "orderid")
+        XCTAssertEqual(SchemaRepair.normalizedKey("orderId"), "orderid")
+    }
+
+    func testEditDistance() {
+        XCTAssertEqual(SchemaRepair.editDistance("kitten", "sitting"), 3)
+        XCTAssertEqual(SchemaRepair.editDistance("", "abc"), 3)
+        XCTAssertEqual(SchemaRepair.editDistance("same", "same"), 0)
+    }
+}
@@ -0,0 +1,189 @@
+import XCTest
+@testable import SWAML
+
+final class StructuredOutputTests: XCTestCase {
+
+    struct Verdict: Codable, Equatable {
+        let label: String
+        let score: Double
+    }
+
+    private let verdictSchema = JSONSchema.object(
+        properties: ["label": .string, "score": .number],
+        required: ["label", "score"]
+    )
+
+    struct Rating: SwamlTyped {
+        let label: String
+        let score: Double
+
+        static var swamlTypeName: String { "Rating" }
+        static var swamlSchema: JSONSchema {
+            .object(properties: ["label": .string, "score": .number], required: ["label", "score"])
+        }
+        static var fieldDescriptions: [String: String] { ["label": "good or bad"] }
+    }
+
+    private final class MetricsBox: @unchecked Sendable {
+        let lock = NSLock()
+        var metrics: CallMetrics?
+    }
+
+    /// Run `body` as a traced call and return its metrics
+    private func traced(_ body: () throws -> Void) async throws -> CallMetrics {
+        let box = MetricsBox()
+        let observer = CallMetricsHandler { metrics in
+            box.lock.lock()
+            box.metrics = metrics
+            box.lock.unlock()
+        }
+        try await CallTrace.run("test", tags: [:], observer: observer) {
+            try body()
+        }
+        box.lock.lock()
+        defer { box.lock.unlock() }
+        return try XCTUnwrap(box.metrics)
+    }
+
+    // MARK: - Capabilities
+
+    func testCapabilityTable() {
+        XCTAssertEqual(LLMProvider.openAI(apiKey: "k").structuredOutput, .jsonSchema)
+        XCTAssertEqual(LLMProvider.anthropic(apiKey: "k").structuredOutput, .toolUse)
+        XCTAssertEqual(LLMProvider.openRouter(apiKey: "k").structuredOutput, .prompt)
+        XCTAssertTrue(LLMProvider.anthropic(apiKey: "k").supportsBatchAPI)
+        XCTAssertFalse(LLMProvider.anthropic(apiKey: "k").supportsPromptCacheKey)
+    }
+
+    func testWhichSchemasQualify() {
+        let optionalScore = JSONSchema.object(properties: ["label": .string, "score": .number], required: ["label"])
+        let withRef = JSONSchema.object(properties: ["label": .ref("Label")], required: ["label"])
+
+        XCTAssertTrue(LLMProvider.StructuredOutput.jsonSchema.accepts(verdictSchema))
+        XCTAssertFalse(LLMProvider.StructuredOutput.jsonSchema.accepts(optionalScore))
+        XCTAssertTrue(LLMProvider.StructuredOutput.toolUse.accepts(optionalScore))
+        XCTAssertFalse(LLMProvider.StructuredOutput.toolUse.accepts(withRef))
+        XCTAssertFalse(LLMProvider.StructuredOutput.toolUse.accepts(.array(items: verdictSchema)))
+        XCTAssertFalse(LLMProvider.StructuredOutput.prompt.accepts(verdictSchema))
+
+        let resolved = withRef.resolvingEnums(["Label": ["good", "bad"]])
+        XCTAssertTrue(LLMProvider.StructuredOutput.jsonSchema.accepts(resolved))
+    }
+
+    func testNativeOutputIsOptIn() async {
+        let client = SwamlClient(provider: .openAI(apiKey: "test"))
+        let usesNative = await client.usesNativeStructuredOutput
+        XCTAssertFalse(usesNative)
+        let format = await client.outputFormat(for: Rating.self)
+        XCTAssertFalse(format.isNative)
+    }
+
+    func testNativeSchemaCarriesDescriptions() async throws {
+        let client = SwamlClient(provider: .openAI(apiKey: "test"))
+        await client.setNativeStructuredOutput(true)
+
+        let format = await client.outputFormat(for: Rating.self)
+
+        guard case .jsonSchema(_, let schema, true) = format.responseFormat else {
+            return XCTFail("Expected a strict json_schema format")
+        }
+        let properties = try XCTUnwrap(schema["properties"] as? [String: [String: Any]])
+        XCTAssertEqual(properties["label"]?["description"] as? String, "good or bad")
+        XCTAssertNil(properties["score"]?["description"])
+        let encoded = try XCTUnwrap(format.encodedSchema)
+        XCTAssertTrue(String(decoding: encoded.bytes, as: UTF8.self).contains("good or bad"))
+    }
+
+    // MARK: - Anthropic Tool Use
+
+    func testAnthropicBodyForcesOutputTool() async throws {
+        let client = LLMClient(provider: .anthropic(apiKey: "test"))
+
+        var writer = JSONBodyWriter()
+        await client.writeAnthropicRequestBody(
+            into: &writer,
+            model: "claude",
+            messages: [.user("Rate this")],
+            responseFormat: .jsonSchema(name: "Verdict.v1", schema: verdictSchema.toDictionary(), strict: true),
+            temperature: nil,
+            maxTokens: 50,
+            topP: nil,
+            stop: nil
+        )
+
+        let body = try XCTUnwrap(try JSONSerialization.jsonObject(with: Data(writer.bytes)) as? [String: Any])
+        let tool = try XCTUnwrap((body["tools"] as? [[String: Any]])?.first)
+        XCTAssertEqual(tool["name"] as? String, "Verdict_v1")
+        XCTAssertEqual((tool["input_schema"] as? [String: Any])?["type"] as? String, "object")
+        let choice = try XCTUnwrap(body["tool_choice"] as? [String: Any])
+        XCTAssertEqual(choice["type"] as? String, "tool")
+        XCTAssertEqual(choice["name"] as? String, "Verdict_v1")
+    }
+
+    func testToolInputBecomesContent() throws {
+        let json = """
+            {"id": "msg_1", "type": "message", "role": "assistant", "model": "claude",
+             "content": [{"type": "tool_use", "id": "t1", "name": "Verdict",
+                          "input": {"label": "good", "score": 0.5}}],
+             "stop_reason": "tool_use", "usage": {"input_tokens": 10, "output_tokens": 5}}
+            """
+
+        let response = try JSONDecoder()
+            .decode(AnthropicCompletionResponse.self, from: Data(json.utf8))
+            .toLLMResponse
+
+        // Anthropic doesn't hold tool input to the schema
+        XCTAssertFalse(response.isSchemaConstrained)
+        XCTAssertEqual(response.finishReason, .toolCalls)
+        XCTAssertEqual(try OutputParser.parse(response, plan: nil, type: Verdict.self), Verdict(label: "good", score: 0.5))
+    }
+
+    // MARK: - Strict Decoding
+
+    func testTruncatedStrictOutputIsNotConstrained() throws {
+        let json = """
+            {"id": "c1", "object": "chat.completion", "created": 0, "model": "gpt-4o",
+             "choices": [{"index": 0, "message": {"role": "assistant", "content": "{\\"label\\": \\"go"},
+                          "finish_reason": "length"}]}
+            """
+
+        let response = try JSONDecoder()
+            .decode(OpenAICompletionResponse.self, from: Data(json.utf8))
+            .toLLMResponse(schemaConstrained: true)
+
+        XCTAssertFalse(response.isSchemaConstrained)
+    }
+
+    func testConstrainedOutputSkipsTolerantParser() async throws {
+        let response = LLMResponse(content: #"{"label": "good", "score": 1}"#, model: "m", isSchemaConstrained: true)
+
+        let metrics = try await traced {
+            XCTAssertEqual(try OutputParser.parse(response, plan: nil, type: Verdict.self), Verdict(label: "good", score: 1))
+        }
+
+        XCTAssertEqual(metrics.strictDecodes, 1)
+        XCTAssertTrue(metrics.parsePaths.isEmpty)
+    }
+
+    func testTolerantParserIsTheFallback() async throws {
+        let fenced = "```json\n{\"label\": \"good\", \"score\": \"0.5\"}\n```"
+        let plan = SchemaPlan(schema: verdictSchema)
+
+        let metrics = try await traced {
+            let constrained = LLMResponse(content: fenced, model: "m", isSchemaConstrained: true)
+            XCTAssertEqual(try OutputParser.parse(constrained, plan: plan, type: Verdict.self), Verdict(label: "good", score: 0.5))
+
+            let unconstrained = LLMResponse(content: #"{"label": "good", "score": 2}"#, model: "m")
+            XCTAssertEqual(try OutputParser.parseToValue(unconstrained, plan: plan)["label"], "good")
+        }
+
+        XCTAssertEqual(metrics.strictDecodes, 0)
+    }
+
+    func testConstrainedValueIsValidated() throws {
+        let plan = SchemaPlan(schema: verdictSchema)
+        let response = LLMResponse(content: #"{"label": "good", "score": "high"}"#, model: "m", isSchemaConstrained: true)
+
+        XCTAssertThrowsError(try OutputParser.parseToValue(response, plan: plan))
+    }
+}
@@ -0,0 +1,134 @@
+import XCTest
+@testable import SWAML
+
+final class SwamlSessionTests: XCTestCase {
+
+    struct Reply: SwamlTyped {
+        let answer: String
+
+        static var swamlTypeName: String { "Reply" }
+        static var swamlSchema: JSONSchema {
+            .object(properties: ["answer": .string], required: ["answer"])
+        }
+    }
+
+    private func body(_ client: LLMClient, _ messages: [ChatMessage]) async -> [UInt8] {
+        var writer = JSONBodyWriter()
+        await client.writeOpenAIRequestBody(
+            into: &writer,
+            model: "gpt-4o",
+            messages: messages,
+            responseFormat: nil,
+            temperature: nil,
+            maxTokens: nil,
+            topP: nil,
+            stop: nil
+        )
+        return writer.bytes
+    }
+
+    // MARK: - Message Encodings
+
+    func testMessagesAreEncodedOnce() async {
+        let client = LLMClient(provider: .openAI(apiKey: "test"))
+        let kept = ChatMessage.user("Where is my \"order\"?").withEncodings()
+
+        let first = await body(client, [kept])
+        let second = await body(client, [kept, .assistant("On its way")])
+        let plainFirst = await body(client, [.user("Where is my \"order\"?")])
+        let plainSecond = await body(client, [.user("Where is my \"order\"?"), .assistant("On its way")])
+
+        XCTAssertEqual(kept.encodings?.count, 1)
+        XCTAssertEqual(first, plainFirst)
+        XCTAssertEqual(second, plainSecond)
+    }
+
+    func testEncodingsDontAffectEquality() {
+        let message = ChatMessage.user("Hi")
+
+        XCTAssertEqual(message.withEncodings(), message)
+    }
+
+    func testAttachmentsAreNotKept() {
+        let message = ChatMessage.user("Look", attachments: [.init(data: Data([1, 2]), mediaType: "image/png")])
+
+        XCTAssertNil(message.withEncodings().encodings)
+    }
+
+    // MARK: - Prefix
+
+    func testSchemaPrefixStaysTheSame() async {
+        let session = SwamlSession(
+            client: SwamlClient(provider: .openRouter(apiKey: "test")),
+            model: "m",
+            systemPrompt: "Be brief."
+        )
+
+        _ = await session.prepare(for: Reply.self)
+        let before = await session.messages
+        await session.append([.user("Hi"), .assistant(#"{"answer": "Hello"}"#)])
+        _ = await session.prepare(for: Reply.self)
+        let after = await session.messages
+
+        XCTAssertEqual(before.count, 2)
+        XCTAssertEqual(before[0].content.textValue, "Be brief.")
+        XCTAssertTrue(before[1].content.textValue?.contains("answer: string") == true)
+        XCTAssertTrue(before[1].encodings === after[1].encodings)
+        XCTAssertEqual(after.count, 4)
+    }
+
+    func testNativeSchemaIsLeftOutOfThePrompt() async {
+        let client = SwamlClient(provider: .openAI(apiKey: "test"))
+        await client.setNativeStructuredOutput(true)
+        let session = SwamlSession(client: client, model: "m")
+
+        let format = await session.prepare(for: Reply.self)
+
+        XCTAssertTrue(format.isNative)
+        let messages = await session.messages
+        XCTAssertTrue(messages.isEmpty)
+    }
+
+    // MARK: - Budget
+
+    private func turns(_ count: Int, length: Int = 400) -> [ChatMessage] {
+        (0..<count).flatMap { turn in
+            [ChatMessage.user("question \(turn) " + String(repeating: "x", count: length)), .assistant("answer \(turn)")]
+        }
+    }
+
+    func testTruncatesWholeTurnsDownToTarget() async throws {
+        let session = SwamlSession(
+            client: SwamlClient(provider: .openRouter(apiKey: "test")),
+            model: "m",
+            systemPrompt: "Be brief.",
+            budget: .init(maxTokens: 1000, target: 0.5)
+        )
+        await session.append(turns(10))
+
+        try await session.compactIfNeeded(adding: .user("next"))
+
+        let history = await session.history
+        XCTAssertLessThan(history.count, 20)
+        XCTAssertEqual(history.first?.role, .user)
+        XCTAssertEqual(history.last?.content.textValue, "answer 9")
+        let messages = await session.messages
+        XCTAssertEqual(messages.first?.content.textValue, "Be brief.")
+        let tokens = await session.contextTokens
+        XCTAssertLessThanOrEqual(try XCTUnwrap(tokens), 500)
+    }
+
+    func testWithinBudgetKeepsHistory() async throws {
+        let session = SwamlSession(
+            client: SwamlClient(provider: .openRouter(apiKey: "test")),
+            model: "m",
+            budget: .init(maxTokens: 100_000)
+        )
+        await session.append(turns(3))
+
+        try await session.compactIfNeeded(adding: .user("next"))
+
+        let history = await session.history
+        XCTAssertEqual(history.count, 6)
+    }
+}
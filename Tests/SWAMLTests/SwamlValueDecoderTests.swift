@@ -0,0 +1,177 @@
+import XCTest
+@testable import SWAML
+
+final class SwamlValueDecoderTests: XCTestCase {
+
+    struct Person: Codable, Equatable {
+        let name: String
+        let age: Int
+    }
+
+    struct Order: SwamlTyped, Equatable {
+        let orderId: String
+        let totalCents: Int
+        let isGift: Bool
+
+        static var swamlTypeName: String { "Order" }
+        static var swamlSchema: JSONSchema {
+            .object(
+                properties: ["orderId": .string, "totalCents": .integer, "isGift": .boolean],
+                required: ["orderId", "totalCents", "isGift"]
+            )
+        }
+        static var fieldAliases: [String: String] { ["totalCents": "total"] }
+    }
+
+    enum Status: String, Codable {
+        case active
+        case inactive
+    }
+
+    // MARK: - Basic Decoding
+
+    func testDecodeStruct() throws {
+        let value: SwamlValue = ["name": "Alice", "age": 30]
+        let person = try SwamlValueDecoder().decode(Person.self, from: value)
+        XCTAssertEqual(person, Person(name: "Alice", age: 30))
+    }
+
+    func testDecodeNestedCollections() throws {
+        struct Team: Codable {
+            let members: [Person]
+            let scores: [String: Double]
+            let lead: Person?
+            let status: Status
+        }
+
+        let value: SwamlValue = [
+            "members": [["name": "A", "age": 1], ["name": "B", "age": 2]],
+            "scores": ["A": 1.5, "B": 2],
+            "lead": nil,
+            "status": "active"
+        ]
+        let team = try SwamlValueDecoder().decode(Team.self, from: value)
+
+        XCTAssertEqual(team.members.map(\.name), ["A", "B"])
+        XCTAssertEqual(team.scores["B"], 2.0)
+        XCTAssertNil(team.lead)
+        XCTAssertEqual(team.status, .active)
+    }
+
+    func testDecodeSwamlValuePassesThrough() throws {
+        struct Wrapper: Codable {
+            let payload: SwamlValue
+        }
+
+        let value: SwamlValue = ["payload": ["flag": "1", "n": 2]]
+        let wrapper = try SwamlValueDecoder().decode(Wrapper.self, from: value)
+        XCTAssertEqual(wrapper.payload, ["flag": "1", "n": 2])
+    }
+
+    // MARK: - Key Resolution
+
+    func testSnakeCaseKeys() throws {
+        let value: SwamlValue = ["order_id": "A1", "total_cents": 500, "is_gift": false]
+        let order = try SwamlValueDecoder().decode(Order.self, from: value)
+        XCTAssertEqual(order, Order(orderId: "A1", totalCents: 500, isGift: false))
+    }
+
+    func testExactKeyWinsOverSnakeCase() throws {
+        let value: SwamlValue = ["orderId": "exact", "order_id": "snake", "totalCents": 1, "isGift": true]
+        let order = try SwamlValueDecoder().decode(Order.self, from: value)
+        XCTAssertEqual(order.orderId, "exact")
+    }
+
+    func testFieldAliases() throws {
+        let value: SwamlValue = ["order_id": "A1", "total": 500, "is_gift": true]
+        let order = try SwamlValueDecoder().decode(Order.self, from: value)
+        XCTAssertEqual(order.totalCents, 500)
+    }
+
+    func testFieldAliasesOfNestedTypes() throws {
+        struct Cart: Codable {
+            let orders: [Order]
+        }
+
+        let value: SwamlValue = ["orders": [["orderId": "A1", "total": 5, "isGift": false]]]
+        let cart = try SwamlValueDecoder().decode(Cart.self, from: value)
+        XCTAssertEqual(cart.orders.first?.totalCents, 5)
+    }
+
+    func testDictionaryKeysAreNotConverted() throws {
+        let value: SwamlValue = ["first_key": 1, "second_key": 2]
+        let dict = try SwamlValueDecoder().decode([String: Int].self, from: value)
+        XCTAssertEqual(dict, ["first_key": 1, "second_key": 2])
+    }
+
+    // MARK: - Coercion
+
+    func testScalarsAreCoerced() throws {
+        let value: SwamlValue = ["order_id": 42, "total_cents": "500", "is_gift": "yes"]
+        let order = try SwamlValueDecoder().decode(Order.self, from: value)
+        XCTAssertEqual(order, Order(orderId: "42", totalCents: 500, isGift: true))
+    }
+
+    func testWholeFloatDecodesAsInt() throws {
+        let value: SwamlValue = ["name": "Bob", "age": 25.0]
+        XCTAssertEqual(try SwamlValueDecoder().decode(Person.self, from: value).age, 25)
+    }
+
+    func testWideIntegersDecodeExactly() throws {
+        struct Counter: Codable {
+            let total: UInt64
+        }
+        let value: SwamlValue = ["total": .float(18_000_000_000_000_000_000)]
+        XCTAssertEqual(try SwamlValueDecoder().decode(Counter.self, from: value).total, 18_000_000_000_000_000_000)
+    }
+
+    func testDecimalKeepsItsDigits() throws {
+        struct Price: Codable {
+            let amount: Decimal
+        }
+        let decoder = SwamlValueDecoder()
+        XCTAssertEqual(try decoder.decode(Price.self, from: ["amount": 0.1]).amount, Decimal(string: "0.1"))
+        XCTAssertEqual(try decoder.decode(Price.self, from: ["amount": "19.99"]).amount, Decimal(string: "19.99"))
+    }
+
+    // MARK: - Errors
+
+    func testNumbersOutOfRangeThrowTypeMismatch() {
+        struct Small: Codable {
+            let count: UInt8
+        }
+        for number: SwamlValue in [.float(1e20), -1, 300, 2.5] {
+            XCTAssertThrowsError(try SwamlValueDecoder().decode(Small.self, from: ["count": number])) { error in
+                guard case DecodingError.typeMismatch = error else {
+                    return XCTFail("Expected typeMismatch, got \(error)")
+                }
+            }
+        }
+        XCTAssertThrowsError(try SwamlValueDecoder().decode(Person.self, from: ["name": "Bob", "age": .float(1e20)]))
+    }
+
+    func testMissingKeyThrows() {
+        let value: SwamlValue = ["name": "Alice"]
+        XCTAssertThrowsError(try SwamlValueDecoder().decode(Person.self, from: value)) { error in
+            guard case DecodingError.keyNotFound(let key, _) = error else {
+                return XCTFail("Expected keyNotFound, got \(error)")
+            }
+            XCTAssertEqual(key.stringValue, "age")
+        }
+    }
+
+    func testUncoercibleValueThrowsTypeMismatch() {
+        let value: SwamlValue = ["name": "Alice", "age": "thirty"]
+        XCTAssertThrowsError(try SwamlValueDecoder().decode(Person.self, from: value)) { error in
+            guard case DecodingError.typeMismatch(_, let context) = error else {
+                return XCTFail("Expected typeMismatch, got \(error)")
+            }
+            XCTAssertEqual(context.codingPath.map(\.stringValue), ["age"])
+        }
+    }
+
+    func testNullForRequiredValueThrows() {
+        let value: SwamlValue = ["name": nil, "age": 1]
+        XCTAssertThrowsError(try SwamlValueDecoder().decode(Person.self, from: value))
+    }
+}
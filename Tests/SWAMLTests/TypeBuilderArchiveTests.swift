@@ -0,0 +1,183 @@
+import XCTest
+@testable import SWAML
+
+final class TypeBuilderArchiveTests: XCTestCase {
+
+    struct Ticket: SwamlTyped {
+        let category: String
+
+        static var swamlTypeName: String { "Ticket" }
+        static var swamlSchema: JSONSchema {
+            .object(properties: ["category": .ref("Category")], required: ["category"])
+        }
+    }
+
+    private let classifySchema = JSONSchema.object(
+        properties: ["category": .ref("Category"), "tags": .array(items: .string)],
+        required: ["category"]
+    )
+
+    private func built() -> TypeBuilder {
+        let tb = TypeBuilder()
+        tb.registerDynamicType("Category")
+        let categories = tb.enumBuilder("Category")
+        categories.addValue("Billing").alias("invoices")
+        categories.addValue("ShippingDelay").description("Orders arriving late")
+        categories.shortlist(10)
+        _ = tb.enumBuilder("Empty")
+
+        let order = tb.addClass("Order")
+        order.addProperty("id", tb.string()).description("Order number")
+        order.addProperty("status", tb.union(tb.literalString("open"), tb.literalInt(-1)))
+        order.addProperty("items", tb.map(key: tb.string(), value: tb.float().list()).optional()).alias("lines")
+        order.addProperty("category", categories.type())
+        return tb
+    }
+
+    // MARK: - Round Trip
+
+    func testRestoresTypes() throws {
+        let original = built()
+        let restored = TypeBuilder()
+        restored.addEnum("Stale").addValue("Gone")
+
+        try restored.load(original.archive())
+
+        let expected = original.snapshot()
+        let snapshot = restored.snapshot()
+        XCTAssertEqual(snapshot.dynamicTypes, expected.dynamicTypes)
+        XCTAssertEqual(snapshot.enums, expected.enums)
+        XCTAssertEqual(snapshot.classes, expected.classes)
+        XCTAssertEqual(restored.enumBuilder("Category").resolve("INVOICES"), "Billing")
+        XCTAssertEqual(restored.enumBuilder("Category").shortlistLimit, 10)
+    }
+
+    func testRestoredBuildersKeepTracking() throws {
+        let restored = TypeBuilder()
+        try restored.load(built().archive())
+        let generation = restored.generation
+
+        restored.enumBuilder("Category").addValue("Refund")
+        restored.addClass("Order").allPropertyBuilders[0].description("Changed")
+
+        XCTAssertEqual(restored.generation, generation + 2)
+        XCTAssertEqual(restored.snapshot().enums["Category"]?.valueNames.last, "Refund")
+        XCTAssertEqual(restored.snapshot().classes["Order"]?.descriptions["id"], "Changed")
+    }
+
+    func testLoadDetachesReplacedBuilders() throws {
+        let tb = TypeBuilder()
+        let stale = tb.enumBuilder("Category")
+        let staleValue = stale.addValue("Old")
+
+        try tb.load(built().archive())
+        let generation = tb.generation
+        stale.addValue("Lost")
+        staleValue.description("Lost")
+
+        XCTAssertEqual(tb.generation, generation)
+        XCTAssertEqual(tb.snapshot().enums["Category"]?.valueNames, ["Billing", "ShippingDelay"])
+        XCTAssertFalse(tb.enumBuilder("Category") === stale)
+    }
+
+    // MARK: - Cached Entries
+
+    func testRestoresPromptsAndSchemas() throws {
+        let original = built()
+        let archive = original.archive(types: [Ticket.self], functions: ["Classify": classifySchema])
+        let restored = TypeBuilder()
+
+        try restored.load(archive, types: [Ticket.self])
+
+        // Ticket's prompt and output schema, Order's prompt, Classify's schema
+        XCTAssertEqual(restored.schemaCache.count, 4)
+        XCTAssertEqual(
+            SchemaPromptRenderer.render(for: Ticket.self, typeBuilder: restored),
+            SchemaPromptRenderer.render(for: Ticket.self, typeBuilder: original)
+        )
+        let resolved = restored.schemaCache.resolvedSchema(
+            for: .function("Classify"),
+            source: classifySchema,
+            generation: restored.generation
+        ) {
+            XCTFail("Classify's schema was resolved again")
+            return classifySchema
+        }
+        XCTAssertEqual(resolved.schema, classifySchema.resolvingEnums(["Category": ["Billing", "ShippingDelay"]]))
+        XCTAssertEqual(resolved.encoded, EncodedJSON(any: resolved.dictionary))
+    }
+
+    func testSkipsEntriesOfTypesNotPassed() throws {
+        let archive = built().archive(types: [Ticket.self])
+        let restored = TypeBuilder()
+
+        try restored.load(archive)
+
+        // Only the dynamic class's prompt
+        XCTAssertEqual(restored.schemaCache.count, 1)
+    }
+
+    func testSkipsEntriesOfChangedTypes() throws {
+        struct RevisedTicket: SwamlTyped {
+            let category: String
+            let urgent: Bool
+
+            static var swamlTypeName: String { "Ticket" }
+            static var swamlSchema: JSONSchema {
+                .object(properties: ["category": .ref("Category"), "urgent": .boolean], required: ["category", "urgent"])
+            }
+        }
+        let archive = built().archive(types: [Ticket.self])
+        let restored = TypeBuilder()
+
+        try restored.load(archive, types: [RevisedTicket.self])
+
+        // Only the dynamic class's prompt; Ticket's entries are out of date
+        XCTAssertEqual(restored.schemaCache.count, 1)
+        XCTAssertTrue(SchemaPromptRenderer.render(for: RevisedTicket.self, typeBuilder: restored).contains("urgent"))
+    }
+
+    func testRejectsOversizedCounts() {
+        // Magic, no dynamic types, then an enum count past any archive's size
+        var bytes: [UInt8] = [0x53, 0x54, 0x42, 0x31, 0, 0, 0, 0]
+        bytes += [0xff, 0xff, 0xff, 0xff]
+
+        XCTAssertThrowsError(try TypeBuilder().load(Data(bytes))) { error in
+            guard case TypeBuilderError.invalidArchive = error else {
+                return XCTFail("Expected invalidArchive, got \(error)")
+            }
+        }
+    }
+
+    func testLoadsMappedFile() throws {
+        let url = FileManager.default.temporaryDirectory
+            .appendingPathComponent("swaml-archive-\(UUID().uuidString).bin")
+        defer { try? FileManager.default.removeItem(at: url) }
+        try built().archive().write(to: url)
+
+        let restored = TypeBuilder()
+        try restored.load(contentsOf: url)
+
+        XCTAssertEqual(restored.dynamicEnumValues()["Category"], ["Billing", "ShippingDelay"])
+    }
+
+    func testRejectsDamagedArchives() {
+        let archive = built().archive(functions: ["Classify": classifySchema])
+        let restored = TypeBuilder()
+
+        XCTAssertThrowsError(try restored.load(archive.prefix(archive.count - 3)))
+        XCTAssertThrowsError(try restored.load(archive + [0]))
+        XCTAssertThrowsError(try restored.load(try TypeBuilder().toJSON()))
+    }
+
+    // MARK: - Prewarming
+
+    func testPrewarmResolvesFunctionSchemas() async {
+        let tb = built()
+        let runtime = SwamlRuntime(clientRegistry: ClientRegistry())
+
+        await runtime.prewarm(functions: ["Classify": classifySchema], typeBuilder: tb)
+
+        XCTAssertEqual(tb.schemaCache.count, 1)
+    }
+}
@@ -600,6 +600,131 @@ final class TypeBuilderTests: XCTestCase {
         XCTAssertEqual(withoutAlias.stringValue, "SAD")
     }
 
+    // MARK: - Generation
+
+    func testGenerationChangesOnMutation() {
+        let tb = TypeBuilder()
+        var last = tb.generation
+
+        func assertChanged(_ message: String, file: StaticString = #filePath, line: UInt = #line) {
+            XCTAssertNotEqual(tb.generation, last, message, file: file, line: line)
+            last = tb.generation
+        }
+
+        let status = tb.enumBuilder("Status")
+        assertChanged("new enum builder")
+
+        let active = status.addValue("active")
+        assertChanged("new enum value")
+
+        active.description("Currently active")
+        assertChanged("enum value description")
+
+        let user = tb.addClass("User")
+        assertChanged("new class builder")
+
+        let name = user.addProperty("name", .string)
+        assertChanged("new property")
+
+        name.alias("full_name")
+        assertChanged("property alias")
+    }
+
+    func testGenerationUnchangedByLookups() {
+        let tb = TypeBuilder()
+        tb.enumBuilder("Status").addValue("active")
+        tb.addClass("User").addProperty("name", .string)
+        let generation = tb.generation
+
+        _ = tb.enumBuilder("Status")
+        tb.enumBuilder("Status").addValue("active")
+        _ = tb.classBuilder("User")
+        tb.addClass("User").addProperty("name", .string)
+        _ = tb.buildEnumSchema("Status")
+        _ = tb.buildClassSchema("User")
+
+        XCTAssertEqual(tb.generation, generation)
+    }
+
+    // MARK: - Snapshots
+
+    func testSnapshotIsSharedUntilChange() {
+        let tb = TypeBuilder()
+        tb.registerDynamicType("Status")
+        let status = tb.enumBuilder("Status")
+        status.addValue("active").description("Currently active")
+        tb.addClass("User").addProperty("name", .string).description("Full name")
+
+        let first = tb.snapshot()
+        XCTAssertEqual(first.generation, tb.generation)
+        XCTAssertTrue(first.isDynamicType("Status"))
+        XCTAssertEqual(first.dynamicEnumValues, ["Status": ["active"]])
+        XCTAssertEqual(first.enums["Status"]?.values.first?.description, "Currently active")
+        XCTAssertEqual(first.classes["User"]?.descriptions, ["name": "Full name"])
+        XCTAssertEqual(first.classSchema("User"), .object(properties: ["name": .string], required: ["name"]))
+
+        // Unchanged builder: same published snapshot
+        XCTAssertEqual(tb.snapshot().generation, first.generation)
+
+        status.addValue("inactive")
+        let second = tb.snapshot()
+        XCTAssertGreaterThan(second.generation, first.generation)
+        XCTAssertEqual(second.dynamicEnumValues["Status"], ["active", "inactive"])
+
+        // The earlier snapshot is unaffected
+        XCTAssertEqual(first.dynamicEnumValues["Status"], ["active"])
+    }
+
+    func testSnapshotSeesMetadataChanges() {
+        let tb = TypeBuilder()
+        let property = tb.addClass("User").addProperty("age", .int)
+        _ = tb.snapshot()
+
+        property.description("Age in years")
+        XCTAssertEqual(tb.snapshot().classes["User"]?.descriptions["age"], "Age in years")
+    }
+
+    func testSnapshotsDuringConcurrentWrites() async {
+        let tb = TypeBuilder()
+        let colors = tb.enumBuilder("Color")
+
+        await withTaskGroup(of: Void.self) { group in
+            for i in 0..<100 {
+                group.addTask {
+                    if i % 2 == 0 {
+                        colors.addValue("color_\(i)")
+                    } else {
+                        // Every snapshot is internally consistent
+                        let snapshot = tb.snapshot()
+                        XCTAssertEqual(
+                            snapshot.dynamicEnumValues["Color"] ?? [],
+                            snapshot.enums["Color"]?.valueNames ?? []
+                        )
+                    }
+                }
+            }
+        }
+
+        XCTAssertEqual(tb.snapshot().dynamicEnumValues["Color"]?.count, 50)
+    }
+
+    func testPublishedReferenceReleasesReplacedObjects() {
+        final class Box {}
+        weak var first: Box?
+        let reference = AtomicReference<Box>()
+        do {
+            let box = Box()
+            first = box
+            reference.store(box)
+        }
+
+        XCTAssertTrue(reference.load() === first)
+        reference.store(Box())
+        XCTAssertNil(first)
+        reference.store(nil)
+        XCTAssertNil(reference.load())
+    }
+
     // MARK: - Thread Safety
 
     func testDynamicEnumBuilderThreadSafety() async {
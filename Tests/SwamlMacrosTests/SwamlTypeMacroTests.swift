@@ -8,8 +8,8 @@ import XCTest
 final class SwamlTypeMacroTests: XCTestCase {
 
     let testMacros: [String: Macro.Type] = [
-        "BamlType": SwamlTypeMacro.self,
-        "BamlDynamic": SwamlDynamicMacro.self,
+        "SwamlType": SwamlTypeMacro.self,
+        "SwamlDynamic": SwamlDynamicMacro.self,
         "Description": DescriptionMacro.self,
         "Alias": AliasMacro.self,
     ]
@@ -33,12 +33,11 @@ final class SwamlTypeMacroTests: XCTestCase {
 
             extension User: SwamlTyped {
                 public static var swamlTypeName: String { "User" }
-                public static var swamlSchema: JSONSchema {
-                    .object(properties: ["age": .integer, "name": .string], required: ["age", "name"])
-                }
+                public static let swamlSchema: JSONSchema = .object(properties: ["age": .integer, "name": .string], required: ["age", "name"])
                 public static var isDynamic: Bool { false }
-                public static var fieldDescriptions: [String: String] { [:] }
-                public static var fieldAliases: [String: String] { [:] }
+                public static let fieldDescriptions: [String: String] = [:]
+                public static let fieldAliases: [String: String] = [:]
+                public static let swamlSchemaPrompt: String? = "Answer in JSON using this schema:\\n{\\n  age: int,\\n  name: string,\\n}"
             }
             """,
             macros: testMacros
@@ -62,12 +61,11 @@ final class SwamlTypeMacroTests: XCTestCase {
 
             extension Profile: SwamlTyped {
                 public static var swamlTypeName: String { "Profile" }
-                public static var swamlSchema: JSONSchema {
-                    .object(properties: ["bio": .anyOf([.string, .null]), "username": .string], required: ["username"])
-                }
+                public static let swamlSchema: JSONSchema = .object(properties: ["bio": .anyOf([.string, .null]), "username": .string], required: ["username"])
                 public static var isDynamic: Bool { false }
-                public static var fieldDescriptions: [String: String] { [:] }
-                public static var fieldAliases: [String: String] { [:] }
+                public static let fieldDescriptions: [String: String] = [:]
+                public static let fieldAliases: [String: String] = [:]
+                public static let swamlSchemaPrompt: String? = "Answer in JSON using this schema:\\n{\\n  bio?: string | null,\\n  username: string,\\n}"
             }
             """,
             macros: testMacros
@@ -95,12 +93,11 @@ final class SwamlTypeMacroTests: XCTestCase {
 
             extension Order: SwamlTyped {
                 public static var swamlTypeName: String { "Order" }
-                public static var swamlSchema: JSONSchema {
-                    .object(properties: ["orderId": .string, "totalCents": .integer], required: ["orderId", "totalCents"])
-                }
+                public static let swamlSchema: JSONSchema = .object(properties: ["orderId": .string, "totalCents": .integer], required: ["orderId", "totalCents"])
                 public static var isDynamic: Bool { false }
-                public static var fieldDescriptions: [String: String] { ["orderId": "Unique order ID", "totalCents": "Total in cents"] }
-                public static var fieldAliases: [String: String] { [:] }
+                public static let fieldDescriptions: [String: String] = ["orderId": "Unique order ID", "totalCents": "Total in cents"]
+                public static let fieldAliases: [String: String] = [:]
+                public static let swamlSchemaPrompt: String? = "Answer in JSON using this schema:\\n{\\n  // Unique order ID\\n  orderId: string,\\n  // Total in cents\\n  totalCents: int,\\n}"
             }
             """,
             macros: testMacros
@@ -126,10 +123,11 @@ final class SwamlTypeMacroTests: XCTestCase {
 
             extension Status: SwamlTyped {
                 public static var swamlTypeName: String { "Status" }
-                public static var swamlSchema: JSONSchema { .enum(values: ["active", "inactive"]) }
+                public static let swamlSchema: JSONSchema = .enum(values: ["active", "inactive"])
                 public static var isDynamic: Bool { false }
-                public static var fieldDescriptions: [String: String] { [:] }
-                public static var fieldAliases: [String: String] { [:] }
+                public static let fieldDescriptions: [String: String] = [:]
+                public static let fieldAliases: [String: String] = [:]
+                public static let swamlSchemaPrompt: String? = "Answer with any of the categories:\\n----\\n- active\\n- inactive"
             }
             """,
             macros: testMacros
@@ -183,12 +181,37 @@ final class SwamlTypeMacroTests: XCTestCase {
 
             extension Team: SwamlTyped {
                 public static var swamlTypeName: String { "Team" }
-                public static var swamlSchema: JSONSchema {
-                    .object(properties: ["members": .array(items: .string), "name": .string], required: ["members", "name"])
-                }
+                public static let swamlSchema: JSONSchema = .object(properties: ["members": .array(items: .string), "name": .string], required: ["members", "name"])
                 public static var isDynamic: Bool { false }
-                public static var fieldDescriptions: [String: String] { [:] }
-                public static var fieldAliases: [String: String] { [:] }
+                public static let fieldDescriptions: [String: String] = [:]
+                public static let fieldAliases: [String: String] = [:]
+                public static let swamlSchemaPrompt: String? = "Answer in JSON using this schema:\\n{\\n  members: string[],\\n  name: string,\\n}"
+            }
+            """,
+            macros: testMacros
+        )
+    }
+
+    func testStructWithDictionary() throws {
+        assertMacroExpansion(
+            """
+            @SwamlType
+            struct Scores {
+                let values: [String: Int]
+            }
+            """,
+            expandedSource: """
+            struct Scores {
+                let values: [String: Int]
+            }
+
+            extension Scores: SwamlTyped {
+                public static var swamlTypeName: String { "Scores" }
+                public static let swamlSchema: JSONSchema = .object(properties: ["values": .object(properties: [:], required: [], additionalProperties: .integer)], required: ["values"])
+                public static var isDynamic: Bool { false }
+                public static let fieldDescriptions: [String: String] = [:]
+                public static let fieldAliases: [String: String] = [:]
+                public static let swamlSchemaPrompt: String? = "Answer in JSON using this schema:\\n{\\n  values: {},\\n}"
             }
             """,
             macros: testMacros
@@ -214,10 +237,39 @@ final class SwamlTypeMacroTests: XCTestCase {
 
             extension User: SwamlTyped {
                 public static var swamlTypeName: String { "User" }
+                public static let swamlSchema: JSONSchema = .object(properties: ["name": .string, "status": .ref("UserStatus")], required: ["name", "status"])
+                public static var isDynamic: Bool { false }
+                public static let fieldDescriptions: [String: String] = [:]
+                public static let fieldAliases: [String: String] = [:]
+                public static let swamlSchemaPrompt: String? = nil
+            }
+            """,
+            macros: testMacros
+        )
+    }
+
+    // MARK: - Runtime Fallback Tests
+
+    func testDynamicStructKeepsComputedSchema() throws {
+        assertMacroExpansion(
+            """
+            @SwamlType
+            @SwamlDynamic
+            struct Tags {
+                let label: String
+            }
+            """,
+            expandedSource: """
+            struct Tags {
+                let label: String
+            }
+
+            extension Tags: SwamlTyped {
+                public static var swamlTypeName: String { "Tags" }
                 public static var swamlSchema: JSONSchema {
-                    .object(properties: ["name": .string, "status": .ref("UserStatus")], required: ["name", "status"])
+                    .object(properties: ["label": .string], required: ["label"])
                 }
-                public static var isDynamic: Bool { false }
+                public static var isDynamic: Bool { true }
                 public static var fieldDescriptions: [String: String] { [:] }
                 public static var fieldAliases: [String: String] { [:] }
             }